@@ -1,2 +1,10 @@
 # Adding Torsten functions making MPL list too long, need adjust list size
 CXXFLAGS += -DBOOST_MPL_CFG_NO_PREPROCESSED_HEADERS -DBOOST_MPL_LIMIT_LIST_SIZE=30
+
+# Reuse value-only Torsten event solutions computed by log_prob
+# in write_array: make TORSTEN_SOLUTION_CACHE=true, then list the
+# call sites to cache at run time, e.g.
+# TORSTEN_SOLUTION_CACHE_SITES="pmx_solve_rk45(ode),other_ode"
+ifdef TORSTEN_SOLUTION_CACHE
+  CXXFLAGS += -DTORSTEN_SOLUTION_CACHE
+endif
@@ -0,0 +1,366 @@
+#ifndef STAN_ANALYZE_MCMC_STREAMING_SUMMARY_HPP
+#define STAN_ANALYZE_MCMC_STREAMING_SUMMARY_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/analyze/mcmc/t_digest.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Summary of MCMC draws computed in a single pass with memory that
+ * does not grow with the number of draws, for runs where the draws
+ * can not be kept in memory as <code>stan::mcmc::chains</code>.
+ *
+ * <p>For each chain and column the summary keeps
+ * <ul>
+ * <li>Welford's running mean and sum of squared deviations, giving
+ * exact means and variances, combined across chains with Chan's
+ * parallel update;</li>
+ * <li>a <code>t_digest</code> of the draws for approximate
+ * quantiles, see there for error bounds;</li>
+ * <li>at most <code>max_batches</code> batch means, whose batch size
+ * doubles when full, for the batch-means estimate of the effective
+ * sample size.</li>
+ * </ul>
+ *
+ * <p>Summaries of different chains, e.g. filled by different
+ * threads, are combined with <code>merge</code>. The table has the
+ * layout of the chains-based summary: mean, MCSE, standard
+ * deviation, quantiles, effective sample size and Rhat. Unlike the
+ * chains-based summary, the effective sample size is the batch-means
+ * estimate summed over chains and Rhat is the (non-split) potential
+ * scale reduction, which is not available for a single chain.
+ */
+class streaming_summary {
+  struct chain_summary {
+    double num_draws;
+    Eigen::VectorXd mean;
+    Eigen::VectorXd m2;
+    std::vector<t_digest> digests;
+    int batch_size;
+    int num_batches;
+    int num_in_batch;
+    Eigen::MatrixXd batch_sums;
+    Eigen::VectorXd partial_sum;
+  };
+
+  double compression_;
+  int max_batches_;
+  std::vector<std::string> names_;
+  std::vector<chain_summary> chains_;
+
+  chain_summary empty_chain(size_t num_params) const {
+    chain_summary c;
+    c.num_draws = 0;
+    c.mean = Eigen::VectorXd::Zero(num_params);
+    c.m2 = Eigen::VectorXd::Zero(num_params);
+    c.digests.assign(num_params, t_digest(compression_));
+    c.batch_size = 1;
+    c.num_batches = 0;
+    c.num_in_batch = 0;
+    c.batch_sums = Eigen::MatrixXd::Zero(num_params, max_batches_);
+    c.partial_sum = Eigen::VectorXd::Zero(num_params);
+    return c;
+  }
+
+  t_digest merged_digest(int index) const {
+    t_digest digest(compression_);
+    for (const chain_summary& c : chains_) {
+      digest.merge(c.digests[index]);
+    }
+    return digest;
+  }
+
+  /*
+   * Welford mean & variance pooled over chains.
+   */
+  void pooled_moments(int index, double& n, double& mean, double& m2) const {
+    n = 0;
+    mean = 0;
+    m2 = 0;
+    for (const chain_summary& c : chains_) {
+      if (c.num_draws == 0) {
+        continue;
+      }
+      double delta = c.mean(index) - mean;
+      double n_new = n + c.num_draws;
+      mean += delta * c.num_draws / n_new;
+      m2 += c.m2(index) + delta * delta * n * c.num_draws / n_new;
+      n = n_new;
+    }
+  }
+
+ public:
+  /**
+   * Construct an empty summary.
+   *
+   * @param compression compression of quantile digests
+   * @param max_batches maximum number of batch means for each
+   * chain, must be even.
+   */
+  explicit streaming_summary(double compression = 100.0,
+                             int max_batches = 64)
+      : compression_(compression), max_batches_(max_batches) {}
+
+  /**
+   * Set column names. Draws are expected to have the same number of
+   * columns.
+   *
+   * @param names column names
+   */
+  void set_names(const std::vector<std::string>& names) {
+    names_ = names;
+    if (!chains_.empty() && chains_.back().num_draws == 0) {
+      chains_.back() = empty_chain(names_.size());
+    }
+  }
+
+  const std::vector<std::string>& names() const { return names_; }
+
+  int num_params() const { return names_.size(); }
+
+  int num_chains() const { return chains_.size(); }
+
+  /**
+   * Start a new chain. Subsequent draws are added to it.
+   */
+  void new_chain() { chains_.push_back(empty_chain(names_.size())); }
+
+  /**
+   * Discard draws added to current chain, e.g. warmup draws.
+   */
+  void reset_chain() {
+    if (!chains_.empty()) {
+      chains_.back() = empty_chain(names_.size());
+    }
+  }
+
+  /**
+   * Add a draw to current chain, starting a chain if there is none.
+   *
+   * @param draw values of all the columns
+   */
+  void add(const std::vector<double>& draw) {
+    if (chains_.empty()) {
+      new_chain();
+    }
+    chain_summary& c = chains_.back();
+    const int n_col = std::min(draw.size(), static_cast<size_t>(c.mean.size()));
+    c.num_draws += 1;
+    for (int i = 0; i < n_col; ++i) {
+      double delta = draw[i] - c.mean(i);
+      c.mean(i) += delta / c.num_draws;
+      c.m2(i) += delta * (draw[i] - c.mean(i));
+      c.digests[i].add(draw[i]);
+      c.partial_sum(i) += draw[i];
+    }
+
+    if (++c.num_in_batch == c.batch_size) {
+      c.batch_sums.col(c.num_batches++) = c.partial_sum;
+      c.partial_sum.setZero();
+      c.num_in_batch = 0;
+      if (c.num_batches == max_batches_) {
+        for (int j = 0; j < max_batches_ / 2; ++j) {
+          c.batch_sums.col(j)
+              = c.batch_sums.col(2 * j) + c.batch_sums.col(2 * j + 1);
+        }
+        c.num_batches = max_batches_ / 2;
+        c.batch_size *= 2;
+      }
+    }
+  }
+
+  /**
+   * Add the chains of another summary with the same columns.
+   *
+   * @param other summary
+   */
+  void merge(const streaming_summary& other) {
+    chains_.insert(chains_.end(), other.chains_.begin(), other.chains_.end());
+  }
+
+  /**
+   * Number of draws in all the chains.
+   */
+  double num_draws() const {
+    double n = 0;
+    for (const chain_summary& c : chains_) {
+      n += c.num_draws;
+    }
+    return n;
+  }
+
+  double mean(int index) const {
+    double n, mean, m2;
+    pooled_moments(index, n, mean, m2);
+    return n > 0 ? mean : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  double variance(int index) const {
+    double n, mean, m2;
+    pooled_moments(index, n, mean, m2);
+    return n > 1 ? m2 / (n - 1) : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  double sd(int index) const { return std::sqrt(variance(index)); }
+
+  /**
+   * Approximate quantile from the merged digests of all the chains.
+   *
+   * @param index column
+   * @param prob probability
+   */
+  double quantile(int index, double prob) const {
+    return merged_digest(index).quantile(prob);
+  }
+
+  /**
+   * Effective sample size as the sum over chains of the batch-means
+   * estimate <code>n s^2 / (b var(batch means))</code>, using the
+   * full batches of each chain. A chain with fewer than two full
+   * batches gives NaN.
+   *
+   * @param index column
+   */
+  double effective_sample_size(int index) const {
+    double ess = 0;
+    for (const chain_summary& c : chains_) {
+      if (c.num_batches < 2) {
+        return std::numeric_limits<double>::quiet_NaN();
+      }
+      Eigen::VectorXd batch_mean
+          = c.batch_sums.row(index).head(c.num_batches).transpose()
+            / c.batch_size;
+      double var_batch = (batch_mean.array() - batch_mean.mean())
+                             .square()
+                             .sum()
+                         / (c.num_batches - 1);
+      double var_chain = c.m2(index) / (c.num_draws - 1);
+      double n = c.num_batches * c.batch_size;
+      ess += std::min(n * var_chain / (c.batch_size * var_batch),
+                      n * std::log10(n));
+    }
+    return ess;
+  }
+
+  /**
+   * Monte Carlo standard error of the mean.
+   *
+   * @param index column
+   */
+  double mcse(int index) const {
+    return sd(index) / std::sqrt(effective_sample_size(index));
+  }
+
+  /**
+   * Potential scale reduction from the means and variances of the
+   * chains, NaN for a single chain.
+   *
+   * @param index column
+   */
+  double potential_scale_reduction(int index) const {
+    const int m = chains_.size();
+    if (m < 2) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    double n = num_draws() / m;
+    double mean_of_means = 0;
+    double var_within = 0;
+    for (const chain_summary& c : chains_) {
+      mean_of_means += c.mean(index) / m;
+      var_within += c.m2(index) / (c.num_draws - 1) / m;
+    }
+    double var_between = 0;
+    for (const chain_summary& c : chains_) {
+      var_between += (c.mean(index) - mean_of_means)
+                     * (c.mean(index) - mean_of_means);
+    }
+    var_between *= n / (m - 1);
+    return std::sqrt((var_between / var_within + n - 1) / n);
+  }
+
+  /**
+   * Column headers of <code>table</code>.
+   *
+   * @param probs probabilities of quantiles
+   */
+  static std::vector<std::string> header(const Eigen::VectorXd& probs) {
+    std::vector<std::string> h{"Mean", "MCSE", "StdDev"};
+    for (int i = 0; i < probs.size(); ++i) {
+      std::stringstream ss;
+      ss << 100 * probs(i) << "%";
+      h.push_back(ss.str());
+    }
+    h.push_back("N_Eff");
+    h.push_back("R_hat");
+    return h;
+  }
+
+  /**
+   * Summary table, one row for each column of the draws and columns
+   * as in <code>header</code>.
+   *
+   * @param probs probabilities of quantiles
+   */
+  Eigen::MatrixXd table(const Eigen::VectorXd& probs) const {
+    const int n_q = probs.size();
+    Eigen::MatrixXd t(num_params(), 5 + n_q);
+    for (int i = 0; i < num_params(); ++i) {
+      t(i, 0) = mean(i);
+      t(i, 1) = mcse(i);
+      t(i, 2) = sd(i);
+      t_digest digest = merged_digest(i);
+      for (int j = 0; j < n_q; ++j) {
+        t(i, 3 + j) = digest.quantile(probs(j));
+      }
+      t(i, 3 + n_q) = effective_sample_size(i);
+      t(i, 4 + n_q) = potential_scale_reduction(i);
+    }
+    return t;
+  }
+
+  /**
+   * Print the summary table with 5%, 50% and 95% quantiles.
+   *
+   * @param o output stream
+   * @param sig_figs significant figures of values
+   */
+  void print(std::ostream& o, int sig_figs = 6) const {
+    Eigen::VectorXd probs(3);
+    probs << 0.05, 0.5, 0.95;
+    std::vector<std::string> h = header(probs);
+    Eigen::MatrixXd t = table(probs);
+
+    size_t name_width = 0;
+    for (const std::string& name : names_) {
+      name_width = std::max(name_width, name.size());
+    }
+    const int width = sig_figs + 7;
+    o << std::setw(name_width) << "";
+    for (const std::string& s : h) {
+      o << std::setw(width) << s;
+    }
+    o << std::endl;
+    for (int i = 0; i < num_params(); ++i) {
+      o << std::setw(name_width) << std::left << names_[i] << std::right;
+      for (int j = 0; j < t.cols(); ++j) {
+        o << std::setw(width) << std::setprecision(sig_figs) << t(i, j);
+      }
+      o << std::endl;
+    }
+  }
+};
+
+}  // namespace analyze
+}  // namespace stan
+
+#endif
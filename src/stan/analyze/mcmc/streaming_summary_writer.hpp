@@ -0,0 +1,66 @@
+#ifndef STAN_ANALYZE_MCMC_STREAMING_SUMMARY_WRITER_HPP
+#define STAN_ANALYZE_MCMC_STREAMING_SUMMARY_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/analyze/mcmc/streaming_summary.hpp>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * <code>streaming_summary_writer</code> is a writer decorator that
+ * passes every call to the writer it wraps and adds the sample
+ * names and draws to a <code>streaming_summary</code>.
+ *
+ * Warmup draws written before the "Adaptation terminated" message
+ * are discarded from the summary.
+ */
+class streaming_summary_writer : public callbacks::writer {
+ public:
+  /**
+   * Constructor.
+   *
+   * @param[in, out] writer writer to be decorated
+   * @param[in, out] summary summary of current chain
+   */
+  streaming_summary_writer(callbacks::writer& writer,
+                           streaming_summary& summary)
+      : writer_(writer), summary_(summary) {}
+
+  virtual ~streaming_summary_writer() {}
+
+  void operator()(const std::vector<std::string>& names) {
+    writer_(names);
+    summary_.set_names(names);
+  }
+
+  void operator()(const std::vector<double>& state) {
+    writer_(state);
+    summary_.add(state);
+  }
+
+  void operator()() { writer_(); }
+
+  void operator()(const std::string& message) {
+    writer_(message);
+    if (message == "Adaptation terminated") {
+      summary_.reset_chain();
+    }
+  }
+
+ private:
+  /**
+   * The decorated writer
+   */
+  callbacks::writer& writer_;
+  /**
+   * The summary
+   */
+  streaming_summary& summary_;
+};
+
+}  // namespace analyze
+}  // namespace stan
+#endif
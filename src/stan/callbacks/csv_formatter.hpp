@@ -0,0 +1,211 @@
+#ifndef STAN_CALLBACKS_CSV_FORMATTER_HPP
+#define STAN_CALLBACKS_CSV_FORMATTER_HPP
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ios>
+#include <limits>
+#include <locale>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define STAN_CALLBACKS_HAS_TO_CHARS
+#endif
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>csv_formatter</code> formats a row of values in csv format
+ * into a reusable character buffer and writes the row to a stream
+ * with a single call to <code>write</code>, rather than formatting
+ * each value through the stream's <code>operator<<</code>.
+ *
+ * <p>Doubles are formatted with <code>std::to_chars</code> where the
+ * standard library provides it and with <code>snprintf</code>
+ * otherwise; both give the same characters. The precision is one of
+ *
+ * <ul>
+ * <li><code>use_stream_precision</code> (the default): the precision
+ * of the stream at the time of writing. The output is byte-identical
+ * to writing each value with <code>operator<<</code>. If the stream
+ * has fixed or scientific format, <code>showpoint</code>,
+ * <code>showpos</code>, <code>uppercase</code>, a field width or a
+ * locale with a decimal point other than '.' or digit grouping, the
+ * values are written with <code>operator<<</code>.</li>
+ * <li><code>shortest_round_trip</code>: <code>%.*g</code> with the
+ * smallest number of significant digits that reads back to the same
+ * double.</li>
+ * <li>a positive number of significant digits: the same characters
+ * as <code>operator<<</code> on a stream in default format with that
+ * precision.</li>
+ * </ul>
+ *
+ * <p>In the last two cases the settings of the stream are ignored.
+ */
+class csv_formatter {
+ public:
+  static const int use_stream_precision = -1;
+  static const int shortest_round_trip = 0;
+
+  /**
+   * Construct a formatter with the specified precision.
+   *
+   * @param[in] precision <code>use_stream_precision</code>,
+   *   <code>shortest_round_trip</code> or a positive number of
+   *   significant digits
+   */
+  explicit csv_formatter(int precision = use_stream_precision)
+      : precision_(precision < 0 ? use_stream_precision : precision) {}
+
+  int precision() const { return precision_; }
+
+  /**
+   * Writes a set of values in csv format followed by a newline and
+   * flushes the stream. Nothing is written for an empty set.
+   *
+   * @tparam T type of values, <code>double</code> or
+   *   <code>std::string</code>
+   * @param[in, out] output stream to write
+   * @param[in] v values
+   */
+  template <class T>
+  void write(std::ostream& output, const std::vector<T>& v) {
+    if (v.empty())
+      return;
+    int precision = precision_;
+    if (precision == use_stream_precision) {
+      if (!default_format(output)) {
+        write_with_stream(output, v);
+        return;
+      }
+      precision = output.precision() < 0 ? 6 : output.precision();
+      if (precision == 0)
+        precision = 1;
+    }
+    buffer_.clear();
+    for (size_t n = 0; n < v.size(); ++n) {
+      if (n > 0)
+        buffer_.push_back(',');
+      append(v[n], precision);
+    }
+    buffer_.push_back('\n');
+    output.write(buffer_.data(), buffer_.size());
+    output.flush();
+  }
+
+ private:
+  int precision_;
+  std::string buffer_;
+
+  /*
+   * Append x to the buffer with the specified number of significant
+   * digits, or the shortest round-trip representation.
+   */
+  void append(double x, int precision) {
+    size_t size = buffer_.size();
+    buffer_.resize(size + (precision > 17 ? precision : 17) + 16);
+    char* first = &buffer_[size];
+    char* last = &buffer_[0] + buffer_.size();
+    buffer_.resize(size + (format(first, last, x, precision) - first));
+  }
+
+  void append(const std::string& s, int precision) { buffer_.append(s); }
+
+  static bool default_format(std::ostream& output) {
+    if ((output.flags()
+         & (std::ios_base::floatfield | std::ios_base::showpoint
+            | std::ios_base::showpos | std::ios_base::uppercase))
+            != 0
+        || output.width() != 0)
+      return false;
+    const std::numpunct<char>& punct
+        = std::use_facet<std::numpunct<char> >(output.getloc());
+    return punct.decimal_point() == '.' && punct.grouping().empty();
+  }
+
+  template <class T>
+  static void write_with_stream(std::ostream& output,
+                                const std::vector<T>& v) {
+    for (size_t n = 0; n + 1 < v.size(); ++n)
+      output << v[n] << ",";
+    output << v.back() << std::endl;
+  }
+
+  /*
+   * Format x into [first, last), which must be large enough, and
+   * return the end of the characters written.
+   */
+  static char* format(char* first, char* last, double x, int precision) {
+    if (precision == shortest_round_trip)
+      precision = shortest_digits(first, last, x);
+#ifdef STAN_CALLBACKS_HAS_TO_CHARS
+    return std::to_chars(first, last, x, std::chars_format::general,
+                         precision)
+        .ptr;
+#else
+    return first + std::snprintf(first, last - first, "%.*g", precision, x);
+#endif
+  }
+
+  /*
+   * Return the smallest number of significant digits with which x
+   * reads back, using [first, last) as scratch space.
+   */
+  static int shortest_digits(char* first, char* last, double x) {
+    if (!std::isfinite(x) || x == 0)
+      return 1;
+#ifdef STAN_CALLBACKS_HAS_TO_CHARS
+    return significant_digits(
+        first,
+        std::to_chars(first, last, x, std::chars_format::scientific).ptr);
+#else
+    // any decimal of at most 15 digits is recovered by %.15g from its
+    // nearest normal double, so if %.15g reads back, its digits without
+    // trailing zeros are the shortest ones
+    bool normal = std::fabs(x) >= std::numeric_limits<double>::min();
+    for (int precision = normal ? 15 : 1; precision < 17; ++precision) {
+      int n = std::snprintf(first, last - first, "%.*g", precision, x);
+      if (std::strtod(first, 0) == x)
+        return normal && precision == 15
+                   ? significant_digits(first, first + n)
+                   : precision;
+    }
+    return 17;
+#endif
+  }
+
+  /*
+   * Return the number of digits of the mantissa in [first, last),
+   * without leading and trailing zeros.
+   */
+  static int significant_digits(const char* first, const char* last) {
+    int first_nonzero = -1;
+    int last_nonzero = -1;
+    int position = 0;
+    for (const char* c = first; c != last && *c != 'e'; ++c) {
+      if (*c < '0' || *c > '9')
+        continue;
+      if (*c != '0') {
+        if (first_nonzero < 0)
+          first_nonzero = position;
+        last_nonzero = position;
+      }
+      ++position;
+    }
+    return first_nonzero < 0 ? 1 : last_nonzero - first_nonzero + 1;
+  }
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
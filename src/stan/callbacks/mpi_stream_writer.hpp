@@ -3,6 +3,7 @@
 
 #ifdef MPI_ADAPTED_WARMUP
 
+#include <stan/callbacks/csv_formatter.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/math/torsten/mpi/session.hpp>
 #include <ostream>
@@ -24,11 +25,15 @@ namespace stan {
        * @param[in, out] output stream to write
        * @param[in] comment_prefix string to stream before
        *   each comment line. Default is "".
+       * @param[in] precision precision of values, see
+       *   <code>csv_formatter</code>. Default is the precision of the
+       *   stream.
        */
       mpi_stream_writer(int num_chains, std::ostream& output,
-                        const std::string& comment_prefix = "")
+                        const std::string& comment_prefix = "",
+                        int precision = csv_formatter::use_stream_precision)
         : num_chains_(num_chains), output_(output),
-          comment_prefix_(comment_prefix)
+          comment_prefix_(comment_prefix), format_(precision)
       {}
 
       /**
@@ -60,8 +65,9 @@ namespace stan {
       /**
        * Writes a set of values in csv format followed by a newline.
        *
-       * Note: the precision of the output is determined by the settings
-       *  of the stream on construction.
+       * Note: unless a precision was given on construction, the
+       *  precision of the output is determined by the settings of the
+       *  stream.
        *
        * @param[in] state Values in a std::vector
        */
@@ -106,26 +112,20 @@ namespace stan {
        */
       std::string comment_prefix_;
 
+      /**
+       * Formatter holding the buffer rows are built in
+       */
+      csv_formatter format_;
+
       /**
        * Writes a set of values in csv format followed by a newline.
        *
-       * Note: the precision of the output is determined by the settings
-       *  of the stream on construction.
-       *
        * @param[in] v Values in a std::vector
        */
       template <class T>
       void write_vector(const std::vector<T>& v) {
         if (stan::math::mpi::Session::is_in_inter_chain_comm(num_chains_)) {
-          if (v.empty()) return;
-
-          typename std::vector<T>::const_iterator last = v.end();
-          --last;
-
-          for (typename std::vector<T>::const_iterator it = v.begin();
-               it != last; ++it)
-            output_ << *it << ",";
-          output_ << v.back() << std::endl;
+          format_.write(output_, v);
         }
       }
     };
@@ -1,6 +1,7 @@
 #ifndef STAN_CALLBACKS_STREAM_WRITER_HPP
 #define STAN_CALLBACKS_STREAM_WRITER_HPP
 
+#include <stan/callbacks/csv_formatter.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <ostream>
 #include <vector>
@@ -22,10 +23,14 @@ class stream_writer : public writer {
    * @param[in, out] output stream to write
    * @param[in] comment_prefix string to stream before
    *   each comment line. Default is "".
+   * @param[in] precision precision of values, see
+   *   <code>csv_formatter</code>. Default is the precision of the
+   *   stream.
    */
-  explicit stream_writer(std::ostream& output,
-                         const std::string& comment_prefix = "")
-      : output_(output), comment_prefix_(comment_prefix) {}
+  explicit stream_writer(
+      std::ostream& output, const std::string& comment_prefix = "",
+      int precision = csv_formatter::use_stream_precision)
+      : output_(output), comment_prefix_(comment_prefix), format_(precision) {}
 
   /**
    * Virtual destructor
@@ -47,8 +52,8 @@ class stream_writer : public writer {
   /**
    * Writes a set of values in csv format followed by a newline.
    *
-   * Note: the precision of the output is determined by the settings
-   *  of the stream on construction.
+   * Note: unless a precision was given on construction, the precision
+   *  of the output is determined by the settings of the stream.
    *
    * @param[in] state Values in a std::vector
    */
@@ -79,26 +84,19 @@ class stream_writer : public writer {
    */
   std::string comment_prefix_;
 
+  /**
+   * Formatter holding the buffer rows are built in
+   */
+  csv_formatter format_;
+
   /**
    * Writes a set of values in csv format followed by a newline.
    *
-   * Note: the precision of the output is determined by the settings
-   *  of the stream on construction.
-   *
    * @param[in] v Values in a std::vector
    */
   template <class T>
   void write_vector(const std::vector<T>& v) {
-    if (v.empty())
-      return;
-
-    typename std::vector<T>::const_iterator last = v.end();
-    --last;
-
-    for (typename std::vector<T>::const_iterator it = v.begin(); it != last;
-         ++it)
-      output_ << *it << ",";
-    output_ << v.back() << std::endl;
+    format_.write(output_, v);
   }
 };
 
@@ -0,0 +1,284 @@
+#ifndef STAN_IO_STAN_CSV_TAIL_READER_HPP
+#define STAN_IO_STAN_CSV_TAIL_READER_HPP
+
+#include <stan/io/stan_csv_reader.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Incremental reader of a Stan CSV file that is still being written,
+ * e.g. by a running sampler.
+ *
+ * <p>The reader remembers the byte offset up to which the file has
+ * been consumed. Each call to <code>read</code> seeks to that offset
+ * and parses only the complete lines appended since, so the cost of
+ * polling a file is proportional to the new data rather than to the
+ * size of the file. A trailing line without newline is left for the
+ * next call, as it may still be being written.
+ *
+ * <p>The metadata comments and the header are parsed with
+ * <code>stan_csv_reader</code> once the header line is complete. The
+ * adaptation block is parsed once the line following it arrives, and
+ * timing comments are accumulated as in
+ * <code>stan_csv_reader::read_samples</code>. Draws saved before the
+ * adaptation block are counted as warmup draws.
+ *
+ * <p>If the file shrinks below the offset, it is assumed to have
+ * been rewritten and the reader starts over.
+ */
+class stan_csv_tail_reader {
+  std::string file_name_;
+  std::streamoff offset_;
+  std::string metadata_lines_;
+  std::string adaptation_lines_;
+  bool in_adaptation_;
+  bool adaptation_read_;
+  int num_rows_;
+  int num_warmup_rows_;
+  stan_csv csv_;
+
+  /*
+   * Parse buffered adaptation block.
+   */
+  void end_adaptation(std::ostream* out) {
+    std::stringstream ss(adaptation_lines_);
+    if (!stan_csv_reader::read_adaptation(ss, csv_.adaptation, out) && out)
+      *out << "Warning: non-fatal error reading adaptation data" << std::endl;
+    adaptation_lines_.clear();
+    in_adaptation_ = false;
+  }
+
+  /*
+   * Process a complete line, appending the values of a draw to
+   * <code>values</code>. Return true if the line is a draw.
+   */
+  bool read_line(const std::string& line, std::vector<double>& values,
+                 std::ostream* out) {
+    if (line.empty())
+      return false;
+
+    if (csv_.header.empty()) {
+      if (line[0] == '#') {
+        metadata_lines_ += line;
+        metadata_lines_ += '\n';
+        return false;
+      }
+      std::stringstream metadata_ss(metadata_lines_);
+      if (!stan_csv_reader::read_metadata(metadata_ss, csv_.metadata, out)
+          && out)
+        *out << "Warning: non-fatal error reading metadata" << std::endl;
+      metadata_lines_.clear();
+      std::stringstream header_ss(line);
+      if (!stan_csv_reader::read_header(header_ss, csv_.header, out) && out)
+        *out << "Error: error reading header" << std::endl;
+      return false;
+    }
+
+    if (line[0] == '#') {
+      if (line.find("Adaptation terminated") != std::string::npos) {
+        in_adaptation_ = true;
+        adaptation_read_ = true;
+        num_warmup_rows_ = num_rows_;
+        adaptation_lines_.clear();
+      } else if (in_adaptation_
+                 && line.find("Elapsed Time") != std::string::npos) {
+        end_adaptation(out);
+      }
+      if (in_adaptation_) {
+        adaptation_lines_ += line;
+        adaptation_lines_ += '\n';
+      } else if (line.find("(Warm-up)") != std::string::npos) {
+        int left = 17;
+        int right = line.find(" seconds");
+        double warmup;
+        std::stringstream(line.substr(left, right - left)) >> warmup;
+        csv_.timing.warmup += warmup;
+      } else if (line.find("(Sampling)") != std::string::npos) {
+        int left = 17;
+        int right = line.find(" seconds");
+        double sampling;
+        std::stringstream(line.substr(left, right - left)) >> sampling;
+        csv_.timing.sampling += sampling;
+      }
+      return false;
+    }
+
+    if (in_adaptation_)
+      end_adaptation(out);
+
+    const size_t cols = csv_.header.size();
+    const size_t current_cols = std::count(line.begin(), line.end(), ',') + 1;
+    if (current_cols != cols) {
+      if (out)
+        *out << "Error: expected " << cols << " columns, but found "
+             << current_cols << " instead for row " << num_rows_ + 1
+             << std::endl;
+      return false;
+    }
+    const char* p = line.c_str();
+    for (size_t col = 0; col < cols; ++col) {
+      char* end;
+      values.push_back(std::strtod(p, &end));
+      p = (*end == ',') ? end + 1 : end;
+    }
+    ++num_rows_;
+    return true;
+  }
+
+ public:
+  /**
+   * Construct a reader of the specified file. The file need not
+   * exist yet.
+   *
+   * @param file_name name of Stan CSV file
+   */
+  explicit stan_csv_tail_reader(const std::string& file_name)
+      : file_name_(file_name) {
+    reset();
+  }
+
+  /**
+   * Forget everything read so far, so that next <code>read</code>
+   * starts from the beginning of the file.
+   */
+  void reset() {
+    offset_ = 0;
+    metadata_lines_.clear();
+    adaptation_lines_.clear();
+    in_adaptation_ = false;
+    adaptation_read_ = false;
+    num_rows_ = 0;
+    num_warmup_rows_ = 0;
+    csv_ = stan_csv();
+  }
+
+  /**
+   * Read the complete lines appended to the file since last call.
+   * Afterwards the samples of <code>csv()</code> hold the new draws
+   * only, while its metadata, header, adaptation and timing reflect
+   * everything read so far.
+   *
+   * @param out stream for messages, may be null
+   * @return number of new draws
+   */
+  int read(std::ostream* out = 0) {
+    csv_.samples.resize(0, csv_.header.size());
+
+    std::ifstream in(file_name_.c_str(), std::ios::binary);
+    if (!in)
+      return 0;
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    if (size < offset_)
+      reset();
+    if (size <= offset_)
+      return 0;
+
+    std::string buffer(size - offset_, '\0');
+    in.seekg(offset_);
+    in.read(&buffer[0], buffer.size());
+    buffer.resize(in.gcount());
+    const size_t last = buffer.rfind('\n');
+    if (last == std::string::npos)
+      return 0;
+
+    std::vector<double> values;
+    int new_rows = 0;
+    size_t pos = 0;
+    std::string line;
+    while (pos <= last) {
+      size_t eol = buffer.find('\n', pos);
+      size_t len = eol - pos;
+      if (len > 0 && buffer[eol - 1] == '\r')
+        --len;
+      line.assign(buffer, pos, len);
+      pos = eol + 1;
+      if (read_line(line, values, out))
+        ++new_rows;
+    }
+    offset_ += last + 1;
+
+    const int cols = csv_.header.size();
+    csv_.samples = Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic,
+                                            Eigen::Dynamic, Eigen::RowMajor>>(
+        values.data(), new_rows, cols);
+    return new_rows;
+  }
+
+  /**
+   * Read the draws appended to the file since last call into the
+   * specified chain, and update the number of warmup draws of the
+   * chain. The chains must have been constructed with the header of
+   * the file, available after a <code>read</code> that got past the
+   * header.
+   *
+   * @param chains chains to be extended
+   * @param chain index of chain
+   * @param out stream for messages, may be null
+   * @return number of new draws
+   */
+  template <class RNG>
+  int read(stan::mcmc::chains<RNG>& chains, int chain,
+           std::ostream* out = 0) {
+    int new_rows = read(out);
+    if (new_rows > 0)
+      chains.add(chain, csv_.samples);
+    if (chain < chains.num_chains())
+      chains.set_warmup(chain, num_warmup_rows());
+    return new_rows;
+  }
+
+  /**
+   * Metadata, header, adaptation and timing read so far, and the
+   * draws of last <code>read</code>.
+   */
+  const stan_csv& csv() const { return csv_; }
+
+  const std::vector<std::string>& header() const { return csv_.header; }
+
+  /**
+   * Byte offset up to which the file has been consumed.
+   */
+  std::streamoff offset() const { return offset_; }
+
+  /**
+   * Number of draws read so far.
+   */
+  int num_rows() const { return num_rows_; }
+
+  /**
+   * Number of warmup draws among those read so far: zero unless
+   * warmup draws are saved, the draws before the adaptation block
+   * once it is read, and otherwise the draws up to the number of
+   * warmup iterations in the metadata.
+   */
+  int num_warmup_rows() const {
+    if (!csv_.metadata.save_warmup)
+      return 0;
+    if (adaptation_read_)
+      return num_warmup_rows_;
+    const int thin = std::max<int>(csv_.metadata.thin, 1);
+    const int num_warmup = (csv_.metadata.num_warmup + thin - 1) / thin;
+    return std::min(num_rows_, num_warmup);
+  }
+
+  /**
+   * Return true if the adaptation block has been read.
+   */
+  bool adaptation_read() const {
+    return adaptation_read_ && !in_adaptation_;
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
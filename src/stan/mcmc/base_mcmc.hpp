@@ -19,6 +19,20 @@ class base_mcmc {
 
   virtual sample transition(sample& init_sample, callbacks::logger& logger) = 0;
 
+  /**
+   * Replace the sample by the next state of the chain. Samplers that
+   * keep their state override this to swap the parameter vector in and
+   * out of the sample instead of copying it; the default returns
+   * <code>transition</code> into the sample.
+   *
+   * @param[in,out] s sample, the initial state on input and the new
+   *   state on output
+   * @param[in,out] logger logger for messages
+   */
+  virtual void transition_in_place(sample& s, callbacks::logger& logger) {
+    s = transition(s, logger);
+  }
+
   virtual void get_sampler_param_names(std::vector<std::string>& names) {}
 
   virtual void get_sampler_params(std::vector<double>& values) {}
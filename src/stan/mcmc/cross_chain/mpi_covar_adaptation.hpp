@@ -86,6 +86,14 @@ public:
   virtual void restart() {
     // estimator.restart();
   }
+
+  /*
+   * Draws are exchanged by one collective per draw, so all the
+   * chains must learn the metric after the same draw, and at
+   * most <code>window_size</code> draws can be pending. Neither
+   * holds in quorum mode.
+   */
+  virtual bool supports_quorum() const { return false; }
 #else
   public:
     mpi_covar_adaptation(int n_params, int num_chains, int num_iterations, int window_size)
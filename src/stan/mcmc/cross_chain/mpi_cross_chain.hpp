@@ -5,7 +5,9 @@
 #include <boost/regex.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
 #include <stan/mcmc/base_mcmc.hpp>
+#include <stan/mcmc/sample.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_unit_e_nuts.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
@@ -53,6 +55,15 @@ namespace util {
     static void write_num_warmup(Sampler& sampler,
                                  callbacks::writer& sample_writer,
                                  int num_thin, int num_warmup) {}
+
+    static bool end_sampling(Sampler& sampler, const mcmc::sample& s,
+                             callbacks::logger& logger) { return false; }
+
+    static void write_num_samples(Sampler& sampler,
+                                  callbacks::writer& sample_writer) {}
+
+    static void write_num_culled(Sampler& sampler,
+                                 callbacks::writer& sample_writer) {}
   };
 
   /*
@@ -74,6 +85,21 @@ namespace util {
                                  int num_thin, int num_warmup) {
       sampler.write_num_cross_chain_warmup(sample_writer, num_thin, num_warmup);
     }
+
+    static bool end_sampling(Sampler& sampler, const mcmc::sample& s,
+                             callbacks::logger& logger) {
+      return sampler.end_cross_chain_sampling(s.log_prob(), s.cont_params(), logger);
+    }
+
+    static void write_num_samples(Sampler& sampler,
+                                  callbacks::writer& sample_writer) {
+      sampler.write_num_cross_chain_samples(sample_writer);
+    }
+
+    static void write_num_culled(Sampler& sampler,
+                                 callbacks::writer& sample_writer) {
+      sampler.write_num_cross_chain_culled(sample_writer);
+    }
   };
 #endif
 
@@ -95,6 +121,24 @@ namespace util {
       mpi_cross_chain_impl<Sampler, has_cross_chain_warmup<Sampler>::value>::
         write_num_warmup(sampler, sample_writer, num_thin, num_warmup);
     }
+
+    static bool end_sampling(Sampler& sampler, const mcmc::sample& s,
+                             callbacks::logger& logger) {
+      return mpi_cross_chain_impl<Sampler, has_cross_chain_warmup<Sampler>::value>::
+        end_sampling(sampler, s, logger);
+    }
+
+    static void write_num_samples(Sampler& sampler,
+                                  callbacks::writer& sample_writer) {
+      mpi_cross_chain_impl<Sampler, has_cross_chain_warmup<Sampler>::value>::
+        write_num_samples(sampler, sample_writer);
+    }
+
+    static void write_num_culled(Sampler& sampler,
+                                 callbacks::writer& sample_writer) {
+      mpi_cross_chain_impl<Sampler, has_cross_chain_warmup<Sampler>::value>::
+        write_num_culled(sampler, sample_writer);
+    }
   };
 
 
@@ -7,6 +7,7 @@
 #include <stan/mcmc/stepsize_covar_adapter.hpp>
 #include <stan/mcmc/cross_chain/mpi_var_adaptation.hpp>
 #include <stan/mcmc/cross_chain/mpi_covar_adaptation.hpp>
+#include <stan/mcmc/cross_chain/mpi_cross_chain_monitor.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
 #include <stan/analyze/mcmc/autocovariance.hpp>
 #include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
@@ -15,8 +16,12 @@
 #include <boost/accumulators/statistics/mean.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
 #include <boost/accumulators/statistics/count.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <algorithm>
 #include <string>
 #include <chrono>
+#include <limits>
 
 #ifdef MPI_ADAPTED_WARMUP
 #include <stan/math/torsten/mpi/session.hpp>
@@ -46,9 +51,80 @@ namespace mcmc {
                                          boost::accumulators::features<boost::accumulators::tag::count> > draw_count_acc_;
     Eigen::ArrayXd rhat_;
     Eigen::ArrayXd ess_;
-    mpi_metric_adaptation* var_adapt;
+    mpi_metric_adaptation* var_adapt = nullptr;
+
+    /// number of chains needed to evaluate a window
+    int quorum_;
+    bool quorum_synced_;
+    std::chrono::steady_clock::time_point warmup_start_;
+    Eigen::MatrixXd window_arrival_;
+
+    /// quorum mode: window data sent by a non-root chain
+    std::vector<std::vector<double>> quorum_send_buf_;
+    std::vector<MPI_Request> quorum_send_req_;
+
+    /// quorum mode: window data posted for receiving by rank 0, per window and chain
+    std::vector<std::vector<std::vector<double>>> quorum_recv_buf_;
+    std::vector<std::vector<MPI_Request>> quorum_recv_req_;
+    std::vector<MPI_Request> quorum_decision_reqs_;
+
+    /// pooled ESS monitor of post-warmup draws
+    mpi_cross_chain_monitor sampling_monitor_;
+
+    /// population warmup: iterations between culls, zero disables
+    int cull_interval_ = 0;
+    double cull_lp_threshold_ = 4.0;
+    double cull_accept_ratio_ = 0.5;
+    int num_culled_ = 0;
+    boost::accumulators::accumulator_set<double,
+                                         boost::accumulators::stats<boost::accumulators::tag::mean, // NOLINT
+                                                                    boost::accumulators::tag::variance>> cull_lp_acc_; // NOLINT
+    boost::accumulators::accumulator_set<double,
+                                         boost::accumulators::stats<boost::accumulators::tag::mean>> cull_accept_acc_; // NOLINT
+
+    /*
+     * scale of the random perturbation of a cloned chain: one
+     * leapfrog step of the donor in each coordinate.
+     */
+    static Eigen::VectorXd clone_scale(const Eigen::VectorXd& inv_e_metric) {
+      return inv_e_metric.array().sqrt();
+    }
+
+    static Eigen::VectorXd clone_scale(const Eigen::MatrixXd& inv_e_metric) {
+      return inv_e_metric.diagonal().array().sqrt();
+    }
+
+    /*
+     * median of the values that are not NaN.
+     */
+    static double median(std::vector<double> x) {
+      x.erase(std::remove_if(x.begin(), x.end(), [](double v) { return std::isnan(v); }),
+              x.end());
+      if (x.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+      }
+      std::sort(x.begin(), x.end());
+      size_t n = x.size();
+      return n % 2 == 1 ? x[n / 2] : 0.5 * (x[n / 2 - 1] + x[n / 2]);
+    }
+    /*
+     * drop the lp__ history of a culled chain. The window statistics
+     * restart from the clone, and the lp__ draws of the current window
+     * are set to NaN, so that a window holding draws of the replaced
+     * chain gets a NaN ESS and is never chosen as adapted.
+     */
+    inline void clear_cross_chain_lp_draws() {
+      lp_acc_.clear();
+      lp_acc_.resize(max_num_windows_);
+      std::fill(lp_draws_.begin(), lp_draws_.end(),
+                std::numeric_limits<double>::quiet_NaN());
+    }
   public:
     const static int nd_win = 2;
+    const static int quorum_decision_tag = 32767;
+    const static int cull_tag = 32766;
+    /// statistics of a chain compared when culling: lp__ mean and sd, mean acceptance
+    const static int nd_cull = 3;
 
     mpi_cross_chain_adapter() = default;
 
@@ -70,7 +146,12 @@ namespace mcmc {
       lp_acc_(max_num_windows_),
       draw_count_acc_(),
       rhat_(Eigen::ArrayXd::Zero(max_num_windows_)),
-      ess_(Eigen::ArrayXd::Zero(max_num_windows_))
+      ess_(Eigen::ArrayXd::Zero(max_num_windows_)),
+      quorum_(num_chains),
+      quorum_synced_(false),
+      warmup_start_(std::chrono::steady_clock::now()),
+      window_arrival_(Eigen::MatrixXd::Constant(max_num_windows_, num_chains,
+                                                std::numeric_limits<double>::quiet_NaN()))
     {}
 
     inline void set_cross_chain_metric_adaptation(mpi_metric_adaptation* ptr) {var_adapt = ptr;}
@@ -95,6 +176,301 @@ namespace mcmc {
       draw_count_acc_ = {};
       rhat_ = Eigen::ArrayXd::Zero(max_num_windows_);
       ess_ = Eigen::ArrayXd::Zero(max_num_windows_);
+      quorum_ = num_chains;
+      quorum_synced_ = false;
+      warmup_start_ = std::chrono::steady_clock::now();
+      window_arrival_ = Eigen::MatrixXd::Constant(max_num_windows_, num_chains,
+                                                  std::numeric_limits<double>::quiet_NaN());
+      quorum_send_buf_.clear();
+      quorum_send_req_.clear();
+      quorum_recv_buf_.clear();
+      quorum_recv_req_.clear();
+      quorum_decision_reqs_.clear();
+      num_culled_ = 0;
+      cull_lp_acc_ = {};
+      cull_accept_acc_ = {};
+    }
+
+    /**
+     * Cull stuck chains during the initial buffer of warmup, before
+     * the cross-chain windows are evaluated. Every
+     * <code>interval</code> iterations of the initial buffer, rank 0
+     * compares the chains' lp__ and acceptance statistics over the
+     * last <code>interval</code> iterations. A chain is an outlier if
+     * its mean lp__ is more than <code>lp_threshold</code> times the
+     * median within-chain standard deviation of lp__ below the median
+     * of the chain means, or if its mean acceptance statistic is less
+     * than <code>accept_ratio</code> times the median of the chains.
+     * Each outlier is replaced by a perturbed copy of a healthy chain,
+     * healthiest first: the donor's unconstrained parameters, step
+     * size and step size adaptation state. Nothing is culled unless
+     * at least half of the chains are healthy. Must be called after
+     * <code>set_cross_chain_adaptation_params</code>.
+     *
+     * @param interval number of iterations between culls, zero
+     *                 disables culling.
+     * @param lp_threshold lp__ threshold in within-chain standard
+     *                     deviations.
+     * @param accept_ratio acceptance threshold relative to the median.
+     */
+    inline void set_cross_chain_culling(int interval, double lp_threshold = 4.0,
+                                        double accept_ratio = 0.5) {
+      cull_interval_ = interval > 0 ? interval : 0;
+      cull_lp_threshold_ = lp_threshold;
+      cull_accept_ratio_ = accept_ratio;
+      num_culled_ = 0;
+      cull_lp_acc_ = {};
+      cull_accept_acc_ = {};
+    }
+
+    inline bool use_cross_chain_culling() {
+      return use_cross_chain_adapt() && cull_interval_ > 0;
+    }
+
+    /*
+     * total number of chains replaced during warmup.
+     */
+    inline int num_cross_chain_culled() { return num_culled_; }
+
+    inline void
+    write_num_cross_chain_culled(callbacks::writer& sample_writer) {
+      if (use_cross_chain_culling()) {
+        sample_writer("num_culled = " + std::to_string(num_culled_));
+      }
+    }
+
+    /**
+     * Choose, in rank 0, the chains to be culled and their donors.
+     *
+     * @param chain_stats <code>nd_cull</code> statistics of each
+     *                    chain: lp__ mean and standard deviation and
+     *                    mean acceptance statistic.
+     * @param lp_threshold see <code>set_cross_chain_culling</code>
+     * @param accept_ratio see <code>set_cross_chain_culling</code>
+     *
+     * @return donor of each chain, -1 for chains that are kept.
+     */
+    static std::vector<int>
+    find_cull_donors(const std::vector<double>& chain_stats,
+                     double lp_threshold, double accept_ratio) {
+      const int n_chains = chain_stats.size() / nd_cull;
+      std::vector<double> lp_mean(n_chains), lp_sd(n_chains), accept(n_chains);
+      for (int chain = 0; chain < n_chains; ++chain) {
+        lp_mean[chain] = chain_stats[nd_cull * chain];
+        lp_sd[chain] = chain_stats[nd_cull * chain + 1];
+        accept[chain] = chain_stats[nd_cull * chain + 2];
+      }
+      const double lp_bound = median(lp_mean) - lp_threshold * median(lp_sd);
+      const double accept_bound = accept_ratio * median(accept);
+
+      std::vector<int> healthy;
+      std::vector<int> outlier;
+      for (int chain = 0; chain < n_chains; ++chain) {
+        if (lp_mean[chain] < lp_bound || accept[chain] < accept_bound
+            || std::isnan(lp_mean[chain]) || std::isnan(accept[chain])) {
+          outlier.push_back(chain);
+        } else {
+          healthy.push_back(chain);
+        }
+      }
+
+      std::vector<int> donor(n_chains, -1);
+      if (outlier.empty() || 2 * healthy.size() < static_cast<size_t>(n_chains)) {
+        return donor;
+      }
+      std::stable_sort(healthy.begin(), healthy.end(),
+                       [&lp_mean](int i, int j) { return lp_mean[i] > lp_mean[j]; });
+      for (size_t i = 0; i < outlier.size(); ++i) {
+        donor[outlier[i]] = healthy[i % healthy.size()];
+      }
+      return donor;
+    }
+
+    /**
+     * Add a warmup draw to the culling statistics and, at the end of
+     * a culling interval of the initial buffer, replace the current
+     * chain if it is an outlier, see
+     * <code>set_cross_chain_culling</code>. The metric is not
+     * transferred as it is not adapted during the initial buffer.
+     * The lp__ draws of a replaced chain are dropped from its cross-chain
+     * window statistics. Must be called after
+     * <code>add_cross_chain_sample</code>.
+     *
+     * @tparam T_metric metric type, <code>Eigen::VectorXd</code> or <code>Eigen::MatrixXd</code>
+     * @tparam RNG random number generator type
+     * @param lp lp__
+     * @param accept_stat acceptance statistic
+     * @param[in,out] q unconstrained parameters, replaced by the
+     *                donor's perturbed parameters if culled
+     * @param[in,out] stepsize nominal step size
+     * @param[in,out] stepsize_adapt step size adaptation
+     * @param inv_e_metric inverse metric, scales the perturbation
+     * @param rng random number generator for the perturbation
+     * @param logger logger for messages
+     *
+     * @return true if current chain is replaced.
+     */
+    template <typename T_metric, typename RNG>
+    inline bool cross_chain_cull(double lp, double accept_stat,
+                                 Eigen::VectorXd& q, double& stepsize,
+                                 stepsize_adaptation& stepsize_adapt,
+                                 const T_metric& inv_e_metric, RNG& rng,
+                                 callbacks::logger& logger) {
+      using boost::accumulators::tag::mean;
+      using boost::accumulators::tag::variance;
+      using stan::math::mpi::Session;
+      using stan::math::mpi::Communicator;
+
+      const int n = num_cross_chain_draws();
+      if (!use_cross_chain_culling() || is_adapted_ || n > init_buffer_) {
+        return false;
+      }
+      cull_lp_acc_(lp);
+      cull_accept_acc_(accept_stat);
+      if (n % cull_interval_ != 0) {
+        return false;
+      }
+
+      const int n_state = q.size() + 1 + stepsize_adaptation::state_size;
+      std::vector<double> state(n_state);
+      bool culled = false;
+      if (Session::is_in_inter_chain_comm(num_chains_)) {
+        const Communicator& comm = Session::inter_chain_comm(num_chains_);
+        std::vector<double> chain_stats{boost::accumulators::mean(cull_lp_acc_),
+                                        std::sqrt(boost::accumulators::variance(cull_lp_acc_)), // NOLINT
+                                        boost::accumulators::mean(cull_accept_acc_)};
+        std::vector<int> donor(num_chains_);
+        if (comm.rank() == 0) {
+          std::vector<double> all_stats(nd_cull * num_chains_);
+          MPI_Gather(chain_stats.data(), nd_cull, MPI_DOUBLE,
+                     all_stats.data(), nd_cull, MPI_DOUBLE, 0, comm.comm());
+          donor = find_cull_donors(all_stats, cull_lp_threshold_, cull_accept_ratio_);
+        } else {
+          MPI_Gather(chain_stats.data(), nd_cull, MPI_DOUBLE,
+                     NULL, 0, MPI_DOUBLE, 0, comm.comm());
+        }
+        MPI_Bcast(donor.data(), num_chains_, MPI_INT, 0, comm.comm());
+
+        /// donors send their state to the chains they replace
+        Eigen::Map<Eigen::VectorXd>(state.data(), q.size()) = q;
+        state[q.size()] = stepsize;
+        stepsize_adapt.get_state(state.data() + q.size() + 1);
+        std::vector<MPI_Request> send_req;
+        std::stringstream message;
+        int n_culled = 0;
+        for (int chain = 0; chain < num_chains_; ++chain) {
+          if (donor[chain] < 0) {
+            continue;
+          }
+          n_culled++;
+          message << " " << chain << "<-" << donor[chain];
+          if (donor[chain] == comm.rank()) {
+            send_req.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(state.data(), n_state, MPI_DOUBLE, chain, cull_tag,
+                      comm.comm(), &send_req.back());
+          }
+        }
+        culled = donor[comm.rank()] >= 0;
+        if (culled) {
+          std::vector<double> recv(n_state);
+          MPI_Recv(recv.data(), n_state, MPI_DOUBLE, donor[comm.rank()], cull_tag,
+                   comm.comm(), MPI_STATUS_IGNORE);
+          state.swap(recv);
+        }
+        MPI_Waitall(send_req.size(), send_req.data(), MPI_STATUSES_IGNORE);
+        num_culled_ += n_culled;
+
+        if (culled) {
+          boost::variate_generator<RNG&, boost::normal_distribution<> >
+            rand_gaus(rng, boost::normal_distribution<>());
+          Eigen::VectorXd scale = clone_scale(inv_e_metric);
+          for (int i = 0; i < q.size(); ++i) {
+            state[i] += state[q.size()] * scale(i) * rand_gaus();
+          }
+          clear_cross_chain_lp_draws();
+        }
+
+        if (comm.rank() == 0 && n_culled > 0) {
+          std::stringstream summary;
+          summary << "iteration: " << std::setw(3) << n << " culled " << n_culled
+                  << " / " << num_chains_ << " chains (chain<-donor):" << message.str();
+          logger.info(summary);
+        }
+      }
+
+      /// send the new state to intra-chain nodes
+      const Communicator& intra_comm = Session::intra_chain_comm(num_chains_);
+      MPI_Bcast(&culled, 1, MPI_C_BOOL, 0, intra_comm.comm());
+      if (culled) {
+        MPI_Bcast(state.data(), n_state, MPI_DOUBLE, 0, intra_comm.comm());
+        q = Eigen::Map<Eigen::VectorXd>(state.data(), q.size());
+        stepsize = state[q.size()];
+        stepsize_adapt.set_state(state.data() + q.size() + 1);
+      }
+
+      cull_lp_acc_ = {};
+      cull_accept_acc_ = {};
+      return culled;
+    }
+
+    /**
+     * Evaluate the cross-chain windows with the first
+     * <code>quorum</code> chains that reach them instead of waiting
+     * for all of them. Chains that have not reached a window when it
+     * is evaluated are folded in as their data arrives, and chains
+     * only synchronize (to learn the metric and the stepsize) once
+     * warmup is found converged or the last window is reached. A
+     * quorum that is not less than the number of chains restores the
+     * default, fully synchronous, evaluation, and a quorum must
+     * have at least two chains. Must be called after
+     * <code>set_cross_chain_adaptation_params</code>.
+     *
+     * A metric adaptation that does not support quorum mode, such
+     * as the dense one, which exchanges every draw, also restores
+     * the default evaluation.
+     *
+     * @param quorum number of chains needed to evaluate a window.
+     */
+    inline void set_cross_chain_quorum(int quorum) {
+      quorum_ = (quorum > 1 && quorum < num_chains_) ? quorum : num_chains_;
+    }
+
+    inline int cross_chain_quorum() { return quorum_; }
+
+    inline bool use_cross_chain_quorum() {
+      return quorum_ < num_chains_
+        && (var_adapt == nullptr || var_adapt -> supports_quorum());
+    }
+
+    /**
+     * A chain synchronizes at the end of its first window after the
+     * decision is sent, so a chain lagging behind rank 0 may not have
+     * reached the window the decision is based on. Restrict the
+     * decision to the windows the chain has reached.
+     *
+     * @param adapted_win adapted window id sent by rank 0, see
+     * <code>cross_chain_adapted_window</code>.
+     * @param win_count number of active windows of current chain
+     *
+     * @return adapted window id whose window is less than
+     * <code>win_count</code>.
+     */
+    static int clamp_quorum_window(int adapted_win, int win_count) {
+      if (adapted_win >= 0) {
+        return std::min(adapted_win, win_count - 1);
+      }
+      return std::max(adapted_win, -win_count);
+    }
+
+    /**
+     * Wall time, in seconds since the start of its warmup, at which
+     * each chain reached the end of each window. Row <code>i</code>
+     * is for window <code>i + 1</code> and column <code>j</code> for
+     * chain <code>j</code>. Entries of chains whose data has not
+     * arrived are NaN. Only filled in rank 0.
+     */
+    inline const Eigen::MatrixXd& cross_chain_window_arrival_times() {
+      return window_arrival_;
     }
 
     inline int max_num_windows() {return max_num_windows_;}
@@ -165,9 +541,10 @@ namespace mcmc {
      */
     inline double compute_effective_sample_size(int win, int win_count,
                                                 const Eigen::MatrixXd& all_lp_draws) {
-      std::vector<const double*> draws(num_chains_);
+      const int n_chains = all_lp_draws.cols();
+      std::vector<const double*> draws(n_chains);
       size_t num_draws = (win_count - win) * window_size_;
-      for (int chain = 0; chain < num_chains_; ++chain) {
+      for (int chain = 0; chain < n_chains; ++chain) {
         draws[chain] = &all_lp_draws(win * window_size_, chain);
       }
       return stan::analyze::compute_effective_sample_size(draws, num_draws);
@@ -219,6 +596,36 @@ namespace mcmc {
       logger.info(message);
     }
 
+    /**
+     * Data of current chain to be sent at the end of a window:
+     * - mean for window 1, 1+2, 1+2+3, ...
+     * - variance for window 1, 1+2, 1+2+3, ...
+     * - lp__ draws in the latest window
+     *
+     * @param win_count number of active windows
+     */
+    inline std::vector<double> cross_chain_window_data(int win_count) {
+      std::vector<double> chain_gather(nd_win * win_count + window_size_, 0.0);
+      for (int win = 0; win < win_count; ++win) {
+        int num_draws = (win_count - win) * window_size_;
+        double unbiased_var_scale = num_draws / (num_draws - 1.0);
+        chain_gather[nd_win * win] = boost::accumulators::mean(lp_acc_[win]);
+        chain_gather[nd_win * win + 1] = boost::accumulators::variance(lp_acc_[win]) *
+          unbiased_var_scale;
+      }
+      std::copy(lp_draws_.begin(), lp_draws_.end(),
+                chain_gather.begin() + nd_win * win_count);
+      return chain_gather;
+    }
+
+    /*
+     * seconds since the start of warmup of current chain.
+     */
+    inline double warmup_elapsed_time() {
+      std::chrono::duration<double> t = std::chrono::steady_clock::now() - warmup_start_;
+      return t.count();
+    }
+
     /**
      * Gather data from chains. Get from each chain:
      * - mean for window 1, 1+2, 1+2+3, ...
@@ -252,16 +659,8 @@ namespace mcmc {
           /**
            * prepare data to be gathered in each chain
            */
-          std::vector<double> chain_gather(n_gather, 0.0);
-          for (int win = 0; win < win_count; ++win) {
-            int num_draws = (win_count - win) * window_size_;
-            double unbiased_var_scale = num_draws / (num_draws - 1.0);
-            chain_gather[nd_win * win] = boost::accumulators::mean(lp_acc_[win]);
-            chain_gather[nd_win * win + 1] = boost::accumulators::variance(lp_acc_[win]) *
-              unbiased_var_scale;
-          }
-          std::copy(lp_draws_.begin(), lp_draws_.end(),
-                    chain_gather.begin() + nd_win * win_count);
+          std::vector<double> chain_gather(cross_chain_window_data(win_count));
+          double arrival = warmup_elapsed_time();
 
           if (comm.rank() == 0) {
             /**
@@ -278,9 +677,17 @@ namespace mcmc {
                 all_lp_draws(begin_row + i, chain) = all_chain_gather[j + i];
               }
             }
+            std::vector<double> all_arrival(num_chains_);
+            MPI_Gather(&arrival, 1, MPI_DOUBLE,
+                       all_arrival.data(), 1, MPI_DOUBLE, 0, comm.comm());
+            for (int chain = 0; chain < num_chains_; ++chain) {
+              window_arrival_(win_count - 1, chain) = all_arrival[chain];
+            }
           } else {
             MPI_Gather(chain_gather.data(), n_gather, MPI_DOUBLE,
                        NULL, 0, MPI_DOUBLE, 0, comm.comm());
+            MPI_Gather(&arrival, 1, MPI_DOUBLE,
+                       NULL, 0, MPI_DOUBLE, 0, comm.comm());
           }
         }
       }
@@ -312,6 +719,72 @@ namespace mcmc {
       return new_stepsize;
     }
 
+    /**
+     * find, in rank 0, adapted window that has maximum ESS and also
+     * meets rhat & ess target.
+     *
+     * @param n_gather number of gathered data from each chain
+     * @param n_chains number of chains in gathered data
+     * @param all_chain_gather gathered data of all the chains
+     * @param all_lp_draws lp__ draws, one column for each chain
+     * @param logger logger for messages
+     *
+     * @return adapted window id, see
+     * <code>cross_chain_adapted_window</code>.
+     */
+    inline int find_adapted_window(int n_gather, int n_chains,
+                                   const std::vector<double>& all_chain_gather,
+                                   const Eigen::MatrixXd& all_lp_draws,
+                                   callbacks::logger& logger) {
+      using boost::accumulators::accumulator_set;
+      using boost::accumulators::stats;
+      using boost::accumulators::tag::mean;
+      using boost::accumulators::tag::variance;
+
+      const int win_count = num_active_cross_chain_windows();
+      int adapted_win = -999;
+      rhat_.setZero();
+      ess_.setZero();
+      double max_ess = 0.0;
+
+      /**
+       * loop through windows to check convergence
+       */
+      for (int win = 0; win < win_count; ++win) {
+        bool win_adapted;
+        accumulator_set<double, stats<variance>> acc_chain_mean;
+        accumulator_set<double, stats<mean>> acc_chain_var;
+        accumulator_set<double, stats<mean>> acc_step;
+        Eigen::VectorXd chain_mean(n_chains);
+        Eigen::VectorXd chain_var(n_chains);
+        for (int chain = 0; chain < n_chains; ++chain) {
+          chain_mean(chain) = all_chain_gather[chain * n_gather + nd_win * win];
+          acc_chain_mean(chain_mean(chain));
+          chain_var(chain) = all_chain_gather[chain * n_gather + nd_win * win + 1];
+          acc_chain_var(chain_var(chain));
+        }
+        size_t num_draws = (win_count - win) * window_size_;
+        double var_between = num_draws * boost::accumulators::variance(acc_chain_mean)
+          * n_chains / (n_chains - 1);
+        double var_within = boost::accumulators::mean(acc_chain_var);
+        rhat_(win) = sqrt((var_between / var_within + num_draws - 1) / num_draws);
+        ess_[win] = compute_effective_sample_size(win, win_count, all_lp_draws);
+        win_adapted = rhat_(win) < target_rhat_ && ess_[win] > target_ess_;
+
+        msg_adaptation(win, logger);
+
+        /// get the win with the largest ESS
+        if(ess_[win] > max_ess) {
+          max_ess = ess_[win];
+          adapted_win = -(win + 1);
+          if (win_adapted) {
+            adapted_win = std::abs(adapted_win) - 1;
+          }
+        }
+      }
+      return adapted_win;
+    }
+
     /** 
      * find adapted window that has maximum ESS and also meets rhat &
      * ess target
@@ -336,51 +809,276 @@ namespace mcmc {
       using math::mpi::Session;
 
       const Communicator& comm = Session::inter_chain_comm(num_chains_);
-      const int win_count = num_active_cross_chain_windows();
       int adapted_win = -999;
       if (comm.rank() == 0) {
-        rhat_.setZero();
-        ess_.setZero();
-        double max_ess = 0.0;
+        adapted_win = find_adapted_window(n_gather, num_chains_, all_chain_gather,
+                                          all_lp_draws, logger);
+      }
+      MPI_Bcast(&adapted_win, 1, MPI_INT, 0, comm.comm());      
+      return adapted_win;
+    }
+
+    /*
+     * rank 0 stores lp__ draws and arrival time of a chain that
+     * has reached the end of window <code>win_count</code>.
+     */
+    inline void fold_quorum_window_data(int chain, int win_count,
+                                        const std::vector<double>& data) {
+      int begin_row = (win_count - 1) * window_size_;
+      int j = nd_win * win_count;
+      for (int i = 0; i < window_size_; ++i) {
+        all_lp_draws_(begin_row + i, chain) = data[j + i];
+      }
+      window_arrival_(win_count - 1, chain) = data.back();
+    }
 
-        /**
-         * loop through windows to check convergence
-         */
+    /**
+     * In rank 0, post receiving window data of all the chains for
+     * current window, fold in data from chains that have reached
+     * previous windows since last evaluation, then wait until a
+     * quorum of chains (including rank 0) reach current window and
+     * evaluate convergence based on these chains only.
+     *
+     * @param win_count number of active windows
+     * @param comm inter-chain communicator
+     * @param logger logger for messages
+     *
+     * @return adapted window id, see
+     * <code>cross_chain_adapted_window</code>.
+     */
+    inline int quorum_adapted_window(int win_count,
+                                     const stan::math::mpi::Communicator& comm,
+                                     callbacks::logger& logger) {
+      const int n_gather = nd_win * win_count + window_size_;
+      if (all_lp_draws_.rows() != window_size_ * max_num_windows_
+          || all_lp_draws_.cols() != num_chains_) {
+        all_lp_draws_ = Eigen::MatrixXd::Constant(window_size_ * max_num_windows_, num_chains_,
+                                                  std::numeric_limits<double>::quiet_NaN());
+      }
+
+      quorum_recv_buf_.resize(win_count);
+      quorum_recv_req_.resize(win_count);
+      std::vector<std::vector<double>>& buf = quorum_recv_buf_[win_count - 1];
+      std::vector<MPI_Request>& req = quorum_recv_req_[win_count - 1];
+      buf.resize(num_chains_);
+      req.assign(num_chains_, MPI_REQUEST_NULL);
+      for (int chain = 1; chain < num_chains_; ++chain) {
+        buf[chain].resize(n_gather + 1);
+        MPI_Irecv(buf[chain].data(), n_gather + 1, MPI_DOUBLE, chain, win_count,
+                  comm.comm(), &req[chain]);
+      }
+      buf[0] = cross_chain_window_data(win_count);
+      buf[0].push_back(warmup_elapsed_time());
+
+      /// fold in laggards that have reached previous windows
+      for (int win = 0; win < win_count - 1; ++win) {
+        for (int chain = 1; chain < num_chains_; ++chain) {
+          int flag = 0;
+          MPI_Test(&quorum_recv_req_[win][chain], &flag, MPI_STATUS_IGNORE);
+          if (flag && !quorum_recv_buf_[win][chain].empty()) {
+            fold_quorum_window_data(chain, win + 1, quorum_recv_buf_[win][chain]);
+            quorum_recv_buf_[win][chain] = std::vector<double>();
+          }
+        }
+      }
+
+      /// wait for quorum, then take all the chains that have arrived
+      std::vector<int> chains{0};
+      std::vector<int> index(num_chains_);
+      int n_done = 0;
+      while (static_cast<int>(chains.size()) < quorum_) {
+        MPI_Waitsome(num_chains_, req.data(), &n_done, index.data(), MPI_STATUSES_IGNORE);
+        chains.insert(chains.end(), index.begin(), index.begin() + n_done);
+      }
+      MPI_Testsome(num_chains_, req.data(), &n_done, index.data(), MPI_STATUSES_IGNORE);
+      if (n_done != MPI_UNDEFINED) {
+        chains.insert(chains.end(), index.begin(), index.begin() + n_done);
+      }
+      std::sort(chains.begin(), chains.end());
+
+      /// a chain in quorum has sent all previous windows
+      for (int chain : chains) {
         for (int win = 0; win < win_count; ++win) {
-          bool win_adapted;
-          accumulator_set<double, stats<variance>> acc_chain_mean;
-          accumulator_set<double, stats<mean>> acc_chain_var;
-          accumulator_set<double, stats<mean>> acc_step;
-          Eigen::VectorXd chain_mean(num_chains_);
-          Eigen::VectorXd chain_var(num_chains_);
-          for (int chain = 0; chain < num_chains_; ++chain) {
-            chain_mean(chain) = all_chain_gather[chain * n_gather + nd_win * win];
-            acc_chain_mean(chain_mean(chain));
-            chain_var(chain) = all_chain_gather[chain * n_gather + nd_win * win + 1];
-            acc_chain_var(chain_var(chain));
+          MPI_Wait(&quorum_recv_req_[win][chain], MPI_STATUS_IGNORE);
+          if (!quorum_recv_buf_[win][chain].empty()) {
+            fold_quorum_window_data(chain, win + 1, quorum_recv_buf_[win][chain]);
+            if (win < win_count - 1) {
+              quorum_recv_buf_[win][chain] = std::vector<double>();
+            }
+          }
+        }
+      }
+
+      const int n_chains = chains.size();
+      std::vector<double> quorum_gather(n_gather * n_chains);
+      Eigen::MatrixXd quorum_lp_draws(window_size_ * win_count, n_chains);
+      double first_arrival = std::numeric_limits<double>::max();
+      double last_arrival = 0.0;
+      for (int i = 0; i < n_chains; ++i) {
+        const std::vector<double>& data = buf[chains[i]];
+        std::copy(data.begin(), data.begin() + n_gather, quorum_gather.begin() + n_gather * i);
+        quorum_lp_draws.col(i) = all_lp_draws_.col(chains[i]).head(window_size_ * win_count);
+        first_arrival = std::min(first_arrival, data.back());
+        last_arrival = std::max(last_arrival, data.back());
+        buf[chains[i]] = std::vector<double>();
+      }
+
+      std::stringstream message;
+      message << "window " << win_count << " quorum: " << n_chains << " / " << num_chains_
+              << " chains, arrival time: " << std::setprecision(3) << std::fixed
+              << first_arrival << " - " << last_arrival << " seconds";
+      logger.info(message);
+
+      return find_adapted_window(n_gather, n_chains, quorum_gather, quorum_lp_draws, logger);
+    }
+
+    /**
+     * In a non-root chain, send window data to rank 0 without
+     * waiting for it to be received, then check if rank 0 has
+     * sent a decision to synchronize the chains. At the last
+     * window the chain waits for the decision.
+     *
+     * @param win_count number of active windows
+     * @param comm inter-chain communicator
+     * @param[out] adapted_win adapted window id sent by rank 0, if any
+     *
+     * @return true if a decision is received.
+     */
+    inline bool post_quorum_window_data(int win_count,
+                                        const stan::math::mpi::Communicator& comm,
+                                        int& adapted_win) {
+      quorum_send_buf_.push_back(cross_chain_window_data(win_count));
+      quorum_send_buf_.back().push_back(warmup_elapsed_time());
+      quorum_send_req_.push_back(MPI_REQUEST_NULL);
+      MPI_Isend(quorum_send_buf_.back().data(), quorum_send_buf_.back().size(), MPI_DOUBLE,
+                0, win_count, comm.comm(), &quorum_send_req_.back());
+
+      int flag = 0;
+      if (win_count == max_num_windows_) {
+        MPI_Probe(0, quorum_decision_tag, comm.comm(), MPI_STATUS_IGNORE);
+        flag = 1;
+      } else {
+        MPI_Iprobe(0, quorum_decision_tag, comm.comm(), &flag, MPI_STATUS_IGNORE);
+      }
+      if (flag) {
+        MPI_Recv(&adapted_win, 1, MPI_INT, 0, quorum_decision_tag, comm.comm(),
+                 MPI_STATUS_IGNORE);
+      }
+      return flag;
+    }
+
+    /**
+     * Complete all the pending window data communication when the
+     * chains synchronize. Rank 0 receives the data sent by laggards
+     * and cancels receiving windows that will never be sent.
+     *
+     * @param comm inter-chain communicator
+     */
+    inline void complete_quorum_communication(const stan::math::mpi::Communicator& comm) {
+      int n_sent = quorum_send_req_.size();
+      if (comm.rank() == 0) {
+        std::vector<int> all_sent(num_chains_);
+        MPI_Gather(&n_sent, 1, MPI_INT, all_sent.data(), 1, MPI_INT, 0, comm.comm());
+        const int n_posted = quorum_recv_req_.size();
+        for (int chain = 1; chain < num_chains_; ++chain) {
+          for (int win = 0; win < std::max(n_posted, all_sent[chain]); ++win) {
+            if (win >= n_posted) {
+              std::vector<double> data(nd_win * (win + 1) + window_size_ + 1);
+              MPI_Recv(data.data(), data.size(), MPI_DOUBLE, chain, win + 1, comm.comm(),
+                       MPI_STATUS_IGNORE);
+            } else if (win >= all_sent[chain]) {
+              MPI_Cancel(&quorum_recv_req_[win][chain]);
+              MPI_Wait(&quorum_recv_req_[win][chain], MPI_STATUS_IGNORE);
+            } else {
+              MPI_Wait(&quorum_recv_req_[win][chain], MPI_STATUS_IGNORE);
+              if (!quorum_recv_buf_[win][chain].empty()) {
+                window_arrival_(win, chain) = quorum_recv_buf_[win][chain].back();
+              }
+            }
           }
-          size_t num_draws = (win_count - win) * window_size_;
-          double var_between = num_draws * boost::accumulators::variance(acc_chain_mean)
-            * num_chains_ / (num_chains_ - 1);
-          double var_within = boost::accumulators::mean(acc_chain_var);
-          rhat_(win) = sqrt((var_between / var_within + num_draws - 1) / num_draws);
-          ess_[win] = compute_effective_sample_size(win, win_count, all_lp_draws);
-          win_adapted = rhat_(win) < target_rhat_ && ess_[win] > target_ess_;
-
-          msg_adaptation(win, logger);
-
-          /// get the win with the largest ESS
-          if(ess_[win] > max_ess) {
-            max_ess = ess_[win];
-            adapted_win = -(win + 1);
-            if (win_adapted) {
-              adapted_win = std::abs(adapted_win) - 1;
+        }
+        MPI_Waitall(quorum_decision_reqs_.size(), quorum_decision_reqs_.data(),
+                    MPI_STATUSES_IGNORE);
+      } else {
+        MPI_Gather(&n_sent, 1, MPI_INT, NULL, 0, MPI_INT, 0, comm.comm());
+        MPI_Waitall(n_sent, quorum_send_req_.data(), MPI_STATUSES_IGNORE);
+      }
+      quorum_send_buf_.clear();
+      quorum_send_req_.clear();
+      quorum_recv_buf_.clear();
+      quorum_recv_req_.clear();
+      quorum_decision_reqs_.clear();
+    }
+
+    /**
+     * Quorum version of <code>cross_chain_adaptation</code>. At the
+     * end of each window rank 0 evaluates convergence with a quorum
+     * of chains while the other chains keep sampling. Chains
+     * synchronize to learn the metric only after rank 0 finds
+     * warmup converged or reaches the last window, and each chain
+     * does so at the end of its first window after the decision is
+     * sent.
+     *
+     * @tparam T_metric metric type, <code>Eigen::VectorXd</code> or <code>Eigen::MatrixXd</code>
+     * @param[in,out] inv_e_metric inverse metric
+     * @param logger logger for messages
+     *
+     * @return true if chains are synchronized and the metric is
+     * updated.
+     */
+    template<typename T_metric>
+    inline bool cross_chain_quorum_adaptation(T_metric& inv_e_metric,
+                                              callbacks::logger& logger) {
+      using stan::math::mpi::Session;
+      using stan::math::mpi::Communicator;
+
+      if (is_adapted_ || quorum_synced_ || !is_cross_chain_adapt_window_end()) {
+        return false;
+      }
+
+      const int win_count = num_active_cross_chain_windows();
+      bool sync = false;
+      int adapted_win = -999;
+      if (Session::is_in_inter_chain_comm(num_chains_)) {
+        const Communicator& comm = Session::inter_chain_comm(num_chains_);
+        if (comm.rank() == 0) {
+          adapted_win = quorum_adapted_window(win_count, comm, logger);
+          sync = adapted_win >= 0 || win_count == max_num_windows_;
+          if (sync) {
+            quorum_decision_reqs_.assign(num_chains_, MPI_REQUEST_NULL);
+            for (int chain = 1; chain < num_chains_; ++chain) {
+              MPI_Isend(&adapted_win, 1, MPI_INT, chain, quorum_decision_tag, comm.comm(),
+                        &quorum_decision_reqs_[chain]);
             }
           }
+        } else {
+          sync = post_quorum_window_data(win_count, comm, adapted_win);
+          if (sync) {
+            adapted_win = clamp_quorum_window(adapted_win, win_count);
+          }
         }
       }
-      MPI_Bcast(&adapted_win, 1, MPI_INT, 0, comm.comm());      
-      return adapted_win;
+
+      const Communicator& intra_comm = Session::intra_chain_comm(num_chains_);
+      MPI_Bcast(&sync, 1, MPI_C_BOOL, 0, intra_comm.comm());
+      if (!sync) {
+        return false;
+      }
+
+      quorum_synced_ = true;
+      if (Session::is_in_inter_chain_comm(num_chains_)) {
+        const Communicator& comm = Session::inter_chain_comm(num_chains_);
+        complete_quorum_communication(comm);
+        set_cross_chain_adapted((adapted_win >= 0));
+
+        /// learn metric based on the window with max ESS
+        int max_ess_win = is_adapted_ ? adapted_win : (-adapted_win - 1);
+        var_adapt -> learn_metric(inv_e_metric, max_ess_win, win_count, comm);
+      }
+
+      MPI_Bcast(&is_adapted_, 1, MPI_C_BOOL, 0, intra_comm.comm());
+      MPI_Bcast(inv_e_metric.data(), inv_e_metric.size(), MPI_DOUBLE, 0, intra_comm.comm());
+      return true;
     }
 
     /*
@@ -404,6 +1102,10 @@ namespace mcmc {
       using stan::math::mpi::Session;
       using stan::math::mpi::Communicator;
 
+      if (use_cross_chain_quorum()) {
+        return cross_chain_quorum_adaptation(inv_e_metric, logger);
+      }
+
       auto t0 = std::chrono::high_resolution_clock::now();
       bool update = false;
 
@@ -459,6 +1161,52 @@ namespace mcmc {
     inline bool use_cross_chain_adapt() {
       return num_chains_ > 1;
     }
+
+    /**
+     * Stop sampling in all the chains once the pooled split ESS and
+     * Rhat of lp__ and of selected unconstrained parameters meet the
+     * target, checked every <code>check_interval</code> post-warmup
+     * iterations. Must be called after
+     * <code>set_cross_chain_adaptation_params</code>.
+     *
+     * @param check_interval number of iterations between checks,
+     *                       zero disables early stopping.
+     * @param target_ess target pooled ESS
+     * @param target_rhat target pooled Rhat
+     * @param index indices of monitored unconstrained parameters,
+     *              empty for all.
+     */
+    inline void set_cross_chain_sampling_target(int check_interval,
+                                                double target_ess, double target_rhat,
+                                                const std::vector<int>& index = {}) {
+      sampling_monitor_.set_target(num_chains_, check_interval,
+                                   target_ess, target_rhat, index);
+    }
+
+    /**
+     * Add a post-warmup draw and test if sampling should end.
+     *
+     * @param lp lp__
+     * @param q unconstrained parameters
+     * @param logger logger for messages
+     * @return true if all the chains should stop sampling.
+     */
+    inline bool end_cross_chain_sampling(double lp, const Eigen::VectorXd& q,
+                                         callbacks::logger& logger) {
+      sampling_monitor_.add_sample(lp, q);
+      return sampling_monitor_.end_sampling(logger);
+    }
+
+    /*
+     * actual number of post-warmup iterations when sampling can
+     * end early.
+     */
+    inline void
+    write_num_cross_chain_samples(callbacks::writer& sample_writer) {
+      if (sampling_monitor_.is_active()) {
+        sample_writer("num_samples = " + std::to_string(sampling_monitor_.num_draws()));
+      }
+    }
   };
 
 #else  // sequential version
@@ -471,8 +1219,23 @@ namespace mcmc {
                                                   int window_size,
                                                   int num_chains,
                                                   double target_rhat, double target_ess) {}
+
+    inline void set_cross_chain_quorum(int quorum) {}
+
+    inline void set_cross_chain_culling(int interval, double lp_threshold = 4.0,
+                                        double accept_ratio = 0.5) {}
+
+    inline int num_cross_chain_culled() { return 0; }
+
     inline void add_cross_chain_sample(double lp, const Eigen::VectorXd& q) {}
 
+    template <typename T_metric, typename RNG>
+    inline bool cross_chain_cull(double lp, double accept_stat,
+                                 Eigen::VectorXd& q, double& stepsize,
+                                 stepsize_adaptation& stepsize_adapt,
+                                 const T_metric& inv_e_metric, RNG& rng,
+                                 callbacks::logger& logger) { return false; }
+
     template<typename T_metric>
     inline bool cross_chain_adaptation(T_metric& inv_e_metric,
                                        callbacks::logger& logger) { return false; }
@@ -482,6 +1245,10 @@ namespace mcmc {
     inline double cross_chain_stepsize(double chain_stepsize) { return 0.0; }
 
     inline bool use_cross_chain_adapt() { return false; }
+
+    inline void set_cross_chain_sampling_target(int check_interval,
+                                                double target_ess, double target_rhat,
+                                                const std::vector<int>& index = {}) {}
   };
   
 #endif
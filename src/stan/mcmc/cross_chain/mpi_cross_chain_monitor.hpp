@@ -0,0 +1,211 @@
+#ifndef STAN_MCMC_MPI_CROSS_CHAIN_MONITOR_HPP
+#define STAN_MCMC_MPI_CROSS_CHAIN_MONITOR_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#ifdef MPI_ADAPTED_WARMUP
+#include <stan/math/torsten/mpi/session.hpp>
+#endif
+
+namespace stan {
+namespace mcmc {
+
+#ifdef MPI_ADAPTED_WARMUP
+  /**
+   * Monitor of pooled convergence of post-warmup draws across
+   * chains. Every <code>check_interval</code> iterations the draws
+   * of lp__ and of selected unconstrained parameters since last
+   * check are gathered to rank 0 of the inter-chain communicator,
+   * which computes pooled split ESS and split Rhat of each quantity
+   * over all the draws so far, and broadcasts whether the targets
+   * are met so that all the chains stop sampling at the same
+   * iteration.
+   */
+  class mpi_cross_chain_monitor {
+  protected:
+    int num_chains_;
+    int check_interval_;
+    double target_ess_;
+    double target_rhat_;
+    std::vector<int> index_;
+    int num_draws_;
+    std::vector<double> new_draws_;
+    std::vector<std::vector<double>> all_draws_;
+    Eigen::ArrayXd ess_;
+    Eigen::ArrayXd rhat_;
+
+  public:
+    mpi_cross_chain_monitor() :
+      num_chains_(1), check_interval_(0), target_ess_(0.0), target_rhat_(0.0),
+      num_draws_(0)
+    {}
+
+    /**
+     * Set target of pooled ESS & Rhat.
+     *
+     * @param num_chains number of chains
+     * @param check_interval number of iterations between checks,
+     *                       zero disables the monitor.
+     * @param target_ess target ESS of every monitored quantity
+     * @param target_rhat target Rhat of every monitored quantity
+     * @param index indices of unconstrained parameters to be
+     *              monitored along with lp__, empty for all.
+     */
+    inline void set_target(int num_chains, int check_interval,
+                           double target_ess, double target_rhat,
+                           const std::vector<int>& index) {
+      num_chains_ = num_chains;
+      check_interval_ = check_interval;
+      target_ess_ = target_ess;
+      target_rhat_ = target_rhat;
+      index_ = index;
+      num_draws_ = 0;
+      new_draws_.clear();
+      all_draws_.clear();
+    }
+
+    inline bool is_active() const {
+      return num_chains_ > 1 && check_interval_ > 0;
+    }
+
+    /*
+     * number of draws added since target is set.
+     */
+    inline int num_draws() const { return num_draws_; }
+
+    inline const Eigen::ArrayXd& ess() const { return ess_; }
+
+    inline const Eigen::ArrayXd& rhat() const { return rhat_; }
+
+    /**
+     * Add a post-warmup draw of current chain.
+     *
+     * @param lp lp__
+     * @param q unconstrained parameters
+     */
+    inline void add_sample(double lp, const Eigen::VectorXd& q) {
+      num_draws_++;
+      if (!is_active()) {
+        return;
+      }
+      new_draws_.push_back(lp);
+      if (index_.empty()) {
+        new_draws_.insert(new_draws_.end(), q.data(), q.data() + q.size());
+      } else {
+        for (int i : index_) {
+          new_draws_.push_back(q(i));
+        }
+      }
+    }
+
+    /**
+     * At check points, gather new draws from all the chains and
+     * test if pooled ESS & Rhat meet the target. Must be called by
+     * all the ranks after each post-warmup draw is added.
+     *
+     * @param logger logger for messages
+     * @return true if all the chains should stop sampling.
+     */
+    inline bool end_sampling(callbacks::logger& logger) {
+      using stan::math::mpi::Session;
+      using stan::math::mpi::Communicator;
+
+      if (!is_active() || num_draws_ % check_interval_ != 0) {
+        return false;
+      }
+
+      bool stop = false;
+      if (Session::is_in_inter_chain_comm(num_chains_)) {
+        const Communicator& comm = Session::inter_chain_comm(num_chains_);
+        const int n_gather = new_draws_.size();
+        if (comm.rank() == 0) {
+          std::vector<double> all_new_draws(n_gather * num_chains_);
+          MPI_Gather(new_draws_.data(), n_gather, MPI_DOUBLE,
+                     all_new_draws.data(), n_gather, MPI_DOUBLE, 0, comm.comm());
+          stop = check_target(all_new_draws, n_gather / check_interval_, logger);
+        } else {
+          MPI_Gather(new_draws_.data(), n_gather, MPI_DOUBLE,
+                     NULL, 0, MPI_DOUBLE, 0, comm.comm());
+        }
+        new_draws_.clear();
+        MPI_Bcast(&stop, 1, MPI_C_BOOL, 0, comm.comm());
+      }
+
+      const Communicator& intra_comm = Session::intra_chain_comm(num_chains_);
+      MPI_Bcast(&stop, 1, MPI_C_BOOL, 0, intra_comm.comm());
+      return stop;
+    }
+
+  protected:
+    /*
+     * In rank 0, append gathered draws and compute pooled ESS & Rhat.
+     */
+    inline bool check_target(const std::vector<double>& all_new_draws,
+                             int n_quantity, callbacks::logger& logger) {
+      const int n_gather = n_quantity * check_interval_;
+      all_draws_.resize(n_quantity * num_chains_);
+      for (int chain = 0; chain < num_chains_; ++chain) {
+        for (int i = 0; i < check_interval_; ++i) {
+          for (int j = 0; j < n_quantity; ++j) {
+            all_draws_[j * num_chains_ + chain].push_back(
+                all_new_draws[chain * n_gather + i * n_quantity + j]);
+          }
+        }
+      }
+
+      ess_.resize(n_quantity);
+      rhat_.resize(n_quantity);
+      std::vector<const double*> draws(num_chains_);
+      for (int j = 0; j < n_quantity; ++j) {
+        for (int chain = 0; chain < num_chains_; ++chain) {
+          draws[chain] = all_draws_[j * num_chains_ + chain].data();
+        }
+        ess_(j) = stan::analyze::compute_split_effective_sample_size(draws, num_draws_);
+        rhat_(j) = stan::analyze::compute_split_potential_scale_reduction(draws, num_draws_);
+      }
+
+      // NaN (e.g. constant draws) never meets the target
+      bool stop = (ess_ > target_ess_).all() && (rhat_ < target_rhat_).all();
+
+      std::stringstream message;
+      message << "iteration: " << std::setw(3) << num_draws_
+              << std::setprecision(4) << std::fixed
+              << " pooled min ESS: " << ess_.minCoeff()
+              << " max Rhat: " << rhat_.maxCoeff();
+      if (stop) {
+        message << " target reached";
+      }
+      logger.info(message);
+      return stop;
+    }
+  };
+
+#else  // sequential version
+  class mpi_cross_chain_monitor {
+    int num_draws_;
+  public:
+    mpi_cross_chain_monitor() : num_draws_(0) {}
+
+    inline void set_target(int num_chains, int check_interval,
+                           double target_ess, double target_rhat,
+                           const std::vector<int>& index) {}
+
+    inline bool is_active() const { return false; }
+
+    inline int num_draws() const { return num_draws_; }
+
+    inline void add_sample(double lp, const Eigen::VectorXd& q) { num_draws_++; }
+
+    inline bool end_sampling(callbacks::logger& logger) { return false; }
+  };
+#endif
+
+}
+}
+#endif
@@ -17,6 +17,13 @@ namespace mcmc {
 
     virtual void restart() {}
 
+    /*
+     * whether the metric can be learned by chains that reach the
+     * decision to learn it at different draws, as they do in
+     * quorum mode.
+     */
+    virtual bool supports_quorum() const { return true; }
+
 #ifdef MPI_ADAPTED_WARMUP
     virtual void learn_metric(Eigen::VectorXd& var, int win, int curr_win_count,
                               const stan::math::mpi::Communicator& comm)
@@ -0,0 +1,111 @@
+#ifndef STAN_MCMC_DELAYED_ACCEPTANCE_ADAPT_DELAYED_ACCEPTANCE_RWM_HPP
+#define STAN_MCMC_DELAYED_ACCEPTANCE_ADAPT_DELAYED_ACCEPTANCE_RWM_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/base_adapter.hpp>
+#include <stan/mcmc/stepsize_adaptation.hpp>
+#include <stan/mcmc/delayed_acceptance/delayed_acceptance_rwm.hpp>
+#include <stan/mcmc/delayed_acceptance/gaussian_adaptation.hpp>
+#include <stan/mcmc/delayed_acceptance/gaussian_surrogate.hpp>
+#include <cmath>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Delayed-acceptance random walk Metropolis with adaptive step size
+ * and adaptive proposal covariance. At the end of each slow
+ * adaptation window the proposal covariance is set to the covariance
+ * of the draws in the window, a Gaussian surrogate is refit to their
+ * mean and covariance, and the step size is reset to the optimal
+ * random walk scaling <code>2.38 / sqrt(d)</code> before dual
+ * averaging restarts. Surrogates that are not Gaussian are left
+ * unchanged. The surrogate is fixed after warmup, so the draws
+ * target the exact posterior.
+ *
+ * <p>The step size is adapted by dual averaging of the acceptance
+ * probability. Its target defaults to 0.234, the optimal acceptance
+ * rate of random walk Metropolis, instead of the NUTS target.
+ *
+ * <p>The counts of proposals and model evaluations are reset when
+ * adaptation ends, so that they cover the sampling phase.
+ */
+template <class Model, class Surrogate, class BaseRNG>
+class adapt_delayed_acceptance_rwm
+    : public delayed_acceptance_rwm<Model, Surrogate, BaseRNG>,
+      public base_adapter {
+ public:
+  adapt_delayed_acceptance_rwm(const Model& model, Surrogate& surrogate,
+                               BaseRNG& rng)
+      : delayed_acceptance_rwm<Model, Surrogate, BaseRNG>(model, surrogate,
+                                                          rng),
+        gaussian_adaptation_(model.num_params_r()) {
+    this->stepsize_adaptation_.set_delta(default_delta);
+  }
+
+  /**
+   * default target acceptance probability
+   */
+  static constexpr double default_delta = 0.234;
+
+  ~adapt_delayed_acceptance_rwm() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s = delayed_acceptance_rwm<Model, Surrogate, BaseRNG>::transition(
+        init_sample, logger);
+
+    if (this->adapt_flag_) {
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+
+      Eigen::VectorXd mean;
+      Eigen::MatrixXd covar;
+      bool update
+          = this->gaussian_adaptation_.learn_gaussian(mean, covar, this->z_.q);
+
+      if (update) {
+        this->set_proposal_covariance(covar);
+        fit_surrogate(this->surrogate_, mean, covar);
+        this->reset_surrogate();
+
+        this->nom_epsilon_ = 2.38 / std::sqrt(this->z_.q.size());
+        this->stepsize_adaptation_.set_mu(log(this->nom_epsilon_));
+        this->stepsize_adaptation_.restart();
+      }
+    }
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+    this->reset_counts();
+  }
+
+  stepsize_adaptation& get_stepsize_adaptation() {
+    return stepsize_adaptation_;
+  }
+
+  const stepsize_adaptation& get_stepsize_adaptation() const noexcept {
+    return stepsize_adaptation_;
+  }
+
+  gaussian_adaptation& get_gaussian_adaptation() {
+    return gaussian_adaptation_;
+  }
+
+  void set_window_params(unsigned int num_warmup, unsigned int init_buffer,
+                         unsigned int term_buffer, unsigned int base_window,
+                         callbacks::logger& logger) {
+    gaussian_adaptation_.set_window_params(num_warmup, init_buffer,
+                                           term_buffer, base_window, logger);
+  }
+
+ protected:
+  stepsize_adaptation stepsize_adaptation_;
+  gaussian_adaptation gaussian_adaptation_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
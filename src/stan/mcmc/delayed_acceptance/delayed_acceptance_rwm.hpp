@@ -0,0 +1,254 @@
+#ifndef STAN_MCMC_DELAYED_ACCEPTANCE_DELAYED_ACCEPTANCE_RWM_HPP
+#define STAN_MCMC_DELAYED_ACCEPTANCE_DELAYED_ACCEPTANCE_RWM_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/base_mcmc.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Delayed-acceptance random walk Metropolis (Christen & Fox, 2005).
+ *
+ * <p>A Gaussian random walk proposal is first accepted or rejected
+ * with the cheap density of a surrogate, and only a proposal that
+ * passes the first stage is accepted or rejected with the model's
+ * log density, with the ratio corrected by the surrogate so that the
+ * chain targets the exact posterior. Proposals rejected at the first
+ * stage cost no model evaluation. The model's log density is
+ * evaluated without autodiff, so no gradients (and no ODE
+ * sensitivities) are ever computed.
+ *
+ * <p>The log densities of the current point are kept between
+ * transitions. The accept statistic is the second-stage acceptance
+ * probability for proposals that reach it and zero otherwise, an
+ * unbiased estimate of the overall acceptance probability.
+ *
+ * @tparam Model type of the model
+ * @tparam Surrogate type of surrogate, with method
+ * <code>double log_density(const Eigen::VectorXd&, callbacks::logger&)</code>
+ * @tparam BaseRNG type of random number generator
+ */
+template <class Model, class Surrogate, class BaseRNG>
+class delayed_acceptance_rwm : public base_mcmc {
+ public:
+  delayed_acceptance_rwm(const Model& model, Surrogate& surrogate,
+                         BaseRNG& rng)
+      : base_mcmc(),
+        z_(model.num_params_r()),
+        model_(model),
+        surrogate_(surrogate),
+        rand_int_(rng),
+        rand_uniform_(rand_int_),
+        chol_(Eigen::MatrixXd::Identity(model.num_params_r(),
+                                        model.num_params_r())),
+        nom_epsilon_(1.0),
+        lp_surrogate_(0),
+        state_valid_(false),
+        surrogate_valid_(false),
+        expensive_(false),
+        num_proposals_(0),
+        num_expensive_(0) {}
+
+  ~delayed_acceptance_rwm() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    const Eigen::VectorXd& q = init_sample.cont_params();
+    if (!state_valid_ || !(q.array() == z_.q.array()).all()) {
+      z_.q = q;
+      z_.V = -log_prob(z_.q, logger);
+      state_valid_ = true;
+      surrogate_valid_ = false;
+    }
+    if (!surrogate_valid_) {
+      lp_surrogate_ = surrogate_.log_density(z_.q, logger);
+      surrogate_valid_ = true;
+    }
+
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_gaus(rand_int_, boost::normal_distribution<>());
+    Eigen::VectorXd u(z_.q.size());
+    for (int i = 0; i < u.size(); ++i)
+      u(i) = nom_epsilon_ * rand_gaus();
+    Eigen::VectorXd q_prop = z_.q + chol_.triangularView<Eigen::Lower>() * u;
+
+    ++num_proposals_;
+    expensive_ = false;
+    double accept_stat = 0;
+
+    double lp_surrogate_prop = surrogate_.log_density(q_prop, logger);
+    double log_ratio1 = lp_surrogate_prop - lp_surrogate_;
+    if (std::isnan(log_ratio1))
+      log_ratio1 = -std::numeric_limits<double>::infinity();
+
+    if (log_ratio1 >= 0 || rand_uniform_() < std::exp(log_ratio1)) {
+      ++num_expensive_;
+      expensive_ = true;
+      double lp_prop = log_prob(q_prop, logger);
+      double log_ratio2 = (lp_prop + z_.V) - log_ratio1;
+      if (std::isnan(log_ratio2))
+        log_ratio2 = -std::numeric_limits<double>::infinity();
+      accept_stat = log_ratio2 >= 0 ? 1 : std::exp(log_ratio2);
+      if (log_ratio2 >= 0 || rand_uniform_() < accept_stat) {
+        z_.q = q_prop;
+        z_.V = -lp_prop;
+        lp_surrogate_ = lp_surrogate_prop;
+      }
+    }
+
+    return sample(z_.q, -z_.V, accept_stat);
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {
+    names.push_back("stepsize__");
+    names.push_back("expensive__");
+  }
+
+  void get_sampler_params(std::vector<double>& values) {
+    values.push_back(nom_epsilon_);
+    values.push_back(expensive_);
+  }
+
+  /**
+   * write stepsize and diagonal of proposal covariance, in one line
+   * like the diagonal of an inverse metric. The full Cholesky factor
+   * is available from <code>get_proposal_cholesky</code>.
+   */
+  void write_sampler_state(callbacks::writer& writer) {
+    std::stringstream nominal_stepsize;
+    nominal_stepsize << "Step size = " << nom_epsilon_;
+    writer(nominal_stepsize.str());
+    writer("Diagonal elements of proposal covariance:");
+    std::stringstream diag;
+    for (int i = 0; i < chol_.rows(); ++i) {
+      if (i > 0)
+        diag << ", ";
+      diag << chol_.row(i).head(i + 1).squaredNorm();
+    }
+    writer(diag.str());
+  }
+
+  /**
+   * Set the proposal covariance, which is scaled by the squared step
+   * size.
+   *
+   * @param covar covariance, must be positive definite
+   */
+  void set_proposal_covariance(const Eigen::MatrixXd& covar) {
+    Eigen::LLT<Eigen::MatrixXd> llt(covar);
+    if (llt.info() == Eigen::Success)
+      chol_ = llt.matrixL();
+  }
+
+  const Eigen::MatrixXd& get_proposal_cholesky() const { return chol_; }
+
+  void set_nominal_stepsize(double e) {
+    if (e > 0)
+      nom_epsilon_ = e;
+  }
+
+  double get_nominal_stepsize() { return nom_epsilon_; }
+
+  /**
+   * Random walk Metropolis needs no stepsize initialization; this
+   * only discards the log densities of the current point.
+   */
+  void init_stepsize(callbacks::logger& logger) { state_valid_ = false; }
+
+  /**
+   * Recompute the surrogate density of the current point at next
+   * transition, e.g. after the surrogate is refit.
+   */
+  void reset_surrogate() { surrogate_valid_ = false; }
+
+  ps_point& z() { return z_; }
+
+  const ps_point& z() const noexcept { return z_; }
+
+  /**
+   * Number of proposals since construction or the last
+   * <code>reset_counts</code>.
+   */
+  int num_proposals() const { return num_proposals_; }
+
+  /**
+   * Number of proposals that passed the first stage, each of which
+   * cost one model evaluation.
+   */
+  int num_expensive_evaluations() const { return num_expensive_; }
+
+  void reset_counts() {
+    num_proposals_ = 0;
+    num_expensive_ = 0;
+  }
+
+  /**
+   * Log the number of proposals and the fraction of model
+   * evaluations saved by the surrogate.
+   *
+   * @param logger logger for messages
+   */
+  void write_evaluation_summary(callbacks::logger& logger) {
+    std::stringstream msg;
+    int saved = num_proposals_ - num_expensive_;
+    msg << "Delayed acceptance: " << saved << " of " << num_proposals_
+        << " proposals rejected by the surrogate ("
+        << (num_proposals_ > 0 ? 100.0 * saved / num_proposals_ : 0.0)
+        << "% of model evaluations saved)";
+    logger.info(msg);
+  }
+
+ protected:
+  ps_point z_;
+  const Model& model_;
+  Surrogate& surrogate_;
+
+  BaseRNG& rand_int_;
+
+  // Uniform(0, 1) RNG
+  boost::uniform_01<BaseRNG&> rand_uniform_;
+
+  Eigen::MatrixXd chol_;
+  double nom_epsilon_;
+  double lp_surrogate_;
+  bool state_valid_;
+  bool surrogate_valid_;
+  bool expensive_;
+  int num_proposals_;
+  int num_expensive_;
+
+  double log_prob(const Eigen::VectorXd& q, callbacks::logger& logger) {
+    std::stringstream msg;
+    Eigen::VectorXd params_r = q;
+    double lp;
+    try {
+      lp = model_.template log_prob<false, true>(params_r, &msg);
+    } catch (const std::exception& e) {
+      logger.error(
+          "Informational Message: The current Metropolis proposal "
+          "is about to be rejected because of the following issue:");
+      logger.error(e.what());
+      logger.error("");
+      lp = -std::numeric_limits<double>::infinity();
+    }
+    if (msg.str().length() > 0)
+      logger.info(msg);
+    return lp;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,72 @@
+#ifndef STAN_MCMC_DELAYED_ACCEPTANCE_GAUSSIAN_SURROGATE_HPP
+#define STAN_MCMC_DELAYED_ACCEPTANCE_GAUSSIAN_SURROGATE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Gaussian approximation of the posterior on the unconstrained
+ * space, used as the cheap first-stage density of delayed
+ * acceptance. Until it is fit, the surrogate is flat, so that every
+ * proposal passes the first stage.
+ */
+class gaussian_surrogate {
+ public:
+  gaussian_surrogate() : fit_(false) {}
+
+  /**
+   * Fit the surrogate to the specified mean and covariance.
+   *
+   * @param mean mean
+   * @param covar covariance, must be positive definite
+   */
+  void fit(const Eigen::VectorXd& mean, const Eigen::MatrixXd& covar) {
+    mean_ = mean;
+    llt_.compute(covar);
+    fit_ = llt_.info() == Eigen::Success;
+  }
+
+  bool is_fit() const { return fit_; }
+
+  const Eigen::VectorXd& mean() const { return mean_; }
+
+  /**
+   * Return the log density at the specified point, up to a constant.
+   *
+   * @param q point on the unconstrained space
+   * @param logger logger for messages
+   */
+  double log_density(const Eigen::VectorXd& q, callbacks::logger& logger) {
+    if (!fit_)
+      return 0;
+    Eigen::VectorXd z = llt_.matrixL().solve(q - mean_);
+    return -0.5 * z.squaredNorm();
+  }
+
+ private:
+  bool fit_;
+  Eigen::VectorXd mean_;
+  Eigen::LLT<Eigen::MatrixXd> llt_;
+};
+
+/**
+ * Refit a surrogate to the mean and covariance of warmup draws. This
+ * overload is for surrogates that are not fit to draws and does
+ * nothing.
+ */
+template <class Surrogate>
+void fit_surrogate(Surrogate& surrogate, const Eigen::VectorXd& mean,
+                   const Eigen::MatrixXd& covar) {}
+
+inline void fit_surrogate(gaussian_surrogate& surrogate,
+                          const Eigen::VectorXd& mean,
+                          const Eigen::MatrixXd& covar) {
+  surrogate.fit(mean, covar);
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,52 @@
+#ifndef STAN_MCMC_DELAYED_ACCEPTANCE_MODEL_SURROGATE_HPP
+#define STAN_MCMC_DELAYED_ACCEPTANCE_MODEL_SURROGATE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <limits>
+#include <sstream>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Surrogate density given by a cheaper instance of a model, e.g. the
+ * same model run with loose ODE solver tolerances or on a subset of
+ * the data. The log density is evaluated with <code>double</code>
+ * arguments, without autodiff.
+ *
+ * @tparam Model type of the surrogate model
+ */
+template <class Model>
+class model_surrogate {
+ public:
+  explicit model_surrogate(const Model& model) : model_(model) {}
+
+  /**
+   * Return the log density at the specified point, up to a constant,
+   * or negative infinity if the model throws.
+   *
+   * @param q point on the unconstrained space
+   * @param logger logger for messages
+   */
+  double log_density(const Eigen::VectorXd& q, callbacks::logger& logger) {
+    std::stringstream msg;
+    Eigen::VectorXd params_r = q;
+    double lp;
+    try {
+      lp = model_.template log_prob<false, true>(params_r, &msg);
+    } catch (const std::exception& e) {
+      lp = -std::numeric_limits<double>::infinity();
+    }
+    if (msg.str().length() > 0)
+      logger.info(msg);
+    return lp;
+  }
+
+ private:
+  const Model& model_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,293 @@
+#ifndef STAN_MCMC_ENSEMBLE_ENSEMBLE_SAMPLER_HPP
+#define STAN_MCMC_ENSEMBLE_ENSEMBLE_SAMPLER_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/base_mcmc.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Gradient-free ensemble sampler with the affine-invariant stretch
+ * move (Goodman & Weare, 2010) and the differential evolution move
+ * (ter Braak, 2006).
+ *
+ * <p>The ensemble is split in two halves. Each half is moved in turn,
+ * every walker with a proposal built from the walkers of the other
+ * half, so the proposals of a half are independent and their log
+ * densities are evaluated as one batch through the parallel loop set
+ * by <code>set_parallel_for</code>. All random numbers are drawn
+ * before the batch, so the draws do not depend on the number of
+ * threads. The model's log density is evaluated with
+ * <code>double</code> arguments, without autodiff.
+ *
+ * <p>Each call to <code>transition</code> returns the next walker in
+ * turn, moving the whole ensemble before returning the first one, so
+ * a sweep of the ensemble writes one row per walker with the usual
+ * sampler output; the <code>walker__</code> column identifies the
+ * walker. The sample passed to <code>transition</code> is ignored,
+ * as the state is the ensemble set by <code>set_walkers</code>.
+ *
+ * @tparam Model type of the model
+ * @tparam BaseRNG type of random number generator
+ */
+template <class Model, class BaseRNG>
+class ensemble_sampler : public base_mcmc {
+ public:
+  typedef std::function<void(int, const std::function<void(int)>&)>
+      parallel_for_type;
+
+  ensemble_sampler(const Model& model, BaseRNG& rng)
+      : base_mcmc(),
+        model_(model),
+        rand_int_(rng),
+        rand_uniform_(rand_int_),
+        stretch_scale_(2.0),
+        de_probability_(0.1),
+        next_walker_(0),
+        current_walker_(0),
+        num_proposals_(0),
+        num_accepted_(0),
+        parallel_for_([](int n, const std::function<void(int)>& f) {
+          for (int i = 0; i < n; ++i)
+            f(i);
+        }) {}
+
+  ~ensemble_sampler() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    if (next_walker_ == 0)
+      sweep(logger);
+    int k = next_walker_;
+    next_walker_ = (next_walker_ + 1) % num_walkers();
+    current_walker_ = k;
+    return sample(walkers_[k], lp_(k), accept_stat_(k));
+  }
+
+  /**
+   * Move every walker once, the first half of the ensemble and then
+   * the second.
+   *
+   * @param logger logger for messages
+   */
+  void sweep(callbacks::logger& logger) {
+    int half = num_walkers() / 2;
+    move_half(0, half, half, num_walkers(), logger);
+    move_half(half, num_walkers(), 0, half, logger);
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {
+    names.push_back("walker__");
+  }
+
+  void get_sampler_params(std::vector<double>& values) {
+    values.push_back(current_walker_);
+  }
+
+  void write_sampler_state(callbacks::writer& writer) {
+    std::stringstream msg;
+    msg << "Ensemble of " << num_walkers() << " walkers, acceptance rate = "
+        << acceptance_rate();
+    writer(msg.str());
+  }
+
+  /**
+   * Set the walkers and evaluate their log densities. The walkers
+   * must span the space for the moves to reach all of it.
+   *
+   * @param walkers points on the unconstrained space, at least four
+   * @param logger logger for messages
+   * @throws std::invalid_argument if there are fewer than four walkers
+   */
+  void set_walkers(const std::vector<Eigen::VectorXd>& walkers,
+                   callbacks::logger& logger) {
+    if (walkers.size() < 4)
+      throw std::invalid_argument("ensemble_sampler: at least four walkers "
+                                  "are required");
+    walkers_ = walkers;
+    lp_ = log_prob(walkers_, logger);
+    accept_stat_ = Eigen::VectorXd::Zero(walkers_.size());
+    next_walker_ = 0;
+    current_walker_ = 0;
+  }
+
+  const std::vector<Eigen::VectorXd>& walkers() const { return walkers_; }
+
+  const Eigen::VectorXd& walker_log_prob() const { return lp_; }
+
+  int num_walkers() const { return walkers_.size(); }
+
+  /**
+   * Set the loop used to evaluate a batch of log densities. It must
+   * call its function once for each index in <code>[0, n)</code>,
+   * possibly concurrently, and return once all calls have finished.
+   */
+  void set_parallel_for(parallel_for_type parallel_for) {
+    parallel_for_ = std::move(parallel_for);
+  }
+
+  /**
+   * Set the scale a > 1 of the stretch move, whose stretch factor has
+   * density proportional to 1 / sqrt(z) on [1 / a, a].
+   */
+  void set_stretch_scale(double a) {
+    if (a > 1)
+      stretch_scale_ = a;
+  }
+
+  double get_stretch_scale() const { return stretch_scale_; }
+
+  /**
+   * Set the probability that a walker makes a differential evolution
+   * move rather than a stretch move.
+   */
+  void set_de_probability(double p) {
+    if (p >= 0 && p <= 1)
+      de_probability_ = p;
+  }
+
+  double get_de_probability() const { return de_probability_; }
+
+  /**
+   * Number of proposals since construction or the last
+   * <code>reset_counts</code>, each of which cost one model
+   * evaluation.
+   */
+  long num_proposals() const { return num_proposals_; }
+
+  double acceptance_rate() const {
+    return num_proposals_ > 0
+               ? static_cast<double>(num_accepted_) / num_proposals_
+               : 0.0;
+  }
+
+  void reset_counts() {
+    num_proposals_ = 0;
+    num_accepted_ = 0;
+  }
+
+ protected:
+  const Model& model_;
+
+  BaseRNG& rand_int_;
+
+  // Uniform(0, 1) RNG
+  boost::uniform_01<BaseRNG&> rand_uniform_;
+
+  double stretch_scale_;
+  double de_probability_;
+  std::vector<Eigen::VectorXd> walkers_;
+  Eigen::VectorXd lp_;
+  Eigen::VectorXd accept_stat_;
+  int next_walker_;
+  int current_walker_;
+  long num_proposals_;
+  long num_accepted_;
+  parallel_for_type parallel_for_;
+
+  /**
+   * Move the walkers in <code>[begin, end)</code> with proposals
+   * built from the walkers in <code>[other_begin, other_end)</code>.
+   */
+  void move_half(int begin, int end, int other_begin, int other_end,
+                 callbacks::logger& logger) {
+    int n = end - begin;
+    int num_other = other_end - other_begin;
+    double dim = walkers_[0].size();
+    double de_scale = 2.38 / std::sqrt(2 * dim);
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_gaus(rand_int_, boost::normal_distribution<>());
+
+    std::vector<Eigen::VectorXd> proposals(n);
+    Eigen::VectorXd log_jacobian(n);
+    Eigen::VectorXd log_u(n);
+    for (int i = 0; i < n; ++i) {
+      const Eigen::VectorXd& x = walkers_[begin + i];
+      int j = other_begin + static_cast<int>(rand_uniform_() * num_other);
+      if (rand_uniform_() < de_probability_) {
+        int l = other_begin
+                + (j - other_begin + 1
+                   + static_cast<int>(rand_uniform_() * (num_other - 1)))
+                      % num_other;
+        double gamma = de_scale * (1 + 1e-4 * rand_gaus());
+        proposals[i] = x + gamma * (walkers_[j] - walkers_[l]);
+        log_jacobian(i) = 0;
+      } else {
+        double u = rand_uniform_();
+        double z = std::pow((stretch_scale_ - 1) * u + 1, 2) / stretch_scale_;
+        proposals[i] = walkers_[j] + z * (x - walkers_[j]);
+        log_jacobian(i) = (dim - 1) * std::log(z);
+      }
+      log_u(i) = std::log(rand_uniform_());
+    }
+
+    Eigen::VectorXd lp_prop = log_prob(proposals, logger);
+    for (int i = 0; i < n; ++i) {
+      int k = begin + i;
+      double log_ratio = log_jacobian(i) + lp_prop(i) - lp_(k);
+      if (std::isnan(log_ratio))
+        log_ratio = -std::numeric_limits<double>::infinity();
+      accept_stat_(k) = log_ratio >= 0 ? 1 : std::exp(log_ratio);
+      ++num_proposals_;
+      if (log_u(i) < log_ratio) {
+        walkers_[k] = std::move(proposals[i]);
+        lp_(k) = lp_prop(i);
+        ++num_accepted_;
+      }
+    }
+  }
+
+  /**
+   * Return the log densities of the points, evaluated as a batch, with
+   * negative infinity for points at which the model throws. Messages
+   * are logged after the batch, in the order of the points.
+   */
+  Eigen::VectorXd log_prob(const std::vector<Eigen::VectorXd>& points,
+                           callbacks::logger& logger) {
+    int n = points.size();
+    Eigen::VectorXd lp(n);
+    std::vector<std::string> msgs(n);
+    std::vector<std::string> errors(n);
+    parallel_for_(n, [&](int i) {
+      std::stringstream msg;
+      Eigen::VectorXd params_r = points[i];
+      try {
+        lp(i) = model_.template log_prob<false, true>(params_r, &msg);
+      } catch (const std::exception& e) {
+        errors[i] = e.what();
+        lp(i) = -std::numeric_limits<double>::infinity();
+      }
+      msgs[i] = msg.str();
+    });
+    for (int i = 0; i < n; ++i) {
+      if (!msgs[i].empty())
+        logger.info(msgs[i]);
+      if (!errors[i].empty()) {
+        logger.error(
+            "Informational Message: The current Metropolis proposal "
+            "is about to be rejected because of the following issue:");
+        logger.error(errors[i]);
+        logger.error("");
+      }
+    }
+    return lp;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
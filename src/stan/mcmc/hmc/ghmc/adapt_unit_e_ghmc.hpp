@@ -0,0 +1,43 @@
+#ifndef STAN_MCMC_HMC_GHMC_ADAPT_UNIT_E_GHMC_HPP
+#define STAN_MCMC_HMC_GHMC_ADAPT_UNIT_E_GHMC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/ghmc/unit_e_ghmc.hpp>
+#include <stan/mcmc/stepsize_adapter.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Generalized Hamiltonian Monte Carlo with persistent momentum
+ * with a Gaussian-Euclidean disintegration and unit metric and
+ * adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_unit_e_ghmc : public unit_e_ghmc<Model, BaseRNG>,
+                          public stepsize_adapter {
+ public:
+  adapt_unit_e_ghmc(const Model& model, BaseRNG& rng)
+      : unit_e_ghmc<Model, BaseRNG>(model, rng) {}
+
+  ~adapt_unit_e_ghmc() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s = unit_e_ghmc<Model, BaseRNG>::transition(init_sample, logger);
+
+    if (this->adapt_flag_) {
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+    }
+
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,195 @@
+#ifndef STAN_MCMC_HMC_GHMC_BASE_GHMC_HPP
+#define STAN_MCMC_HMC_GHMC_BASE_GHMC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/base_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Generalized Hamiltonian Monte Carlo (Horowitz, 1991) with
+ * persistent momentum.
+ *
+ * <p>Each transition takes a few (by default one) leapfrog steps
+ * and keeps the momentum of the previous transition, partially
+ * refreshed as
+ * <code>p = alpha p + sqrt(1 - alpha^2) xi</code>, with
+ * <code>xi</code> drawn from the Gaussian-Euclidean kinetic energy.
+ * A rejected proposal negates the momentum, so that successive
+ * transitions keep moving in the same direction until a rejection,
+ * giving long trajectories made of cheap transitions. With
+ * <code>alpha = 0</code> this is static HMC.
+ *
+ * <p>The accept/reject decision is made with Neal's (2020)
+ * non-reversible update of a uniform value <code>u</code> in
+ * <code>(-1, 1)</code>: <code>u</code> drifts by a fixed amount
+ * each transition and a proposal is accepted if
+ * <code>|u| < exp(H0 - H)</code>, which clusters rejections and
+ * thus reduces the momentum flips that undo the persistence. A zero
+ * drift draws a fresh <code>u</code> for every transition.
+ *
+ * <p>The gradient at the current point is kept between transitions,
+ * so that a transition costs <code>L</code> gradient evaluations.
+ * Because the momentum must follow a Gaussian distribution
+ * independent of the position, only Euclidean metrics are supported.
+ */
+template <class Model, template <class, class> class Hamiltonian,
+          template <class> class Integrator, class BaseRNG>
+class base_ghmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
+ public:
+  base_ghmc(const Model& model, BaseRNG& rng)
+      : base_hmc<Model, Hamiltonian, Integrator, BaseRNG>(model, rng),
+        L_(1),
+        alpha_(0.9),
+        drift_(0.0),
+        u_(2.0 * this->rand_uniform_() - 1.0),
+        energy_(0),
+        momentum_valid_(false) {}
+
+  ~base_ghmc() {}
+
+  void set_metric(const Eigen::MatrixXd& inv_e_metric) {
+    this->z_.set_metric(inv_e_metric);
+    reset_momentum();
+  }
+
+  void set_metric(const Eigen::VectorXd& inv_e_metric) {
+    this->z_.set_metric(inv_e_metric);
+    reset_momentum();
+  }
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    this->sample_stepsize();
+
+    const Eigen::VectorXd& q = init_sample.cont_params();
+    if (momentum_valid_ && q.size() == this->z_.q.size()
+        && (q.array() == this->z_.q.array()).all()) {
+      refresh_momentum();
+    } else {
+      this->seed(q);
+      this->hamiltonian_.sample_p(this->z_, this->rand_int_);
+      this->hamiltonian_.init(this->z_, logger);
+      momentum_valid_ = true;
+    }
+
+    ps_point z_init(this->z_);
+
+    double H0 = this->hamiltonian_.H(this->z_);
+
+    for (int i = 0; i < L_; ++i)
+      this->integrator_.evolve(this->z_, this->hamiltonian_, this->epsilon_,
+                               logger);
+
+    double h = this->hamiltonian_.H(this->z_);
+    if (std::isnan(h))
+      h = std::numeric_limits<double>::infinity();
+
+    double acceptProb = std::exp(H0 - h);
+
+    if (!accept(acceptProb)) {
+      this->z_.ps_point::operator=(z_init);
+      this->z_.p = -this->z_.p;
+    }
+
+    acceptProb = acceptProb > 1 ? 1 : acceptProb;
+
+    this->energy_ = this->hamiltonian_.H(this->z_);
+    return sample(this->z_.q, -this->hamiltonian_.V(this->z_), acceptProb);
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {
+    names.push_back("stepsize__");
+    names.push_back("int_time__");
+    names.push_back("energy__");
+  }
+
+  void get_sampler_params(std::vector<double>& values) {
+    values.push_back(this->epsilon_);
+    values.push_back(this->epsilon_ * this->L_);
+    values.push_back(this->energy_);
+  }
+
+  void set_nominal_stepsize_and_L(const double e, const int l) {
+    if (e > 0 && l > 0) {
+      this->nom_epsilon_ = e;
+      L_ = l;
+    }
+  }
+
+  void set_L(const int l) {
+    if (l > 0)
+      L_ = l;
+  }
+
+  int get_L() { return this->L_; }
+
+  /**
+   * Set the fraction <code>alpha</code> of the momentum kept at each
+   * transition, in <code>[0, 1)</code>.
+   *
+   * @param alpha momentum persistence
+   */
+  void set_momentum_persistence(const double alpha) {
+    if (alpha >= 0 && alpha < 1)
+      alpha_ = alpha;
+  }
+
+  double get_momentum_persistence() { return this->alpha_; }
+
+  /**
+   * Set the drift of the uniform value used in the non-reversible
+   * accept/reject decision, in <code>[0, 1]</code>. Zero gives the
+   * usual Metropolis decision.
+   *
+   * @param drift acceptance drift
+   */
+  void set_acceptance_drift(const double drift) {
+    if (drift >= 0 && drift <= 1)
+      drift_ = drift;
+  }
+
+  double get_acceptance_drift() { return this->drift_; }
+
+  /**
+   * Draw a fresh momentum at next transition, e.g. after the metric
+   * changes.
+   */
+  void reset_momentum() { momentum_valid_ = false; }
+
+ protected:
+  int L_;
+  double alpha_;
+  double drift_;
+  double u_;
+  double energy_;
+  bool momentum_valid_;
+
+  void refresh_momentum() {
+    Eigen::VectorXd p_old = this->z_.p;
+    this->hamiltonian_.sample_p(this->z_, this->rand_int_);
+    this->z_.p = alpha_ * p_old + std::sqrt(1 - alpha_ * alpha_) * this->z_.p;
+  }
+
+  bool accept(double accept_prob) {
+    if (drift_ == 0) {
+      return accept_prob >= 1 || this->rand_uniform_() < accept_prob;
+    }
+    u_ += drift_;
+    if (u_ > 1)
+      u_ -= 2;
+    if (std::fabs(u_) < accept_prob) {
+      u_ /= accept_prob;
+      return true;
+    }
+    return false;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,25 @@
+#ifndef STAN_MCMC_HMC_GHMC_DIAG_E_GHMC_HPP
+#define STAN_MCMC_HMC_GHMC_DIAG_E_GHMC_HPP
+
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/mcmc/hmc/ghmc/base_ghmc.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Generalized Hamiltonian Monte Carlo with persistent momentum
+ * with a Gaussian-Euclidean disintegration and diagonal metric
+ */
+template <class Model, class BaseRNG>
+class diag_e_ghmc
+    : public base_ghmc<Model, diag_e_metric, expl_leapfrog, BaseRNG> {
+ public:
+  diag_e_ghmc(const Model& model, BaseRNG& rng)
+      : base_ghmc<Model, diag_e_metric, expl_leapfrog, BaseRNG>(model, rng) {}
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,25 @@
+#ifndef STAN_MCMC_HMC_GHMC_UNIT_E_GHMC_HPP
+#define STAN_MCMC_HMC_GHMC_UNIT_E_GHMC_HPP
+
+#include <stan/mcmc/hmc/hamiltonians/unit_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/unit_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/mcmc/hmc/ghmc/base_ghmc.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Generalized Hamiltonian Monte Carlo with persistent momentum
+ * with a Gaussian-Euclidean disintegration and unit metric
+ */
+template <class Model, class BaseRNG>
+class unit_e_ghmc
+    : public base_ghmc<Model, unit_e_metric, expl_leapfrog, BaseRNG> {
+ public:
+  unit_e_ghmc(const Model& model, BaseRNG& rng)
+      : base_ghmc<Model, unit_e_metric, expl_leapfrog, BaseRNG>(model, rng) {}
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -24,8 +24,8 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
 
   ~adapt_diag_e_nuts() {}
 
-  sample transition(sample& init_sample, callbacks::logger& logger) {
-    sample s = diag_e_nuts<Model, BaseRNG>::transition(init_sample, logger);
+  void transition_in_place(sample& s, callbacks::logger& logger) {
+    diag_e_nuts<Model, BaseRNG>::transition_in_place(s, logger);
 
     if (this->adapt_flag_) {
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
@@ -34,6 +34,13 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
       if (this -> use_cross_chain_adapt()) {
         /// cross chain adapter has its own var adaptor so needs to add sample
         this -> add_cross_chain_sample(s.log_prob(), this -> z().q);
+        if (this -> cross_chain_cull(s.log_prob(), s.accept_stat(), this->z_.q,
+                                     this->nom_epsilon_, this->stepsize_adaptation_,
+                                     this->z_.inv_e_metric_, this->rand_int_, logger)) {
+          /// continue from the perturbed copy of the donor chain
+          this->init_hamiltonian(logger);
+          s = sample(this->z_.q, -this->z_.V, s.accept_stat());
+        }
         bool update = this -> cross_chain_adaptation(this -> z().inv_e_metric_, logger);
         if (update) {
           // this->init_stepsize(logger);
@@ -52,7 +59,6 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
         }
       }
     }
-    return s;
   }
 
   void disengage_adaptation() {
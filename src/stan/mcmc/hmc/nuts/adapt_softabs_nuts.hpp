@@ -21,14 +21,12 @@ class adapt_softabs_nuts : public softabs_nuts<Model, BaseRNG>,
 
   ~adapt_softabs_nuts() {}
 
-  sample transition(sample& init_sample, callbacks::logger& logger) {
-    sample s = softabs_nuts<Model, BaseRNG>::transition(init_sample, logger);
+  void transition_in_place(sample& s, callbacks::logger& logger) {
+    softabs_nuts<Model, BaseRNG>::transition_in_place(s, logger);
 
     if (this->adapt_flag_)
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
-
-    return s;
   }
 
   void disengage_adaptation() {
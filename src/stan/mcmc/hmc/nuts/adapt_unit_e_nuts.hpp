@@ -23,14 +23,12 @@ class adapt_unit_e_nuts : public unit_e_nuts<Model, BaseRNG>,
 
   ~adapt_unit_e_nuts() {}
 
-  sample transition(sample& init_sample, callbacks::logger& logger) {
-    sample s = unit_e_nuts<Model, BaseRNG>::transition(init_sample, logger);
+  void transition_in_place(sample& s, callbacks::logger& logger) {
+    unit_e_nuts<Model, BaseRNG>::transition_in_place(s, logger);
 
     if (this->adapt_flag_)
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
-
-    return s;
   }
 
   void disengage_adaptation() {
@@ -76,10 +76,27 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
   double get_max_delta() { return this->max_deltaH_; }
 
   sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s(init_sample);
+    this->transition_in_place(s, logger);
+    return s;
+  }
+
+  /**
+   * Replace the sample by the next state of the chain without
+   * allocating: the initial position is swapped into the sampler's
+   * state, the selected point of the trajectory replaces that state
+   * by swaps, and its position is copied into the sample's existing
+   * buffer.
+   *
+   * @param[in,out] s sample, the initial state on input and the new
+   *   state on output
+   * @param[in,out] logger logger for messages
+   */
+  void transition_in_place(sample& s, callbacks::logger& logger) {
     // Initialize the algorithm
     this->sample_stepsize();
 
-    this->seed(init_sample.cont_params());
+    s.swap_cont_params(this->z_.q);
 
     this->hamiltonian_.sample_p(this->z_, this->rand_int_);
     this->hamiltonian_.init(this->z_, logger);
@@ -198,9 +215,20 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     // even over subtrees that may have been rejected
     double accept_prob = sum_metro_prob / static_cast<double>(n_leapfrog);
 
-    this->z_.ps_point::operator=(z_sample);
+    // Swap the selected point into the sampler's state; z_sample is
+    // left with buffers of the right size that are reused below
+    this->z_.q.swap(z_sample.q);
+    this->z_.p.swap(z_sample.p);
+    this->z_.g.swap(z_sample.g);
+    this->z_.V = z_sample.V;
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->z_.V, accept_prob);
+
+    // The sampler's state keeps q for the diagnostic output, so the
+    // sample gets one copy of it, written into an existing buffer
+    z_sample.q = this->z_.q;
+    s.swap_cont_params(z_sample.q);
+    s.set_log_prob(-this->z_.V);
+    s.set_accept_stat(accept_prob);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
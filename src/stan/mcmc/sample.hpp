@@ -35,6 +35,20 @@ class sample {
 
   const Eigen::VectorXd& cont_params() const { return cont_params_; }
 
+  /**
+   * Swap the continuous coordinates with the vector, which takes the
+   * buffer of the sample and gives its own, without copying the
+   * values. Samplers use it to move their state in and out of the
+   * sample in <code>base_mcmc::transition_in_place</code>.
+   *
+   * @param[in,out] q vector to swap with the continuous coordinates
+   */
+  void swap_cont_params(Eigen::VectorXd& q) { cont_params_.swap(q); }
+
+  void set_log_prob(double log_prob) { log_prob_ = log_prob; }
+
+  void set_accept_stat(double stat) { accept_stat_ = stat; }
+
   inline double log_prob() const { return log_prob_; }
 
   inline double accept_stat() const { return accept_stat_; }
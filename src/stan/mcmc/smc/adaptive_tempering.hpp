@@ -0,0 +1,56 @@
+#ifndef STAN_MCMC_SMC_ADAPTIVE_TEMPERING_HPP
+#define STAN_MCMC_SMC_ADAPTIVE_TEMPERING_HPP
+
+#include <stan/math/prim.hpp>
+#include <cmath>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Return the effective sample size of the incremental importance
+ * weights <code>exp(delta * log_ratio)</code> of an equally weighted
+ * ensemble.
+ *
+ * @param[in] log_ratio log ratio of the model to the reference density
+ *   at each particle
+ * @param[in] delta increment of the inverse temperature
+ */
+inline double tempering_ess(const Eigen::VectorXd& log_ratio, double delta) {
+  Eigen::VectorXd log_w = delta * log_ratio;
+  Eigen::VectorXd log_w2 = 2 * log_w;
+  return std::exp(2 * stan::math::log_sum_exp(log_w)
+                  - stan::math::log_sum_exp(log_w2));
+}
+
+/**
+ * Return the next inverse temperature, the largest one in
+ * <code>(beta, 1]</code> at which the incremental weights keep an
+ * effective sample size of at least <code>ess_fraction</code> times
+ * the number of particles, found by bisection.
+ *
+ * @param[in] log_ratio log ratio of the model to the reference density
+ *   at each particle, finite for every particle
+ * @param[in] beta current inverse temperature
+ * @param[in] ess_fraction target fraction of particles, in (0, 1)
+ */
+inline double next_temperature(const Eigen::VectorXd& log_ratio, double beta,
+                               double ess_fraction) {
+  double target = ess_fraction * log_ratio.size();
+  if (tempering_ess(log_ratio, 1 - beta) >= target)
+    return 1;
+  double lo = beta;
+  double hi = 1;
+  for (int i = 0; i < 60 && hi - lo > 1e-12; ++i) {
+    double mid = 0.5 * (lo + hi);
+    if (tempering_ess(log_ratio, mid - beta) >= target)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo > beta ? lo : hi;
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,38 @@
+#ifndef STAN_MCMC_SMC_SYSTEMATIC_RESAMPLE_HPP
+#define STAN_MCMC_SMC_SYSTEMATIC_RESAMPLE_HPP
+
+#include <stan/math/prim.hpp>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Return the ancestor indices drawn by systematic resampling: a single
+ * uniform offset <code>u</code> places the points
+ * <code>(k + u) / N</code>, and particle <code>i</code> is selected
+ * once for each point falling in its share of the cumulative weight.
+ * Each particle is selected either floor or ceil of N times its weight.
+ *
+ * @param[in] weights normalized weights of the N particles
+ * @param[in] u uniform draw in [0, 1)
+ * @return indices of the selected particles, in increasing order
+ */
+inline std::vector<int> systematic_resample(const Eigen::VectorXd& weights,
+                                            double u) {
+  int n = weights.size();
+  std::vector<int> ancestors(n);
+  double cumulative = weights(0);
+  int i = 0;
+  for (int k = 0; k < n; ++k) {
+    double point = (k + u) / n;
+    while (point > cumulative && i < n - 1)
+      cumulative += weights(++i);
+    ancestors[k] = i;
+  }
+  return ancestors;
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,82 @@
+#ifndef STAN_MCMC_SMC_TEMPERED_MODEL_HPP
+#define STAN_MCMC_SMC_TEMPERED_MODEL_HPP
+
+#include <stan/math/prim.hpp>
+#include <cmath>
+#include <ostream>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Geometric bridge between a Gaussian reference density and a model's
+ * log density on the unconstrained scale,
+ *
+ *   log p_beta(q) = beta * log p(q) + (1 - beta) * log N(q | 0, s^2 I),
+ *
+ * which is the target of the mutation kernel at inverse temperature
+ * <code>beta</code>. Stan models do not separate the prior from the
+ * likelihood, so the bridge starts from a reference that can be
+ * sampled exactly rather than from the prior. The class provides the
+ * part of the model interface used by the Hamiltonians.
+ *
+ * The inverse temperature is read by every evaluation and must not be
+ * changed while a sampler is running.
+ *
+ * @tparam Model type of the model
+ */
+template <class Model>
+class tempered_model {
+ public:
+  /**
+   * @param[in] model model
+   * @param[in] ref_scale standard deviation s of the reference
+   */
+  tempered_model(const Model& model, double ref_scale)
+      : model_(model), ref_scale_(ref_scale), beta_(0) {}
+
+  size_t num_params_r() const { return model_.num_params_r(); }
+
+  double beta() const { return beta_; }
+
+  void set_beta(double beta) { beta_ = beta; }
+
+  double ref_scale() const { return ref_scale_; }
+
+  const Model& model() const { return model_; }
+
+  /**
+   * Return the normalized log density of the reference.
+   *
+   * @tparam T scalar type
+   * @param[in] params_r point on the unconstrained space
+   */
+  template <typename T>
+  T log_reference(const Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r) const {
+    static const double log_sqrt_two_pi = 0.5 * std::log(2 * M_PI);
+    return -0.5 * params_r.squaredNorm() / (ref_scale_ * ref_scale_)
+           - params_r.size() * (std::log(ref_scale_) + log_sqrt_two_pi);
+  }
+
+  template <bool propto, bool jacobian_adjust_transform, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs) const {
+    T lp_ref = log_reference(params_r);
+    if (beta_ == 0)
+      return lp_ref;
+    T lp = model_.template log_prob<propto, jacobian_adjust_transform, T>(
+        params_r, msgs);
+    if (beta_ == 1)
+      return lp;
+    return beta_ * lp + (1 - beta_) * lp_ref;
+  }
+
+ private:
+  const Model& model_;
+  double ref_scale_;
+  double beta_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
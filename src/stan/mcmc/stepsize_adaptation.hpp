@@ -72,6 +72,36 @@ class stepsize_adaptation : public base_adaptation {
 
   void complete_adaptation(double& epsilon) { epsilon = std::exp(x_bar_); }
 
+  /**
+   * Number of doubles in the state of the adaptation.
+   */
+  static const int state_size = 4;
+
+  /**
+   * Copy the state of the dual averaging, including its asymptotic
+   * mean, so that it can be restored in another adaptation.
+   *
+   * @param[out] state array of <code>state_size</code> doubles
+   */
+  void get_state(double* state) const {
+    state[0] = counter_;
+    state[1] = s_bar_;
+    state[2] = x_bar_;
+    state[3] = mu_;
+  }
+
+  /**
+   * Restore a state copied by <code>get_state</code>.
+   *
+   * @param[in] state array of <code>state_size</code> doubles
+   */
+  void set_state(const double* state) {
+    counter_ = state[0];
+    s_bar_ = state[1];
+    x_bar_ = state[2];
+    mu_ = state[3];
+  }
+
  protected:
   double counter_;  // Adaptation iteration
   double s_bar_;    // Moving average statistic
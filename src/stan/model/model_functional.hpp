@@ -23,6 +23,25 @@ struct model_functional {
   }
 };
 
+namespace internal {
+
+// model_functional with the specified log_prob template arguments
+template <bool propto, bool jacobian_adjust_transform, class M>
+struct log_prob_functional {
+  const M& model;
+  std::ostream* o;
+
+  log_prob_functional(const M& m, std::ostream* out) : model(m), o(out) {}
+
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& x) const {
+    // log_prob() requires non-const but doesn't modify its argument
+    return model.template log_prob<propto, jacobian_adjust_transform, T>(
+        const_cast<Eigen::Matrix<T, -1, 1>&>(x), o);
+  }
+};
+
+}  // namespace internal
 }  // namespace model
 }  // namespace stan
 #endif
@@ -15,6 +15,8 @@
 #include <stan/model/model_base_crtp.hpp>
 #include <stan/model/prob_grad.hpp>
 #include <stan/model/indexing.hpp>
+#include <stan/model/pmx_value_of.hpp>
+#include <stan/model/solution_cache.hpp>
 #include <stan/services/util/create_rng.hpp>
 
 #include <boost/random/additive_combine.hpp>
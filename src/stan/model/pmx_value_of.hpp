@@ -0,0 +1,98 @@
+#ifndef STAN_MODEL_PMX_VALUE_OF_HPP
+#define STAN_MODEL_PMX_VALUE_OF_HPP
+
+#include <stan/math/rev.hpp>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Type of the <code>double</code> values of a Torsten event
+ * argument: <code>double</code> for scalars, and the same container
+ * with <code>double</code> elements for arrays, at any nesting
+ * depth, and for Eigen matrices.
+ *
+ * @tparam T type of the argument
+ */
+template <typename T>
+struct pmx_value_type {
+  typedef double type;
+};
+
+template <typename T>
+struct pmx_value_type<std::vector<T> > {
+  typedef std::vector<typename pmx_value_type<T>::type> type;
+};
+
+template <typename T, int R, int C>
+struct pmx_value_type<Eigen::Matrix<T, R, C> > {
+  typedef Eigen::Matrix<double, R, C> type;
+};
+
+/**
+ * Return the value of a scalar event argument.
+ *
+ * @tparam T scalar type
+ * @param x argument
+ * @return value of the argument
+ */
+template <typename T>
+inline double pmx_value_of(const T& x) {
+  return stan::math::value_of_rec(x);
+}
+
+inline double pmx_value_of(double x) { return x; }
+
+/**
+ * Return an array of <code>double</code> as is, without copying it.
+ */
+inline const std::vector<double>& pmx_value_of(const std::vector<double>& x) {
+  return x;
+}
+
+inline const std::vector<std::vector<double> >& pmx_value_of(
+    const std::vector<std::vector<double> >& x) {
+  return x;
+}
+
+template <int R, int C>
+inline const Eigen::Matrix<double, R, C>& pmx_value_of(
+    const Eigen::Matrix<double, R, C>& x) {
+  return x;
+}
+
+/**
+ * Return the values of an array event argument, recursing into
+ * nested arrays so that every level holds <code>double</code>.
+ * The generator wraps data-only event arguments of the Torsten
+ * solvers in this function; unlike <code>value_of</code>, it is
+ * guaranteed to reach the innermost scalars of
+ * <code>real[,]</code> arguments built from promoted expressions.
+ *
+ * @tparam T element type
+ * @param x argument
+ * @return values of the argument
+ */
+template <typename T>
+inline typename pmx_value_type<std::vector<T> >::type pmx_value_of(
+    const std::vector<T>& x) {
+  typename pmx_value_type<std::vector<T> >::type y;
+  y.reserve(x.size());
+  for (size_t i = 0; i < x.size(); ++i)
+    y.push_back(pmx_value_of(x[i]));
+  return y;
+}
+
+template <typename T, int R, int C>
+inline Eigen::Matrix<double, R, C> pmx_value_of(
+    const Eigen::Matrix<T, R, C>& x) {
+  Eigen::Matrix<double, R, C> y(x.rows(), x.cols());
+  for (int i = 0; i < x.size(); ++i)
+    y(i) = pmx_value_of(x(i));
+  return y;
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -0,0 +1,413 @@
+#ifndef STAN_MODEL_SOLUTION_CACHE_HPP
+#define STAN_MODEL_SOLUTION_CACHE_HPP
+
+#include <stan/math/rev.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Cache of value-only solutions of Torsten event solvers, used to
+ * avoid re-solving in <code>write_array</code> the ODE systems that
+ * were already solved (with gradients) by <code>log_prob</code> at
+ * the same point.
+ *
+ * <p>Caching is opt-in per call site: only the sites enabled with
+ * <code>enable_site</code>, or listed in the environment variable
+ * <code>TORSTEN_SOLUTION_CACHE_SITES</code> when the process-wide
+ * cache is created, are cached. A site is named either
+ * <code>solver(system)</code>, e.g. <code>pmx_solve_rk45(ode)</code>,
+ * or by the ODE system alone, which enables every solver of that
+ * system; the variable holds a comma-separated list of names.
+ *
+ * <p>An entry is keyed on the model (the type of the ODE system
+ * functor, which lives in the model's namespace), on the call site
+ * (solver and ODE system name) and on the exact values of every
+ * solver argument, so a lookup only hits when the same model's
+ * solver would be called with bit-wise identical inputs, even when
+ * several models share the process. Because transformed parameters are a
+ * deterministic function of the unconstrained parameters and the
+ * data, this is at least as selective as keying on the unconstrained
+ * parameter vector, and it stays correct for calls inside loops and
+ * for calls whose arguments do not depend on the parameters at all.
+ *
+ * <p>The cache holds the most recently stored solutions up to a
+ * memory budget and evicts the oldest first, so that all the points
+ * of a NUTS trajectory, including the one that is eventually
+ * accepted, can be held at once.
+ */
+class solution_cache {
+  struct entry {
+    std::string site;
+    std::vector<double> key;
+    Eigen::MatrixXd sol;
+    size_t bytes() const {
+      return sizeof(double) * (key.size() + sol.size()) + site.size();
+    }
+  };
+
+  std::unordered_multimap<size_t, const entry*> index_;
+  std::deque<entry> entries_;
+  std::unordered_set<std::string> enabled_sites_;
+  size_t bytes_;
+  size_t max_bytes_;
+  size_t max_entry_bytes_;
+  size_t hits_;
+  size_t misses_;
+  mutable std::mutex mutex_;
+
+  static size_t hash_key(const std::string& site,
+                         const std::vector<double>& key) {
+    size_t seed = boost::hash_value(site);
+    boost::hash_range(seed, key.begin(), key.end());
+    return seed;
+  }
+
+  void evict_oldest() {
+    const entry& e = entries_.front();
+    auto range = index_.equal_range(hash_key(e.site, e.key));
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == &e) {
+        index_.erase(it);
+        break;
+      }
+    }
+    bytes_ -= e.bytes();
+    entries_.pop_front();
+  }
+
+ public:
+  /**
+   * Construct an empty cache with the specified memory budget. A
+   * single solution may use at most a sixteenth of the budget.
+   *
+   * @param max_bytes maximum number of bytes held by the cache
+   */
+  explicit solution_cache(size_t max_bytes = 64 * 1024 * 1024)
+      : solution_cache(max_bytes, max_bytes / 16) {}
+
+  /**
+   * Construct an empty cache with the specified memory budget and
+   * per-entry limit.
+   *
+   * @param max_bytes maximum number of bytes held by the cache
+   * @param max_entry_bytes maximum number of bytes of one entry
+   */
+  solution_cache(size_t max_bytes, size_t max_entry_bytes)
+      : bytes_(0),
+        max_bytes_(max_bytes),
+        max_entry_bytes_(max_entry_bytes),
+        hits_(0),
+        misses_(0) {}
+
+  /**
+   * Return the process-wide cache used by generated model code,
+   * with the sites listed in <code>TORSTEN_SOLUTION_CACHE_SITES</code>
+   * enabled.
+   */
+  static solution_cache& instance() {
+    static solution_cache cache(sites_from_env());
+    return cache;
+  }
+
+  /**
+   * Enable caching for a call site, named <code>solver(system)</code>
+   * or by its ODE system.
+   *
+   * @param[in] name site or ODE system name
+   */
+  void enable_site(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_sites_.insert(name);
+  }
+
+  void disable_site(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_sites_.erase(name);
+  }
+
+  /**
+   * Return true if caching is enabled for the call site
+   * <code>solver(system)</code>, by its full name or its system.
+   *
+   * @param[in] site call site
+   */
+  bool enabled(const std::string& site) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (enabled_sites_.empty())
+      return false;
+    if (enabled_sites_.count(site))
+      return true;
+    size_t open = site.find('(');
+    size_t close = site.rfind(')');
+    return open != std::string::npos && close != std::string::npos
+           && close > open
+           && enabled_sites_.count(site.substr(open + 1, close - open - 1));
+  }
+
+  /**
+   * Return true if a solution with the specified number of values
+   * fits the per-entry limit, checked before its values are copied.
+   *
+   * @param[in] num_values number of values of the solution
+   */
+  bool fits(size_t num_values) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sizeof(double) * num_values <= max_entry_bytes_;
+  }
+
+  /**
+   * Look up the solution of the specified call site at the
+   * specified inputs.
+   *
+   * @param[in] site call site
+   * @param[in] key flattened solver inputs
+   * @param[out] sol solution, if found
+   * @return true if the solution was found
+   */
+  bool find(const std::string& site, const std::vector<double>& key,
+            Eigen::MatrixXd& sol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = index_.equal_range(hash_key(site, key));
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->site == site && it->second->key == key) {
+        sol = it->second->sol;
+        ++hits_;
+        return true;
+      }
+    }
+    ++misses_;
+    return false;
+  }
+
+  /**
+   * Store the solution of the specified call site at the specified
+   * inputs, evicting the oldest entries if the memory budget would
+   * be exceeded.
+   *
+   * @param[in] site call site
+   * @param[in] key flattened solver inputs
+   * @param[in] sol solution
+   */
+  void insert(const std::string& site, std::vector<double>&& key,
+              const Eigen::MatrixXd& sol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sizeof(double) * (key.size() + sol.size()) + site.size()
+        > max_entry_bytes_) {
+      return;
+    }
+    entries_.push_back(entry{site, std::move(key), sol});
+    const entry& e = entries_.back();
+    bytes_ += e.bytes();
+    while (bytes_ > max_bytes_) {
+      evict_oldest();
+    }
+    index_.emplace(hash_key(e.site, e.key), &e);
+  }
+
+  /**
+   * Remove all entries and reset the statistics.
+   */
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    entries_.clear();
+    bytes_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+  /**
+   * Set the memory budget, evicting the oldest entries if needed. A
+   * single solution may use at most a sixteenth of the budget.
+   *
+   * @param max_bytes maximum number of bytes held by the cache
+   */
+  void set_max_bytes(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    max_entry_bytes_ = max_bytes / 16;
+    while (bytes_ > max_bytes_) {
+      evict_oldest();
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+  size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+
+  size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+
+ private:
+  explicit solution_cache(const std::vector<std::string>& sites)
+      : solution_cache() {
+    enabled_sites_.insert(sites.begin(), sites.end());
+  }
+
+  static std::vector<std::string> sites_from_env() {
+    std::vector<std::string> sites;
+    const char* env = std::getenv("TORSTEN_SOLUTION_CACHE_SITES");
+    if (env == nullptr)
+      return sites;
+    std::string list(env);
+    boost::split(sites, list, boost::is_any_of(","));
+    for (std::string& site : sites)
+      boost::trim(site);
+    sites.erase(std::remove(sites.begin(), sites.end(), std::string()),
+                sites.end());
+    return sites;
+  }
+};
+
+namespace internal {
+
+inline void append_cache_key(std::vector<double>& key, int x) {
+  key.push_back(x);
+}
+
+inline void append_cache_key(std::vector<double>& key, double x) {
+  key.push_back(x);
+}
+
+inline void append_cache_key(std::vector<double>& key,
+                             const stan::math::var& x) {
+  key.push_back(x.val());
+}
+
+template <typename T>
+inline void append_cache_key(std::vector<double>& key,
+                             const std::vector<T>& x) {
+  key.push_back(x.size());
+  for (const auto& xi : x) {
+    append_cache_key(key, xi);
+  }
+}
+
+template <typename T, int R, int C>
+inline void append_cache_key(std::vector<double>& key,
+                             const Eigen::Matrix<T, R, C>& x) {
+  key.push_back(x.rows());
+  key.push_back(x.cols());
+  for (int i = 0; i < x.size(); ++i) {
+    append_cache_key(key, x(i));
+  }
+}
+
+inline bool find_cached_solution(solution_cache& cache, const char* site,
+                                 const std::vector<double>& key,
+                                 Eigen::MatrixXd& sol) {
+  return cache.find(site, key, sol);
+}
+
+/**
+ * Solutions carrying autodiff variables are never read from the
+ * cache, as the solve is needed to build the expression graph.
+ */
+template <typename T>
+inline bool find_cached_solution(solution_cache& cache, const char* site,
+                                 const std::vector<double>& key, T& sol) {
+  return false;
+}
+
+/**
+ * Return the identity of a call site in the cache: the type of the
+ * ODE system functor, which is unique to the model that defines it,
+ * followed by the site name.
+ */
+template <typename System>
+inline std::string cache_site_id(const char* site) {
+  std::string id(typeid(System).name());
+  id += ':';
+  id += site;
+  return id;
+}
+
+}  // namespace internal
+
+/**
+ * Solve a Torsten event system through the process-wide
+ * <code>solution_cache</code>.
+ *
+ * <p>When the solution carries autodiff variables (the
+ * <code>log_prob</code> gradient pass) the system is always solved
+ * and its values are stored. When the solution is
+ * <code>double</code>-valued (<code>write_array</code> and
+ * <code>double</code> <code>log_prob</code> evaluations) a cached
+ * solution for identical inputs is returned if there is one, and
+ * the solution is stored otherwise.
+ *
+ * <p>The cache is opt-in: unless the model is compiled with
+ * <code>TORSTEN_SOLUTION_CACHE</code> and the site is enabled in the
+ * cache, this simply calls the solver, without building a key or
+ * copying the solution. Solutions too large for the per-entry limit
+ * are not copied into the cache. Collective calls (group solvers
+ * that communicate across MPI ranks) are never cached under
+ * <code>TORSTEN_MPI</code>, since a cache hit on one rank would skip
+ * the communication expected by the others.
+ *
+ * @tparam System type of the ODE system functor, identifying the
+ *   model
+ * @tparam F type of solver functor
+ * @tparam Args types of solver arguments
+ * @param[in] site call site, naming the solver and ODE system
+ * @param[in] collective true if the solver communicates across ranks
+ * @param[in] solve functor calling the solver with the arguments
+ * @param[in] args solver arguments
+ * @return solution matrix
+ */
+template <typename System, typename F, typename... Args>
+inline auto cached_solve(const char* site, bool collective, const F& solve,
+                         const Args&... args) {
+  using result_t = decltype(solve(args...));
+#ifdef TORSTEN_SOLUTION_CACHE
+#ifdef TORSTEN_MPI
+  if (collective) {
+    return result_t(solve(args...));
+  }
+#endif
+  solution_cache& cache = solution_cache::instance();
+  if (!cache.enabled(site)) {
+    return result_t(solve(args...));
+  }
+  std::string id = internal::cache_site_id<System>(site);
+  std::vector<double> key;
+  (void)std::initializer_list<int>{
+      (internal::append_cache_key(key, args), 0)...};
+  result_t res;
+  if (!internal::find_cached_solution(cache, id.c_str(), key, res)) {
+    res = solve(args...);
+    if (cache.fits(res.size())) {
+      cache.insert(id, std::move(key), stan::math::value_of(res));
+    }
+  }
+  return res;
+#else
+  return result_t(solve(args...));
+#endif
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
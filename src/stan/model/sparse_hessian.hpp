@@ -0,0 +1,317 @@
+#ifndef STAN_MODEL_SPARSE_HESSIAN_HPP
+#define STAN_MODEL_SPARSE_HESSIAN_HPP
+
+#include <stan/math/mix.hpp>
+#include <stan/model/model_functional.hpp>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Sparsity pattern of a symmetric Hessian together with a star
+ * coloring of its adjacency graph (Gebremedhin, Manne and Pothen,
+ * 2005), so that the whole Hessian can be recovered directly from one
+ * Hessian-vector product per color rather than one per parameter.
+ *
+ * <p>Two parameters share a color only if they do not interact, and
+ * every path of four parameters uses at least three colors. Each
+ * off-diagonal nonzero <code>H(i, j)</code> is then the only term of
+ * color <code>color(j)</code> in row <code>i</code> of the product
+ * of the Hessian with the indicator vector of that color, or the
+ * symmetric case with <code>i</code> and <code>j</code> swapped. For
+ * a hierarchical model with <code>p</code> population parameters and
+ * subjects of <code>s</code> parameters each, the number of colors is
+ * about <code>p + s</code> regardless of the number of subjects.
+ *
+ * <p>The diagonal is always part of the pattern.
+ */
+class hessian_sparsity {
+ public:
+  /**
+   * Construct the sparsity pattern of a Hessian of the specified
+   * dimension with the specified nonzero entries, and color it. Each
+   * pair may be given in either or both orders.
+   *
+   * @param[in] dimension number of parameters
+   * @param[in] nonzeros row and column indices of nonzero entries
+   * @throw std::invalid_argument if an index is out of range
+   */
+  hessian_sparsity(int dimension,
+                   const std::vector<std::pair<int, int> >& nonzeros)
+      : dimension_(dimension), adjacency_(dimension), colors_(dimension, -1) {
+    for (const std::pair<int, int>& nz : nonzeros) {
+      if (nz.first < 0 || nz.first >= dimension || nz.second < 0
+          || nz.second >= dimension)
+        throw std::invalid_argument(
+            "hessian_sparsity: nonzero index out of range");
+      if (nz.first != nz.second) {
+        adjacency_[nz.first].push_back(nz.second);
+        adjacency_[nz.second].push_back(nz.first);
+      }
+    }
+    for (std::vector<int>& adj : adjacency_) {
+      std::sort(adj.begin(), adj.end());
+      adj.erase(std::unique(adj.begin(), adj.end()), adj.end());
+    }
+    star_color();
+    build_recovery();
+  }
+
+  int dimension() const { return dimension_; }
+
+  /**
+   * Return the number of structural nonzeros of the full Hessian,
+   * diagonal included.
+   */
+  int num_nonzeros() const {
+    int n = dimension_;
+    for (const std::vector<int>& adj : adjacency_)
+      n += adj.size();
+    return n;
+  }
+
+  /**
+   * Return the number of colors, which is the number of
+   * Hessian-vector products needed to compute the Hessian.
+   */
+  int num_colors() const { return num_colors_; }
+
+  /**
+   * Return the color of each parameter.
+   */
+  const std::vector<int>& colors() const { return colors_; }
+
+  /**
+   * Return the sorted indices of the parameters that interact with
+   * the specified parameter, excluding itself.
+   *
+   * @param[in] i parameter index
+   */
+  const std::vector<int>& neighbors(int i) const { return adjacency_[i]; }
+
+  /**
+   * Return the indicator vector of the parameters of the specified
+   * color, the direction of one compressed Hessian-vector product.
+   *
+   * @param[in] color color index
+   */
+  Eigen::VectorXd seed(int color) const {
+    Eigen::VectorXd s = Eigen::VectorXd::Zero(dimension_);
+    for (int i = 0; i < dimension_; ++i)
+      if (colors_[i] == color)
+        s(i) = 1;
+    return s;
+  }
+
+  /**
+   * Recover the Hessian from the compressed products.
+   *
+   * @param[in] compressed matrix whose column <code>c</code> is the
+   * product of the Hessian with <code>seed(c)</code>
+   * @param[out] hessian full symmetric Hessian
+   */
+  void recover(const Eigen::MatrixXd& compressed,
+               Eigen::SparseMatrix<double>& hessian) const {
+    std::vector<Eigen::Triplet<double> > triplets;
+    triplets.reserve(num_nonzeros());
+    for (const entry& e : recovery_) {
+      double h = compressed(e.source_row, e.source_color);
+      triplets.emplace_back(e.row, e.col, h);
+      if (e.row != e.col)
+        triplets.emplace_back(e.col, e.row, h);
+    }
+    hessian.resize(dimension_, dimension_);
+    hessian.setFromTriplets(triplets.begin(), triplets.end());
+  }
+
+ private:
+  struct entry {
+    int row;
+    int col;
+    int source_row;
+    int source_color;
+  };
+
+  int dimension_;
+  std::vector<std::vector<int> > adjacency_;
+  std::vector<int> colors_;
+  int num_colors_;
+  std::vector<entry> recovery_;
+
+  /*
+   * Greedy star coloring, visiting parameters by decreasing degree.
+   */
+  void star_color() {
+    std::vector<int> order(dimension_);
+    for (int i = 0; i < dimension_; ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+      return adjacency_[a].size() > adjacency_[b].size();
+    });
+
+    std::vector<int> forbidden(dimension_ + 1, -1);
+    num_colors_ = 0;
+    for (int v : order) {
+      for (int w : adjacency_[v]) {
+        if (colors_[w] >= 0) {
+          forbidden[colors_[w]] = v;
+          for (int x : adjacency_[w]) {
+            if (x == v || colors_[x] < 0)
+              continue;
+            for (int y : adjacency_[x]) {
+              if (y != w && colors_[y] == colors_[w]) {
+                forbidden[colors_[x]] = v;
+                break;
+              }
+            }
+          }
+        } else {
+          for (int x : adjacency_[w])
+            if (colors_[x] >= 0)
+              forbidden[colors_[x]] = v;
+        }
+      }
+      int c = 0;
+      while (forbidden[c] == v)
+        ++c;
+      colors_[v] = c;
+      num_colors_ = std::max(num_colors_, c + 1);
+    }
+  }
+
+  bool unique_color_neighbor(int i, int j) const {
+    for (int k : adjacency_[i])
+      if (k != j && colors_[k] == colors_[j])
+        return false;
+    return true;
+  }
+
+  void build_recovery() {
+    for (int i = 0; i < dimension_; ++i) {
+      recovery_.push_back({i, i, i, colors_[i]});
+      for (int j : adjacency_[i]) {
+        if (j > i)
+          continue;
+        if (unique_color_neighbor(i, j))
+          recovery_.push_back({i, j, i, colors_[j]});
+        else if (unique_color_neighbor(j, i))
+          recovery_.push_back({i, j, j, colors_[i]});
+        else
+          throw std::logic_error(
+              "hessian_sparsity: coloring does not allow direct recovery");
+      }
+    }
+  }
+};
+
+/**
+ * Detect the sparsity pattern of the Hessian of the log density of a
+ * model by computing the dense Hessian once at the specified point and
+ * once at a slightly perturbed point, and marking the entries that are
+ * nonzero at either. The perturbation guards against entries that
+ * vanish by accident at the initial point; entries that are zero at
+ * both points but nonzero elsewhere are not detected.
+ *
+ * <p>This costs two dense Hessians, after which every Hessian of the
+ * model costs one gradient and <code>num_colors()</code>
+ * Hessian-vector products.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to the
+ * log probability.
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] params_r Real-valued parameter vector.
+ * @param[in, out] msgs Stream to which print statements in Stan
+ * programs are written, default is 0
+ * @return sparsity pattern and coloring of the Hessian
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+hessian_sparsity detect_hessian_sparsity(const M& model,
+                                         const Eigen::VectorXd& params_r,
+                                         std::ostream* msgs = 0) {
+  internal::log_prob_functional<propto, jacobian_adjust_transform, M> f(model,
+                                                                        msgs);
+  int d = params_r.size();
+  double fx;
+  Eigen::VectorXd grad;
+  Eigen::MatrixXd H;
+  Eigen::MatrixXd H_jitter;
+  stan::math::hessian(f, params_r, fx, grad, H);
+
+  Eigen::VectorXd jittered = params_r;
+  for (int i = 0; i < d; ++i)
+    jittered(i) += 1e-3 * (1 + (i * 7919) % 13) / 13.0;
+  stan::math::hessian(f, jittered, fx, grad, H_jitter);
+
+  std::vector<std::pair<int, int> > nonzeros;
+  for (int j = 0; j < d; ++j)
+    for (int i = j + 1; i < d; ++i)
+      if (H(i, j) != 0 || H(j, i) != 0 || H_jitter(i, j) != 0
+          || H_jitter(j, i) != 0)
+        nonzeros.emplace_back(i, j);
+  return hessian_sparsity(d, nonzeros);
+}
+
+/**
+ * Evaluate the log-probability, its gradient, and its sparse Hessian
+ * at params_r, using one Hessian-vector product per color of the
+ * specified sparsity pattern.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to the
+ * log probability.
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] sparsity Sparsity pattern of the Hessian, e.g. from
+ * <code>detect_hessian_sparsity</code>.
+ * @param[in] params_r Real-valued parameter vector.
+ * @param[out] gradient Vector to write gradient to.
+ * @param[out] hessian Full symmetric Hessian.
+ * @param[in, out] msgs Stream to which print statements in Stan
+ * programs are written, default is 0
+ * @return log density
+ * @throw std::invalid_argument if the dimension of the sparsity
+ * pattern does not match the parameters
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+double sparse_grad_hess_log_prob(const M& model,
+                                 const hessian_sparsity& sparsity,
+                                 const Eigen::VectorXd& params_r,
+                                 Eigen::VectorXd& gradient,
+                                 Eigen::SparseMatrix<double>& hessian,
+                                 std::ostream* msgs = 0) {
+  if (sparsity.dimension() != params_r.size())
+    throw std::invalid_argument(
+        "sparse_grad_hess_log_prob: dimension of sparsity pattern does not "
+        "match the number of parameters");
+  internal::log_prob_functional<propto, jacobian_adjust_transform, M> f(model,
+                                                                        msgs);
+  double fx;
+  stan::math::gradient(f, params_r, fx, gradient);
+
+  Eigen::MatrixXd compressed(params_r.size(), sparsity.num_colors());
+  for (int c = 0; c < sparsity.num_colors(); ++c) {
+    double fx_c;
+    Eigen::VectorXd hv;
+    stan::math::hessian_times_vector(f, params_r, sparsity.seed(c), fx_c, hv);
+    compressed.col(c) = hv;
+  }
+  sparsity.recover(compressed, hessian);
+  return fx;
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -0,0 +1,358 @@
+#ifndef STAN_MODEL_TRANSFORMED_DATA_CACHE_HPP
+#define STAN_MODEL_TRANSFORMED_DATA_CACHE_HPP
+
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+
+namespace stan {
+namespace model {
+
+namespace internal {
+
+/*
+ * 128-bit FNV-1a hash, stable across runs and platforms of the same
+ * endianness.
+ */
+class data_hash {
+ public:
+  data_hash() : h1_(14695981039346656037ULL), h2_(0x6c62272e07bb0142ULL) {}
+
+  void add_bytes(const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+      h1_ = (h1_ ^ p[i]) * 1099511628211ULL;
+      h2_ = (h2_ ^ p[i]) * 0x100000001b3ULL;
+      h2_ ^= h2_ >> 29;
+    }
+  }
+
+  void add(const std::string& s) {
+    add(static_cast<uint64_t>(s.size()));
+    add_bytes(s.data(), s.size());
+  }
+
+  template <typename T>
+  void add(const T& x) {
+    add_bytes(&x, sizeof(T));
+  }
+
+  template <typename T>
+  void add(const std::vector<T>& x) {
+    add(static_cast<uint64_t>(x.size()));
+    for (const T& xi : x)
+      add(xi);
+  }
+
+  std::string hex() const {
+    std::stringstream ss;
+    ss << std::hex;
+    ss.fill('0');
+    ss.width(16);
+    ss << h1_;
+    ss.width(16);
+    ss << h2_;
+    return ss.str();
+  }
+
+ private:
+  uint64_t h1_;
+  uint64_t h2_;
+};
+
+/*
+ * Members are written and read recursively; every overload is declared
+ * before the definitions so that containers of containers, e.g.
+ * std::vector<Eigen::VectorXd>, resolve to the matching overload
+ * rather than to the raw bytes of the generic one.
+ */
+template <typename T>
+inline void write_member(std::ostream& out, const T& x);
+inline void write_member(std::ostream& out, const std::string& x);
+template <typename T>
+inline void write_member(std::ostream& out, const std::vector<T>& x);
+template <typename T, int R, int C>
+inline void write_member(std::ostream& out, const Eigen::Matrix<T, R, C>& x);
+
+template <typename T>
+inline bool read_member(std::istream& in, T& x);
+inline bool read_member(std::istream& in, std::string& x);
+template <typename T>
+inline bool read_member(std::istream& in, std::vector<T>& x);
+template <typename T, int R, int C>
+inline bool read_member(std::istream& in, Eigen::Matrix<T, R, C>& x);
+
+template <typename T>
+inline void write_member(std::ostream& out, const T& x) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "transformed data members must be scalars, strings, "
+                "std::vector or Eigen::Matrix");
+  out.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+inline void write_member(std::ostream& out, const std::string& x) {
+  write_member(out, static_cast<uint64_t>(x.size()));
+  out.write(x.data(), x.size());
+}
+
+template <typename T>
+inline void write_member(std::ostream& out, const std::vector<T>& x) {
+  write_member(out, static_cast<uint64_t>(x.size()));
+  for (const T& xi : x)
+    write_member(out, xi);
+}
+
+template <typename T, int R, int C>
+inline void write_member(std::ostream& out, const Eigen::Matrix<T, R, C>& x) {
+  write_member(out, static_cast<int64_t>(x.rows()));
+  write_member(out, static_cast<int64_t>(x.cols()));
+  for (int i = 0; i < x.size(); ++i)
+    write_member(out, x(i));
+}
+
+template <typename T>
+inline bool read_member(std::istream& in, T& x) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "transformed data members must be scalars, strings, "
+                "std::vector or Eigen::Matrix");
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&x), sizeof(T)));
+}
+
+inline bool read_member(std::istream& in, std::string& x) {
+  uint64_t n;
+  if (!read_member(in, n))
+    return false;
+  x.resize(n);
+  return n == 0 || static_cast<bool>(in.read(&x[0], n));
+}
+
+template <typename T>
+inline bool read_member(std::istream& in, std::vector<T>& x) {
+  uint64_t n;
+  if (!read_member(in, n))
+    return false;
+  x.resize(n);
+  for (T& xi : x)
+    if (!read_member(in, xi))
+      return false;
+  return true;
+}
+
+template <typename T, int R, int C>
+inline bool read_member(std::istream& in, Eigen::Matrix<T, R, C>& x) {
+  int64_t rows, cols;
+  if (!read_member(in, rows) || !read_member(in, cols))
+    return false;
+  if ((R != Eigen::Dynamic && rows != R) || (C != Eigen::Dynamic && cols != C))
+    return false;
+  x.resize(rows, cols);
+  for (int i = 0; i < x.size(); ++i)
+    if (!read_member(in, x(i)))
+      return false;
+  return true;
+}
+
+inline bool read_members(std::istream& in) { return true; }
+
+template <typename T, typename... Ts>
+inline bool read_members(std::istream& in, T& x, Ts&... xs) {
+  return read_member(in, x) && read_members(in, xs...);
+}
+
+inline void write_members(std::ostream& out) {}
+
+template <typename T, typename... Ts>
+inline void write_members(std::ostream& out, const T& x, const Ts&... xs) {
+  write_member(out, x);
+  write_members(out, xs...);
+}
+
+}  // namespace internal
+
+/**
+ * Cache of the transformed data members of a model in a binary file,
+ * so that heavy transformed data computations (distance matrices,
+ * spline bases, event expansions) are done once for a given model
+ * and data set rather than in every chain process, MPI rank and refit.
+ *
+ * <p>The cache file is named after the model and a 128-bit hash of
+ * the model name, a hash of the program, the model's compile
+ * information, the random seed (transformed data may draw random
+ * numbers) and every variable of the data context. The program hash
+ * identifies the program itself, e.g. a hash of its Stan or generated
+ * C++ source, so that editing a program without renaming it never
+ * loads members computed by the old one. The file repeats the hash
+ * and the model identity, which are checked on load together with the
+ * number and shapes of the members; on any mismatch the members are
+ * recomputed and the file is rewritten. Files are written to a unique
+ * temporary file and renamed, so that concurrent constructions never
+ * read a partial file.
+ *
+ * <p>The cache is opt-in: it is disabled unless a directory is given,
+ * by default the value of the <code>STAN_TRANSFORMED_DATA_CACHE</code>
+ * environment variable. Members may be scalars, strings,
+ * <code>std::vector</code>s and Eigen matrices of those. The model
+ * constructor uses it as
+ * <pre>
+ * transformed_data_cache cache(model_name(), program_hash,
+ *                              model_compile_info(), context__,
+ *                              random_seed__);
+ * if (!cache.load(td1, td2)) {
+ *   // compute td1, td2
+ *   cache.store(td1, td2);
+ * }
+ * </pre>
+ */
+class transformed_data_cache {
+ public:
+  /**
+   * Construct a cache for the specified model and data.
+   *
+   * @param model_name name of the model
+   * @param program_hash hash of the program source
+   * @param compile_info compile information of the model
+   * @param context data of the model
+   * @param random_seed seed of the model's random number generator
+   * @param directory directory of cache files, empty to disable
+   */
+  transformed_data_cache(const std::string& model_name,
+                         const std::string& program_hash,
+                         const std::vector<std::string>& compile_info,
+                         const stan::io::var_context& context,
+                         unsigned int random_seed = 0,
+                         const std::string& directory = default_directory())
+      : model_name_(model_name),
+        program_hash_(program_hash),
+        compile_info_(compile_info) {
+    if (directory.empty())
+      return;
+
+    internal::data_hash hash;
+    hash.add(model_name);
+    hash.add(program_hash);
+    hash.add(compile_info);
+    hash.add(random_seed);
+
+    std::vector<std::string> names;
+    context.names_r(names);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+      hash.add(name);
+      hash.add(context.dims_r(name));
+      hash.add(context.vals_r(name));
+    }
+    names.clear();
+    context.names_i(names);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+      hash.add(name);
+      hash.add(context.dims_i(name));
+      hash.add(context.vals_i(name));
+    }
+
+    hash_ = hash.hex();
+    file_name_ = directory + "/" + model_name + "-" + hash_ + ".tdata";
+  }
+
+  /**
+   * Return the directory named by the environment variable
+   * <code>STAN_TRANSFORMED_DATA_CACHE</code>, or an empty string.
+   */
+  static std::string default_directory() {
+    const char* dir = std::getenv("STAN_TRANSFORMED_DATA_CACHE");
+    return dir == nullptr ? std::string() : std::string(dir);
+  }
+
+  bool enabled() const { return !file_name_.empty(); }
+
+  const std::string& file_name() const { return file_name_; }
+
+  const std::string& hash() const { return hash_; }
+
+  /**
+   * Load the transformed data members from the cache file.
+   *
+   * @param[out] members transformed data members, in the order they
+   * were stored
+   * @return true if the members were loaded, false if the cache is
+   * disabled, the file does not exist or does not match.
+   */
+  template <typename... Ts>
+  bool load(Ts&... members) const {
+    if (!enabled())
+      return false;
+    std::ifstream in(file_name_.c_str(), std::ios::binary);
+    if (!in)
+      return false;
+    std::string magic, hash, model_name, program_hash;
+    std::vector<std::string> compile_info;
+    uint64_t num_members;
+    if (!internal::read_members(in, magic, hash, model_name, program_hash,
+                                compile_info, num_members))
+      return false;
+    if (magic != file_magic() || hash != hash_ || model_name != model_name_
+        || program_hash != program_hash_ || compile_info != compile_info_
+        || num_members != sizeof...(Ts))
+      return false;
+    if (!internal::read_members(in, members...))
+      return false;
+    return in.peek() == std::char_traits<char>::eof();
+  }
+
+  /**
+   * Store the transformed data members in the cache file. Failure to
+   * write the file is silently ignored.
+   *
+   * @param[in] members transformed data members
+   */
+  template <typename... Ts>
+  void store(const Ts&... members) const {
+    if (!enabled())
+      return;
+    // mkstemp creates a file no other process or thread can also
+    // create, including other hosts on a shared file system
+    std::string tmp_name = file_name_ + ".tmpXXXXXX";
+    int fd = mkstemp(&tmp_name[0]);
+    if (fd == -1)
+      return;
+    close(fd);
+    {
+      std::ofstream out(tmp_name.c_str(), std::ios::binary | std::ios::trunc);
+      if (out) {
+        internal::write_members(out, file_magic(), hash_, model_name_,
+                                program_hash_, compile_info_,
+                                static_cast<uint64_t>(sizeof...(Ts)));
+        internal::write_members(out, members...);
+      }
+      if (!out) {
+        out.close();
+        std::remove(tmp_name.c_str());
+        return;
+      }
+    }
+    if (std::rename(tmp_name.c_str(), file_name_.c_str()) != 0)
+      std::remove(tmp_name.c_str());
+  }
+
+ private:
+  std::string model_name_;
+  std::string program_hash_;
+  std::vector<std::string> compile_info_;
+  std::string hash_;
+  std::string file_name_;
+
+  static std::string file_magic() { return "stan_transformed_data_v2"; }
+};
+
+}  // namespace model
+}  // namespace stan
+#endif
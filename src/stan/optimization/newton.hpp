@@ -3,7 +3,10 @@
 
 #include <stan/model/grad_hess_log_prob.hpp>
 #include <stan/model/log_prob_grad.hpp>
+#include <stan/model/sparse_hessian.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <Eigen/Sparse>
+#include <algorithm>
 #include <vector>
 
 namespace stan {
@@ -26,25 +29,15 @@ inline void make_negative_definite_and_solve(matrix_d& H, vector_d& g) {
   g = eigenvectors * eigenprojections;
 }
 
+// Backtracking line search along -g from params_r, halving the step
+// from 1 until the log density does not decrease below f0. Updates
+// params_r and returns the new log density, or returns f0 and leaves
+// params_r unchanged if no step improves.
 template <typename M>
-double newton_step(M& model, std::vector<double>& params_r,
-                   std::vector<int>& params_i,
-                   std::ostream* output_stream = 0) {
+double newton_line_search(M& model, std::vector<double>& params_r,
+                          std::vector<int>& params_i, double f0,
+                          const vector_d& g) {
   std::vector<double> gradient;
-  std::vector<double> hessian;
-
-  double f0 = stan::model::grad_hess_log_prob<true, false>(
-      model, params_r, params_i, gradient, hessian);
-  matrix_d H(params_r.size(), params_r.size());
-  for (size_t i = 0; i < hessian.size(); i++) {
-    H(i) = hessian[i];
-  }
-  vector_d g(params_r.size());
-  for (size_t i = 0; i < gradient.size(); i++)
-    g(i) = gradient[i];
-  make_negative_definite_and_solve(H, g);
-  //         H.ldlt().solveInPlace(g);
-
   std::vector<double> new_params_r(params_r.size());
   double step_size = 2;
   double min_step_size = 1e-50;
@@ -71,6 +64,85 @@ double newton_step(M& model, std::vector<double>& params_r,
   return f1;
 }
 
+template <typename M>
+double newton_step(M& model, std::vector<double>& params_r,
+                   std::vector<int>& params_i,
+                   std::ostream* output_stream = 0) {
+  std::vector<double> gradient;
+  std::vector<double> hessian;
+
+  double f0 = stan::model::grad_hess_log_prob<true, false>(
+      model, params_r, params_i, gradient, hessian);
+  matrix_d H(params_r.size(), params_r.size());
+  for (size_t i = 0; i < hessian.size(); i++) {
+    H(i) = hessian[i];
+  }
+  vector_d g(params_r.size());
+  for (size_t i = 0; i < gradient.size(); i++)
+    g(i) = gradient[i];
+  make_negative_definite_and_solve(H, g);
+  //         H.ldlt().solveInPlace(g);
+
+  return newton_line_search(model, params_r, params_i, f0, g);
+}
+
+// Solves (-H + tau I) u = g for the smallest tau in 0, 1e-8, 1e-7,
+// ... (relative to the largest diagonal entry of H) for which the
+// shifted matrix is positive definite, and stores -u into g, so that
+// g has the same role as after make_negative_definite_and_solve.
+// The sparse Cholesky factorization keeps the cost proportional to
+// the fill-in of H rather than its dimension cubed.
+inline void shift_negative_definite_and_solve(
+    const Eigen::SparseMatrix<double>& H, vector_d& g) {
+  Eigen::SparseMatrix<double> A = -H;
+  double scale = std::max(1.0, H.diagonal().cwiseAbs().maxCoeff());
+  Eigen::SparseMatrix<double> identity(H.rows(), H.cols());
+  identity.setIdentity();
+  Eigen::SimplicialLLT<Eigen::SparseMatrix<double> > llt;
+  llt.analyzePattern(A);
+  for (double tau = 0; tau < 1e10 * scale;
+       tau = (tau == 0 ? 1e-8 * scale : 10 * tau)) {
+    llt.factorize(A + tau * identity);
+    if (llt.info() == Eigen::Success) {
+      g = -llt.solve(g);
+      return;
+    }
+  }
+  g *= -1 / scale;
+}
+
+/**
+ * Take one Newton step with the Hessian computed from one
+ * Hessian-vector product per color of the specified sparsity pattern
+ * and factored with a sparse Cholesky decomposition; see
+ * <code>stan::model::detect_hessian_sparsity</code>.
+ *
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] sparsity Sparsity pattern of the Hessian of the log
+ * density without Jacobian adjustment.
+ * @param[in,out] params_r Real-valued parameter vector.
+ * @param[in] params_i Integer-valued parameter vector.
+ * @param[in, out] output_stream Stream to which print statements in
+ * Stan programs are written, default is 0
+ * @return log density after the step
+ */
+template <typename M>
+double sparse_newton_step(M& model,
+                          const stan::model::hessian_sparsity& sparsity,
+                          std::vector<double>& params_r,
+                          std::vector<int>& params_i,
+                          std::ostream* output_stream = 0) {
+  vector_d x = Eigen::Map<vector_d>(params_r.data(), params_r.size());
+  vector_d g;
+  Eigen::SparseMatrix<double> H;
+  double f0 = stan::model::sparse_grad_hess_log_prob<true, false>(
+      model, sparsity, x, g, H, output_stream);
+  shift_negative_definite_and_solve(H, g);
+
+  return newton_line_search(model, params_r, params_i, f0, g);
+}
+
 }  // namespace optimization
 }  // namespace stan
 #endif
@@ -8,6 +8,7 @@
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/io/var_context.hpp>
+#include <stan/services/error_codes.hpp>
 #include <stan/variational/advi.hpp>
 #include <boost/random/additive_combine.hpp>
 #include <string>
@@ -19,7 +20,10 @@ namespace experimental {
 namespace advi {
 
 /**
- * Runs full rank ADVI.
+ * Runs full rank ADVI, estimating each ELBO gradient from a random
+ * minibatch of the observations when <code>minibatch_size</code> is
+ * positive. The model must then provide the minibatch hook described
+ * in <code>stan::variational::has_minibatch</code>.
  *
  * @tparam Model A model implementation
  * @param[in] model Input model to test (with data already instantiated)
@@ -40,12 +44,17 @@ namespace advi {
  * @param[in] eval_elbo evaluate ELBO every Nth iteration
  * @param[in] output_samples number of posterior samples to draw and
  *   save
+ * @param[in] num_observations number of observations in the model's
+ *   minibatch index
+ * @param[in] minibatch_size number of observations per minibatch, or 0
+ *   to use all observations
  * @param[in,out] interrupt callback to be called every iteration
  * @param[in,out] logger Logger for messages
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] parameter_writer output for parameter values
  * @param[in,out] diagnostic_writer output for diagnostic values
- * @return error_codes::OK if successful
+ * @return error_codes::OK if successful, error_codes::CONFIG if the
+ *   minibatch is misconfigured
  */
 template <class Model>
 int fullrank(Model& model, const stan::io::var_context& init,
@@ -53,6 +62,7 @@ int fullrank(Model& model, const stan::io::var_context& init,
              int grad_samples, int elbo_samples, int max_iterations,
              double tol_rel_obj, double eta, bool adapt_engaged,
              int adapt_iterations, int eval_elbo, int output_samples,
+             int num_observations, int minibatch_size,
              callbacks::interrupt& interrupt, callbacks::logger& logger,
              callbacks::writer& init_writer,
              callbacks::writer& parameter_writer,
@@ -79,11 +89,65 @@ int fullrank(Model& model, const stan::io::var_context& init,
                           boost::ecuyer1988>
       cmd_advi(model, cont_params, rng, grad_samples, elbo_samples, eval_elbo,
                output_samples);
+  if (minibatch_size > 0) {
+    try {
+      cmd_advi.set_minibatch(num_observations, minibatch_size);
+    } catch (const std::domain_error& e) {
+      logger.error(e.what());
+      return error_codes::CONFIG;
+    }
+  }
   cmd_advi.run(eta, adapt_engaged, adapt_iterations, tol_rel_obj,
                max_iterations, logger, parameter_writer, diagnostic_writer);
 
   return 0;
 }
+
+/**
+ * Runs full rank ADVI.
+ *
+ * @tparam Model A model implementation
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] grad_samples number of samples for Monte Carlo estimate
+ *   of gradients
+ * @param[in] elbo_samples number of samples for Monte Carlo estimate
+ *   of ELBO
+ * @param[in] max_iterations maximum number of iterations
+ * @param[in] tol_rel_obj convergence tolerance on the relative norm of
+ *   the objective
+ * @param[in] eta stepsize scaling parameter for variational inference
+ * @param[in] adapt_engaged adaptation engaged?
+ * @param[in] adapt_iterations number of iterations for eta adaptation
+ * @param[in] eval_elbo evaluate ELBO every Nth iteration
+ * @param[in] output_samples number of posterior samples to draw and
+ *   save
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @param[in,out] diagnostic_writer output for diagnostic values
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int fullrank(Model& model, const stan::io::var_context& init,
+             unsigned int random_seed, unsigned int chain, double init_radius,
+             int grad_samples, int elbo_samples, int max_iterations,
+             double tol_rel_obj, double eta, bool adapt_engaged,
+             int adapt_iterations, int eval_elbo, int output_samples,
+             callbacks::interrupt& interrupt, callbacks::logger& logger,
+             callbacks::writer& init_writer,
+             callbacks::writer& parameter_writer,
+             callbacks::writer& diagnostic_writer) {
+  return fullrank(model, init, random_seed, chain, init_radius, grad_samples,
+                  elbo_samples, max_iterations, tol_rel_obj, eta,
+                  adapt_engaged, adapt_iterations, eval_elbo, output_samples,
+                  0, 0, interrupt, logger, init_writer, parameter_writer,
+                  diagnostic_writer);
+}
 }  // namespace advi
 }  // namespace experimental
 }  // namespace services
@@ -0,0 +1,121 @@
+#ifndef STAN_SERVICES_LOG_DENSITY_LATENCY_STATS_HPP
+#define STAN_SERVICES_LOG_DENSITY_LATENCY_STATS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace log_density {
+
+/**
+ * Thread-safe summary of request latencies: the count, mean and
+ * maximum, and quantiles from a histogram with eight buckets per
+ * doubling of the latency between one microsecond and about an hour,
+ * so quantiles are accurate to about 9%.
+ */
+class latency_stats {
+ public:
+  latency_stats()
+      : count_(0), sum_(0), max_(0), histogram_(num_buckets, 0) {}
+
+  /**
+   * Add the latency of one request.
+   *
+   * @param[in] seconds latency in seconds
+   */
+  void record(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++count_;
+    sum_ += seconds;
+    max_ = std::max(max_, seconds);
+    ++histogram_[bucket(seconds)];
+  }
+
+  long count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+  /**
+   * Return the mean latency in seconds, or 0 if there are no
+   * requests.
+   */
+  double mean() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ == 0 ? 0 : sum_ / count_;
+  }
+
+  /**
+   * Return the largest latency in seconds.
+   */
+  double max() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_;
+  }
+
+  /**
+   * Return an approximate quantile of the latencies in seconds, the
+   * upper edge of the histogram bucket holding it, or 0 if there are
+   * no requests.
+   *
+   * @param[in] p probability in <code>[0, 1]</code>
+   */
+  double quantile(double p) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0)
+      return 0;
+    long rank = std::max(1L, static_cast<long>(std::ceil(p * count_)));
+    long seen = 0;
+    for (int b = 0; b < num_buckets; ++b) {
+      seen += histogram_[b];
+      if (seen >= rank)
+        return std::min(max_, upper_edge(b));
+    }
+    return max_;
+  }
+
+  /**
+   * Return a one-line summary with latencies in microseconds.
+   */
+  std::string summary() const {
+    std::stringstream ss;
+    ss << "count=" << count() << " mean_us=" << 1e6 * mean()
+       << " p50_us=" << 1e6 * quantile(0.5)
+       << " p99_us=" << 1e6 * quantile(0.99) << " max_us=" << 1e6 * max();
+    return ss.str();
+  }
+
+ private:
+  static const int buckets_per_doubling = 8;
+  static const int num_buckets = 32 * buckets_per_doubling;
+
+  mutable std::mutex mutex_;
+  long count_;
+  double sum_;
+  double max_;
+  std::vector<long> histogram_;
+
+  static int bucket(double seconds) {
+    double micros = 1e6 * seconds;
+    if (!(micros > 1))
+      return 0;
+    int b = static_cast<int>(
+        std::ceil(buckets_per_doubling * std::log2(micros)));
+    return std::min(b, num_buckets - 1);
+  }
+
+  static double upper_edge(int b) {
+    return 1e-6
+           * std::exp2(static_cast<double>(b) / buckets_per_doubling);
+  }
+};
+
+}  // namespace log_density
+}  // namespace services
+}  // namespace stan
+#endif
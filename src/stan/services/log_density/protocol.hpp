@@ -0,0 +1,321 @@
+#ifndef STAN_SERVICES_LOG_DENSITY_PROTOCOL_HPP
+#define STAN_SERVICES_LOG_DENSITY_PROTOCOL_HPP
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace log_density {
+
+/**
+ * Types of request understood by the log density server.
+ *
+ * <p>A batch of a request consists of <code>batch_size</code> items
+ * of <code>width</code> doubles each. With <code>N</code> the number
+ * of unconstrained parameters and <code>K</code> the number of
+ * constrained parameters (without transformed parameters and
+ * generated quantities), the items and results are
+ *
+ * <ul>
+ * <li><code>describe</code>: no items; the text of the response is
+ * the model name, the unconstrained parameter names and the
+ * constrained parameter names, on three lines with names separated by
+ * commas.</li>
+ * <li><code>log_density</code>: unconstrained parameters
+ * (<code>N</code>); the log density (1).</li>
+ * <li><code>gradient</code>: unconstrained parameters
+ * (<code>N</code>); the log density and its gradient
+ * (<code>1 + N</code>).</li>
+ * <li><code>hessian_vector</code>: unconstrained parameters followed
+ * by a direction (<code>2 N</code>); the log density and the product
+ * of its Hessian with the direction (<code>1 + N</code>).</li>
+ * <li><code>constrain</code>: unconstrained parameters
+ * (<code>N</code>); the output of <code>write_array</code>. Generated
+ * quantities of item <code>i</code> use the random number generator
+ * for seed <code>seed</code> and chain <code>i + 1</code>.</li>
+ * <li><code>unconstrain</code>: constrained parameters
+ * (<code>K</code>); unconstrained parameters (<code>N</code>).</li>
+ * <li><code>stats</code>: no items; the text of the response holds
+ * one line of latency statistics per request type.</li>
+ * <li><code>shutdown</code>: no items; the server stops after
+ * responding.</li>
+ * </ul>
+ */
+struct request_type {
+  enum {
+    describe = 0,
+    log_density = 1,
+    gradient = 2,
+    hessian_vector = 3,
+    constrain = 4,
+    unconstrain = 5,
+    stats = 6,
+    shutdown = 7,
+    num_types = 8
+  };
+};
+
+/**
+ * Flags of a request, combined with bitwise or.
+ */
+struct request_flags {
+  enum {
+    /** drop constant terms of the log density */
+    propto = 1,
+    /** include the log Jacobian of the constraining transform */
+    jacobian = 2,
+    /** constrain: include transformed parameters */
+    include_tparams = 4,
+    /** constrain: include generated quantities */
+    include_gqs = 8
+  };
+};
+
+/**
+ * Status of a response and of each item of a batch.
+ */
+struct response_status {
+  enum { ok = 0, error = 1 };
+};
+
+/**
+ * Magic number opening every request and response header.
+ */
+const std::uint32_t protocol_magic = 0x444c5453;  // "STLD"
+
+/**
+ * Fixed header of a request, in the byte order of the host. It is
+ * followed by <code>batch_size * width</code> doubles.
+ */
+struct request_header {
+  std::uint32_t magic;
+  std::uint8_t type;
+  std::uint8_t flags;
+  std::uint16_t reserved;
+  std::uint32_t batch_size;
+  std::uint32_t width;
+  std::uint32_t seed;
+};
+
+/**
+ * Fixed header of a response, in the byte order of the host. It is
+ * followed by <code>batch_size</code> bytes of item status,
+ * <code>batch_size * width</code> doubles, the length of the text as
+ * a 32-bit unsigned integer and the text. Results of items that
+ * failed are NaN, and the text holds the first error message.
+ */
+struct response_header {
+  std::uint32_t magic;
+  std::uint8_t status;
+  std::uint8_t reserved[3];
+  std::uint32_t batch_size;
+  std::uint32_t width;
+};
+
+static_assert(sizeof(request_header) == 20, "unexpected padding");
+static_assert(sizeof(response_header) == 16, "unexpected padding");
+
+/**
+ * A request of the log density server.
+ */
+struct request {
+  int type;
+  int flags;
+  unsigned int seed;
+  int batch_size;
+  int width;
+  std::vector<double> values;
+
+  request() : type(request_type::describe), flags(0), seed(0),
+              batch_size(0), width(0) {}
+
+  bool has_flag(int flag) const { return (flags & flag) != 0; }
+};
+
+/**
+ * A response of the log density server.
+ */
+struct response {
+  int status;
+  int batch_size;
+  int width;
+  std::vector<char> item_status;
+  std::vector<double> values;
+  std::string text;
+
+  response() : status(response_status::ok), batch_size(0), width(0) {}
+
+  /**
+   * Construct a response with the specified status and text and no
+   * items.
+   *
+   * @param[in] s status
+   * @param[in] t text
+   */
+  response(int s, const std::string& t)
+      : status(s), batch_size(0), width(0), text(t) {}
+};
+
+namespace internal {
+
+/*
+ * Read exactly n bytes from the socket, returning false at
+ * end of file or on error.
+ */
+inline bool read_fully(int fd, void* data, size_t n) {
+  char* p = static_cast<char*>(data);
+  while (n > 0) {
+    ssize_t r = ::read(fd, p, n);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    p += r;
+    n -= r;
+  }
+  return true;
+}
+
+/*
+ * Write exactly n bytes to the socket, returning false on error. A
+ * closed peer is an error rather than a SIGPIPE.
+ */
+inline bool write_fully(int fd, const void* data, size_t n) {
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+  const char* p = static_cast<const char*>(data);
+  while (n > 0) {
+    ssize_t r = ::send(fd, p, n, flags);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    p += r;
+    n -= r;
+  }
+  return true;
+}
+
+}  // namespace internal
+
+/**
+ * Read a request from the socket.
+ *
+ * @param[in] fd socket
+ * @param[out] r request
+ * @param[in] max_values largest number of doubles accepted in a batch
+ * @param[in] max_batch_size largest number of items accepted in a
+ * batch, whatever their width; at most <code>INT_MAX</code>
+ * @return true if a well-formed request was read
+ */
+inline bool read_request(int fd, request& r, size_t max_values = 1 << 27,
+                         size_t max_batch_size = 1 << 20) {
+  const std::uint64_t max_int = std::numeric_limits<int>::max();
+  request_header h;
+  if (!internal::read_fully(fd, &h, sizeof(h)) || h.magic != protocol_magic
+      || h.type >= request_type::num_types
+      || h.batch_size > std::min<std::uint64_t>(max_batch_size, max_int)
+      || h.width > max_int
+      || static_cast<std::uint64_t>(h.batch_size) * h.width > max_values)
+    return false;
+  r.type = h.type;
+  r.flags = h.flags;
+  r.seed = h.seed;
+  r.batch_size = h.batch_size;
+  r.width = h.width;
+  r.values.resize(static_cast<size_t>(h.batch_size) * h.width);
+  return internal::read_fully(fd, r.values.data(),
+                              r.values.size() * sizeof(double));
+}
+
+/**
+ * Write a request to the socket.
+ *
+ * @param[in] fd socket
+ * @param[in] r request; <code>values</code> must hold
+ * <code>batch_size * width</code> doubles
+ * @return true on success
+ */
+inline bool write_request(int fd, const request& r) {
+  request_header h = {protocol_magic,
+                      static_cast<std::uint8_t>(r.type),
+                      static_cast<std::uint8_t>(r.flags),
+                      0,
+                      static_cast<std::uint32_t>(r.batch_size),
+                      static_cast<std::uint32_t>(r.width),
+                      static_cast<std::uint32_t>(r.seed)};
+  return internal::write_fully(fd, &h, sizeof(h))
+         && internal::write_fully(fd, r.values.data(),
+                                  r.values.size() * sizeof(double));
+}
+
+/**
+ * Read a response from the socket.
+ *
+ * @param[in] fd socket
+ * @param[out] r response
+ * @return true if a well-formed response was read
+ */
+inline bool read_response(int fd, response& r) {
+  response_header h;
+  if (!internal::read_fully(fd, &h, sizeof(h)) || h.magic != protocol_magic)
+    return false;
+  r.status = h.status;
+  r.batch_size = h.batch_size;
+  r.width = h.width;
+  r.item_status.resize(h.batch_size);
+  r.values.resize(static_cast<size_t>(h.batch_size) * h.width);
+  std::uint32_t text_size;
+  if (!internal::read_fully(fd, r.item_status.data(), r.item_status.size())
+      || !internal::read_fully(fd, r.values.data(),
+                               r.values.size() * sizeof(double))
+      || !internal::read_fully(fd, &text_size, sizeof(text_size)))
+    return false;
+  r.text.resize(text_size);
+  return internal::read_fully(fd, &r.text[0], text_size);
+}
+
+/**
+ * Write a response to the socket as a single message.
+ *
+ * @param[in] fd socket
+ * @param[in] r response; <code>item_status</code> must hold
+ * <code>batch_size</code> entries and <code>values</code>
+ * <code>batch_size * width</code> doubles
+ * @return true on success
+ */
+inline bool write_response(int fd, const response& r) {
+  response_header h = {protocol_magic,
+                       static_cast<std::uint8_t>(r.status),
+                       {0, 0, 0},
+                       static_cast<std::uint32_t>(r.batch_size),
+                       static_cast<std::uint32_t>(r.width)};
+  std::uint32_t text_size = r.text.size();
+  std::string message;
+  message.reserve(sizeof(h) + r.item_status.size()
+                  + r.values.size() * sizeof(double) + sizeof(text_size)
+                  + r.text.size());
+  message.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  message.append(r.item_status.data(), r.item_status.size());
+  message.append(reinterpret_cast<const char*>(r.values.data()),
+                 r.values.size() * sizeof(double));
+  message.append(reinterpret_cast<const char*>(&text_size),
+                 sizeof(text_size));
+  message.append(r.text);
+  return internal::write_fully(fd, message.data(), message.size());
+}
+
+}  // namespace log_density
+}  // namespace services
+}  // namespace stan
+#endif
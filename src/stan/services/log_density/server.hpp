@@ -0,0 +1,463 @@
+#ifndef STAN_SERVICES_LOG_DENSITY_SERVER_HPP
+#define STAN_SERVICES_LOG_DENSITY_SERVER_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <stan/math/mix.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <stan/model/model_functional.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/log_density/latency_stats.hpp>
+#include <stan/services/log_density/protocol.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/thread_pool.hpp>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace log_density {
+
+/**
+ * Server that evaluates the log density of a model, its gradient and
+ * Hessian-vector products, and the constraining and unconstraining
+ * transforms, for clients connecting to a Unix domain socket. The
+ * model and its data are loaded once by the caller; each request
+ * carries a batch of points, evaluated concurrently on a thread pool.
+ * See <code>request_type</code> for the requests and
+ * <code>request_header</code> and <code>response_header</code> for
+ * the binary protocol.
+ *
+ * <p>Each connection is served by its own thread, and requests on a
+ * connection are answered in order. Print statements of the model are
+ * discarded.
+ *
+ * @tparam Model class of model
+ */
+template <class Model>
+class log_density_server {
+ public:
+  /**
+   * Construct a server for the specified model.
+   *
+   * @param[in] model model, which must outlive the server
+   * @param[in] num_threads number of threads evaluating batches
+   * @throw std::invalid_argument if the number of threads is not
+   * positive
+   */
+  log_density_server(const Model& model, int num_threads)
+      : model_(model),
+        own_pool_(new util::thread_pool(num_threads)),
+        pool_(*own_pool_),
+        stats_(request_type::num_types),
+        listen_fd_(-1),
+        stopping_(false) {
+    read_param_names();
+  }
+
+  /**
+   * Construct a server for the specified model that evaluates batches
+   * on a pool shared with other work, such as
+   * <code>util::shared_thread_pool()</code>.
+   *
+   * @param[in] model model, which must outlive the server
+   * @param[in,out] pool thread pool, which must outlive the server
+   */
+  log_density_server(const Model& model, util::thread_pool& pool)
+      : model_(model),
+        pool_(pool),
+        stats_(request_type::num_types),
+        listen_fd_(-1),
+        stopping_(false) {
+    read_param_names();
+  }
+
+  ~log_density_server() { close(); }
+
+  /**
+   * Create the socket at the specified path and listen on it. An
+   * existing socket at the path is replaced. The socket is only
+   * accessible to the user.
+   *
+   * @param[in] path file system path of the socket
+   * @param[out] error description of the failure
+   * @return true on success
+   */
+  bool open(const std::string& path, std::string& error) {
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+      error = "Socket path must have between 1 and "
+              + std::to_string(sizeof(address.sun_path) - 1) + " characters";
+      return false;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    struct stat status;
+    if (::stat(path.c_str(), &status) == 0) {
+      if (!S_ISSOCK(status.st_mode)) {
+        error = path + " exists and is not a socket";
+        return false;
+      }
+      ::unlink(path.c_str());
+    }
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0
+        || ::bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address))
+               != 0
+        || ::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0
+        || ::listen(listen_fd_, 16) != 0) {
+      error = "Cannot listen on " + path + ": " + std::strerror(errno);
+      close();
+      return false;
+    }
+    path_ = path;
+    return true;
+  }
+
+  /**
+   * Accept and serve connections until a shutdown request is received
+   * or <code>stop()</code> is called. The interrupt callback is called
+   * about ten times a second and may throw to stop the server.
+   *
+   * @param[in,out] interrupt interrupt callback
+   */
+  void serve(callbacks::interrupt& interrupt) {
+    std::vector<std::thread> connections;
+    try {
+      while (!stopping_) {
+        interrupt();
+        if (!wait_readable(listen_fd_))
+          continue;
+        int fd = ::accept(listen_fd_, 0, 0);
+        if (fd >= 0)
+          connections.emplace_back([this, fd]() { serve_connection(fd); });
+      }
+    } catch (...) {
+      stop();
+      for (std::thread& connection : connections)
+        connection.join();
+      throw;
+    }
+    for (std::thread& connection : connections)
+      connection.join();
+  }
+
+  /**
+   * Make <code>serve()</code> return once the requests in progress are
+   * answered. May be called from any thread.
+   */
+  void stop() { stopping_ = true; }
+
+  /**
+   * Close and remove the socket.
+   */
+  void close() {
+    if (listen_fd_ >= 0)
+      ::close(listen_fd_);
+    listen_fd_ = -1;
+    if (!path_.empty())
+      ::unlink(path_.c_str());
+    path_.clear();
+  }
+
+  /**
+   * Evaluate a request.
+   *
+   * @param[in] r request
+   * @return response
+   */
+  response evaluate(const request& r) {
+    if (r.type == request_type::describe)
+      return response(response_status::ok, describe(r));
+    if (r.type == request_type::stats)
+      return response(response_status::ok, stats_summary());
+    if (r.type == request_type::shutdown) {
+      stop();
+      return response();
+    }
+    int num_params = model_.num_params_r();
+    int input_width = r.type == request_type::hessian_vector
+                          ? 2 * num_params
+                          : r.type == request_type::unconstrain
+                                ? num_constrained_
+                                : num_params;
+    if (r.width != input_width
+        || r.values.size() != static_cast<size_t>(r.batch_size) * r.width)
+      return response(response_status::error,
+                      "Expected items of " + std::to_string(input_width)
+                          + " values, found "
+                          + std::to_string(r.width));
+
+    response result;
+    result.batch_size = r.batch_size;
+    result.width = output_width(r);
+    result.item_status.assign(r.batch_size, response_status::ok);
+    result.values.resize(static_cast<size_t>(r.batch_size) * result.width);
+    std::mutex error_mutex;
+    pool_.parallel_for(r.batch_size, [&](int i) {
+      Eigen::Map<const Eigen::VectorXd> in(r.values.data() + i * r.width,
+                                           r.width);
+      Eigen::Map<Eigen::VectorXd> out(
+          result.values.data() + i * result.width, result.width);
+      try {
+        evaluate_item(r, i, in, out);
+      } catch (const std::exception& e) {
+        out.setConstant(std::numeric_limits<double>::quiet_NaN());
+        result.item_status[i] = response_status::error;
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (result.text.empty())
+          result.text = "Item " + std::to_string(i) + ": " + e.what();
+      }
+    });
+    return result;
+  }
+
+  /**
+   * Return the latency statistics of the specified request type.
+   *
+   * @param[in] type request type
+   */
+  const latency_stats& stats(int type) const { return stats_[type]; }
+
+  /**
+   * Return one line of latency statistics per request type, and one
+   * of task statistics of the thread pool.
+   */
+  std::string stats_summary() const {
+    static const char* names[request_type::num_types]
+        = {"describe",  "log_density", "gradient", "hessian_vector",
+           "constrain", "unconstrain", "stats",    "shutdown"};
+    std::stringstream ss;
+    for (int type = 0; type < request_type::num_types; ++type)
+      ss << names[type] << " " << stats_[type].summary() << "\n";
+    ss << "thread_pool " << pool_.stats().summary() << "\n";
+    return ss.str();
+  }
+
+ private:
+  const Model& model_;
+  std::unique_ptr<util::thread_pool> own_pool_;
+  util::thread_pool& pool_;
+  std::vector<latency_stats> stats_;
+  int num_constrained_;
+  std::vector<std::string> param_names_;
+  std::vector<std::vector<size_t> > param_dims_;
+  int listen_fd_;
+  std::string path_;
+  std::atomic<bool> stopping_;
+
+  void read_param_names() {
+    std::vector<std::string> names;
+    model_.constrained_param_names(names, false, false);
+    num_constrained_ = names.size();
+
+    // the parameters come first among the variables of the model
+    model_.get_param_names(param_names_);
+    model_.get_dims(param_dims_);
+    size_t num_values = 0;
+    size_t num_vars = 0;
+    while (num_vars < param_names_.size()
+           && num_values < static_cast<size_t>(num_constrained_)) {
+      size_t size = 1;
+      for (size_t d : param_dims_[num_vars])
+        size *= d;
+      num_values += size;
+      ++num_vars;
+    }
+    param_names_.resize(num_vars);
+    param_dims_.resize(num_vars);
+  }
+
+  /*
+   * Wait up to 100 ms for the file descriptor to become readable.
+   */
+  static bool wait_readable(int fd) {
+    struct pollfd p = {fd, POLLIN, 0};
+    return ::poll(&p, 1, 100) > 0;
+  }
+
+  void serve_connection(int fd) {
+    request r;
+    while (!stopping_) {
+      if (!wait_readable(fd))
+        continue;
+      if (!read_request(fd, r))
+        break;
+      auto start = std::chrono::steady_clock::now();
+      response result;
+      try {
+        result = evaluate(r);
+      } catch (const std::exception& e) {
+        result = response(response_status::error, e.what());
+      }
+      if (!write_response(fd, result))
+        break;
+      stats_[r.type].record(
+          std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                        - start)
+              .count());
+    }
+    ::close(fd);
+  }
+
+  int output_width(const request& r) const {
+    switch (r.type) {
+      case request_type::log_density:
+        return 1;
+      case request_type::gradient:
+      case request_type::hessian_vector:
+        return 1 + model_.num_params_r();
+      case request_type::constrain: {
+        std::vector<std::string> names;
+        model_.constrained_param_names(
+            names, r.has_flag(request_flags::include_tparams),
+            r.has_flag(request_flags::include_gqs));
+        return names.size();
+      }
+      default:
+        return model_.num_params_r();
+    }
+  }
+
+  template <bool propto, bool jacobian>
+  void log_density(const request& r, const Eigen::VectorXd& x,
+                   Eigen::Map<Eigen::VectorXd>& out) {
+    Eigen::VectorXd params_r = x;
+    if (r.type == request_type::log_density) {
+      out(0) = propto ? stan::model::log_prob_propto<jacobian>(model_,
+                                                               params_r)
+                      : model_.template log_prob<false, jacobian>(params_r,
+                                                                  0);
+    } else if (r.type == request_type::gradient) {
+      Eigen::VectorXd gradient;
+      out(0) = stan::model::log_prob_grad<propto, jacobian>(model_, params_r,
+                                                            gradient);
+      out.tail(gradient.size()) = gradient;
+    } else {
+      Eigen::VectorXd v = params_r.tail(r.width / 2);
+      params_r.conservativeResize(r.width / 2);
+      double f;
+      Eigen::VectorXd hv;
+      stan::math::hessian_times_vector(
+          stan::model::internal::log_prob_functional<propto, jacobian, Model>(
+              model_, 0),
+          params_r, v, f, hv);
+      out(0) = f;
+      out.tail(hv.size()) = hv;
+    }
+  }
+
+  void evaluate_item(const request& r, int i,
+                     const Eigen::Map<const Eigen::VectorXd>& in,
+                     Eigen::Map<Eigen::VectorXd>& out) {
+    Eigen::VectorXd x = in;
+    if (r.type == request_type::constrain) {
+      boost::ecuyer1988 rng = util::create_rng(r.seed, i + 1);
+      Eigen::VectorXd constrained;
+      model_.write_array(rng, x, constrained,
+                         r.has_flag(request_flags::include_tparams),
+                         r.has_flag(request_flags::include_gqs), 0);
+      out = constrained;
+    } else if (r.type == request_type::unconstrain) {
+      stan::io::array_var_context context(param_names_, x, param_dims_);
+      Eigen::VectorXd params_r;
+      model_.transform_inits(context, params_r, 0);
+      out = params_r;
+    } else {
+      bool propto = r.has_flag(request_flags::propto);
+      if (r.has_flag(request_flags::jacobian))
+        propto ? log_density<true, true>(r, x, out)
+               : log_density<false, true>(r, x, out);
+      else
+        propto ? log_density<true, false>(r, x, out)
+               : log_density<false, false>(r, x, out);
+    }
+  }
+
+  static std::string join(const std::vector<std::string>& names) {
+    std::string joined;
+    for (size_t n = 0; n < names.size(); ++n)
+      joined += (n == 0 ? "" : ",") + names[n];
+    return joined;
+  }
+
+  std::string describe(const request& r) const {
+    std::vector<std::string> unconstrained;
+    std::vector<std::string> constrained;
+    model_.unconstrained_param_names(unconstrained, false, false);
+    model_.constrained_param_names(
+        constrained, r.has_flag(request_flags::include_tparams),
+        r.has_flag(request_flags::include_gqs));
+    return model_.model_name() + "\n" + join(unconstrained) + "\n"
+           + join(constrained);
+  }
+};
+
+/**
+ * Serve the log density of the model and its derivatives and
+ * transforms over a Unix domain socket until a client sends a
+ * shutdown request or the interrupt callback throws. See
+ * <code>log_density_server</code>.
+ *
+ * <p>Without <code>STAN_THREADS</code> the autodiff stack is shared
+ * by all threads, so batches are evaluated by a single thread
+ * regardless of <code>num_threads</code>.
+ *
+ * @tparam Model class of model
+ * @param[in] model model with its data loaded
+ * @param[in] socket_path file system path of the socket
+ * @param[in] num_threads number of threads evaluating batches
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int serve(const Model& model, const std::string& socket_path, int num_threads,
+          callbacks::interrupt& interrupt, callbacks::logger& logger) {
+  if (num_threads < 1) {
+    logger.error("Number of threads must be positive");
+    return error_codes::CONFIG;
+  }
+#ifndef STAN_THREADS
+  if (num_threads > 1) {
+    logger.info("Built without STAN_THREADS; using one thread");
+    num_threads = 1;
+  }
+#endif
+  log_density_server<Model> server(model, num_threads);
+  std::string error;
+  if (!server.open(socket_path, error)) {
+    logger.error(error);
+    return error_codes::CONFIG;
+  }
+  logger.info("Serving " + model.model_name() + " on " + socket_path
+              + " with " + std::to_string(num_threads) + " thread(s)");
+  server.serve(interrupt);
+  logger.info("Request latencies:");
+  logger.info(server.stats_summary());
+  return error_codes::OK;
+}
+
+}  // namespace log_density
+}  // namespace services
+}  // namespace stan
+#endif
@@ -19,7 +19,11 @@ namespace services {
 namespace optimize {
 
 /**
- * Runs the Newton algorithm for a model.
+ * Runs the Newton algorithm for a model. With a sparse Hessian, the
+ * cost of each iteration scales with the number of colors of the
+ * Hessian's sparsity pattern instead of the number of parameters, which
+ * pays off for hierarchical models where subject-level parameters only
+ * interact with population-level parameters.
  *
  * @tparam Model A model implementation
  * @param[in] model the Stan model instantiated with data
@@ -30,6 +34,9 @@ namespace optimize {
  * @param[in] num_iterations maximum number of iterations
  * @param[in] save_iterations indicates whether all the iterations should
  *   be saved
+ * @param[in] sparse_hessian indicates whether the sparsity pattern of the
+ *   Hessian is detected at the initial point and used to compute each
+ *   Hessian with one Hessian-vector product per color of the pattern
  * @param[in,out] interrupt callback to be called every iteration
  * @param[in,out] logger Logger for messages
  * @param[in,out] init_writer Writer callback for unconstrained inits
@@ -39,7 +46,7 @@ namespace optimize {
 template <class Model>
 int newton(Model& model, const stan::io::var_context& init,
            unsigned int random_seed, unsigned int chain, double init_radius,
-           int num_iterations, bool save_iterations,
+           int num_iterations, bool save_iterations, bool sparse_hessian,
            callbacks::interrupt& interrupt, callbacks::logger& logger,
            callbacks::writer& init_writer,
            callbacks::writer& parameter_writer) {
@@ -77,6 +84,22 @@ int newton(Model& model, const stan::io::var_context& init,
   msg << "Initial log joint probability = " << lp;
   logger.info(msg);
 
+  stan::model::hessian_sparsity sparsity(0, {});
+  if (sparse_hessian) {
+    std::stringstream ss;
+    Eigen::VectorXd x
+        = Eigen::Map<Eigen::VectorXd>(cont_vector.data(), cont_vector.size());
+    sparsity = stan::model::detect_hessian_sparsity<true, false>(model, x, &ss);
+    if (ss.str().length() > 0)
+      logger.info(ss);
+    std::stringstream msg_sparsity;
+    msg_sparsity << "Hessian sparsity: " << sparsity.num_nonzeros() << " of "
+                 << cont_vector.size() * cont_vector.size()
+                 << " entries nonzero, " << sparsity.num_colors()
+                 << " Hessian-vector products per iteration";
+    logger.info(msg_sparsity);
+  }
+
   std::vector<std::string> names;
   names.push_back("lp__");
   model.constrained_param_names(names, true, true);
@@ -95,7 +118,11 @@ int newton(Model& model, const stan::io::var_context& init,
     }
     interrupt();
     lastlp = lp;
-    lp = stan::optimization::newton_step(model, cont_vector, disc_vector);
+    if (sparse_hessian)
+      lp = stan::optimization::sparse_newton_step(model, sparsity, cont_vector,
+                                                  disc_vector);
+    else
+      lp = stan::optimization::newton_step(model, cont_vector, disc_vector);
 
     std::stringstream msg2;
     msg2 << "Iteration " << std::setw(2) << (m + 1) << "."
@@ -119,6 +146,36 @@ int newton(Model& model, const stan::io::var_context& init,
   return error_codes::OK;
 }
 
+/**
+ * Runs the Newton algorithm for a model with dense Hessians.
+ *
+ * @tparam Model A model implementation
+ * @param[in] model the Stan model instantiated with data
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int newton(Model& model, const stan::io::var_context& init,
+           unsigned int random_seed, unsigned int chain, double init_radius,
+           int num_iterations, bool save_iterations,
+           callbacks::interrupt& interrupt, callbacks::logger& logger,
+           callbacks::writer& init_writer,
+           callbacks::writer& parameter_writer) {
+  return newton(model, init, random_seed, chain, init_radius, num_iterations,
+                save_iterations, false, interrupt, logger, init_writer,
+                parameter_writer);
+}
+
 }  // namespace optimize
 }  // namespace services
 }  // namespace stan
@@ -0,0 +1,182 @@
+#ifndef STAN_SERVICES_SAMPLE_DELAYED_ACCEPTANCE_ADAPT_HPP
+#define STAN_SERVICES_SAMPLE_DELAYED_ACCEPTANCE_ADAPT_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/delayed_acceptance/adapt_delayed_acceptance_rwm.hpp>
+#include <stan/mcmc/delayed_acceptance/gaussian_surrogate.hpp>
+#include <stan/mcmc/delayed_acceptance/model_surrogate.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/run_adaptive_sampler.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+namespace internal {
+
+template <class Model, class Surrogate>
+int delayed_acceptance_adapt(
+    Model& model, Surrogate& surrogate, const stan::io::var_context& init,
+    unsigned int random_seed, unsigned int chain, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double delta, double gamma, double kappa,
+    double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
+  boost::ecuyer1988 rng = util::create_rng(random_seed, chain);
+
+  std::vector<double> cont_vector = util::initialize(
+      model, init, rng, init_radius, false, logger, init_writer);
+
+  stan::mcmc::adapt_delayed_acceptance_rwm<Model, Surrogate, boost::ecuyer1988>
+      sampler(model, surrogate, rng);
+
+  sampler.set_nominal_stepsize(stepsize);
+
+  sampler.get_stepsize_adaptation().set_mu(log(stepsize));
+  sampler.get_stepsize_adaptation().set_delta(delta);
+  sampler.get_stepsize_adaptation().set_gamma(gamma);
+  sampler.get_stepsize_adaptation().set_kappa(kappa);
+  sampler.get_stepsize_adaptation().set_t0(t0);
+
+  sampler.set_window_params(num_warmup, init_buffer, term_buffer, window,
+                            logger);
+
+  util::run_adaptive_sampler(
+      sampler, model, cont_vector, num_warmup, num_samples, num_thin, refresh,
+      save_warmup, rng, interrupt, logger, sample_writer, diagnostic_writer);
+
+  sampler.write_evaluation_summary(logger);
+
+  return error_codes::OK;
+}
+
+}  // namespace internal
+
+/**
+ * Runs delayed-acceptance random walk Metropolis with adaptation,
+ * screening proposals with a Gaussian approximation of the posterior
+ * fit to the warmup draws. The model's log density is only evaluated
+ * for proposals that pass the Gaussian screen, and no gradients are
+ * computed. The fraction of model evaluations saved during sampling
+ * is logged at the end, and the <code>expensive__</code> column
+ * flags the iterations that evaluated the model.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial scale of random walk proposals
+ * @param[in] delta adaptation target acceptance probability. Unlike
+ *            NUTS, random walk proposals are best tuned for about
+ *            0.234; a value outside (0, 1) selects this default.
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int delayed_acceptance_adapt(
+    Model& model, const stan::io::var_context& init, unsigned int random_seed,
+    unsigned int chain, double init_radius, int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize, double delta,
+    double gamma, double kappa, double t0, unsigned int init_buffer,
+    unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    callbacks::writer& init_writer, callbacks::writer& sample_writer,
+    callbacks::writer& diagnostic_writer) {
+  stan::mcmc::gaussian_surrogate surrogate;
+  return internal::delayed_acceptance_adapt(
+      model, surrogate, init, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, delta, gamma,
+      kappa, t0, init_buffer, term_buffer, window, interrupt, logger,
+      init_writer, sample_writer, diagnostic_writer);
+}
+
+/**
+ * Runs delayed-acceptance random walk Metropolis with adaptation,
+ * screening proposals with a cheaper instance of the model, e.g. the
+ * same model with data that sets loose ODE solver tolerances. Both
+ * models must have the same unconstrained parameters.
+ *
+ * @tparam Model Model class
+ * @tparam SurrogateModel Model class of the surrogate
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] surrogate_model cheap model used to screen proposals
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial scale of random walk proposals
+ * @param[in] delta adaptation target acceptance probability. Unlike
+ *            NUTS, random walk proposals are best tuned for about
+ *            0.234; a value outside (0, 1) selects this default.
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model, class SurrogateModel>
+int delayed_acceptance_adapt(
+    Model& model, const SurrogateModel& surrogate_model,
+    const stan::io::var_context& init, unsigned int random_seed,
+    unsigned int chain, double init_radius, int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize, double delta,
+    double gamma, double kappa, double t0, unsigned int init_buffer,
+    unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    callbacks::writer& init_writer, callbacks::writer& sample_writer,
+    callbacks::writer& diagnostic_writer) {
+  if (surrogate_model.num_params_r() != model.num_params_r()) {
+    logger.error(
+        "The surrogate model must have the same number of parameters as "
+        "the model.");
+    return error_codes::CONFIG;
+  }
+  stan::mcmc::model_surrogate<SurrogateModel> surrogate(surrogate_model);
+  return internal::delayed_acceptance_adapt(
+      model, surrogate, init, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, delta, gamma,
+      kappa, t0, init_buffer, term_buffer, window, interrupt, logger,
+      init_writer, sample_writer, diagnostic_writer);
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,242 @@
+#ifndef STAN_SERVICES_SAMPLE_ENSEMBLE_HPP
+#define STAN_SERVICES_SAMPLE_ENSEMBLE_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/ensemble/ensemble_sampler.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/shared_thread_pool.hpp>
+#include <stan/services/util/thread_pool.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+namespace internal {
+
+/**
+ * Generate sweeps of the ensemble, writing one row per walker for
+ * every <code>num_thin</code>-th sweep, as
+ * <code>util::generate_transitions</code> does for a single chain.
+ */
+template <class Sampler, class Model, class RNG>
+void generate_ensemble_sweeps(Sampler& sampler, int num_sweeps, int start,
+                              int finish, int num_thin, int refresh,
+                              bool save, bool warmup,
+                              util::mcmc_writer& mcmc_writer,
+                              stan::mcmc::sample& s, Model& model,
+                              RNG& base_rng, callbacks::interrupt& callback,
+                              callbacks::logger& logger) {
+  for (int m = 0; m < num_sweeps; ++m) {
+    callback();
+
+    if (refresh > 0
+        && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
+      int it_print_width = std::ceil(std::log10(static_cast<double>(finish)));
+      std::stringstream message;
+      message << "Iteration: ";
+      message << std::setw(it_print_width) << m + 1 + start << " / " << finish;
+      message << " [" << std::setw(3)
+              << static_cast<int>((100.0 * (start + m + 1)) / finish) << "%] ";
+      message << (warmup ? " (Warmup)" : " (Sampling)");
+
+      logger.info(message);
+    }
+
+    for (int k = 0; k < sampler.num_walkers(); ++k) {
+      s = sampler.transition(s, logger);
+      if (save && ((m % num_thin) == 0)) {
+        mcmc_writer.write_sample_params(base_rng, s, sampler, model);
+        mcmc_writer.write_diagnostic_params(s, sampler);
+      }
+    }
+  }
+}
+
+}  // namespace internal
+
+/**
+ * Runs the gradient-free ensemble sampler, with affine-invariant
+ * stretch moves and differential evolution moves. Only the model's
+ * log density is evaluated, in <code>double</code> precision, so the
+ * sampler suits low-dimensional models whose gradients are unusable
+ * or expensive, e.g. with kinks or failing ODE sensitivities.
+ *
+ * <p>Each iteration moves every walker once, evaluating the proposals
+ * of half of the ensemble as one batch on the thread pool, and writes
+ * one row per walker in the usual layout, with the walker in the
+ * <code>walker__</code> column. Warmup iterations are not adapted,
+ * only discarded unless <code>save_warmup</code> is set.
+ *
+ * <p>Walkers are initialized as a single chain is, one at a time, with
+ * the same retries within the init radius, but only the
+ * <code>double</code> log density must be finite: no gradient is
+ * evaluated. If the inits fix every parameter, walkers after the
+ * first would coincide with it and are moved by a small Gaussian
+ * jitter instead.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_walkers number of walkers, at least 4
+ * @param[in] num_warmup Number of warmup iterations
+ * @param[in] num_samples Number of sampling iterations
+ * @param[in] num_thin Number to thin the iterations
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stretch_scale scale of the stretch move, greater than 1
+ * @param[in] de_probability probability of a differential evolution
+ *   move
+ * @param[in,out] pool thread pool for the log density evaluations
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int ensemble(Model& model, const stan::io::var_context& init,
+             unsigned int random_seed, unsigned int chain, double init_radius,
+             int num_walkers, int num_warmup, int num_samples, int num_thin,
+             bool save_warmup, int refresh, double stretch_scale,
+             double de_probability, util::thread_pool& pool,
+             callbacks::interrupt& interrupt, callbacks::logger& logger,
+             callbacks::writer& init_writer, callbacks::writer& sample_writer,
+             callbacks::writer& diagnostic_writer) {
+  if (num_walkers < 4) {
+    logger.error("Number of walkers must be at least 4");
+    return error_codes::CONFIG;
+  }
+  if (!(stretch_scale > 1) || !(de_probability >= 0 && de_probability <= 1)) {
+    logger.error("Stretch scale must be greater than 1 and differential "
+                 "evolution probability must be in [0, 1]");
+    return error_codes::CONFIG;
+  }
+
+  boost::ecuyer1988 rng = util::create_rng(random_seed, chain);
+  boost::variate_generator<boost::ecuyer1988&, boost::normal_distribution<> >
+      rand_gaus(rng, boost::normal_distribution<>());
+
+  callbacks::writer no_init_writer;
+  std::vector<Eigen::VectorXd> walkers;
+  for (int k = 0; k < num_walkers; ++k) {
+    std::vector<double> cont_vector
+        = util::initialize(model, init, rng, init_radius, false, logger,
+                           k == 0 ? init_writer : no_init_writer, false);
+    Eigen::VectorXd q = Eigen::Map<Eigen::VectorXd>(cont_vector.data(),
+                                                    cont_vector.size());
+    if (k > 0 && q == walkers[0]) {
+      for (int i = 0; i < q.size(); ++i)
+        q(i) += 1e-2 * rand_gaus();
+    }
+    walkers.push_back(q);
+  }
+
+  stan::mcmc::ensemble_sampler<Model, boost::ecuyer1988> sampler(model, rng);
+  sampler.set_stretch_scale(stretch_scale);
+  sampler.set_de_probability(de_probability);
+  sampler.set_parallel_for(
+      [&pool](int n, const std::function<void(int)>& f) {
+        pool.parallel_for(n, f);
+      });
+  sampler.set_walkers(walkers, logger);
+
+  util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  stan::mcmc::sample s(walkers[0], 0, 0);
+  writer.write_sample_names(s, sampler, model);
+  writer.write_diagnostic_names(s, sampler, model);
+
+  auto start_warm = std::chrono::steady_clock::now();
+  internal::generate_ensemble_sweeps(sampler, num_warmup, 0,
+                                     num_warmup + num_samples, num_thin,
+                                     refresh, save_warmup, true, writer, s,
+                                     model, rng, interrupt, logger);
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+  writer.write_adapt_finish(sampler);
+  sampler.write_sampler_state(sample_writer);
+
+  sampler.reset_counts();
+  auto start_sample = std::chrono::steady_clock::now();
+  internal::generate_ensemble_sweeps(sampler, num_samples, num_warmup,
+                                     num_warmup + num_samples, num_thin,
+                                     refresh, true, false, writer, s, model,
+                                     rng, interrupt, logger);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  writer.write_timing(warm_delta_t, sample_delta_t);
+
+  std::stringstream msg;
+  msg << "Ensemble: " << sampler.num_proposals()
+      << " log density evaluations while sampling, acceptance rate = "
+      << sampler.acceptance_rate();
+  logger.info(msg);
+
+  return error_codes::OK;
+}
+
+/**
+ * Runs the gradient-free ensemble sampler on the shared thread pool,
+ * <code>util::shared_thread_pool()</code>.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_walkers number of walkers, at least 4
+ * @param[in] num_warmup Number of warmup iterations
+ * @param[in] num_samples Number of sampling iterations
+ * @param[in] num_thin Number to thin the iterations
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int ensemble(Model& model, const stan::io::var_context& init,
+             unsigned int random_seed, unsigned int chain, double init_radius,
+             int num_walkers, int num_warmup, int num_samples, int num_thin,
+             bool save_warmup, int refresh, callbacks::interrupt& interrupt,
+             callbacks::logger& logger, callbacks::writer& init_writer,
+             callbacks::writer& sample_writer,
+             callbacks::writer& diagnostic_writer) {
+  return ensemble(model, init, random_seed, chain, init_radius, num_walkers,
+                  num_warmup, num_samples, num_thin, save_warmup, refresh, 2.0,
+                  0.1, util::shared_thread_pool(), interrupt, logger,
+                  init_writer, sample_writer, diagnostic_writer);
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,317 @@
+#ifndef STAN_SERVICES_SAMPLE_HMC_NUTS_AUTO_E_ADAPT_HPP
+#define STAN_SERVICES_SAMPLE_HMC_NUTS_AUTO_E_ADAPT_HPP
+
+#include <stan/math/prim.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/mcmc/cross_chain/mpi_cross_chain.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/generate_transitions.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/metric_selection.hpp>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+namespace internal {
+
+/*
+ * Finish warmup and sample with an adaptive sampler whose adaptation
+ * is engaged, as util::run_adaptive_sampler does after its first
+ * warmup iteration. The lines of the summary are written as comments
+ * after the draws, outside the adaptation block.
+ */
+template <class Sampler, class Model, class RNG>
+void finish_adaptive_sampler(Sampler& sampler, Model& model,
+                             util::mcmc_writer& writer, stan::mcmc::sample& s,
+                             int start, int num_warmup, int num_samples,
+                             int num_thin, int refresh, bool save_warmup,
+                             double warm_delta_t, const std::string& summary,
+                             RNG& rng, callbacks::interrupt& interrupt,
+                             callbacks::logger& logger,
+                             callbacks::writer& sample_writer) {
+  auto start_warm = std::chrono::steady_clock::now();
+  util::generate_transitions(sampler, num_warmup - start, start,
+                             num_warmup + num_samples, num_thin, refresh,
+                             save_warmup, true, writer, s, model, rng,
+                             interrupt, logger);
+  auto end_warm = std::chrono::steady_clock::now();
+  warm_delta_t += std::chrono::duration_cast<std::chrono::milliseconds>(
+                      end_warm - start_warm)
+                      .count()
+                  / 1000.0;
+  sampler.disengage_adaptation();
+  writer.write_adapt_finish(sampler);
+  sampler.write_sampler_state(sample_writer);
+
+  auto start_sample = std::chrono::steady_clock::now();
+  util::generate_transitions(sampler, num_samples, num_warmup,
+                             num_warmup + num_samples, num_thin, refresh, true,
+                             false, writer, s, model, rng, interrupt, logger);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  std::stringstream lines(summary);
+  for (std::string line; std::getline(lines, line);)
+    sample_writer(line);
+  util::mpi_cross_chain<Sampler>::write_num_samples(sampler, sample_writer);
+  writer.write_timing(warm_delta_t, sample_delta_t);
+}
+
+/*
+ * Size of the last slow window of a windowed adaptation with the
+ * specified parameters, which the sampling metric is estimated from,
+ * following mcmc::windowed_adaptation::compute_next_window.
+ */
+inline int last_window_size(int num_warmup, int init_buffer, int term_buffer,
+                            int base_window) {
+  int end = num_warmup - term_buffer - 1;
+  int size = base_window;
+  int window_end = init_buffer + base_window - 1;
+  while (window_end < end) {
+    int previous_end = window_end;
+    size *= 2;
+    window_end = previous_end + size;
+    if (window_end != end && window_end + 2 * size >= end + 1)
+      window_end = end;
+    if (window_end >= end)
+      return end - previous_end;
+  }
+  return base_window;
+}
+
+}  // namespace internal
+
+/**
+ * Runs HMC with NUTS with adaptation, choosing between a diagonal and
+ * a dense Euclidean metric during warmup.
+ *
+ * <p>Warmup starts with a diagonal metric. After the initial buffer
+ * and the first two slow adaptation windows (or only the first one if
+ * warmup is too short for two), the draws of the windows and the
+ * measured time of a leapfrog step are handed to
+ * <code>util::metric_selector</code>, together with the size of the
+ * last window of a dense adaptation, from which the sampling metric
+ * would be estimated. If it predicts that a dense
+ * metric reaches an effective draw sooner, warmup continues with a
+ * dense metric initialized from the covariance of those draws, and
+ * the remaining windows adapt it. Otherwise the diagonal metric
+ * carries on as in <code>hmc_nuts_diag_e_adapt</code>. The choice and
+ * its predictions are written to the logger when they are made, and
+ * as comments to the sample writer after the draws, so that the
+ * adaptation block keeps its usual layout.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_auto_e_adapt(
+    Model& model, const stan::io::var_context& init, unsigned int random_seed,
+    unsigned int chain, double init_radius, int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize,
+    double stepsize_jitter, int max_depth, double delta, double gamma,
+    double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
+  boost::ecuyer1988 rng = util::create_rng(random_seed, chain);
+
+  std::vector<double> cont_vector = util::initialize(
+      model, init, rng, init_radius, true, logger, init_writer);
+  Eigen::Map<Eigen::VectorXd> cont_params(cont_vector.data(),
+                                          cont_vector.size());
+
+  stan::mcmc::adapt_diag_e_nuts<Model, boost::ecuyer1988> sampler(model, rng);
+
+  Eigen::VectorXd inv_metric = Eigen::VectorXd::Ones(model.num_params_r());
+  sampler.set_metric(inv_metric);
+  sampler.set_nominal_stepsize(stepsize);
+  sampler.set_stepsize_jitter(stepsize_jitter);
+  sampler.set_max_depth(max_depth);
+
+  sampler.get_stepsize_adaptation().set_mu(log(10 * stepsize));
+  sampler.get_stepsize_adaptation().set_delta(delta);
+  sampler.get_stepsize_adaptation().set_gamma(gamma);
+  sampler.get_stepsize_adaptation().set_kappa(kappa);
+  sampler.get_stepsize_adaptation().set_t0(t0);
+
+  sampler.set_window_params(num_warmup, init_buffer, term_buffer, window,
+                            logger);
+
+  // The selection ends with a slow window; the window after it must
+  // fit before the terminal buffer.
+  int num_selection = 0;
+  int next_window = 0;
+  int init_n = init_buffer, term_n = term_buffer, window_n = window;
+  if (init_n + 7 * window_n + term_n <= num_warmup) {
+    num_selection = init_n + 3 * window_n;
+    next_window = 4 * window_n;
+  } else if (init_n + 3 * window_n + term_n <= num_warmup) {
+    num_selection = init_n + window_n;
+    next_window = 2 * window_n;
+  }
+
+  sampler.engage_adaptation();
+  try {
+    sampler.z().q = cont_params;
+    sampler.init_stepsize(logger);
+  } catch (const std::exception& e) {
+    logger.info("Exception initializing step size.");
+    logger.info(e.what());
+    return error_codes::OK;
+  }
+
+  util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  stan::mcmc::sample s(cont_params, 0, 0);
+
+  writer.write_sample_names(s, sampler, model);
+  writer.write_diagnostic_names(s, sampler, model);
+
+  std::vector<std::string> sampler_names;
+  sampler.get_sampler_param_names(sampler_names);
+  size_t leapfrog_index
+      = std::find(sampler_names.begin(), sampler_names.end(), "n_leapfrog__")
+        - sampler_names.begin();
+
+  util::metric_selector selector(model.num_params_r());
+  int iteration = 0;
+  long num_leapfrog = 0;
+  std::vector<double> sampler_values;
+  auto observe = [&](const stan::mcmc::sample& draw) {
+    if (iteration++ < init_n)
+      return;
+    selector.add_draw(draw.cont_params());
+    sampler_values.clear();
+    sampler.get_sampler_params(sampler_values);
+    if (leapfrog_index < sampler_values.size())
+      num_leapfrog += sampler_values[leapfrog_index];
+  };
+
+  // The initial buffer is excluded from the timing, as its early
+  // transitions are dominated by the step size search.
+  int num_init = std::min(init_n, num_selection);
+  auto start_selection = std::chrono::steady_clock::now();
+  util::generate_transitions(sampler, num_init, 0, num_warmup + num_samples,
+                             num_thin, refresh, save_warmup, true, writer, s,
+                             model, rng, interrupt, logger, observe);
+  auto start_windows = std::chrono::steady_clock::now();
+  util::generate_transitions(sampler, num_selection - num_init, num_init,
+                             num_warmup + num_samples, num_thin, refresh,
+                             save_warmup, true, writer, s, model, rng,
+                             interrupt, logger, observe);
+  auto end_selection = std::chrono::steady_clock::now();
+  double selection_delta_t
+      = std::chrono::duration_cast<std::chrono::milliseconds>(
+            end_selection - start_selection)
+            .count()
+        / 1000.0;
+
+  util::metric_choice choice;
+  if (num_selection == 0) {
+    choice.dense = false;
+    choice.reason = "too few warmup iterations to compare metrics";
+  } else {
+    double windows_t
+        = std::chrono::duration<double>(end_selection - start_windows)
+              .count();
+    int num_remaining = num_warmup - num_selection;
+    int num_metric_draws = internal::last_window_size(
+        num_remaining, 0, term_n,
+        std::min(next_window, num_remaining - term_n));
+    choice = selector.select(windows_t / std::max(1L, num_leapfrog),
+                             num_metric_draws);
+  }
+
+  std::stringstream summary(choice.summary());
+  for (std::string line; std::getline(summary, line);)
+    logger.info(line);
+  logger.info("");
+
+  if (!choice.dense) {
+    internal::finish_adaptive_sampler(
+        sampler, model, writer, s, num_selection, num_warmup, num_samples,
+        num_thin, refresh, save_warmup, selection_delta_t, choice.summary(),
+        rng, interrupt, logger, sample_writer);
+    return error_codes::OK;
+  }
+
+  stan::mcmc::adapt_dense_e_nuts<Model, boost::ecuyer1988> dense_sampler(
+      model, rng);
+
+  dense_sampler.set_metric(choice.covariance);
+  dense_sampler.set_nominal_stepsize(sampler.get_nominal_stepsize());
+  dense_sampler.set_stepsize_jitter(stepsize_jitter);
+  dense_sampler.set_max_depth(max_depth);
+
+  dense_sampler.get_stepsize_adaptation().set_delta(delta);
+  dense_sampler.get_stepsize_adaptation().set_gamma(gamma);
+  dense_sampler.get_stepsize_adaptation().set_kappa(kappa);
+  dense_sampler.get_stepsize_adaptation().set_t0(t0);
+
+  int num_remaining = num_warmup - num_selection;
+  dense_sampler.set_window_params(num_remaining, 0, term_buffer,
+                                  std::min(next_window, num_remaining - term_n),
+                                  logger);
+
+  dense_sampler.engage_adaptation();
+  try {
+    dense_sampler.z().q = s.cont_params();
+    dense_sampler.init_stepsize(logger);
+  } catch (const std::exception& e) {
+    logger.info("Exception initializing step size.");
+    logger.info(e.what());
+    return error_codes::OK;
+  }
+  dense_sampler.get_stepsize_adaptation().set_mu(
+      log(10 * dense_sampler.get_nominal_stepsize()));
+  dense_sampler.get_stepsize_adaptation().restart();
+
+  internal::finish_adaptive_sampler(
+      dense_sampler, model, writer, s, num_selection, num_warmup, num_samples,
+      num_thin, refresh, save_warmup, selection_delta_t, choice.summary(),
+      rng, interrupt, logger, sample_writer);
+  return error_codes::OK;
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
@@ -25,8 +25,7 @@ namespace sample {
  * @tparam Model Model class
  * @param[in] model Input model to test (with data already instantiated)
  * @param[in] init var context for initialization
- * @param[in] init_inv_metric var context exposing an initial dense
-              inverse Euclidean metric (must be positive definite)
+ * @param[in] init_inv_metric initial inverse Euclidean metric
  * @param[in] random_seed random seed for the random number generator
  * @param[in] chain chain id to advance the pseudo random number generator
  * @param[in] init_radius radius to initialize
@@ -47,7 +46,7 @@ namespace sample {
  */
 template <class Model>
 int hmc_nuts_dense_e(Model& model, const stan::io::var_context& init,
-                     const stan::io::var_context& init_inv_metric,
+                     const util::inv_metric_spec& init_inv_metric,
                      unsigned int random_seed, unsigned int chain,
                      double init_radius, int num_warmup, int num_samples,
                      int num_thin, bool save_warmup, int refresh,
@@ -62,18 +61,15 @@ int hmc_nuts_dense_e(Model& model, const stan::io::var_context& init,
   std::vector<double> cont_vector = util::initialize(
       model, init, rng, init_radius, true, logger, init_writer);
 
-  Eigen::MatrixXd inv_metric;
   try {
-    inv_metric = util::read_dense_inv_metric(init_inv_metric,
-                                             model.num_params_r(), logger);
-    util::validate_dense_inv_metric(inv_metric, logger);
+    init_inv_metric.validate(model.num_params_r(), logger);
   } catch (const std::domain_error& e) {
     return error_codes::CONFIG;
   }
 
   stan::mcmc::dense_e_nuts<Model, boost::ecuyer1988> sampler(model, rng);
 
-  sampler.set_metric(inv_metric);
+  sampler.set_metric(init_inv_metric.dense_inv_metric());
 
   sampler.set_nominal_stepsize(stepsize);
   sampler.set_stepsize_jitter(stepsize_jitter);
@@ -85,6 +81,61 @@ int hmc_nuts_dense_e(Model& model, const stan::io::var_context& init,
   return error_codes::OK;
 }
 
+/**
+ * Runs HMC with NUTS without adaptation using dense Euclidean metric
+ * with a pre-specified Euclidean metric read from a var context.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] init_inv_metric var context exposing an initial dense
+              inverse Euclidean metric (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_dense_e(Model& model, const stan::io::var_context& init,
+                     const stan::io::var_context& init_inv_metric,
+                     unsigned int random_seed, unsigned int chain,
+                     double init_radius, int num_warmup, int num_samples,
+                     int num_thin, bool save_warmup, int refresh,
+                     double stepsize, double stepsize_jitter, int max_depth,
+                     callbacks::interrupt& interrupt, callbacks::logger& logger,
+                     callbacks::writer& init_writer,
+                     callbacks::writer& sample_writer,
+                     callbacks::writer& diagnostic_writer) {
+  Eigen::MatrixXd inv_metric;
+  try {
+    inv_metric = util::read_dense_inv_metric(init_inv_metric,
+                                             model.num_params_r(), logger);
+  } catch (const std::domain_error& e) {
+    return error_codes::CONFIG;
+  }
+  util::inv_metric_spec dense_metric
+      = util::inv_metric_spec::full(std::move(inv_metric));
+
+  return hmc_nuts_dense_e(model, init, dense_metric, random_seed, chain,
+                          init_radius, num_warmup, num_samples, num_thin,
+                          save_warmup, refresh, stepsize, stepsize_jitter,
+                          max_depth, interrupt, logger, init_writer,
+                          sample_writer, diagnostic_writer);
+}
+
 /**
  * Runs HMC with NUTS without adaptation using dense Euclidean metric,
  * with identity matrix as initial inv_metric.
@@ -121,9 +172,8 @@ int hmc_nuts_dense_e(Model& model, const stan::io::var_context& init,
                      callbacks::writer& init_writer,
                      callbacks::writer& sample_writer,
                      callbacks::writer& diagnostic_writer) {
-  stan::io::dump dmp
-      = util::create_unit_e_dense_inv_metric(model.num_params_r());
-  stan::io::var_context& unit_e_metric = dmp;
+  util::inv_metric_spec unit_e_metric
+      = util::inv_metric_spec::identity(model.num_params_r());
 
   return hmc_nuts_dense_e(model, init, unit_e_metric, random_seed, chain,
                           init_radius, num_warmup, num_samples, num_thin,
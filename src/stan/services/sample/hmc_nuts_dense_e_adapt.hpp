@@ -11,8 +11,12 @@
 #include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
 #include <stan/services/util/run_adaptive_sampler.hpp>
 #include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/cross_chain_options.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/inv_metric.hpp>
+#include <stan/services/util/inv_metric_binary.hpp>
+#include <istream>
+#include <ostream>
 #include <vector>
 
 namespace stan {
@@ -21,13 +25,14 @@ namespace sample {
 
 /**
  * Runs HMC with NUTS with adaptation using dense Euclidean metric
- * with a pre-specified Euclidean metric.
+ * with a pre-specified Euclidean metric. Cross-chain quorum is not
+ * supported, as the dense metric adaptation exchanges every draw
+ * between chains.
  *
  * @tparam Model Model class
  * @param[in] model Input model to test (with data already instantiated)
  * @param[in] init var context for initialization
- * @param[in] init_inv_metric var context exposing an initial dense
-              inverse Euclidean metric (must be positive definite)
+ * @param[in] init_inv_metric initial inverse Euclidean metric
  * @param[in] random_seed random seed for the random number generator
  * @param[in] chain chain id to advance the pseudo random number generator
  * @param[in] init_radius radius to initialize
@@ -51,12 +56,16 @@ namespace sample {
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] sample_writer Writer for draws
  * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
+ * @param[in,out] inv_metric_out optional binary stream for the adapted
+ *            inverse metric, written after adaptation
  * @return error_codes::OK if successful
  */
 template <class Model>
 int hmc_nuts_dense_e_adapt(
     Model& model, const stan::io::var_context& init,
-    const stan::io::var_context& init_inv_metric, unsigned int random_seed,
+    const util::inv_metric_spec& init_inv_metric, unsigned int random_seed,
     unsigned int chain, double init_radius,
     int num_cross_chains, int cross_chain_window, double cross_chain_rhat, int cross_chain_ess,
     int num_warmup, int num_samples,
@@ -65,25 +74,30 @@ int hmc_nuts_dense_e_adapt(
     double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
     unsigned int window, callbacks::interrupt& interrupt,
     callbacks::logger& logger, callbacks::writer& init_writer,
-    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options(),
+    std::ostream* inv_metric_out = nullptr) {
+  if (cross_chain_opts.use_quorum(num_cross_chains)) {
+    logger.error("Cross-chain quorum is not supported with dense metric.");
+    return error_codes::CONFIG;
+  }
+
   boost::ecuyer1988 rng = util::create_rng(random_seed, chain);
 
   std::vector<int> disc_vector;
   std::vector<double> cont_vector = util::initialize(
       model, init, rng, init_radius, true, logger, init_writer);
 
-  Eigen::MatrixXd inv_metric;
   try {
-    inv_metric = util::read_dense_inv_metric(init_inv_metric,
-                                             model.num_params_r(), logger);
-    util::validate_dense_inv_metric(inv_metric, logger);
+    init_inv_metric.validate(model.num_params_r(), logger);
   } catch (const std::domain_error& e) {
     return error_codes::CONFIG;
   }
 
   stan::mcmc::adapt_dense_e_nuts<Model, boost::ecuyer1988> sampler(model, rng);
 
-  sampler.set_metric(inv_metric);
+  sampler.set_metric(init_inv_metric.dense_inv_metric());
 
   sampler.set_nominal_stepsize(stepsize);
   sampler.set_stepsize_jitter(stepsize_jitter);
@@ -105,14 +119,166 @@ int hmc_nuts_dense_e_adapt(
   mcmc::mpi_covar_adaptation var_adapt(model.num_params_r(),
                                        num_cross_chains, num_warmup, cross_chain_window);
   sampler.set_cross_chain_metric_adaptation(&var_adapt);
+  util::set_cross_chain_options(sampler, cross_chain_opts);
 
   util::run_adaptive_sampler(
       sampler, model, cont_vector, num_warmup, num_samples, num_thin, refresh,
-      save_warmup, rng, interrupt, logger, sample_writer, diagnostic_writer);
+      save_warmup, rng, interrupt, logger, sample_writer, diagnostic_writer,
+      [&](decltype(sampler)& adapted) {
+        util::write_dense_inv_metric_binary(adapted, inv_metric_out, logger);
+      });
 
   return error_codes::OK;
 }
 
+/**
+ * Runs HMC with NUTS with adaptation using dense Euclidean metric
+ * with a pre-specified Euclidean metric read from a var context.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] init_inv_metric var context exposing an initial dense
+              inverse Euclidean metric (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
+ * @param[in,out] inv_metric_out optional binary stream for the adapted
+ *            inverse metric, written after adaptation
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_dense_e_adapt(
+    Model& model, const stan::io::var_context& init,
+    const stan::io::var_context& init_inv_metric, unsigned int random_seed,
+    unsigned int chain, double init_radius,
+    int num_cross_chains, int cross_chain_window, double cross_chain_rhat, int cross_chain_ess,
+    int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize,
+    double stepsize_jitter, int max_depth, double delta, double gamma,
+    double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options(),
+    std::ostream* inv_metric_out = nullptr) {
+  Eigen::MatrixXd inv_metric;
+  try {
+    inv_metric = util::read_dense_inv_metric(init_inv_metric,
+                                             model.num_params_r(), logger);
+  } catch (const std::domain_error& e) {
+    return error_codes::CONFIG;
+  }
+  util::inv_metric_spec dense_metric
+      = util::inv_metric_spec::full(std::move(inv_metric));
+
+  return hmc_nuts_dense_e_adapt(
+      model, init, dense_metric, random_seed, chain, init_radius,
+      num_cross_chains, cross_chain_window, cross_chain_rhat, cross_chain_ess,
+      num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init_writer, sample_writer, diagnostic_writer,
+      cross_chain_opts, inv_metric_out);
+}
+
+/**
+ * Runs HMC with NUTS with adaptation using dense Euclidean metric
+ * with a pre-specified Euclidean metric read from a binary file written by
+ * <code>util::write_inv_metric_binary</code>.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in,out] init_inv_metric binary stream holding an initial
+ *            inverse Euclidean metric (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
+ * @param[in,out] inv_metric_out optional binary stream for the adapted
+ *            inverse metric, written after adaptation
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_dense_e_adapt(
+    Model& model, const stan::io::var_context& init,
+    std::istream& init_inv_metric, unsigned int random_seed,
+    unsigned int chain, double init_radius,
+    int num_cross_chains, int cross_chain_window, double cross_chain_rhat, int cross_chain_ess,
+    int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize,
+    double stepsize_jitter, int max_depth, double delta, double gamma,
+    double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options(),
+    std::ostream* inv_metric_out = nullptr) {
+  util::inv_metric_spec sidecar_metric
+      = util::inv_metric_spec::identity(model.num_params_r());
+  try {
+    sidecar_metric = util::read_inv_metric_binary(
+        init_inv_metric, model.num_params_r(), logger);
+  } catch (const std::domain_error& e) {
+    return error_codes::CONFIG;
+  }
+
+  return hmc_nuts_dense_e_adapt(
+      model, init, sidecar_metric, random_seed, chain, init_radius,
+      num_cross_chains, cross_chain_window, cross_chain_rhat, cross_chain_ess,
+      num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init_writer, sample_writer, diagnostic_writer,
+      cross_chain_opts, inv_metric_out);
+}
+
 /**
  * Runs HMC with NUTS with adaptation using dense Euclidean metric,
  * with identity matrix as initial inv_metric.
@@ -143,6 +309,10 @@ int hmc_nuts_dense_e_adapt(
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] sample_writer Writer for draws
  * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
+ * @param[in,out] inv_metric_out optional binary stream for the adapted
+ *            inverse metric, written after adaptation
  * @return error_codes::OK if successful
  */
 template <class Model>
@@ -156,10 +326,12 @@ int hmc_nuts_dense_e_adapt(
     double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
     unsigned int window, callbacks::interrupt& interrupt,
     callbacks::logger& logger, callbacks::writer& init_writer,
-    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
-  stan::io::dump dmp
-      = util::create_unit_e_dense_inv_metric(model.num_params_r());
-  stan::io::var_context& unit_e_metric = dmp;
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options(),
+    std::ostream* inv_metric_out = nullptr) {
+  util::inv_metric_spec unit_e_metric
+      = util::inv_metric_spec::identity(model.num_params_r());
 
   return hmc_nuts_dense_e_adapt(
       model, init, unit_e_metric, random_seed, chain, init_radius,
@@ -167,7 +339,8 @@ int hmc_nuts_dense_e_adapt(
       num_warmup,
       num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
       max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
-      interrupt, logger, init_writer, sample_writer, diagnostic_writer);
+      interrupt, logger, init_writer, sample_writer, diagnostic_writer,
+      cross_chain_opts, inv_metric_out);
 }
 
 }  // namespace sample
@@ -11,6 +11,7 @@
 #include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
 #include <stan/services/util/run_adaptive_sampler.hpp>
 #include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/cross_chain_options.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/inv_metric.hpp>
 #include <vector>
@@ -51,6 +52,8 @@ namespace sample {
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] sample_writer Writer for draws
  * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
  * @return error_codes::OK if successful
  */
 template <class Model>
@@ -65,7 +68,9 @@ int hmc_nuts_diag_e_adapt(
     double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
     unsigned int window, callbacks::interrupt& interrupt,
     callbacks::logger& logger, callbacks::writer& init_writer,
-    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options()) {
   boost::ecuyer1988 rng = util::create_rng(random_seed, chain);
 
   std::vector<int> disc_vector;
@@ -103,6 +108,7 @@ int hmc_nuts_diag_e_adapt(
                                             cross_chain_rhat, cross_chain_ess);
   mcmc::mpi_var_adaptation var_adapt(model.num_params_r(), num_warmup, cross_chain_window);
   sampler.set_cross_chain_metric_adaptation(&var_adapt);
+  util::set_cross_chain_options(sampler, cross_chain_opts);
 
   util::run_adaptive_sampler(
       sampler, model, cont_vector, num_warmup, num_samples, num_thin, refresh,
@@ -140,6 +146,8 @@ int hmc_nuts_diag_e_adapt(
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] sample_writer Writer for draws
  * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in] cross_chain_opts optional cross-chain features, all off
+ *            by default
  * @return error_codes::OK if successful
  */
 template <class Model>
@@ -153,7 +161,9 @@ int hmc_nuts_diag_e_adapt(
     double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
     unsigned int window, callbacks::interrupt& interrupt,
     callbacks::logger& logger, callbacks::writer& init_writer,
-    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer) {
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    const util::cross_chain_options& cross_chain_opts
+    = util::cross_chain_options()) {
   stan::io::dump dmp
       = util::create_unit_e_diag_inv_metric(model.num_params_r());
   stan::io::var_context& unit_e_metric = dmp;
@@ -163,7 +173,8 @@ int hmc_nuts_diag_e_adapt(
       num_cross_chains, cross_chain_window, cross_chain_rhat, cross_chain_ess, num_warmup,
       num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
       max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
-      interrupt, logger, init_writer, sample_writer, diagnostic_writer);
+      interrupt, logger, init_writer, sample_writer, diagnostic_writer,
+      cross_chain_opts);
 }
 
 }  // namespace sample
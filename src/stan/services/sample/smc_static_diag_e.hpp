@@ -0,0 +1,293 @@
+#ifndef STAN_SERVICES_SAMPLE_SMC_STATIC_DIAG_E_HPP
+#define STAN_SERVICES_SAMPLE_SMC_STATIC_DIAG_E_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/static/diag_e_static_hmc.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/smc/adaptive_tempering.hpp>
+#include <stan/mcmc/smc/systematic_resample.hpp>
+#include <stan/mcmc/smc/tempered_model.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/shared_thread_pool.hpp>
+#include <stan/services/util/thread_pool.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+namespace internal {
+
+/**
+ * Return the log ratio of the model density to the reference density
+ * of the tempered model at the specified point, or negative infinity
+ * if the model throws.
+ */
+template <class Model>
+double smc_log_ratio(const stan::mcmc::tempered_model<Model>& tempered,
+                     const Eigen::VectorXd& q) {
+  Eigen::VectorXd params_r = q;
+  try {
+    double lp = stan::model::log_prob_propto<true>(tempered.model(), params_r);
+    double log_ratio = lp - tempered.log_reference(params_r);
+    return std::isnan(log_ratio) ? -std::numeric_limits<double>::infinity()
+                                 : log_ratio;
+  } catch (const std::exception& e) {
+    return -std::numeric_limits<double>::infinity();
+  }
+}
+
+/**
+ * Return the regularized variance of the particles, shrunk towards a
+ * small multiple of the identity as in <code>var_adaptation</code>.
+ */
+inline Eigen::VectorXd smc_ensemble_inv_metric(
+    const std::vector<stan::mcmc::sample>& particles) {
+  int n = particles.size();
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(particles[0].size_cont());
+  for (const stan::mcmc::sample& s : particles)
+    mean += s.cont_params();
+  mean /= n;
+  Eigen::VectorXd var = Eigen::VectorXd::Zero(mean.size());
+  for (const stan::mcmc::sample& s : particles)
+    var += (s.cont_params() - mean).array().square().matrix();
+  var /= n - 1.0;
+  return (n / (n + 5.0)) * var
+         + 1e-3 * (5.0 / (n + 5.0)) * Eigen::VectorXd::Ones(var.size());
+}
+
+}  // namespace internal
+
+/**
+ * Runs sequential Monte Carlo with adaptive tempering, moving an
+ * ensemble of particles from a Gaussian reference density on the
+ * unconstrained scale to the posterior through the geometric bridge
+ * of <code>stan::mcmc::tempered_model</code>.
+ *
+ * <p>Each stage picks the next inverse temperature by bisection so
+ * that the incremental importance weights keep an effective sample
+ * size of <code>ess_fraction</code> times the number of particles,
+ * resamples the particles systematically, and mutates each with
+ * <code>num_mutations</code> static HMC transitions. The diagonal
+ * metric of the moves is the regularized variance of the ensemble,
+ * and the step size is scaled after each stage towards an average
+ * acceptance statistic of <code>delta</code>. Particles are mutated in
+ * parallel on the thread pool, each with its own sampler and random
+ * number generator; messages from the moves are not logged, as the
+ * logger is not safe to call from several threads.
+ *
+ * <p>The final particles are written as equally weighted draws. The
+ * log of the normalizing constant of the model density, as computed
+ * for <code>lp__</code>, is written as a comment and logged, along
+ * with the number of stages.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] num_particles number of particles, at least 2
+ * @param[in] ref_scale standard deviation of the reference density
+ * @param[in] ess_fraction target fraction of the particles kept by the
+ *   incremental weights, in (0, 1)
+ * @param[in] num_mutations number of HMC transitions per stage
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] int_time integration time
+ * @param[in] delta target average acceptance statistic, in (0, 1)
+ * @param[in,out] pool thread pool for the mutation moves
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] sample_writer Writer for draws
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int smc_static_diag_e(Model& model, unsigned int random_seed,
+                      unsigned int chain, int num_particles, double ref_scale,
+                      double ess_fraction, int num_mutations, double stepsize,
+                      double int_time, double delta, util::thread_pool& pool,
+                      callbacks::interrupt& interrupt,
+                      callbacks::logger& logger,
+                      callbacks::writer& sample_writer) {
+  if (num_particles < 2 || num_mutations < 1) {
+    logger.error("Number of particles must be at least 2 and number of "
+                 "mutations must be positive");
+    return error_codes::CONFIG;
+  }
+  if (!(ref_scale > 0) || !(stepsize > 0) || !(int_time > 0)
+      || !(ess_fraction > 0 && ess_fraction < 1)
+      || !(delta > 0 && delta < 1)) {
+    logger.error("Reference scale, stepsize and integration time must be "
+                 "positive, and ESS fraction and delta must be in (0, 1)");
+    return error_codes::CONFIG;
+  }
+
+  typedef boost::ecuyer1988 rng_t;
+  typedef stan::mcmc::tempered_model<Model> tempered_t;
+  typedef stan::mcmc::diag_e_static_hmc<tempered_t, rng_t> sampler_t;
+
+  tempered_t tempered(model, ref_scale);
+  size_t num_params = model.num_params_r();
+
+  // Streams of the particles split the stride between chains
+  rng_t rng = util::create_rng(random_seed, chain);
+  boost::uintmax_t particle_stride
+      = (static_cast<boost::uintmax_t>(1) << 50) / (num_particles + 1);
+  std::vector<rng_t> rngs;
+  rngs.reserve(num_particles);
+  std::vector<std::unique_ptr<sampler_t>> samplers;
+  for (int k = 0; k < num_particles; ++k) {
+    rngs.push_back(rng);
+    rngs[k].discard(particle_stride * (k + 1));
+    samplers.emplace_back(new sampler_t(tempered, rngs[k]));
+  }
+
+  std::vector<stan::mcmc::sample> particles(
+      num_particles, stan::mcmc::sample(Eigen::VectorXd(num_params), 0, 0));
+  Eigen::VectorXd log_ratio(num_particles);
+  std::vector<int> finite(num_particles);
+  pool.parallel_for(num_particles, [&](int k) {
+    boost::normal_distribution<double> std_normal;
+    Eigen::VectorXd q(num_params);
+    finite[k] = 0;
+    for (int tries = 0; tries < 100 && !finite[k]; ++tries) {
+      for (size_t i = 0; i < num_params; ++i)
+        q(i) = ref_scale * std_normal(rngs[k]);
+      log_ratio(k) = internal::smc_log_ratio(tempered, q);
+      finite[k] = std::isfinite(log_ratio(k));
+    }
+    particles[k] = stan::mcmc::sample(q, tempered.log_reference(q), 0);
+  });
+  for (int k = 0; k < num_particles; ++k) {
+    if (!finite[k]) {
+      logger.error("Cannot draw particles with finite log density from the "
+                   "reference after 100 attempts; consider a smaller "
+                   "reference scale");
+      throw std::domain_error("Initialization failed.");
+    }
+  }
+
+  boost::uniform_01<rng_t&> rand_uniform(rng);
+  double beta = 0;
+  double log_z = 0;
+  int num_stages = 0;
+  std::vector<double> accept(num_particles);
+  while (beta < 1) {
+    interrupt();
+    double next_beta
+        = stan::mcmc::next_temperature(log_ratio, beta, ess_fraction);
+    Eigen::VectorXd log_w = (next_beta - beta) * log_ratio;
+    double log_sum_w = stan::math::log_sum_exp(log_w);
+    log_z += log_sum_w - std::log(num_particles);
+    double ess = stan::mcmc::tempering_ess(log_ratio, next_beta - beta);
+
+    Eigen::VectorXd weights = (log_w.array() - log_sum_w).exp().matrix();
+    std::vector<int> ancestors
+        = stan::mcmc::systematic_resample(weights, rand_uniform());
+    std::vector<stan::mcmc::sample> resampled;
+    resampled.reserve(num_particles);
+    Eigen::VectorXd resampled_log_ratio(num_particles);
+    for (int k = 0; k < num_particles; ++k) {
+      resampled.push_back(particles[ancestors[k]]);
+      resampled_log_ratio(k) = log_ratio(ancestors[k]);
+    }
+    particles.swap(resampled);
+    log_ratio.swap(resampled_log_ratio);
+
+    beta = next_beta;
+    tempered.set_beta(beta);
+    ++num_stages;
+
+    Eigen::VectorXd inv_metric = internal::smc_ensemble_inv_metric(particles);
+    pool.parallel_for(num_particles, [&](int k) {
+      callbacks::logger quiet_logger;
+      sampler_t& sampler = *samplers[k];
+      sampler.set_metric(inv_metric);
+      sampler.set_nominal_stepsize_and_T(stepsize, int_time);
+      accept[k] = 0;
+      for (int m = 0; m < num_mutations; ++m) {
+        particles[k] = sampler.transition(particles[k], quiet_logger);
+        accept[k] += particles[k].accept_stat() / num_mutations;
+      }
+      log_ratio(k)
+          = internal::smc_log_ratio(tempered, particles[k].cont_params());
+    });
+
+    double mean_accept = 0;
+    for (double a : accept)
+      mean_accept += a / num_particles;
+    std::stringstream msg;
+    msg << "Stage " << num_stages << ": beta = " << beta
+        << ", ESS = " << ess << ", acceptance = " << mean_accept
+        << ", stepsize = " << stepsize;
+    logger.info(msg);
+    stepsize *= std::exp(2 * (mean_accept - delta));
+  }
+
+  util::mcmc_writer writer(sample_writer, sample_writer, logger);
+  writer.write_sample_names(particles[0], *samplers[0], model);
+  for (int k = 0; k < num_particles; ++k)
+    writer.write_sample_params(rng, particles[k], *samplers[k], model);
+
+  std::stringstream log_z_msg;
+  log_z_msg << "Log marginal likelihood = " << log_z;
+  std::stringstream stages_msg;
+  stages_msg << "Number of tempering stages = " << num_stages;
+  sample_writer(log_z_msg.str());
+  sample_writer(stages_msg.str());
+  logger.info(log_z_msg);
+  logger.info(stages_msg);
+
+  return error_codes::OK;
+}
+
+/**
+ * Runs sequential Monte Carlo with adaptive tempering on the shared
+ * thread pool, <code>util::shared_thread_pool()</code>.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] num_particles number of particles, at least 2
+ * @param[in] ref_scale standard deviation of the reference density
+ * @param[in] ess_fraction target fraction of the particles kept by the
+ *   incremental weights, in (0, 1)
+ * @param[in] num_mutations number of HMC transitions per stage
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] int_time integration time
+ * @param[in] delta target average acceptance statistic, in (0, 1)
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] sample_writer Writer for draws
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int smc_static_diag_e(Model& model, unsigned int random_seed,
+                      unsigned int chain, int num_particles, double ref_scale,
+                      double ess_fraction, int num_mutations, double stepsize,
+                      double int_time, double delta,
+                      callbacks::interrupt& interrupt,
+                      callbacks::logger& logger,
+                      callbacks::writer& sample_writer) {
+  return smc_static_diag_e(model, random_seed, chain, num_particles,
+                           ref_scale, ess_fraction, num_mutations, stepsize,
+                           int_time, delta, util::shared_thread_pool(),
+                           interrupt, logger, sample_writer);
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
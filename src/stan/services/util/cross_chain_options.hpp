@@ -0,0 +1,72 @@
+#ifndef STAN_SERVICES_UTIL_CROSS_CHAIN_OPTIONS_HPP
+#define STAN_SERVICES_UTIL_CROSS_CHAIN_OPTIONS_HPP
+
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Optional features of cross-chain warmup and sampling handed to a
+ * sampler service. A default constructed object turns all of them
+ * off, so that a service behaves as it does without it.
+ */
+struct cross_chain_options {
+  /**
+   * number of chains needed to evaluate a cross-chain window, zero
+   * for all the chains. See
+   * <code>mpi_cross_chain_adapter::set_cross_chain_quorum</code>.
+   */
+  int quorum = 0;
+
+  /**
+   * iterations between culls of stuck chains in the initial
+   * buffer, zero disables culling. See
+   * <code>mpi_cross_chain_adapter::set_cross_chain_culling</code>.
+   */
+  int cull_interval = 0;
+  double cull_lp_threshold = 4.0;
+  double cull_accept_ratio = 0.5;
+
+  /**
+   * post-warmup iterations between checks of the pooled ESS and
+   * Rhat, zero disables early stopping. See
+   * <code>mpi_cross_chain_adapter::set_cross_chain_sampling_target</code>.
+   */
+  int sampling_check_interval = 0;
+  double sampling_target_ess = 0.0;
+  double sampling_target_rhat = 0.0;
+  std::vector<int> sampling_index;
+
+  bool use_quorum(int num_chains) const {
+    return quorum > 1 && quorum < num_chains;
+  }
+};
+
+/**
+ * Pass cross-chain options to a sampler. Must be called after
+ * <code>set_cross_chain_adaptation_params</code>.
+ *
+ * @tparam Sampler sampler with cross-chain warmup
+ * @param[in,out] sampler sampler
+ * @param[in] options cross-chain options
+ */
+template <class Sampler>
+void set_cross_chain_options(Sampler& sampler,
+                             const cross_chain_options& options) {
+  sampler.set_cross_chain_quorum(options.quorum);
+  sampler.set_cross_chain_culling(options.cull_interval,
+                                  options.cull_lp_threshold,
+                                  options.cull_accept_ratio);
+  sampler.set_cross_chain_sampling_target(options.sampling_check_interval,
+                                          options.sampling_target_ess,
+                                          options.sampling_target_rhat,
+                                          options.sampling_index);
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+
+#endif
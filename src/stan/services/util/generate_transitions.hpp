@@ -37,8 +37,10 @@ namespace util {
  * @param[in,out] base_rng random number generator
  * @param[in,out] callback interrupt callback called once an iteration
  * @param[in,out] logger logger for messages
+ * @param[in] observe functor called with the sample after each
+ *   transition
  */
-template <class Sampler, class Model, class RNG,
+template <class Sampler, class Model, class RNG, class Observer,
           std::enable_if_t<std::is_base_of<stan::mcmc::base_mcmc, Sampler>::value>* = nullptr>
 void generate_transitions(Sampler& sampler, int num_iterations,
                           int start, int finish, int num_thin, int refresh,
@@ -46,7 +48,8 @@ void generate_transitions(Sampler& sampler, int num_iterations,
                           util::mcmc_writer& mcmc_writer,
                           stan::mcmc::sample& init_s, Model& model,
                           RNG& base_rng, callbacks::interrupt& callback,
-                          callbacks::logger& logger) {
+                          callbacks::logger& logger,
+                          const Observer& observe) {
   for (int m = 0; m < num_iterations; ++m) {
     callback();
 
@@ -63,7 +66,8 @@ void generate_transitions(Sampler& sampler, int num_iterations,
       logger.info(message);
     }
 
-    init_s = sampler.transition(init_s, logger);
+    sampler.transition_in_place(init_s, logger);
+    observe(init_s);
 
     if (save && ((m % num_thin) == 0)) {
       mcmc_writer.write_sample_params(base_rng, init_s, sampler, model);
@@ -74,9 +78,55 @@ void generate_transitions(Sampler& sampler, int num_iterations,
     if (mpi_cross_chain<Sampler>::end_transitions(sampler)) {
       break;
     }
+
+    // check pooled cross-chain ESS of post-warmup draws
+    if (!warmup && mpi_cross_chain<Sampler>::end_sampling(sampler, init_s, logger)) {
+      break;
+    }
   }
 }
 
+/**
+ * Generates MCMC transitions.
+ *
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] sampler MCMC sampler used to generate transitions
+ * @param[in] num_iterations number of MCMC transitions
+ * @param[in] start starting iteration number used for printing messages
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writer writer to handle mcmc output
+ * @param[in,out] init_s starts as the initial unconstrained parameter
+ *   values. When the function completes, this will have the final
+ *   iteration's unconstrained parameter values
+ * @param[in] model model
+ * @param[in,out] base_rng random number generator
+ * @param[in,out] callback interrupt callback called once an iteration
+ * @param[in,out] logger logger for messages
+ */
+template <class Sampler, class Model, class RNG,
+          std::enable_if_t<std::is_base_of<stan::mcmc::base_mcmc, Sampler>::value>* = nullptr>
+void generate_transitions(Sampler& sampler, int num_iterations,
+                          int start, int finish, int num_thin, int refresh,
+                          bool save, bool warmup,
+                          util::mcmc_writer& mcmc_writer,
+                          stan::mcmc::sample& init_s, Model& model,
+                          RNG& base_rng, callbacks::interrupt& callback,
+                          callbacks::logger& logger) {
+  generate_transitions(sampler, num_iterations, start, finish, num_thin,
+                       refresh, save, warmup, mcmc_writer, init_s, model,
+                       base_rng, callback, logger,
+                       [](const stan::mcmc::sample&) {});
+}
+
 }  // namespace util
 }  // namespace services
 }  // namespace stan
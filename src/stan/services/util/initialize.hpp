@@ -41,7 +41,9 @@ namespace util {
  *
  * Valid initialization is defined as a finite, non-NaN value for the
  * evaluation of the log probability density function and all its
- * gradients.
+ * gradients. Samplers that never evaluate the gradients can skip
+ * them with <code>check_gradient = false</code>; then only the
+ * <code>double</code> log density is evaluated.
  *
  * @tparam Jacobian indicates whether to include the Jacobian term when
  *   evaluating the log density function
@@ -58,6 +60,8 @@ namespace util {
  *   be printed to the logger
  * @param[in,out] logger logger for messages
  * @param[in,out] init_writer init writer (on the unconstrained scale)
+ * @param[in] check_gradient indicates whether the gradients must be
+ *   evaluated and finite
  * @throws exception passed through from the model if the model has a
  *   fatal error (not a std::domain_error)
  * @throws std::domain_error if the model can not be initialized and
@@ -69,7 +73,8 @@ template <bool Jacobian = true, class Model, class RNG>
 std::vector<double> initialize(Model& model, const stan::io::var_context& init,
                                RNG& rng, double init_radius, bool print_timing,
                                stan::callbacks::logger& logger,
-                               stan::callbacks::writer& init_writer) {
+                               stan::callbacks::writer& init_writer,
+                               bool check_gradient = true) {
   std::vector<double> unconstrained;
   std::vector<int> disc_vector;
 
@@ -157,6 +162,10 @@ std::vector<double> initialize(Model& model, const stan::io::var_context& init,
           " initial value.");
       continue;
     }
+    if (!check_gradient) {
+      init_writer(unconstrained);
+      return unconstrained;
+    }
     std::stringstream log_prob_msg;
     std::vector<double> gradient;
     auto start = std::chrono::steady_clock::now();
@@ -4,3 +4,5 @@
 #include <stan/services/util/read_dense_inv_metric.hpp>
 #include <stan/services/util/validate_diag_inv_metric.hpp>
 #include <stan/services/util/validate_dense_inv_metric.hpp>
+#include <stan/services/util/inv_metric_spec.hpp>
+#include <stan/services/util/inv_metric_binary.hpp>
@@ -0,0 +1,141 @@
+#ifndef STAN_SERVICES_UTIL_INV_METRIC_BINARY_HPP
+#define STAN_SERVICES_UTIL_INV_METRIC_BINARY_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/services/util/inv_metric_spec.hpp>
+#include <stan/math/prim.hpp>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace stan {
+namespace services {
+namespace util {
+
+namespace internal {
+
+/*
+ * Header of an inverse metric sidecar file, followed by the stored
+ * elements of the metric as doubles in column-major order. The byte
+ * order mark is written as 1 in the byte order of the writer.
+ */
+struct inv_metric_binary_header {
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t kind;
+  uint64_t num_params;
+};
+
+inline const char* inv_metric_binary_magic() { return "STANIMT1"; }
+
+}  // namespace internal
+
+/**
+ * Write an inverse Euclidean metric to a binary stream: a 24 byte
+ * header and the stored elements, an empty body for the identity, the
+ * diagonal, or the dense matrix in column-major order. Values are
+ * written in the byte order of the host and read back bit for bit.
+ *
+ * @param[in] inv_metric inverse metric
+ * @param[in,out] out binary output stream
+ * @throws std::runtime_error if the stream fails
+ */
+inline void write_inv_metric_binary(const inv_metric_spec& inv_metric,
+                                    std::ostream& out) {
+  internal::inv_metric_binary_header header;
+  std::memcpy(header.magic, internal::inv_metric_binary_magic(),
+              sizeof(header.magic));
+  header.byte_order = 1;
+  header.kind = inv_metric.kind();
+  header.num_params = inv_metric.num_params();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(inv_metric.data()),
+            inv_metric.size() * sizeof(double));
+  if (!out)
+    throw std::runtime_error("Cannot write inverse metric");
+}
+
+/**
+ * Read an inverse Euclidean metric written by
+ * <code>write_inv_metric_binary</code>.
+ *
+ * @param[in,out] in binary input stream
+ * @param[in] num_params expected number of unconstrained parameters
+ * @param[in,out] logger Logger for messages
+ * @throws std::domain_error if the stream does not hold an inverse
+ *   metric of the expected size
+ * @return inverse metric
+ */
+inline inv_metric_spec read_inv_metric_binary(std::istream& in,
+                                              size_t num_params,
+                                              callbacks::logger& logger) {
+  internal::inv_metric_binary_header header;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  std::string error;
+  if (!in
+      || std::memcmp(header.magic, internal::inv_metric_binary_magic(),
+                     sizeof(header.magic))
+             != 0)
+    error = "not an inverse metric file";
+  else if (header.byte_order != 1)
+    error = "written with a different byte order";
+  else if (header.kind > inv_metric_spec::dense)
+    error = "unknown metric kind " + std::to_string(header.kind);
+  else if (header.num_params != num_params)
+    error = "expected " + std::to_string(num_params) + " parameters, found "
+            + std::to_string(header.num_params);
+  if (!error.empty()) {
+    logger.error("Cannot get inverse metric from binary file: " + error);
+    throw std::domain_error("Initialization failure");
+  }
+
+  inv_metric_spec inv_metric = inv_metric_spec::identity(num_params);
+  if (header.kind == inv_metric_spec::diag) {
+    Eigen::VectorXd diag(num_params);
+    in.read(reinterpret_cast<char*>(diag.data()), diag.size() * sizeof(double));
+    inv_metric = inv_metric_spec::diagonal(std::move(diag));
+  } else if (header.kind == inv_metric_spec::dense) {
+    Eigen::MatrixXd dense(num_params, num_params);
+    in.read(reinterpret_cast<char*>(dense.data()),
+            dense.size() * sizeof(double));
+    inv_metric = inv_metric_spec::full(std::move(dense));
+  }
+  if (!in) {
+    logger.error("Cannot get inverse metric from binary file: truncated");
+    throw std::domain_error("Initialization failure");
+  }
+  return inv_metric;
+}
+
+/**
+ * Write the adapted inverse metric of a dense Euclidean sampler to a
+ * binary sidecar stream. Nothing is written if no stream is given. A
+ * failed write is logged and does not stop sampling.
+ *
+ * @tparam Sampler sampler with a dense Euclidean point
+ * @param[in] sampler sampler after adaptation
+ * @param[in,out] out binary output stream, may be null
+ * @param[in,out] logger Logger for messages
+ */
+template <class Sampler>
+void write_dense_inv_metric_binary(Sampler& sampler, std::ostream* out,
+                                   callbacks::logger& logger) {
+  if (out == nullptr)
+    return;
+  try {
+    write_inv_metric_binary(inv_metric_spec::full(sampler.z().inv_e_metric_),
+                            *out);
+  } catch (const std::runtime_error& e) {
+    logger.error(e.what());
+  }
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef STAN_SERVICES_UTIL_INV_METRIC_SPEC_HPP
+#define STAN_SERVICES_UTIL_INV_METRIC_SPEC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/services/util/validate_dense_inv_metric.hpp>
+#include <stan/services/util/validate_diag_inv_metric.hpp>
+#include <stan/math/prim.hpp>
+#include <cstddef>
+#include <utility>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Inverse Euclidean metric handed to a sampler service: the identity,
+ * a diagonal or a dense matrix. Unlike a <code>var_context</code>
+ * holding the elements, the identity takes no storage until a sampler
+ * needs it, and a diagonal or dense matrix is held as is, without
+ * text formatting and parsing.
+ */
+class inv_metric_spec {
+ public:
+  enum kind_type { unit = 0, diag = 1, dense = 2 };
+
+  /**
+   * Return the identity metric.
+   *
+   * @param[in] num_params number of unconstrained parameters
+   */
+  static inv_metric_spec identity(size_t num_params) {
+    return inv_metric_spec(unit, num_params);
+  }
+
+  /**
+   * Return a diagonal metric.
+   *
+   * @param[in] inv_metric diagonal of the inverse metric
+   */
+  static inv_metric_spec diagonal(Eigen::VectorXd inv_metric) {
+    inv_metric_spec spec(diag, inv_metric.size());
+    spec.diag_ = std::move(inv_metric);
+    return spec;
+  }
+
+  /**
+   * Return a dense metric.
+   *
+   * @param[in] inv_metric inverse metric
+   */
+  static inv_metric_spec full(Eigen::MatrixXd inv_metric) {
+    inv_metric_spec spec(dense, inv_metric.rows());
+    spec.dense_ = std::move(inv_metric);
+    return spec;
+  }
+
+  kind_type kind() const { return kind_; }
+
+  size_t num_params() const { return num_params_; }
+
+  /**
+   * Return the diagonal of the inverse metric.
+   */
+  Eigen::VectorXd diag_inv_metric() const {
+    switch (kind_) {
+      case diag:
+        return diag_;
+      case dense:
+        return dense_.diagonal();
+      default:
+        return Eigen::VectorXd::Ones(num_params_);
+    }
+  }
+
+  /**
+   * Return the inverse metric as a dense matrix.
+   */
+  Eigen::MatrixXd dense_inv_metric() const {
+    switch (kind_) {
+      case diag:
+        return diag_.asDiagonal();
+      case dense:
+        return dense_;
+      default:
+        return Eigen::MatrixXd::Identity(num_params_, num_params_);
+    }
+  }
+
+  /**
+   * Stored elements: empty for the identity, the diagonal, or the
+   * dense matrix in column-major order.
+   */
+  const double* data() const {
+    return kind_ == diag ? diag_.data() : dense_.data();
+  }
+
+  size_t size() const {
+    return kind_ == diag ? diag_.size() : kind_ == dense ? dense_.size() : 0;
+  }
+
+  /**
+   * Validate the metric as <code>validate_diag_inv_metric</code> and
+   * <code>validate_dense_inv_metric</code> do, and check its size.
+   *
+   * @param[in] num_params expected number of unconstrained parameters
+   * @param[in,out] logger Logger for messages
+   * @throws std::domain_error if the metric is not valid
+   */
+  void validate(size_t num_params, callbacks::logger& logger) const {
+    if (num_params != num_params_
+        || (kind_ == dense
+            && static_cast<size_t>(dense_.cols()) != num_params_)) {
+      logger.error("Inverse Euclidean metric has wrong size.");
+      throw std::domain_error("Initialization failure");
+    }
+    if (kind_ == diag)
+      validate_diag_inv_metric(diag_, logger);
+    else if (kind_ == dense)
+      validate_dense_inv_metric(dense_, logger);
+  }
+
+ private:
+  kind_type kind_;
+  size_t num_params_;
+  Eigen::VectorXd diag_;
+  Eigen::MatrixXd dense_;
+
+  inv_metric_spec(kind_type kind, size_t num_params)
+      : kind_(kind), num_params_(num_params) {}
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+
+#endif
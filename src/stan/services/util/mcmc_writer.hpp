@@ -26,6 +26,8 @@ class mcmc_writer {
   callbacks::writer& sample_writer_;
   callbacks::writer& diagnostic_writer_;
   callbacks::logger& logger_;
+  // unconstrained parameters passed to write_array, reused across draws
+  std::vector<double> cont_params_;
 
  public:
   size_t num_sample_params_;
@@ -105,10 +107,10 @@ class mcmc_writer {
     std::vector<int> params_i;
     std::stringstream ss;
     try {
-      std::vector<double> cont_params(
+      cont_params_.assign(
           sample.cont_params().data(),
           sample.cont_params().data() + sample.cont_params().size());
-      model.write_array(rng, cont_params, params_i, model_values, true, true,
+      model.write_array(rng, cont_params_, params_i, model_values, true, true,
                         &ss);
     } catch (const std::exception& e) {
       if (ss.str().length() > 0)
@@ -0,0 +1,272 @@
+#ifndef STAN_SERVICES_UTIL_METRIC_SELECTION_HPP
+#define STAN_SERVICES_UTIL_METRIC_SELECTION_HPP
+
+#include <stan/math/prim.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Outcome of <code>metric_selector::select()</code>: the chosen
+ * Euclidean metric and the predictions it is based on.
+ */
+struct metric_choice {
+  /** true if the dense metric was chosen, false for the diagonal one */
+  bool dense;
+  /** condition number of the correlation matrix of the draws */
+  double diag_condition;
+  /** expected condition number left by a dense metric estimated from
+      the draws */
+  double dense_condition;
+  /** seconds per leapfrog step with a diagonal metric */
+  double diag_step_time;
+  /** predicted seconds per leapfrog step with a dense metric */
+  double dense_step_time;
+  /** predicted relative cost of an effective draw, diagonal metric */
+  double diag_cost;
+  /** predicted relative cost of an effective draw, dense metric */
+  double dense_cost;
+  /** regularized covariance of the draws, if dense was chosen */
+  Eigen::MatrixXd covariance;
+  /** explanation if the choice was made without a prediction */
+  std::string reason;
+
+  std::string name() const { return dense ? "dense_e" : "diag_e"; }
+
+  /**
+   * Return a description of the choice, one item per line.
+   */
+  std::string summary() const {
+    std::stringstream ss;
+    ss << "Metric selection: " << name();
+    if (!reason.empty()) {
+      ss << " (" << reason << ")";
+      return ss.str();
+    }
+    ss << "\n  diag_e: condition number " << diag_condition << ", "
+       << diag_step_time << " s per leapfrog step, relative cost "
+       << diag_cost << "\n  dense_e: condition number " << dense_condition
+       << ", " << dense_step_time << " s per leapfrog step, relative cost "
+       << dense_cost;
+    return ss.str();
+  }
+};
+
+/**
+ * Chooses between a diagonal and a dense Euclidean metric from warmup
+ * draws of a sampler with a diagonal metric.
+ *
+ * <p>The number of leapfrog steps NUTS needs per effective draw grows
+ * roughly with the square root of the condition number of the
+ * posterior covariance after scaling by the metric. A diagonal metric
+ * leaves the correlations, so its condition number is that of the
+ * correlation matrix of the draws. A dense metric removes the
+ * correlations up to the error of estimating the covariance from
+ * <code>m</code> draws in <code>d</code> dimensions, which leaves a
+ * condition number of about
+ * <code>((1 + sqrt(d / m)) / (1 - sqrt(d / m)))^2</code> (the
+ * Marchenko-Pastur edges). Here <code>m</code> is the number of
+ * draws the sampling metric will be estimated from, i.e. the last
+ * adaptation window, which is usually much longer than the
+ * <code>n</code> selection draws.
+ *
+ * <p>With more selection draws than dimensions, the condition number
+ * of the correlations is that of the sample correlation matrix, whose
+ * square root is divided by the one of its estimation noise at
+ * <code>n</code> draws. With fewer, the sample correlation matrix is
+ * singular and is shrunk toward the identity with the Ledoit-Wolf
+ * intensity, which removes most of the noise; the shrunk matrix also
+ * initializes the dense metric.
+ *
+ * <p>The steps are weighted by their cost: the measured time of a
+ * leapfrog step with the diagonal metric, and for the dense metric
+ * the same plus the measured extra time of its two matrix-vector
+ * products. The metric with the smaller predicted time per effective
+ * draw is chosen. A dense metric is never chosen if it would be
+ * estimated from fewer draws than dimensions, nor from fewer than
+ * <code>min_draws</code> selection draws.
+ */
+class metric_selector {
+ public:
+  /**
+   * @param[in] num_params number of unconstrained parameters
+   */
+  explicit metric_selector(int num_params) : num_params_(num_params) {}
+
+  /** smallest number of selection draws for a dense metric */
+  static constexpr int min_draws = 10;
+
+  /**
+   * Add a draw of the unconstrained parameters.
+   *
+   * @param[in] q draw
+   */
+  void add_draw(const Eigen::VectorXd& q) { draws_.push_back(q); }
+
+  int num_draws() const { return draws_.size(); }
+
+  /**
+   * Choose the metric.
+   *
+   * @param[in] diag_step_time measured seconds per leapfrog step with
+   *   a diagonal metric
+   * @param[in] num_metric_draws number of draws the sampling metric
+   *   will be estimated from, the number of selection draws if not
+   *   positive
+   * @return choice and predictions
+   */
+  metric_choice select(double diag_step_time,
+                       int num_metric_draws = 0) const {
+    metric_choice choice;
+    choice.dense = false;
+    choice.diag_step_time = diag_step_time;
+    choice.dense_condition = std::numeric_limits<double>::infinity();
+    choice.diag_condition = std::numeric_limits<double>::quiet_NaN();
+    choice.dense_step_time = std::numeric_limits<double>::quiet_NaN();
+    choice.diag_cost = std::numeric_limits<double>::quiet_NaN();
+    choice.dense_cost = std::numeric_limits<double>::infinity();
+
+    int n = draws_.size();
+    int d = num_params_;
+    int m = num_metric_draws > 0 ? num_metric_draws : n;
+    if (n < min_draws || m <= d + 1) {
+      std::stringstream ss;
+      ss << std::min(n, m)
+         << " draws are too few to estimate a dense metric in " << d
+         << " dimensions";
+      choice.reason = ss.str();
+      return choice;
+    }
+
+    Eigen::MatrixXd centered(d, n);
+    for (int i = 0; i < n; ++i)
+      centered.col(i) = draws_[i];
+    Eigen::VectorXd mean = centered.rowwise().mean();
+    centered.colwise() -= mean;
+    Eigen::MatrixXd covar = centered * centered.transpose() / (n - 1.0);
+    Eigen::VectorXd inv_sd = covar.diagonal().cwiseSqrt().cwiseInverse();
+    if (!inv_sd.allFinite()) {
+      choice.reason = "a parameter did not move during warmup";
+      return choice;
+    }
+    Eigen::MatrixXd correlation
+        = inv_sd.asDiagonal() * covar * inv_sd.asDiagonal();
+    bool shrunk = n <= d + 1;
+    if (shrunk) {
+      Eigen::MatrixXd standardized = inv_sd.asDiagonal() * centered;
+      double lambda = ledoit_wolf_intensity(standardized);
+      correlation *= 1 - lambda;
+      correlation.diagonal().array() += lambda;
+    }
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(
+        correlation, Eigen::EigenvaluesOnly);
+    double min_eigenvalue = std::max(eigen.eigenvalues().minCoeff(),
+                                     std::numeric_limits<double>::min());
+    choice.diag_condition = eigen.eigenvalues().maxCoeff() / min_eigenvalue;
+
+    // noise of the sample correlation of the selection draws, already
+    // removed by the shrinkage, and of the sampling metric
+    double sample_noise_steps = shrunk ? 1.0 : noise_steps(d, n);
+    double metric_noise_steps = noise_steps(d, m);
+    choice.dense_condition = metric_noise_steps * metric_noise_steps;
+
+    choice.dense_step_time
+        = diag_step_time
+          + std::max(0.0, metric_time(d, true) - metric_time(d, false));
+    choice.diag_cost
+        = std::max(1.0, std::sqrt(choice.diag_condition) / sample_noise_steps)
+          * diag_step_time;
+    choice.dense_cost = metric_noise_steps * choice.dense_step_time;
+    choice.dense = choice.dense_cost < choice.diag_cost;
+
+    if (choice.dense) {
+      if (shrunk) {
+        Eigen::VectorXd sd = inv_sd.cwiseInverse();
+        covar = sd.asDiagonal() * correlation * sd.asDiagonal();
+      }
+      // regularized as in covar_adaptation
+      choice.covariance = (n / (n + 5.0)) * covar;
+      choice.covariance.diagonal().array() += 1e-3 * (5.0 / (n + 5.0));
+    }
+    return choice;
+  }
+
+ private:
+  int num_params_;
+  std::vector<Eigen::VectorXd> draws_;
+
+  /*
+   * Square root of the condition number left by the error of a
+   * covariance estimated from n draws in d dimensions.
+   */
+  static double noise_steps(int d, int n) {
+    double root_ratio = std::sqrt(static_cast<double>(d) / n);
+    return (1 + root_ratio) / (1 - root_ratio);
+  }
+
+  /*
+   * Ledoit-Wolf intensity of the shrinkage of a sample correlation
+   * matrix toward the identity, from the standardized draws in
+   * columns (Ledoit and Wolf, 2004, with a target of the identity).
+   */
+  static double ledoit_wolf_intensity(const Eigen::MatrixXd& standardized) {
+    int d = standardized.rows();
+    int n = standardized.cols();
+    Eigen::MatrixXd sample = standardized * standardized.transpose() / n;
+    double delta = (sample - Eigen::MatrixXd::Identity(d, d)).squaredNorm();
+    double beta = 0;
+    double sample_norm = sample.squaredNorm();
+    for (int i = 0; i < n; ++i) {
+      Eigen::VectorXd z = standardized.col(i);
+      double z_norm = z.squaredNorm();
+      beta += z_norm * z_norm - 2 * z.dot(sample * z) + sample_norm;
+    }
+    beta /= static_cast<double>(n) * n;
+    if (!(delta > 0))
+      return 1;
+    return std::min(beta, delta) / delta;
+  }
+
+  /*
+   * Time of the two products of the metric with a vector in a
+   * leapfrog step, for a dense or diagonal metric of dimension d.
+   */
+  static double metric_time(int d, bool dense) {
+    int rows = dense ? d : 1;
+    Eigen::MatrixXd m = Eigen::MatrixXd::Identity(rows, rows);
+    Eigen::VectorXd v = Eigen::VectorXd::Ones(d);
+    Eigen::VectorXd p = Eigen::VectorXd::Ones(d);
+    Eigen::VectorXd r(d);
+    double sink = 0;
+    long reps = 0;
+    double elapsed = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (elapsed < 1e-3) {
+      for (int k = 0; k < 10; ++k, ++reps) {
+        if (dense)
+          r.noalias() = m * p;
+        else
+          r = v.cwiseProduct(p);
+        sink += r(0);
+        p(0) = sink * 1e-300;
+      }
+      elapsed = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    }
+    return 2 * elapsed / reps + 0 * sink;
+  }
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -5,6 +5,7 @@
 #include <stan/callbacks/writer.hpp>
 #include <stan/services/util/generate_transitions.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
+#include <stan/mcmc/cross_chain/mpi_cross_chain.hpp>
 #include <chrono>
 #include <vector>
 
@@ -33,8 +34,10 @@ namespace util {
  * @param[in,out] logger logger for messages
  * @param[in,out] sample_writer writer for draws
  * @param[in,out] diagnostic_writer writer for diagnostic information
+ * @param[in] on_adapted callback taking the sampler, called once after
+ *   adaptation ends and before the first post warmup draw
  */
-template <class Sampler, class Model, class RNG>
+template <class Sampler, class Model, class RNG, class AdaptedCallback>
 void run_adaptive_sampler(Sampler& sampler, Model& model,
                           std::vector<double>& cont_vector, int num_warmup,
                           int num_samples, int num_thin, int refresh,
@@ -42,7 +45,8 @@ void run_adaptive_sampler(Sampler& sampler, Model& model,
                           callbacks::interrupt& interrupt,
                           callbacks::logger& logger,
                           callbacks::writer& sample_writer,
-                          callbacks::writer& diagnostic_writer) {
+                          callbacks::writer& diagnostic_writer,
+                          const AdaptedCallback& on_adapted) {
   Eigen::Map<Eigen::VectorXd> cont_params(cont_vector.data(),
                                           cont_vector.size());
 
@@ -75,6 +79,7 @@ void run_adaptive_sampler(Sampler& sampler, Model& model,
   sampler.disengage_adaptation();
   writer.write_adapt_finish(sampler);
   sampler.write_sampler_state(sample_writer);
+  on_adapted(sampler);
 
   auto start_sample = std::chrono::steady_clock::now();
   util::generate_transitions(sampler, num_samples, num_warmup,
@@ -85,8 +90,48 @@ void run_adaptive_sampler(Sampler& sampler, Model& model,
                               end_sample - start_sample)
                               .count()
                           / 1000.0;
+  // after the draws, so that the adaptation block holds only the
+  // step size and the metric read by stan_csv_reader
+  mpi_cross_chain<Sampler>::write_num_culled(sampler, sample_writer);
+  mpi_cross_chain<Sampler>::write_num_samples(sampler, sample_writer);
   writer.write_timing(warm_delta_t, sample_delta_t);
 }
+
+/**
+ * Runs the sampler with adaptation.
+ *
+ * @tparam Sampler Type of adaptive sampler.
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @param[in,out] sampler the mcmc sampler to use on the model
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vector initial parameter values
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in,out] rng random number generator
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writer for draws
+ * @param[in,out] diagnostic_writer writer for diagnostic information
+ */
+template <class Sampler, class Model, class RNG>
+void run_adaptive_sampler(Sampler& sampler, Model& model,
+                          std::vector<double>& cont_vector, int num_warmup,
+                          int num_samples, int num_thin, int refresh,
+                          bool save_warmup, RNG& rng,
+                          callbacks::interrupt& interrupt,
+                          callbacks::logger& logger,
+                          callbacks::writer& sample_writer,
+                          callbacks::writer& diagnostic_writer) {
+  run_adaptive_sampler(sampler, model, cont_vector, num_warmup, num_samples,
+                       num_thin, refresh, save_warmup, rng, interrupt, logger,
+                       sample_writer, diagnostic_writer, [](Sampler&) {});
+}
 }  // namespace util
 }  // namespace services
 }  // namespace stan
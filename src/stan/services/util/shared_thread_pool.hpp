@@ -0,0 +1,102 @@
+#ifndef STAN_SERVICES_UTIL_SHARED_THREAD_POOL_HPP
+#define STAN_SERVICES_UTIL_SHARED_THREAD_POOL_HPP
+
+#include <stan/services/util/thread_pool.hpp>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace stan {
+namespace services {
+namespace util {
+namespace internal {
+
+inline std::mutex& shared_thread_pool_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+inline std::unique_ptr<thread_pool>& shared_thread_pool_instance() {
+  static std::unique_ptr<thread_pool> pool;
+  return pool;
+}
+
+inline std::unique_ptr<thread_pool_options>& shared_thread_pool_options() {
+  static std::unique_ptr<thread_pool_options> options;
+  return options;
+}
+
+}  // namespace internal
+
+/**
+ * Return the number of threads requested by the environment variable
+ * <code>STAN_NUM_THREADS</code>: a positive number, or -1 for one per
+ * hardware thread. Returns 1 if the variable is unset or invalid, or
+ * if compiled without <code>STAN_THREADS</code>, in which case the
+ * autodiff stack cannot be used from several threads.
+ */
+inline int default_num_threads() {
+#ifdef STAN_THREADS
+  const char* env = std::getenv("STAN_NUM_THREADS");
+  if (env == nullptr)
+    return 1;
+  int n = std::atoi(env);
+  if (n == -1)
+    return std::max(1U, std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+#else
+  return 1;
+#endif
+}
+
+/**
+ * Configure the pool returned by <code>shared_thread_pool()</code>.
+ * Must be called before its first use.
+ *
+ * @param[in] options configuration of the shared pool
+ * @throw std::logic_error if the shared pool has already started
+ * @throw std::invalid_argument if the number of threads is not
+ * positive
+ */
+inline void configure_shared_thread_pool(const thread_pool_options& options) {
+  if (options.num_threads < 1)
+    throw std::invalid_argument("configure_shared_thread_pool: number of "
+                                "threads must be positive");
+  std::lock_guard<std::mutex> lock(internal::shared_thread_pool_mutex());
+  if (internal::shared_thread_pool_instance())
+    throw std::logic_error("configure_shared_thread_pool: the shared thread "
+                           "pool has already started");
+  internal::shared_thread_pool_options().reset(
+      new thread_pool_options(options));
+}
+
+/**
+ * Return the thread pool shared by the services and by parallel code
+ * within a log density, started on first use. It is configured by
+ * <code>configure_shared_thread_pool()</code>, or else has
+ * <code>default_num_threads()</code> threads.
+ *
+ * <p>Loops submitted from within the pool's own tasks run on the same
+ * workers, so a parallel service may call a parallel log density
+ * without oversubscribing the machine.
+ *
+ * @return shared thread pool
+ */
+inline thread_pool& shared_thread_pool() {
+  std::lock_guard<std::mutex> lock(internal::shared_thread_pool_mutex());
+  std::unique_ptr<thread_pool>& pool = internal::shared_thread_pool_instance();
+  if (!pool) {
+    std::unique_ptr<thread_pool_options>& options
+        = internal::shared_thread_pool_options();
+    pool.reset(options ? new thread_pool(*options)
+                       : new thread_pool(default_num_threads()));
+  }
+  return *pool;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,482 @@
+#ifndef STAN_SERVICES_UTIL_THREAD_POOL_HPP
+#define STAN_SERVICES_UTIL_THREAD_POOL_HPP
+
+#ifdef STAN_THREADS
+#include <stan/math/rev.hpp>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Configuration of a <code>thread_pool</code>.
+ */
+struct thread_pool_options {
+  /** number of worker threads */
+  int num_threads;
+  /** worker <code>i</code> is pinned to CPU
+      <code>cpus[i % cpus.size()]</code>; empty leaves scheduling to
+      the operating system. Only supported on Linux. */
+  std::vector<int> cpus;
+  /** give each worker its own autodiff stack, with
+      <code>STAN_THREADS</code> */
+  bool autodiff;
+
+  explicit thread_pool_options(int n = 1) : num_threads(n), autodiff(true) {}
+};
+
+/**
+ * Counters of a <code>thread_pool</code> since it started or since
+ * its statistics were reset. A task is one iteration of a loop.
+ */
+struct thread_pool_stats {
+  long num_tasks;
+  double task_seconds;
+  double max_task_seconds;
+  /** tasks a worker took from the queue of another worker */
+  long num_steals;
+  /** number of times work was queued */
+  long num_submits;
+  /** sum over submits of the number of queued items after each */
+  long queue_depth_sum;
+  int max_queue_depth;
+
+  thread_pool_stats()
+      : num_tasks(0),
+        task_seconds(0),
+        max_task_seconds(0),
+        num_steals(0),
+        num_submits(0),
+        queue_depth_sum(0),
+        max_queue_depth(0) {}
+
+  double mean_task_seconds() const {
+    return num_tasks == 0 ? 0 : task_seconds / num_tasks;
+  }
+
+  double mean_queue_depth() const {
+    return num_submits == 0 ? 0
+                            : static_cast<double>(queue_depth_sum)
+                                  / num_submits;
+  }
+
+  /**
+   * Return a one-line summary with times in microseconds.
+   */
+  std::string summary() const {
+    std::stringstream ss;
+    ss << "tasks=" << num_tasks << " mean_us=" << 1e6 * mean_task_seconds()
+       << " max_us=" << 1e6 * max_task_seconds << " steals=" << num_steals
+       << " mean_queue=" << mean_queue_depth()
+       << " max_queue=" << max_queue_depth;
+    return ss.str();
+  }
+};
+
+/**
+ * A fixed set of worker threads that evaluate loops of independent
+ * iterations. Several threads may submit loops at the same time; the
+ * iterations of all of them share the workers.
+ *
+ * <p>Each worker has its own queue. Work submitted from outside the
+ * pool is spread over the queues, work submitted by a worker goes to
+ * its own queue, and idle workers steal from the others. A loop
+ * submitted by a worker, such as a parallel log density inside a
+ * parallel chain, is not waited for idly: the worker runs its
+ * iterations, and iterations of loops nested in them, until the loop
+ * is done, so nested loops share the same threads and cannot
+ * deadlock. A waiting worker never runs unrelated work, which would
+ * share the autodiff stack of the task that is waiting and could
+ * recover its memory.
+ *
+ * <p>When compiled with <code>STAN_THREADS</code>, each worker owns
+ * an autodiff stack unless disabled in the options, so iterations may
+ * use reverse mode autodiff. Without <code>STAN_THREADS</code> the
+ * autodiff stack is global and only a pool of one thread may be used
+ * for autodiff.
+ */
+class thread_pool {
+ public:
+  /**
+   * Start the specified number of worker threads.
+   *
+   * @param[in] num_threads number of worker threads
+   * @throw std::invalid_argument if the number of threads is not
+   * positive
+   */
+  explicit thread_pool(int num_threads)
+      : thread_pool(thread_pool_options(num_threads)) {}
+
+  /**
+   * Start the worker threads configured by the options.
+   *
+   * @param[in] options configuration
+   * @throw std::invalid_argument if the number of threads is not
+   * positive
+   */
+  explicit thread_pool(const thread_pool_options& options)
+      : options_(options), stopping_(false) {
+    if (options.num_threads < 1)
+      throw std::invalid_argument("thread_pool: number of threads must be "
+                                  "positive");
+    // one more set of counters for threads outside the pool
+    for (int n = 0; n <= options.num_threads; ++n)
+      states_.emplace_back(new worker_state());
+    for (int n = 0; n < options.num_threads; ++n)
+      workers_.emplace_back([this, n]() { work(n); });
+  }
+
+  /**
+   * Finish the queued work and join the workers.
+   */
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_)
+      worker.join();
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  int num_threads() const { return workers_.size(); }
+
+  const thread_pool_options& options() const { return options_; }
+
+  /**
+   * Return the number of queued items that no worker has started.
+   */
+  int queue_depth() const { return pending_; }
+
+  /**
+   * Evaluate <code>f(i)</code> for <code>i</code> in
+   * <code>[0, n)</code> on the workers and return when all are done.
+   * If any iteration throws, the remaining iterations are skipped and
+   * the first exception is rethrown.
+   *
+   * @tparam F type of functor
+   * @param[in] n number of iterations
+   * @param[in] f functor called with the iteration index
+   */
+  template <class F>
+  void parallel_for(int n, const F& f) {
+    if (n <= 0)
+      return;
+    int self = self_index();
+    std::shared_ptr<loop> parent
+        = self >= 0 && current_loop() ? current_loop()->shared_from_this()
+                                      : nullptr;
+    std::shared_ptr<loop> l = std::make_shared<loop>(n, parent);
+    int num_tasks = std::min(n, num_threads());
+    for (int t = 0; t < num_tasks; ++t)
+      push(queued_task(l, [this, l, &f]() { l->run(f, current_state()); }),
+           self);
+    if (self >= 0) {
+      l->run(f, *states_[self]);
+      while (!l->finished()) {
+        std::function<void()> task;
+        if (try_pop(self, task, l.get()))
+          task();
+        else
+          l->wait_for(std::chrono::microseconds(100));
+      }
+    } else {
+      l->wait();
+    }
+    if (l->error)
+      std::rethrow_exception(l->error);
+  }
+
+  /**
+   * Return the counters summed over the workers.
+   */
+  thread_pool_stats stats() const {
+    thread_pool_stats s;
+    for (const std::unique_ptr<worker_state>& state : states_) {
+      s.num_tasks += state->num_tasks;
+      s.task_seconds += 1e-9 * state->task_nanos;
+      s.max_task_seconds
+          = std::max(s.max_task_seconds, 1e-9 * state->max_task_nanos);
+      s.num_steals += state->num_steals;
+    }
+    s.num_submits = num_submits_;
+    s.queue_depth_sum = queue_depth_sum_;
+    s.max_queue_depth = max_queue_depth_;
+    return s;
+  }
+
+  /**
+   * Reset the counters. Counts of tasks running concurrently may be
+   * lost.
+   */
+  void reset_stats() {
+    for (std::unique_ptr<worker_state>& state : states_) {
+      state->num_tasks = 0;
+      state->task_nanos = 0;
+      state->max_task_nanos = 0;
+      state->num_steals = 0;
+    }
+    num_submits_ = 0;
+    queue_depth_sum_ = 0;
+    max_queue_depth_ = 0;
+  }
+
+ private:
+  /*
+   * Queue and counters of one worker, allocated separately and padded
+   * so that workers do not share cache lines.
+   */
+  struct loop;
+
+  /*
+   * Queued work and the loop it belongs to.
+   */
+  struct queued_task {
+    queued_task(const std::shared_ptr<loop>& l, std::function<void()> f)
+        : owner(l), run(std::move(f)) {}
+
+    std::shared_ptr<loop> owner;
+    std::function<void()> run;
+  };
+
+  struct worker_state {
+    std::mutex mutex;
+    std::deque<queued_task> tasks;
+    std::atomic<long> num_tasks{0};
+    std::atomic<long> task_nanos{0};
+    std::atomic<long> max_task_nanos{0};
+    std::atomic<long> num_steals{0};
+    char padding[64];
+
+    void record(long nanos) {
+      ++num_tasks;
+      task_nanos += nanos;
+      long max = max_task_nanos;
+      while (nanos > max && !max_task_nanos.compare_exchange_weak(max, nanos)) {
+      }
+    }
+  };
+
+  /*
+   * Shared state of one call to parallel_for. A loop submitted from
+   * an iteration of another loop on a worker is nested in it.
+   */
+  struct loop : public std::enable_shared_from_this<loop> {
+    loop(int n, const std::shared_ptr<loop>& p)
+        : size(n), next(0), remaining(n), parent(p) {}
+
+    template <class F>
+    void run(const F& f, worker_state& state) {
+      for (int i = next++; i < size; i = next++) {
+        auto start = std::chrono::steady_clock::now();
+        loop* enclosing = current_loop();
+        current_loop() = this;
+        try {
+          if (!failed)
+            f(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error)
+            error = std::current_exception();
+          failed = true;
+        }
+        current_loop() = enclosing;
+        state.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count());
+        if (--remaining == 0) {
+          std::lock_guard<std::mutex> lock(mutex);
+          done.notify_all();
+        }
+      }
+    }
+
+    bool finished() const { return remaining == 0; }
+
+    /*
+     * Return true if this loop is the specified one or nested in it.
+     */
+    bool within(const loop* l) const {
+      for (const loop* p = this; p != nullptr; p = p->parent.get())
+        if (p == l)
+          return true;
+      return false;
+    }
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [this]() { return remaining == 0; });
+    }
+
+    template <class Duration>
+    void wait_for(const Duration& d) {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait_for(lock, d, [this]() { return remaining == 0; });
+    }
+
+    const int size;
+    std::atomic<int> next;
+    std::atomic<int> remaining;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+    const std::shared_ptr<loop> parent;
+  };
+
+  thread_pool_options options_;
+  std::vector<std::unique_ptr<worker_state> > states_;
+  std::vector<std::thread> workers_;
+  std::atomic<int> pending_{0};
+  std::atomic<unsigned int> next_queue_{0};
+  std::atomic<long> num_submits_{0};
+  std::atomic<long> queue_depth_sum_{0};
+  std::atomic<int> max_queue_depth_{0};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stopping_;
+
+  static thread_pool*& current_pool() {
+    static thread_local thread_pool* pool = nullptr;
+    return pool;
+  }
+
+  static int& current_index() {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  /*
+   * Loop whose iteration the calling thread is running, if any.
+   */
+  static loop*& current_loop() {
+    static thread_local loop* l = nullptr;
+    return l;
+  }
+
+  /*
+   * Index of the calling worker, or -1 if the caller is not a worker
+   * of this pool.
+   */
+  int self_index() const {
+    return current_pool() == this ? current_index() : -1;
+  }
+
+  worker_state& current_state() {
+    int self = self_index();
+    return *states_[self >= 0 ? self : num_threads()];
+  }
+
+  void push(queued_task task, int self) {
+    int q = self >= 0 ? self : next_queue_++ % num_threads();
+    {
+      std::lock_guard<std::mutex> lock(states_[q]->mutex);
+      states_[q]->tasks.push_back(std::move(task));
+    }
+    int depth = ++pending_;
+    ++num_submits_;
+    queue_depth_sum_ += depth;
+    int max = max_queue_depth_;
+    while (depth > max && !max_queue_depth_.compare_exchange_weak(max, depth)) {
+    }
+    { std::lock_guard<std::mutex> lock(wake_mutex_); }
+    wake_.notify_one();
+  }
+
+  /*
+   * Take the newest task of the worker's own queue, or else steal the
+   * oldest task of another queue. If a loop is specified, only tasks
+   * of that loop or of loops nested in it are taken.
+   */
+  bool try_pop(int self, std::function<void()>& task,
+               const loop* within = nullptr) {
+    if (pending_ == 0)
+      return false;
+    int n = num_threads();
+    for (int k = 0; k < n; ++k) {
+      int q = self >= 0 ? (self + k) % n : k;
+      std::lock_guard<std::mutex> lock(states_[q]->mutex);
+      std::deque<queued_task>& tasks = states_[q]->tasks;
+      if (tasks.empty())
+        continue;
+      auto matches = [within](const queued_task& t) {
+        return within == nullptr || t.owner->within(within);
+      };
+      std::deque<queued_task>::iterator it;
+      if (q == self) {
+        auto rit = std::find_if(tasks.rbegin(), tasks.rend(), matches);
+        if (rit == tasks.rend())
+          continue;
+        it = std::next(rit).base();
+      } else {
+        it = std::find_if(tasks.begin(), tasks.end(), matches);
+        if (it == tasks.end())
+          continue;
+        if (self >= 0)
+          ++states_[self]->num_steals;
+      }
+      task = std::move(it->run);
+      tasks.erase(it);
+      --pending_;
+      return true;
+    }
+    return false;
+  }
+
+  void work(int index) {
+    current_pool() = this;
+    current_index() = index;
+#ifdef __linux__
+    if (!options_.cpus.empty()) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(options_.cpus[index % options_.cpus.size()], &cpus);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+#ifdef STAN_THREADS
+    std::unique_ptr<stan::math::ChainableStack> thread_tape;
+    if (options_.autodiff)
+      thread_tape.reset(new stan::math::ChainableStack());
+#endif
+    while (true) {
+      std::function<void()> task;
+      if (try_pop(index, task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_.wait(lock, [this]() { return stopping_ || pending_ > 0; });
+      if (stopping_ && pending_ == 0)
+        return;
+    }
+  }
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
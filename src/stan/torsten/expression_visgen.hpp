@@ -1,6 +1,45 @@
 #ifndef STAN_LANG_TORSTEN_GENERATOR_EXPRESSION_VISGEN_HPP
 #define STAN_LANG_TORSTEN_GENERATOR_EXPRESSION_VISGEN_HPP
 
+/*
+ * Generate a real-valued event argument of a Torsten event
+ * solver. Arguments found to be data-only during semantic
+ * validation are passed through @c stan::model::pmx_value_of so
+ * that they reach the solver as @c double, at every level of
+ * nested arrays, even when the enclosing expression is promoted
+ * to @c local_scalar_t__ (e.g. array expressions in function
+ * bodies), letting the solver overloads keep them out of the
+ * sensitivity system.
+ */
+void generate_pmx_event_arg(const expression& e, bool is_var) const {
+  if (is_var) {
+    generate_expression(e, NOT_USER_FACING, o_);
+  } else {
+    o_ << "stan::model::pmx_value_of(";
+    generate_expression(e, NOT_USER_FACING, o_);
+    o_ << ")";
+  }
+}
+
+/*
+ * Open a call to a Torsten event solver through
+ * @c stan::model::cached_solve, which reuses double-valued
+ * solutions for identical inputs when the model is compiled with
+ * @c TORSTEN_SOLUTION_CACHE and the call site is enabled in the
+ * cache; otherwise it calls the solver directly. The system functor
+ * type identifies the model in the cache key. The solver arguments
+ * follow, and the caller closes the call.
+ */
+void generate_cached_solve_open(const std::string& solver,
+                                const std::string& system,
+                                bool collective) const {
+  o_ << "stan::model::cached_solve<" << system << "_functor__>(\""
+     << solver << '(' << system << ")\", "
+     << (collective ? "true" : "false") << ", "
+     << "[&](const auto&... pmx_args__) { return "
+     << solver << '(' << system << "_functor__(), pmx_args__..., pstream__); }, ";
+}
+
 void operator()(const univariate_integral_control& fx) const {
   o_ << fx.integration_function_name_
      << '('
@@ -19,24 +58,22 @@ void operator()(const univariate_integral_control& fx) const {
 }
 
 void operator()(const generalOdeModel_control& fx) const {
-  o_ << fx.integration_function_name_
-     << '('
-     << fx.system_function_name_
-     << "_functor__(), ";
+  generate_cached_solve_open(fx.integration_function_name_,
+                             fx.system_function_name_, false);
 
   generate_expression(fx.nCmt_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.time_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.time_, fx.var_args_.time_);
   o_ << ", ";
 
-  generate_expression(fx.amt_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.amt_, fx.var_args_.amt_);
   o_ << ", ";
 
-  generate_expression(fx.rate_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.rate_, fx.var_args_.rate_);
   o_ << ", ";
 
-  generate_expression(fx.ii_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.ii_, fx.var_args_.ii_);
   o_ << ", ";
 
   generate_expression(fx.evid_, NOT_USER_FACING, o_);
@@ -51,13 +88,13 @@ void operator()(const generalOdeModel_control& fx) const {
   generate_expression(fx.ss_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.pMatrix_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.pMatrix_, fx.var_args_.pMatrix_);
   o_ << ", ";
 
-  generate_expression(fx.biovar_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.biovar_, fx.var_args_.biovar_);
   o_ << ", ";
 
-  generate_expression(fx.tlag_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.tlag_, fx.var_args_.tlag_);
   o_ << ", ";
 
   generate_expression(fx.rel_tol_, NOT_USER_FACING, o_);
@@ -68,30 +105,26 @@ void operator()(const generalOdeModel_control& fx) const {
 
   generate_expression(fx.max_num_steps_, NOT_USER_FACING, o_);
 
-  o_ << ", pstream__";
-
   o_ << ")";
 }
 
 void operator()(const generalOdeModel_control_ss& fx) const {
-  o_ << fx.integration_function_name_
-     << '('
-     << fx.system_function_name_
-     << "_functor__(), ";
+  generate_cached_solve_open(fx.integration_function_name_,
+                             fx.system_function_name_, false);
 
   generate_expression(fx.nCmt_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.time_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.time_, fx.var_args_.time_);
   o_ << ", ";
 
-  generate_expression(fx.amt_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.amt_, fx.var_args_.amt_);
   o_ << ", ";
 
-  generate_expression(fx.rate_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.rate_, fx.var_args_.rate_);
   o_ << ", ";
 
-  generate_expression(fx.ii_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.ii_, fx.var_args_.ii_);
   o_ << ", ";
 
   generate_expression(fx.evid_, NOT_USER_FACING, o_);
@@ -106,13 +139,13 @@ void operator()(const generalOdeModel_control_ss& fx) const {
   generate_expression(fx.ss_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.pMatrix_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.pMatrix_, fx.var_args_.pMatrix_);
   o_ << ", ";
 
-  generate_expression(fx.biovar_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.biovar_, fx.var_args_.biovar_);
   o_ << ", ";
 
-  generate_expression(fx.tlag_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.tlag_, fx.var_args_.tlag_);
   o_ << ", ";
 
   generate_expression(fx.rel_tol_, NOT_USER_FACING, o_);
@@ -132,29 +165,26 @@ void operator()(const generalOdeModel_control_ss& fx) const {
 
   generate_expression(fx.ss_max_num_steps_, NOT_USER_FACING, o_);
 
-  o_ << ", pstream__";
   o_ << ")";
 }
 
 void operator()(const generalOdeModel& fx) const {
-  o_ << fx.integration_function_name_
-     << '('
-     << fx.system_function_name_
-     << "_functor__(), ";
+  generate_cached_solve_open(fx.integration_function_name_,
+                             fx.system_function_name_, false);
 
   generate_expression(fx.nCmt_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.time_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.time_, fx.var_args_.time_);
   o_ << ", ";
 
-  generate_expression(fx.amt_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.amt_, fx.var_args_.amt_);
   o_ << ", ";
 
-  generate_expression(fx.rate_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.rate_, fx.var_args_.rate_);
   o_ << ", ";
 
-  generate_expression(fx.ii_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.ii_, fx.var_args_.ii_);
   o_ << ", ";
 
   generate_expression(fx.evid_, NOT_USER_FACING, o_);
@@ -169,14 +199,14 @@ void operator()(const generalOdeModel& fx) const {
   generate_expression(fx.ss_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.pMatrix_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.pMatrix_, fx.var_args_.pMatrix_);
   o_ << ", ";
 
-  generate_expression(fx.biovar_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.biovar_, fx.var_args_.biovar_);
   o_ << ", ";
 
-  generate_expression(fx.tlag_, NOT_USER_FACING, o_);
-  o_ << ", pstream__)";
+  generate_pmx_event_arg(fx.tlag_, fx.var_args_.tlag_);
+  o_ << ")";
 }
 
 void operator()(const pmx_integrate_ode& fx) const {
@@ -274,10 +304,8 @@ void operator()(const pmx_integrate_ode_group_control& fx) const {
 }
 
 void operator()(const pmx_solve_group& fx) const {
-  o_ << fx.integration_function_name_
-     << '('
-     << fx.system_function_name_
-     << "_functor__(), ";
+  generate_cached_solve_open(fx.integration_function_name_,
+                             fx.system_function_name_, true);
 
   generate_expression(fx.nCmt_, NOT_USER_FACING, o_);
   o_ << ", ";
@@ -285,16 +313,16 @@ void operator()(const pmx_solve_group& fx) const {
   generate_expression(fx.len_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.time_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.time_, fx.var_args_.time_);
   o_ << ", ";
 
-  generate_expression(fx.amt_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.amt_, fx.var_args_.amt_);
   o_ << ", ";
 
-  generate_expression(fx.rate_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.rate_, fx.var_args_.rate_);
   o_ << ", ";
 
-  generate_expression(fx.ii_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.ii_, fx.var_args_.ii_);
   o_ << ", ";
 
   generate_expression(fx.evid_, NOT_USER_FACING, o_);
@@ -309,21 +337,19 @@ void operator()(const pmx_solve_group& fx) const {
   generate_expression(fx.ss_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.pMatrix_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.pMatrix_, fx.var_args_.pMatrix_);
   o_ << ", ";
 
-  generate_expression(fx.biovar_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.biovar_, fx.var_args_.biovar_);
   o_ << ", ";
 
-  generate_expression(fx.tlag_, NOT_USER_FACING, o_);
-  o_ << ", pstream__)";
+  generate_pmx_event_arg(fx.tlag_, fx.var_args_.tlag_);
+  o_ << ")";
 }
 
 void operator()(const pmx_solve_group_control& fx) const {
-  o_ << fx.integration_function_name_
-     << '('
-     << fx.system_function_name_
-     << "_functor__(), ";
+  generate_cached_solve_open(fx.integration_function_name_,
+                             fx.system_function_name_, true);
 
   generate_expression(fx.nCmt_, NOT_USER_FACING, o_);
   o_ << ", ";
@@ -331,16 +357,16 @@ void operator()(const pmx_solve_group_control& fx) const {
   generate_expression(fx.len_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.time_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.time_, fx.var_args_.time_);
   o_ << ", ";
 
-  generate_expression(fx.amt_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.amt_, fx.var_args_.amt_);
   o_ << ", ";
 
-  generate_expression(fx.rate_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.rate_, fx.var_args_.rate_);
   o_ << ", ";
 
-  generate_expression(fx.ii_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.ii_, fx.var_args_.ii_);
   o_ << ", ";
 
   generate_expression(fx.evid_, NOT_USER_FACING, o_);
@@ -355,13 +381,13 @@ void operator()(const pmx_solve_group_control& fx) const {
   generate_expression(fx.ss_, NOT_USER_FACING, o_);
   o_ << ", ";
 
-  generate_expression(fx.pMatrix_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.pMatrix_, fx.var_args_.pMatrix_);
   o_ << ", ";
 
-  generate_expression(fx.biovar_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.biovar_, fx.var_args_.biovar_);
   o_ << ", ";
 
-  generate_expression(fx.tlag_, NOT_USER_FACING, o_);
+  generate_pmx_event_arg(fx.tlag_, fx.var_args_.tlag_);
   o_ << ", ";
 
   generate_expression(fx.rel_tol_, NOT_USER_FACING, o_);
@@ -371,7 +397,6 @@ void operator()(const pmx_solve_group_control& fx) const {
   o_ << ", ";
 
   generate_expression(fx.max_num_steps_, NOT_USER_FACING, o_);
-  o_ << ", pstream__";
   o_ << ")";
 }
 #endif
@@ -2,6 +2,7 @@
 #define STAN_LANG_AST_NODE_GENERALODEMODEL_CONTROL_SS_HPP
 
 #include <stan/lang/ast/node/expression.hpp>
+#include <stan/torsten/pmx_event_var_args.hpp>
 #include <string>
 
 namespace stan {
@@ -85,6 +86,12 @@ namespace stan {
        */
       expression tlag_;
 
+      /**
+       * Which real-valued event arguments may contain vars, set
+       * during semantic validation.
+       */
+      pmx_event_var_args var_args_;
+
       /**
        * Relative tolerance (real).
        */
@@ -0,0 +1,63 @@
+#ifndef STAN_LANG_AST_NODE_TORSTEN_PMX_EVENT_VAR_ARGS_HPP
+#define STAN_LANG_AST_NODE_TORSTEN_PMX_EVENT_VAR_ARGS_HPP
+
+namespace stan {
+  namespace lang {
+
+    /**
+     * Classification of the real-valued event arguments of a
+     * Torsten event solver call (generalOdeModel_*, pmx_solve_*,
+     * pmx_solve_group_*). A flag is true when the argument may
+     * contain an autodiff variable. Flags are set from
+     * @c has_var during semantic validation and are used by the
+     * generator to keep data-only arguments as @c double, so
+     * that only truly variable inputs enter the ODE sensitivity
+     * system. The default is the conservative "may be var".
+     */
+    struct pmx_event_var_args {
+      /**
+       * Time of events.
+       */
+      bool time_;
+
+      /**
+       * Amount at events.
+       */
+      bool amt_;
+
+      /**
+       * Rate at events.
+       */
+      bool rate_;
+
+      /**
+       * Interdose interval at events.
+       */
+      bool ii_;
+
+      /**
+       * ODE parameters.
+       */
+      bool pMatrix_;
+
+      /**
+       * Biovariability parameters.
+       */
+      bool biovar_;
+
+      /**
+       * Lag time parameters.
+       */
+      bool tlag_;
+
+      /**
+       * Construct a classification with every argument
+       * treated as possibly containing vars.
+       */
+      pmx_event_var_args()
+        : time_(true), amt_(true), rate_(true), ii_(true),
+          pMatrix_(true), biovar_(true), tlag_(true) {}
+    };
+  }
+}
+#endif
@@ -21,4 +21,20 @@
   TORSTEN_LANG_FUNCTORS_EXPRESSION_LIST
 #undef TORSTEN_FUNC_EXPR
 
+// record which real-valued event arguments of a Torsten event
+// solver may contain vars, so data-only ones are generated as double
+// called from: term_grammar
+struct set_pmx_event_var_args : public phoenix_functor_binary {
+  void operator()(generalOdeModel& func, const variable_map& var_map) const;
+  void operator()(generalOdeModel_control& func,
+                  const variable_map& var_map) const;
+  void operator()(generalOdeModel_control_ss& func,
+                  const variable_map& var_map) const;
+  void operator()(pmx_solve_group& func, const variable_map& var_map) const;
+  void operator()(pmx_solve_group_control& func,
+                  const variable_map& var_map) const;
+};
+extern boost::phoenix::function<set_pmx_event_var_args>
+set_pmx_event_var_args_f;
+
 #endif
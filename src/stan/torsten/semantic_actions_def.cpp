@@ -1119,6 +1119,48 @@ template void assign_lhs::operator()(expression &, const pmx_integrate_ode_contr
       pmx_integrate_ode_group::CALLED_FUNCTORS.push_back(ode_fun.system_function_name_);
     }
 
+/*****************
+ event solver argument classification
+*****************/
+
+template <class T>
+void set_pmx_event_var_args_impl(T& ode_fun, const variable_map& var_map) {
+  ode_fun.var_args_.time_ = has_var(ode_fun.time_, var_map);
+  ode_fun.var_args_.amt_ = has_var(ode_fun.amt_, var_map);
+  ode_fun.var_args_.rate_ = has_var(ode_fun.rate_, var_map);
+  ode_fun.var_args_.ii_ = has_var(ode_fun.ii_, var_map);
+  ode_fun.var_args_.pMatrix_ = has_var(ode_fun.pMatrix_, var_map);
+  ode_fun.var_args_.biovar_ = has_var(ode_fun.biovar_, var_map);
+  ode_fun.var_args_.tlag_ = has_var(ode_fun.tlag_, var_map);
+}
+
+void set_pmx_event_var_args::operator()(generalOdeModel& ode_fun,
+                                        const variable_map& var_map) const {
+  set_pmx_event_var_args_impl(ode_fun, var_map);
+}
+
+void set_pmx_event_var_args::operator()(generalOdeModel_control& ode_fun,
+                                        const variable_map& var_map) const {
+  set_pmx_event_var_args_impl(ode_fun, var_map);
+}
+
+void set_pmx_event_var_args::operator()(generalOdeModel_control_ss& ode_fun,
+                                        const variable_map& var_map) const {
+  set_pmx_event_var_args_impl(ode_fun, var_map);
+}
+
+void set_pmx_event_var_args::operator()(pmx_solve_group& ode_fun,
+                                        const variable_map& var_map) const {
+  set_pmx_event_var_args_impl(ode_fun, var_map);
+}
+
+void set_pmx_event_var_args::operator()(pmx_solve_group_control& ode_fun,
+                                        const variable_map& var_map) const {
+  set_pmx_event_var_args_impl(ode_fun, var_map);
+}
+boost::phoenix::function<set_pmx_event_var_args>
+set_pmx_event_var_args_f;
+
 /*****************
  generalOdeModel_control
 *****************/
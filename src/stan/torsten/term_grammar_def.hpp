@@ -84,7 +84,8 @@ generalOdeModel_control_ss_r
   > lit(')')
   [validate_generalOdeModel_control_ss_f(_val,
                                       boost::phoenix::ref(var_map_), _pass,
-                                      boost::phoenix::ref(error_msgs_))];
+                                      boost::phoenix::ref(error_msgs_)),
+   set_pmx_event_var_args_f(_val, boost::phoenix::ref(var_map_))];
 
 generalOdeModel_control_r.name("expression");
 generalOdeModel_control_r
@@ -139,7 +140,8 @@ generalOdeModel_control_r
   > lit(')')
   [validate_generalOdeModel_control_f(_val,
                                       boost::phoenix::ref(var_map_), _pass,
-                                      boost::phoenix::ref(error_msgs_))];
+                                      boost::phoenix::ref(error_msgs_)),
+   set_pmx_event_var_args_f(_val, boost::phoenix::ref(var_map_))];
 
 generalOdeModel_r.name("expression");
 generalOdeModel_r
@@ -188,7 +190,8 @@ generalOdeModel_r
   > lit(')')
   [validate_generalOdeModel_f(_val,
                               boost::phoenix::ref(var_map_), _pass,
-                              boost::phoenix::ref(error_msgs_))];
+                              boost::phoenix::ref(error_msgs_)),
+   set_pmx_event_var_args_f(_val, boost::phoenix::ref(var_map_))];
 
 pmx_solve_group_control_r.name("expression");
 pmx_solve_group_control_r
@@ -233,7 +236,8 @@ pmx_solve_group_control_r
   > lit(')')
   [validate_pmx_solve_group_control_f(_val,
                                       boost::phoenix::ref(var_map_), _pass,
-                                      boost::phoenix::ref(error_msgs_))];
+                                      boost::phoenix::ref(error_msgs_)),
+   set_pmx_event_var_args_f(_val, boost::phoenix::ref(var_map_))];
 
 pmx_solve_group_r.name("expression");
 pmx_solve_group_r
@@ -276,7 +280,8 @@ pmx_solve_group_r
   > lit(')')
   [validate_pmx_solve_group_f(_val,
                               boost::phoenix::ref(var_map_), _pass,
-                              boost::phoenix::ref(error_msgs_))];
+                              boost::phoenix::ref(error_msgs_)),
+   set_pmx_event_var_args_f(_val, boost::phoenix::ref(var_map_))];
 
 pmx_integrate_ode_group_control_r.name("expression");
 pmx_integrate_ode_group_control_r
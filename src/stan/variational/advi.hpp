@@ -7,6 +7,7 @@
 #include <stan/callbacks/stream_writer.hpp>
 #include <stan/io/dump.hpp>
 #include <stan/services/error_codes.hpp>
+#include <stan/variational/minibatch.hpp>
 #include <stan/variational/print_progress.hpp>
 #include <stan/variational/families/normal_fullrank.hpp>
 #include <stan/variational/families/normal_meanfield.hpp>
@@ -32,6 +33,12 @@ namespace variational {
  * ascent to maximize the Evidence Lower Bound for a given model
  * and variational family.
  *
+ * <p>For models that provide a minibatch hook (see
+ * <code>has_minibatch</code>), <code>set_minibatch</code> makes each
+ * gradient an unbiased estimate from a random minibatch of the
+ * observations, so that an iteration costs a fraction of a full-data
+ * log density evaluation.
+ *
  * @tparam Model class of model
  * @tparam Q class of variational distribution
  * @tparam BaseRNG class of random number generator
@@ -91,9 +98,35 @@ class advi {
    * that the variational distribution has somehow collapsed.
    */
   double calc_ELBO(const Q& variational, callbacks::logger& logger) const {
+    double elbo_se;
+    return calc_ELBO(variational, logger, elbo_se);
+  }
+
+  /**
+   * Calculates the Evidence Lower BOund (ELBO) and the Monte Carlo
+   * standard error of the estimate. With minibatches, the ELBO is
+   * evaluated on a fixed evaluation minibatch, so that successive
+   * estimates are comparable.
+   *
+   * @param[in] variational variational approximation at which to evaluate
+   * the ELBO.
+   * @param logger logger for messages
+   * @param[out] elbo_se Monte Carlo standard error of the ELBO.
+   * @return the evidence lower bound.
+   * @throw std::domain_error If, after n_monte_carlo_elbo_ number of draws
+   * from the variational distribution all give non-finite log joint
+   * evaluations.
+   */
+  double calc_ELBO(const Q& variational, callbacks::logger& logger,
+                   double& elbo_se) const {
     static const char* function = "stan::variational::advi::calc_ELBO";
 
+    if (minibatch_.enabled())
+      stan::variational::set_minibatch(model_, eval_batch_,
+                                       minibatch_.weight());
+
     double elbo = 0.0;
+    double elbo_squares = 0.0;
     int dim = variational.dimension();
     Eigen::VectorXd zeta(dim);
 
@@ -107,6 +140,7 @@ class advi {
           logger.info(ss);
         stan::math::check_finite(function, "log_prob", log_prob);
         elbo += log_prob;
+        elbo_squares += log_prob * log_prob;
         ++i;
       } catch (const std::domain_error& e) {
         ++n_dropped_evaluations;
@@ -122,6 +156,9 @@ class advi {
       }
     }
     elbo /= n_monte_carlo_elbo_;
+    elbo_se = std::sqrt(
+        std::max(0.0, elbo_squares / n_monte_carlo_elbo_ - elbo * elbo)
+        / n_monte_carlo_elbo_);
     elbo += variational.entropy();
     return elbo;
   }
@@ -146,10 +183,38 @@ class advi {
         function, "Dimension of variational q", variational.dimension(),
         "Dimension of variables in model", cont_params_.size());
 
+    if (minibatch_.enabled())
+      stan::variational::set_minibatch(model_, minibatch_.next(rng_),
+                                       minibatch_.weight());
+
     variational.calc_grad(elbo_grad, model_, cont_params_, n_monte_carlo_grad_,
                           rng_, logger);
   }
 
+  /**
+   * Estimate each ELBO gradient from a random minibatch of the
+   * observations instead of all of them, through the model's
+   * minibatch hook. The ELBO used for convergence checks is evaluated
+   * on a fixed minibatch of the same size, and convergence is also
+   * declared when the ELBO shows no significant upward trend over
+   * the convergence window, since the minibatch noise may keep the
+   * relative ELBO changes above the tolerance. The full data are
+   * restored before the approximate posterior is written.
+   *
+   * @param[in] num_observations number of observations N
+   * @param[in] minibatch_size number of observations per minibatch
+   * @throw std::domain_error if the model has no minibatch hook, N is
+   * not positive or the minibatch size is not in <code>[1, N]</code>
+   */
+  void set_minibatch(int num_observations, int minibatch_size) {
+    static const char* function = "stan::variational::advi::set_minibatch";
+    if (!has_minibatch<Model>::value)
+      stan::math::throw_domain_error(function, "Model", "",
+                                     "does not provide a minibatch hook", "");
+    minibatch_ = minibatch_schedule(num_observations, minibatch_size);
+    eval_batch_ = minibatch_.next(rng_);
+  }
+
   /**
    * Heuristic grid search to adapt eta to the scale of the problem.
    *
@@ -226,16 +291,14 @@ class advi {
         }
 
         // Update step-size
-        if (iter_tune == 1) {
-          history_grad_squared += elbo_grad.square();
-        } else {
-          history_grad_squared = pre_factor * history_grad_squared
-                                 + post_factor * elbo_grad.square();
-        }
         eta_scaled = eta / sqrt(static_cast<double>(iter_tune));
-        // Stochastic gradient update
-        variational
-            += eta_scaled * elbo_grad / (tau + history_grad_squared.sqrt());
+        // Stochastic gradient update, fused with the step-size update
+        if (iter_tune == 1)
+          variational.adagrad_update(elbo_grad, history_grad_squared,
+                                     eta_scaled, tau, 1.0, 1.0);
+        else
+          variational.adagrad_update(elbo_grad, history_grad_squared,
+                                     eta_scaled, tau, pre_factor, post_factor);
       }
 
       // (ROBUST) Compute ELBO. It's OK if it has diverged.
@@ -338,6 +401,7 @@ class advi {
     int cb_size
         = static_cast<int>(std::max(0.1 * max_iterations / eval_elbo_, 2.0));
     boost::circular_buffer<double> elbo_diff(cb_size);
+    boost::circular_buffer<double> elbo_window(std::max(cb_size, 5));
 
     logger.info("Begin stochastic gradient ascent.");
     logger.info(
@@ -357,22 +421,22 @@ class advi {
       calc_ELBO_grad(variational, elbo_grad, logger);
 
       // Update step-size
-      if (iter_counter == 1) {
-        history_grad_squared += elbo_grad.square();
-      } else {
-        history_grad_squared = pre_factor * history_grad_squared
-                               + post_factor * elbo_grad.square();
-      }
       eta_scaled = eta / sqrt(static_cast<double>(iter_counter));
 
-      // Stochastic gradient update
-      variational
-          += eta_scaled * elbo_grad / (tau + history_grad_squared.sqrt());
+      // Stochastic gradient update, fused with the step-size update
+      if (iter_counter == 1)
+        variational.adagrad_update(elbo_grad, history_grad_squared, eta_scaled,
+                                   tau, 1.0, 1.0);
+      else
+        variational.adagrad_update(elbo_grad, history_grad_squared, eta_scaled,
+                                   tau, pre_factor, post_factor);
 
       // Check for convergence every "eval_elbo_"th iteration
       if (iter_counter % eval_elbo_ == 0) {
         elbo_prev = elbo;
-        elbo = calc_ELBO(variational, logger);
+        double elbo_se;
+        elbo = calc_ELBO(variational, logger, elbo_se);
+        elbo_window.push_back(elbo);
         if (elbo > elbo_best)
           elbo_best = elbo;
         delta_elbo = rel_difference(elbo, elbo_prev);
@@ -409,6 +473,14 @@ class advi {
           do_more_iterations = false;
         }
 
+        if (minibatch_.enabled()) {
+          ss << "   (ELBO se " << std::setprecision(3) << elbo_se << ")";
+          if (elbo_window.full() && !elbo_trend_increasing(elbo_window)) {
+            ss << "   ELBO TREND CONVERGED";
+            do_more_iterations = false;
+          }
+        }
+
         if (iter_counter > 10 * eval_elbo_) {
           if (delta_elbo_med > 0.5 || delta_elbo_ave > 0.5) {
             ss << "   MAY BE DIVERGING... INSPECT ELBO";
@@ -475,6 +547,9 @@ class advi {
     stochastic_gradient_ascent(variational, eta, tol_rel_obj, max_iterations,
                                logger, diagnostic_writer);
 
+    if (minibatch_.enabled())
+      stan::variational::set_minibatch(model_, minibatch_.all(), 1.0);
+
     // Write posterior mean of variational approximations.
     cont_params_ = variational.mean();
     std::vector<double> cont_vector(cont_params_.size());
@@ -554,6 +629,34 @@ class advi {
     return std::fabs((curr - prev) / prev);
   }
 
+  /**
+   * Test whether a sequence of ELBO values increases significantly,
+   * i.e. whether the least squares slope of the values against their
+   * position is more than two standard errors above zero.
+   *
+   * @param[in] cb circular buffer with at least three values in it.
+   * @return true if the ELBO is still increasing.
+   */
+  bool elbo_trend_increasing(const boost::circular_buffer<double>& cb) const {
+    int n = cb.size();
+    double x_mean = 0.5 * (n - 1);
+    double y_mean = std::accumulate(cb.begin(), cb.end(), 0.0) / n;
+    double s_xx = 0;
+    double s_xy = 0;
+    for (int i = 0; i < n; ++i) {
+      s_xx += (i - x_mean) * (i - x_mean);
+      s_xy += (i - x_mean) * (cb[i] - y_mean);
+    }
+    double slope = s_xy / s_xx;
+    double ss_residual = 0;
+    for (int i = 0; i < n; ++i) {
+      double r = cb[i] - y_mean - slope * (i - x_mean);
+      ss_residual += r * r;
+    }
+    double slope_se = std::sqrt(ss_residual / (n - 2) / s_xx);
+    return slope > 2 * slope_se;
+  }
+
  protected:
   Model& model_;
   Eigen::VectorXd& cont_params_;
@@ -562,6 +665,8 @@ class advi {
   int n_monte_carlo_elbo_;
   int eval_elbo_;
   int n_posterior_samples_;
+  mutable minibatch_schedule minibatch_;
+  std::vector<int> eval_batch_;
 };
 }  // namespace variational
 }  // namespace stan
@@ -84,7 +84,45 @@ class base_family {
                  int n_monte_carlo_grad, BaseRNG& rng,
                  callbacks::logger& logger) const;
 
+  /**
+   * Apply one adaGrad step to this approximation in place, updating
+   * the running average of squared gradients first:
+   *
+   * <p>history = pre_factor * history + post_factor * grad^2
+   * <br>this += eta * grad / (tau + sqrt(history))
+   *
+   * <p>All operations are coefficient-wise and fused into a single
+   * pass without temporaries. Derived families implement it for their
+   * own type.
+   *
+   * @param[in] grad Gradient of the ELBO.
+   * @param[in,out] history Running average of squared gradients.
+   * @param[in] eta Step size.
+   * @param[in] tau Offset of the denominator.
+   * @param[in] pre_factor Weight of the previous history.
+   * @param[in] post_factor Weight of the squared gradient.
+   */
+  void adagrad_update(const base_family& grad, base_family& history,
+                      double eta, double tau, double pre_factor,
+                      double post_factor);
+
  protected:
+  /**
+   * Apply one fused adaGrad step to a block of coefficients of a
+   * family; see <code>adagrad_update</code>.
+   *
+   * @tparam T_param Type of writable array expression of parameters.
+   * @tparam T_grad Type of array expression of gradients.
+   * @tparam T_history Type of writable array expression of history.
+   */
+  template <typename T_param, typename T_grad, typename T_history>
+  static void adagrad_step(T_param&& param, const T_grad& grad,
+                           T_history&& history, double eta, double tau,
+                           double pre_factor, double post_factor) {
+    history = pre_factor * history + post_factor * grad.square();
+    param += eta * grad / (tau + history.sqrt());
+  }
+
   void write_error_msg_(std::ostream* error_msgs,
                         const std::exception& e) const {
     if (!error_msgs) {
@@ -299,6 +299,44 @@ class normal_fullrank : public base_family {
     return *this;
   }
 
+  /**
+   * Apply one adaGrad step to this approximation in place; see
+   * <code>base_family::adagrad_update</code>. Only the lower
+   * triangle of the Cholesky factor is visited, since the upper
+   * triangles of the approximation, gradient and history are zero
+   * and stay zero.
+   *
+   * @param[in] grad Gradient of the ELBO.
+   * @param[in,out] history Running average of squared gradients.
+   * @param[in] eta Step size.
+   * @param[in] tau Offset of the denominator.
+   * @param[in] pre_factor Weight of the previous history.
+   * @param[in] post_factor Weight of the squared gradient.
+   * @throw std::domain_error If the dimensionality of the gradient
+   * or history does not match this approximation's dimensionality.
+   */
+  void adagrad_update(const normal_fullrank& grad, normal_fullrank& history,
+                      double eta, double tau, double pre_factor,
+                      double post_factor) {
+    static const char* function
+        = "stan::variational::normal_fullrank::adagrad_update";
+    stan::math::check_size_match(function, "Dimension of approximation",
+                                 dimension(), "Dimension of gradient",
+                                 grad.dimension());
+    stan::math::check_size_match(function, "Dimension of approximation",
+                                 dimension(), "Dimension of history",
+                                 history.dimension());
+    adagrad_step(mu_.array(), grad.mu_.array(), history.mu_.array(), eta, tau,
+                 pre_factor, post_factor);
+    for (int j = 0; j < dimension(); ++j) {
+      int n = dimension() - j;
+      adagrad_step(L_chol_.col(j).tail(n).array(),
+                   grad.L_chol_.col(j).tail(n).array(),
+                   history.L_chol_.col(j).tail(n).array(), eta, tau,
+                   pre_factor, post_factor);
+    }
+  }
+
   /**
    * Returns the mean vector for this approximation.
    *
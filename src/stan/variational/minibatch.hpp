@@ -0,0 +1,164 @@
+#ifndef STAN_VARIATIONAL_MINIBATCH_HPP
+#define STAN_VARIATIONAL_MINIBATCH_HPP
+
+#include <stan/math/prim.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace variational {
+
+/**
+ * Trait that is true if a model provides the minibatch hook
+ * <code>void set_minibatch(const std::vector<int>& indices,
+ * double weight)</code>.
+ *
+ * <p>After a call to the hook, the model's log density must be the
+ * log prior plus <code>weight</code> times the sum of the log
+ * likelihood terms of the observations with the given (1-based)
+ * indices, e.g. by holding the indices in a designated data index
+ * array that the likelihood loops over. With all observations and a
+ * weight of 1 it must be the full-data log density.
+ *
+ * @tparam Model class of model
+ */
+template <class Model, typename = void>
+struct has_minibatch : std::false_type {};
+
+template <class Model>
+struct has_minibatch<
+    Model, decltype(std::declval<Model&>().set_minibatch(
+                        std::declval<const std::vector<int>&>(), 1.0),
+                    void())> : std::true_type {};
+
+namespace internal {
+
+template <class Model>
+inline void set_minibatch(Model& model, const std::vector<int>& indices,
+                          double weight, std::true_type) {
+  model.set_minibatch(indices, weight);
+}
+
+template <class Model>
+inline void set_minibatch(Model& model, const std::vector<int>& indices,
+                          double weight, std::false_type) {
+  throw std::domain_error("The model does not provide a minibatch hook.");
+}
+
+}  // namespace internal
+
+/**
+ * Restrict the likelihood of the model to the specified observations.
+ *
+ * @tparam Model class of model
+ * @param[in,out] model model
+ * @param[in] indices 1-based indices of the observations
+ * @param[in] weight scaling of the log likelihood
+ * @throw std::domain_error if the model does not provide a minibatch
+ * hook
+ */
+template <class Model>
+inline void set_minibatch(Model& model, const std::vector<int>& indices,
+                          double weight) {
+  internal::set_minibatch(model, indices, weight, has_minibatch<Model>());
+}
+
+/**
+ * Schedule of minibatches of observations for stochastic variational
+ * inference. Each epoch visits the observations in a new random order
+ * in consecutive batches of fixed size, so every batch is a uniformly
+ * random subset of the observations and, with the weight
+ * <code>N / B</code>, the minibatch log likelihood is an unbiased
+ * estimate of the full-data log likelihood.
+ */
+class minibatch_schedule {
+ public:
+  /**
+   * Construct a disabled schedule.
+   */
+  minibatch_schedule() : num_observations_(0), batch_size_(0), next_(0) {}
+
+  /**
+   * Construct a schedule of minibatches of the specified size.
+   *
+   * @param[in] num_observations number of observations N
+   * @param[in] batch_size number of observations per batch B
+   * @throw std::domain_error if N is not positive or B is not in
+   * <code>[1, N]</code>
+   */
+  minibatch_schedule(int num_observations, int batch_size)
+      : num_observations_(num_observations),
+        batch_size_(batch_size),
+        order_(num_observations),
+        batch_(batch_size),
+        next_(num_observations) {
+    static const char* function = "stan::variational::minibatch_schedule";
+    math::check_positive(function, "Number of observations",
+                         num_observations);
+    math::check_bounded(function, "Minibatch size", batch_size, 1,
+                        num_observations);
+    for (int n = 0; n < num_observations; ++n)
+      order_[n] = n + 1;
+  }
+
+  bool enabled() const { return batch_size_ > 0; }
+
+  int num_observations() const { return num_observations_; }
+
+  int batch_size() const { return batch_size_; }
+
+  /**
+   * Return the scaling of the minibatch log likelihood,
+   * <code>N / B</code>.
+   */
+  double weight() const {
+    return static_cast<double>(num_observations_) / batch_size_;
+  }
+
+  /**
+   * Return the 1-based indices of the next minibatch, starting a
+   * new epoch with a fresh random order when fewer than
+   * <code>B</code> observations are left in the current one.
+   *
+   * @tparam BaseRNG class of random number generator
+   * @param[in,out] rng random number generator
+   */
+  template <class BaseRNG>
+  const std::vector<int>& next(BaseRNG& rng) {
+    if (next_ + batch_size_ > num_observations_) {
+      for (int n = num_observations_ - 1; n > 0; --n) {
+        boost::random::uniform_int_distribution<int> unif(0, n);
+        std::swap(order_[n], order_[unif(rng)]);
+      }
+      next_ = 0;
+    }
+    std::copy(order_.begin() + next_, order_.begin() + next_ + batch_size_,
+              batch_.begin());
+    next_ += batch_size_;
+    return batch_;
+  }
+
+  /**
+   * Return the 1-based indices of all observations.
+   */
+  std::vector<int> all() const {
+    std::vector<int> indices(num_observations_);
+    for (int n = 0; n < num_observations_; ++n)
+      indices[n] = n + 1;
+    return indices;
+  }
+
+ private:
+  int num_observations_;
+  int batch_size_;
+  std::vector<int> order_;
+  std::vector<int> batch_;
+  int next_;
+};
+
+}  // namespace variational
+}  // namespace stan
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Performance test: csv output of draws.
+ *
+ * This test writes rows of 10, 100 and 1000 doubles to a string
+ * stream, once by streaming each value with <code>operator<<</code>
+ * as <code>stream_writer</code> used to, and once through
+ * <code>stream_writer</code>, which formats each row into a reusable
+ * buffer. For each row length the throughput of both versions in
+ * values per second and the speedup are printed at the default
+ * precision of 6 digits and at 17 digits, and both outputs are
+ * checked to be byte-identical. The throughput of the shortest
+ * round-trip format is printed as well.
+ */
+
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_writer.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+void stream_row(std::ostream& output, const std::vector<double>& v) {
+  for (size_t n = 0; n + 1 < v.size(); ++n)
+    output << v[n] << ",";
+  output << v.back() << std::endl;
+}
+
+template <class Write>
+double time_rows(Write write, const std::vector<std::vector<double> >& rows,
+                 std::stringstream& output) {
+  auto start = std::chrono::steady_clock::now();
+  for (const std::vector<double>& row : rows)
+    write(output, row);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double> >(end
+                                                                    - start)
+      .count();
+}
+
+}  // namespace
+
+TEST(stream_writer, throughput) {
+  boost::ecuyer1988 rng(1234);
+  boost::random::normal_distribution<double> normal(0, 100);
+
+  for (int d : {10, 100, 1000}) {
+    std::vector<std::vector<double> > rows(1000000 / d,
+                                           std::vector<double>(d));
+    for (std::vector<double>& row : rows)
+      for (double& x : row)
+        x = normal(rng);
+    double num_values = static_cast<double>(rows.size()) * d;
+
+    for (int precision : {6, 17}) {
+      std::stringstream ss_stream, ss_writer;
+      ss_stream << std::setprecision(precision);
+      ss_writer << std::setprecision(precision);
+      stan::callbacks::stream_writer writer(ss_writer);
+
+      double t_stream = time_rows(stream_row, rows, ss_stream);
+      double t_writer = time_rows(
+          [&writer](std::ostream&, const std::vector<double>& row) {
+            writer(row);
+          },
+          rows, ss_writer);
+      std::cout << "d = " << std::setw(4) << d << "  precision "
+                << std::setw(2) << precision
+                << "  operator<<: " << std::scientific
+                << std::setprecision(3) << num_values / t_stream
+                << " values/s  stream_writer: " << num_values / t_writer
+                << " values/s  speedup: " << std::fixed
+                << std::setprecision(2) << t_stream / t_writer << std::endl;
+      EXPECT_TRUE(ss_stream.str() == ss_writer.str());
+    }
+
+    std::stringstream ss_shortest;
+    stan::callbacks::stream_writer writer_shortest(
+        ss_shortest, "", stan::callbacks::csv_formatter::shortest_round_trip);
+    double t_shortest = time_rows(
+        [&writer_shortest](std::ostream&, const std::vector<double>& row) {
+          writer_shortest(row);
+        },
+        rows, ss_shortest);
+    std::cout << "d = " << std::setw(4) << d
+              << "  shortest round trip: " << std::scientific
+              << std::setprecision(3) << num_values / t_shortest
+              << " values/s" << std::endl;
+  }
+}
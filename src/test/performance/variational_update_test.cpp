@@ -0,0 +1,138 @@
+/**
+ * Performance test: ADVI parameter update.
+ *
+ * This test times one adaGrad step of the variational families at
+ * dimensions 1000, 2000 and 5000, once through the overloaded family
+ * operators, where every operation returns a new family object, and
+ * once through the fused, in-place <code>adagrad_update</code> used by
+ * ADVI, which makes no allocation. For each family and dimension the
+ * average time per iteration of both versions and the speedup are
+ * printed, and both versions are checked to give identical results.
+ *
+ * The full-rank family at dimension 5000 holds 200 MB per Cholesky
+ * factor, so the operator version needs a few GB of memory. It is
+ * only timed when the environment variable STAN_PERF_LARGE is set;
+ * by default the full-rank family stops at dimension 2000.
+ */
+
+#include <gtest/gtest.h>
+#include <stan/variational/families/normal_fullrank.hpp>
+#include <stan/variational/families/normal_meanfield.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double tau = 1.0;
+const double pre_factor = 0.9;
+const double post_factor = 0.1;
+
+template <class Q>
+void operator_update(Q& variational, const Q& elbo_grad,
+                     Q& history_grad_squared, double eta_scaled, int iter) {
+  if (iter == 1) {
+    history_grad_squared += elbo_grad.square();
+  } else {
+    history_grad_squared = pre_factor * history_grad_squared
+                           + post_factor * elbo_grad.square();
+  }
+  variational += eta_scaled * elbo_grad / (tau + history_grad_squared.sqrt());
+}
+
+template <class Q>
+void fused_update(Q& variational, const Q& elbo_grad, Q& history_grad_squared,
+                  double eta_scaled, int iter) {
+  if (iter == 1)
+    variational.adagrad_update(elbo_grad, history_grad_squared, eta_scaled,
+                               tau, 1.0, 1.0);
+  else
+    variational.adagrad_update(elbo_grad, history_grad_squared, eta_scaled,
+                               tau, pre_factor, post_factor);
+}
+
+template <class Q, class Update>
+double time_update(Update update, Q& variational, const Q& elbo_grad,
+                   Q& history_grad_squared, int num_iterations) {
+  auto start = std::chrono::steady_clock::now();
+  for (int iter = 1; iter <= num_iterations; ++iter)
+    update(variational, elbo_grad, history_grad_squared,
+           0.1 / std::sqrt(static_cast<double>(iter)), iter);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(end - start)
+             .count()
+         / num_iterations;
+}
+
+void report(const std::string& family, int d, double t_operator,
+            double t_fused) {
+  std::cout << std::setw(10) << family << "  d = " << std::setw(5) << d
+            << "  operators: " << std::scientific << std::setprecision(3)
+            << t_operator << " s/iter"
+            << "  fused: " << t_fused << " s/iter"
+            << "  speedup: " << std::fixed << std::setprecision(2)
+            << t_operator / t_fused << std::endl;
+}
+
+/*
+ * dimensions of the full-rank family, 5000 only with STAN_PERF_LARGE.
+ */
+std::vector<int> fullrank_dims() {
+  std::vector<int> dims{1000, 2000};
+  if (std::getenv("STAN_PERF_LARGE") != 0)
+    dims.push_back(5000);
+  return dims;
+}
+
+}  // namespace
+
+TEST(advi_update, normal_meanfield) {
+  using stan::variational::normal_meanfield;
+  for (int d : {1000, 2000, 5000}) {
+    normal_meanfield grad(Eigen::VectorXd::Random(d),
+                          Eigen::VectorXd::Random(d));
+    normal_meanfield q_operator(Eigen::VectorXd::Zero(d));
+    normal_meanfield q_fused(Eigen::VectorXd::Zero(d));
+    normal_meanfield history_operator(d);
+    normal_meanfield history_fused(d);
+
+    const int num_iterations = 10000;
+    double t_operator
+        = time_update(operator_update<normal_meanfield>, q_operator, grad,
+                      history_operator, num_iterations);
+    double t_fused = time_update(fused_update<normal_meanfield>, q_fused, grad,
+                                 history_fused, num_iterations);
+    report("meanfield", d, t_operator, t_fused);
+
+    EXPECT_TRUE(q_operator.mu().isApprox(q_fused.mu()));
+    EXPECT_TRUE(q_operator.omega().isApprox(q_fused.omega()));
+  }
+}
+
+TEST(advi_update, normal_fullrank) {
+  using stan::variational::normal_fullrank;
+  for (int d : fullrank_dims()) {
+    Eigen::MatrixXd L_grad = Eigen::MatrixXd::Random(d, d)
+                                 .triangularView<Eigen::Lower>();
+    normal_fullrank grad(Eigen::VectorXd::Random(d), L_grad);
+    normal_fullrank q_operator(Eigen::VectorXd::Zero(d));
+    normal_fullrank q_fused(Eigen::VectorXd::Zero(d));
+    normal_fullrank history_operator(d);
+    normal_fullrank history_fused(d);
+
+    const int num_iterations = d > 2000 ? 5 : 20;
+    double t_operator
+        = time_update(operator_update<normal_fullrank>, q_operator, grad,
+                      history_operator, num_iterations);
+    double t_fused = time_update(fused_update<normal_fullrank>, q_fused, grad,
+                                 history_fused, num_iterations);
+    report("fullrank", d, t_operator, t_fused);
+
+    EXPECT_TRUE(q_operator.mu().isApprox(q_fused.mu()));
+    EXPECT_TRUE(q_operator.L_chol().isApprox(q_fused.L_chol()));
+  }
+}
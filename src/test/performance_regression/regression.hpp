@@ -0,0 +1,257 @@
+#ifndef TEST__PERFORMANCE_REGRESSION__REGRESSION_HPP
+#define TEST__PERFORMANCE_REGRESSION__REGRESSION_HPP
+
+#include <gtest/gtest.h>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/dump.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <stan/model/gradient.hpp>
+#include <stan/services/sample/hmc_nuts_diag_e_adapt.hpp>
+#include <test/performance/utility.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace test {
+namespace performance {
+
+/**
+ * Baseline of a throughput metric: the value recorded on the reference
+ * host and the tolerated relative slowdown. A metric regresses if its
+ * value falls below <code>value * (1 - tolerance)</code>. A baseline
+ * with value <code>NA</code> is missing, see <code>record_metric</code>.
+ */
+struct baseline {
+  double value;
+  double tolerance;
+};
+
+/**
+ * Return the path of the baselines file: the environment variable
+ * <code>STAN_PERF_BASELINES</code> if set, or the checked-in
+ * <code>src/test/performance_regression/regression_baselines.csv</code>.
+ */
+inline std::string baselines_path() {
+  const char* env = std::getenv("STAN_PERF_BASELINES");
+  return env ? env : "src/test/performance_regression/regression_baselines.csv";
+}
+
+/**
+ * Return true if the environment variable
+ * <code>STAN_PERF_RECORD</code> is set, in which case metrics are
+ * recorded without being checked, to produce new baselines.
+ */
+inline bool record_mode() { return std::getenv("STAN_PERF_RECORD") != 0; }
+
+/**
+ * Read baselines from a csv file with header
+ * <code>metric,unit,baseline,tolerance</code>. Lines starting with
+ * <code>#</code> are comments.
+ *
+ * @param path path of the baselines file
+ * @return baselines by metric name, empty if the file cannot be read
+ */
+inline std::map<std::string, baseline> read_baselines(
+    const std::string& path) {
+  std::map<std::string, baseline> baselines;
+  std::ifstream in(path.c_str());
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::vector<std::string> fields;
+    boost::split(fields, line, boost::is_any_of(","));
+    for (std::string& field : fields)
+      boost::trim(field);
+    if (fields.size() != 4 || fields[0] == "metric")
+      continue;
+    baseline b;
+    b.value = fields[2] == "NA" ? std::numeric_limits<double>::quiet_NaN()
+                                : std::atof(fields[2].c_str());
+    b.tolerance = std::atof(fields[3].c_str());
+    baselines[fields[0]] = b;
+  }
+  return baselines;
+}
+
+/**
+ * Run the function <code>repeats</code> times and return the highest
+ * throughput, in units of work per second. The function returns the
+ * amount of work it did.
+ *
+ * @tparam F type of function
+ * @param repeats number of runs
+ * @param f function to time
+ */
+template <class F>
+double best_rate(int repeats, const F& f) {
+  double best = 0;
+  for (int r = 0; r < repeats; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    double work = f();
+    auto end = std::chrono::steady_clock::now();
+    double seconds
+        = std::chrono::duration_cast<std::chrono::duration<double> >(end
+                                                                     - start)
+              .count();
+    best = std::max(best, work / seconds);
+  }
+  return best;
+}
+
+/**
+ * Append a measured metric to
+ * <code>test/performance_regression/regression_results.csv</code>, writing the
+ * header first if the file is empty, and check it against its
+ * baseline. A metric without a baseline fails, so that a baselines
+ * file of <code>NA</code> cannot pass silently, unless
+ * <code>record_mode()</code> is on.
+ *
+ * @param metric name of the metric
+ * @param unit unit of the metric
+ * @param value measured value
+ * @return success unless the metric has no baseline or regressed
+ * beyond its tolerance, always success in record mode
+ */
+inline ::testing::AssertionResult record_metric(const std::string& metric,
+                                                const std::string& unit,
+                                                double value) {
+  static const char* results_path
+      = "test/performance_regression/regression_results.csv";
+  std::map<std::string, baseline> baselines
+      = read_baselines(baselines_path());
+  bool has_baseline = baselines.count(metric) > 0
+                      && !std::isnan(baselines[metric].value);
+  baseline b = has_baseline ? baselines[metric] : baseline{0, 0};
+  double ratio = has_baseline ? value / b.value : 1;
+  bool record = record_mode();
+  bool regressed = !record && has_baseline && ratio < 1 - b.tolerance;
+
+  std::fstream file_stream(results_path, std::ios_base::in);
+  bool write_header
+      = file_stream.peek() == std::fstream::traits_type::eof();
+  file_stream.close();
+  file_stream.open(results_path, std::ios_base::app);
+  if (write_header)
+    file_stream << "date,git_hash,metric,unit,value,baseline,tolerance,"
+                   "ratio,status"
+                << std::endl;
+  file_stream << quote(get_date()) << "," << quote(get_git_hash()) << ","
+              << metric << "," << unit << "," << value << ",";
+  if (has_baseline)
+    file_stream << b.value << "," << b.tolerance << "," << ratio << ",";
+  else
+    file_stream << "NA,NA,NA,";
+  file_stream << (record ? "recorded"
+                          : !has_baseline ? "missing"
+                                          : regressed ? "regressed" : "ok")
+              << std::endl;
+
+  std::cout << metric << ": " << value << " " << unit;
+  if (has_baseline)
+    std::cout << " (baseline " << b.value << ", ratio " << ratio << ")";
+  std::cout << std::endl;
+
+  if (!record && !has_baseline)
+    return ::testing::AssertionFailure()
+           << metric << " has no baseline in " << baselines_path()
+           << "; rerun with STAN_PERF_RECORD=1 on the reference host and"
+           << " copy the value column of " << results_path;
+  if (regressed)
+    return ::testing::AssertionFailure()
+           << metric << " = " << value << " " << unit << " is below "
+           << (1 - b.tolerance) << " times the baseline " << b.value;
+  return ::testing::AssertionSuccess();
+}
+
+/**
+ * Return the number of gradients of the model's log density per
+ * second, at points drawn uniformly in (-2, 2) on the unconstrained
+ * scale. The best of three runs is returned.
+ *
+ * @tparam Model type of model
+ * @param model model
+ * @param num_gradients number of gradients per run
+ */
+template <class Model>
+double gradient_throughput(const Model& model, int num_gradients) {
+  boost::ecuyer1988 rng(1234);
+  boost::random::uniform_real_distribution<double> uniform(-2, 2);
+  std::vector<Eigen::VectorXd> points(100,
+                                      Eigen::VectorXd(model.num_params_r()));
+  for (Eigen::VectorXd& point : points)
+    for (int i = 0; i < point.size(); ++i)
+      point(i) = uniform(rng);
+
+  double sum = 0;
+  double rate = best_rate(3, [&]() {
+    double f;
+    Eigen::VectorXd grad;
+    for (int n = 0; n < num_gradients; ++n) {
+      stan::model::gradient(model, points[n % points.size()], f, grad);
+      sum += f;
+    }
+    return static_cast<double>(num_gradients);
+  });
+  EXPECT_FALSE(std::isnan(sum));
+  return rate;
+}
+
+/**
+ * Return the number of post-warmup NUTS draws per second, from the
+ * sampling time written by <code>hmc_nuts_diag_e_adapt</code> with
+ * default settings and a fixed seed.
+ *
+ * @tparam Model type of model
+ * @param model model
+ * @param num_warmup number of warmup iterations
+ * @param num_samples number of sampling iterations
+ */
+template <class Model>
+double nuts_draws_throughput(Model& model, int num_warmup, int num_samples) {
+  std::stringstream output;
+  callbacks::stream_writer sample_writer(output, "# ");
+  callbacks::writer init_writer;
+  callbacks::writer diagnostic_writer;
+  std::stringstream log;
+  callbacks::stream_logger logger(log, log, log, std::cerr, std::cerr);
+  callbacks::interrupt interrupt;
+  stan::io::empty_var_context init_context;
+
+  // a single chain, without cross-chain adaptation
+  int num_cross_chains = 1;
+  int cross_chain_window = 100;
+  double cross_chain_rhat = 1.1;
+  int cross_chain_ess = 100;
+  int return_code = stan::services::sample::hmc_nuts_diag_e_adapt(
+      model, init_context, 0U, 0, 2, num_cross_chains, cross_chain_window,
+      cross_chain_rhat, cross_chain_ess, num_warmup, num_samples, 1, false, 0,
+      1, 0, 10, 0.8, 0.05, 0.75, 10, 75, 50, 25, interrupt, logger,
+      init_writer, sample_writer, diagnostic_writer);
+  EXPECT_EQ(0, return_code);
+
+  stan::io::stan_csv csv = stan::io::stan_csv_reader::parse(output, 0);
+  EXPECT_EQ(num_samples, csv.samples.rows());
+  return csv.samples.rows() / std::max(csv.timing.sampling, 1e-3);
+}
+
+}  // namespace performance
+}  // namespace test
+}  // namespace stan
+#endif
@@ -0,0 +1,131 @@
+/**
+ * Performance regression test: output and analysis.
+ *
+ * Writes 4 chains of 2500 draws of 100 autocorrelated parameters as a
+ * Stan csv file through stream_writer, parses it back with
+ * stan_csv_reader, and computes the split effective sample size and
+ * split R-hat of every parameter with chains. The throughput of each
+ * step, in values or parameters per second, is appended to
+ * test/performance_regression/regression_results.csv and checked
+ * against src/test/performance_regression/regression_baselines.csv
+ * (see regression.hpp).
+ */
+
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_writer.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <test/performance_regression/regression.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class performance_regression_io : public ::testing::Test {
+ public:
+  static void SetUpTestCase() {
+    boost::ecuyer1988 rng(1234);
+    boost::random::normal_distribution<double> normal(0, 1);
+    names.clear();
+    for (int i = 0; i < num_params; ++i)
+      names.push_back("theta." + std::to_string(i + 1));
+    draws.assign(num_chains, std::vector<std::vector<double> >(
+                                 num_draws, std::vector<double>(num_params)));
+    for (int c = 0; c < num_chains; ++c) {
+      std::vector<double> x(num_params, 0);
+      for (int n = 0; n < num_draws; ++n) {
+        for (int i = 0; i < num_params; ++i) {
+          double rho = 0.9 * i / num_params;
+          x[i] = rho * x[i] + std::sqrt(1 - rho * rho) * normal(rng);
+        }
+        draws[c][n] = x;
+      }
+    }
+  }
+
+  /**
+   * Write one chain in the layout of the sampler output.
+   */
+  static void write_chain(int chain, std::stringstream& output) {
+    stan::callbacks::stream_writer writer(output, "# ");
+    writer("num_samples = " + std::to_string(num_draws));
+    writer("num_warmup = 0");
+    writer("save_warmup = 0");
+    writer("thin = 1");
+    writer(names);
+    writer("Adaptation terminated");
+    writer("Step size = 0.5");
+    writer("Diagonal elements of inverse mass matrix:");
+    std::stringstream inv_metric;
+    inv_metric << 1;
+    for (int i = 1; i < num_params; ++i)
+      inv_metric << ", 1";
+    writer(inv_metric.str());
+    for (const std::vector<double>& draw : draws[chain])
+      writer(draw);
+    writer();
+    writer(" Elapsed Time: 0 seconds (Warm-up)");
+    writer("               0 seconds (Sampling)");
+  }
+
+  static const int num_chains = 4;
+  static const int num_draws = 2500;
+  static const int num_params = 100;
+  static std::vector<std::string> names;
+  static std::vector<std::vector<std::vector<double> > > draws;
+};
+
+const int performance_regression_io::num_chains;
+const int performance_regression_io::num_draws;
+const int performance_regression_io::num_params;
+std::vector<std::string> performance_regression_io::names;
+std::vector<std::vector<std::vector<double> > >
+    performance_regression_io::draws;
+
+TEST_F(performance_regression_io, writer_reader_chains_throughput) {
+  double num_values = static_cast<double>(num_chains) * num_draws * num_params;
+
+  std::vector<std::string> csv(num_chains);
+  double write_rate = stan::test::performance::best_rate(3, [&]() {
+    for (int c = 0; c < num_chains; ++c) {
+      std::stringstream output;
+      write_chain(c, output);
+      csv[c] = output.str();
+    }
+    return num_values;
+  });
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "stream_writer_values", "values/s", write_rate));
+
+  std::vector<stan::io::stan_csv> parsed(num_chains);
+  double read_rate = stan::test::performance::best_rate(3, [&]() {
+    for (int c = 0; c < num_chains; ++c) {
+      std::stringstream input(csv[c]);
+      parsed[c] = stan::io::stan_csv_reader::parse(input, 0);
+    }
+    return num_values;
+  });
+  for (int c = 0; c < num_chains; ++c) {
+    ASSERT_EQ(num_draws, parsed[c].samples.rows());
+    ASSERT_EQ(num_params, parsed[c].samples.cols());
+  }
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "stan_csv_reader_values", "values/s", read_rate));
+
+  stan::mcmc::chains<> chains(parsed[0].header);
+  for (int c = 0; c < num_chains; ++c)
+    chains.add(parsed[c]);
+  ASSERT_EQ(num_chains, chains.num_chains());
+  double sum = 0;
+  double analysis_rate = stan::test::performance::best_rate(3, [&]() {
+    for (int i = 0; i < num_params; ++i) {
+      sum += chains.split_effective_sample_size(i);
+      sum += chains.split_potential_scale_reduction(i);
+    }
+    return static_cast<double>(num_params);
+  });
+  EXPECT_FALSE(std::isnan(sum));
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "chains_split_ess_rhat_params", "params/s", analysis_rate));
+}
@@ -0,0 +1,43 @@
+/**
+ * Performance regression test: logistic regression.
+ *
+ * Measures the gradient throughput of the logistic model and its NUTS
+ * draws per second, appends both to
+ * test/performance_regression/regression_results.csv and checks them
+ * against src/test/performance_regression/regression_baselines.csv
+ * (see regression.hpp).
+ * Runs offline; the working directory must be the top of the repo.
+ */
+
+#include <gtest/gtest.h>
+#include <test/test-models/performance/logistic.hpp>
+#include <test/performance_regression/regression.hpp>
+#include <fstream>
+#include <memory>
+
+class performance_regression_logistic : public ::testing::Test {
+ public:
+  void SetUp() {
+    std::fstream data_stream(
+        "src/test/test-models/performance/logistic.data.R",
+        std::fstream::in);
+    stan::io::dump data_var_context(data_stream);
+    model.reset(new stan_model(data_var_context, 0, &std::cout));
+  }
+
+  std::unique_ptr<stan_model> model;
+};
+
+TEST_F(performance_regression_logistic, gradient_throughput) {
+  double rate
+      = stan::test::performance::gradient_throughput(*model, 20000);
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "logistic_gradients", "gradients/s", rate));
+}
+
+TEST_F(performance_regression_logistic, nuts_draws_throughput) {
+  double rate
+      = stan::test::performance::nuts_draws_throughput(*model, 1000, 10000);
+  EXPECT_TRUE(stan::test::performance::record_metric("logistic_nuts_draws",
+                                                     "draws/s", rate));
+}
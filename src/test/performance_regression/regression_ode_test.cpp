@@ -0,0 +1,43 @@
+/**
+ * Performance regression test: one-compartment ODE model.
+ *
+ * Measures the gradient throughput of the one-compartment ODE model
+ * fit with pmx_solve_rk45 to 200 observations, and its NUTS draws per
+ * second, appends both to
+ * test/performance_regression/regression_results.csv and checks them
+ * against src/test/performance_regression/regression_baselines.csv
+ * (see regression.hpp). Runs offline; the working directory must be
+ * the top of the repo.
+ */
+
+#include <gtest/gtest.h>
+#include <test/test-models/performance/one_cpt_ode.hpp>
+#include <test/performance_regression/regression.hpp>
+#include <fstream>
+#include <memory>
+
+class performance_regression_ode : public ::testing::Test {
+ public:
+  void SetUp() {
+    std::fstream data_stream(
+        "src/test/test-models/performance/one_cpt_ode.data.R",
+        std::fstream::in);
+    stan::io::dump data_var_context(data_stream);
+    model.reset(new stan_model(data_var_context, 0, &std::cout));
+  }
+
+  std::unique_ptr<stan_model> model;
+};
+
+TEST_F(performance_regression_ode, gradient_throughput) {
+  double rate = stan::test::performance::gradient_throughput(*model, 500);
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "one_cpt_ode_gradients", "gradients/s", rate));
+}
+
+TEST_F(performance_regression_ode, nuts_draws_throughput) {
+  double rate
+      = stan::test::performance::nuts_draws_throughput(*model, 200, 200);
+  EXPECT_TRUE(stan::test::performance::record_metric(
+      "one_cpt_ode_nuts_draws", "draws/s", rate));
+}
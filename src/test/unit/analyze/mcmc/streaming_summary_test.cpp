@@ -0,0 +1,122 @@
+#include <stan/analyze/mcmc/streaming_summary.hpp>
+#include <stan/analyze/mcmc/streaming_summary_writer.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+class StreamingSummary : public testing::Test {
+ public:
+  void SetUp() {
+    blocker1_stream.open("src/test/unit/mcmc/test_csv_files/blocker.1.csv");
+    blocker2_stream.open("src/test/unit/mcmc/test_csv_files/blocker.2.csv");
+  }
+
+  void TearDown() {
+    blocker1_stream.close();
+    blocker2_stream.close();
+  }
+
+  void add_chain(const stan::io::stan_csv& csv,
+                 stan::analyze::streaming_summary& summary) {
+    stan::analyze::streaming_summary_writer writer(null_writer, summary);
+    summary.new_chain();
+    writer(csv.header);
+    for (int n = 0; n < csv.samples.rows(); ++n) {
+      std::vector<double> draw(csv.samples.cols());
+      Eigen::VectorXd::Map(draw.data(), draw.size()) = csv.samples.row(n);
+      writer(draw);
+    }
+  }
+
+  std::ifstream blocker1_stream, blocker2_stream;
+  stan::callbacks::writer null_writer;
+};
+
+TEST_F(StreamingSummary, matches_chains) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+
+  // chains filled separately, e.g. by threads, then merged
+  stan::analyze::streaming_summary summary, summary2;
+  add_chain(blocker1, summary);
+  add_chain(blocker2, summary2);
+  summary.merge(summary2);
+
+  ASSERT_EQ(chains.num_params(), summary.num_params());
+  EXPECT_EQ(2, summary.num_chains());
+  for (int i = 0; i < chains.num_params(); ++i) {
+    EXPECT_EQ(chains.param_name(i), summary.names()[i]);
+    EXPECT_NEAR(chains.mean(i), summary.mean(i),
+                1e-10 * (1 + std::fabs(chains.mean(i))));
+    EXPECT_NEAR(chains.sd(i), summary.sd(i), 1e-8 * (1 + chains.sd(i)));
+
+    // rank error bound of the digest
+    for (double p : {0.05, 0.5, 0.95}) {
+      double err = 3.1416 * std::sqrt(p * (1 - p)) / 100.0 + 1e-3;
+      double q = summary.quantile(i, p);
+      EXPECT_GE(q, chains.quantile(i, std::max(0.0, p - err)));
+      EXPECT_LE(q, chains.quantile(i, std::min(1.0, p + err)));
+    }
+
+    std::vector<const double*> draws{blocker1.samples.col(i).data(),
+                                     blocker2.samples.col(i).data()};
+    double rhat = stan::analyze::compute_potential_scale_reduction(
+        draws, blocker1.samples.rows());
+    if (std::isfinite(rhat)) {
+      EXPECT_FLOAT_EQ(rhat, summary.potential_scale_reduction(i));
+    }
+  }
+
+  Eigen::VectorXd probs(3);
+  probs << 0.05, 0.5, 0.95;
+  Eigen::MatrixXd table = summary.table(probs);
+  std::vector<std::string> header = summary.header(probs);
+  ASSERT_EQ(8U, header.size());
+  EXPECT_EQ("5%", header[3]);
+  EXPECT_EQ("R_hat", header[7]);
+  EXPECT_EQ(chains.num_params(), table.rows());
+  EXPECT_EQ(8, table.cols());
+  EXPECT_FLOAT_EQ(summary.mean(7), table(7, 0));
+}
+
+TEST_F(StreamingSummary, discard_warmup) {
+  stan::analyze::streaming_summary summary;
+  stan::analyze::streaming_summary_writer writer(null_writer, summary);
+  writer(std::vector<std::string>{"x"});
+  writer(std::vector<double>{100.0});
+  writer(std::string("Adaptation terminated"));
+  writer(std::vector<double>{1.0});
+  writer(std::vector<double>{3.0});
+  EXPECT_EQ(2, summary.num_draws());
+  EXPECT_FLOAT_EQ(2.0, summary.mean(0));
+  EXPECT_FLOAT_EQ(2.0, summary.variance(0));
+}
+
+TEST_F(StreamingSummary, iid_effective_sample_size) {
+  boost::ecuyer1988 rng(4);
+  boost::variate_generator<boost::ecuyer1988&, boost::normal_distribution<> >
+      rand_norm(rng, boost::normal_distribution<>());
+
+  const int N = 100000;
+  stan::analyze::streaming_summary summary;
+  summary.set_names({"x"});
+  for (int n = 0; n < N; ++n) {
+    summary.add({rand_norm()});
+  }
+  EXPECT_NEAR(summary.effective_sample_size(0), N, 0.25 * N);
+  EXPECT_NEAR(summary.quantile(0, 0.5), 0.0, 0.02);
+  EXPECT_NEAR(summary.quantile(0, 0.95), 1.645, 0.03);
+  EXPECT_TRUE(std::isnan(summary.potential_scale_reduction(0)));
+}
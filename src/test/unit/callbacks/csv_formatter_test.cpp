@@ -0,0 +1,140 @@
+#include <stan/callbacks/csv_formatter.hpp>
+#include <gtest/gtest.h>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<double> test_values() {
+  std::vector<double> x{0.0,
+                        -0.0,
+                        1.0,
+                        -1.0,
+                        0.1,
+                        1.0 / 3.0,
+                        100000.0,
+                        123456.0,
+                        1234567.0,
+                        1e-5,
+                        1e15,
+                        1e16,
+                        1e21,
+                        3.14159265358979,
+                        std::numeric_limits<double>::max(),
+                        std::numeric_limits<double>::min(),
+                        std::numeric_limits<double>::denorm_min(),
+                        std::numeric_limits<double>::infinity(),
+                        -std::numeric_limits<double>::infinity(),
+                        std::numeric_limits<double>::quiet_NaN()};
+  boost::ecuyer1988 rng(1234);
+  boost::uniform_01<boost::ecuyer1988&> unif(rng);
+  for (int n = 0; n < 1000; ++n)
+    x.push_back((unif() - 0.5) * std::pow(10.0, 40 * unif() - 20));
+  return x;
+}
+
+std::string stream_row(const std::vector<double>& x, int precision) {
+  std::stringstream ss;
+  if (precision > 0)
+    ss << std::setprecision(precision);
+  for (size_t n = 0; n + 1 < x.size(); ++n)
+    ss << x[n] << ",";
+  ss << x.back() << std::endl;
+  return ss.str();
+}
+
+}  // namespace
+
+TEST(StanCallbacksCsvFormatter, stream_precision) {
+  std::vector<double> x = test_values();
+  for (int precision : {1, 6, 9, 15, 17, 25}) {
+    std::stringstream ss;
+    ss << std::setprecision(precision);
+    stan::callbacks::csv_formatter formatter;
+    formatter.write(ss, x);
+    EXPECT_EQ(stream_row(x, precision), ss.str());
+  }
+}
+
+TEST(StanCallbacksCsvFormatter, fixed_precision) {
+  std::vector<double> x = test_values();
+  for (int precision : {1, 6, 9, 15, 17, 25}) {
+    std::stringstream ss;
+    ss << std::setprecision(3);
+    stan::callbacks::csv_formatter formatter(precision);
+    EXPECT_EQ(precision, formatter.precision());
+    formatter.write(ss, x);
+    formatter.write(ss, x);
+    EXPECT_EQ(stream_row(x, precision) + stream_row(x, precision), ss.str());
+  }
+}
+
+TEST(StanCallbacksCsvFormatter, stream_format) {
+  std::vector<double> x{0.5, 1234.5678, -1e-8};
+  std::stringstream expected;
+  std::stringstream ss;
+  expected << std::scientific << std::setprecision(4);
+  ss << std::scientific << std::setprecision(4);
+  for (size_t n = 0; n + 1 < x.size(); ++n)
+    expected << x[n] << ",";
+  expected << x.back() << std::endl;
+  stan::callbacks::csv_formatter formatter;
+  formatter.write(ss, x);
+  EXPECT_EQ(expected.str(), ss.str());
+}
+
+TEST(StanCallbacksCsvFormatter, shortest_round_trip) {
+  std::vector<double> x = test_values();
+  stan::callbacks::csv_formatter formatter(
+      stan::callbacks::csv_formatter::shortest_round_trip);
+  std::stringstream ss;
+  formatter.write(ss, x);
+
+  std::string row = ss.str();
+  ASSERT_EQ('\n', row.back());
+  std::stringstream values(row.substr(0, row.size() - 1));
+  std::string value;
+  size_t n = 0;
+  for (; std::getline(values, value, ','); ++n) {
+    ASSERT_LT(n, x.size());
+    if (std::isnan(x[n])) {
+      EXPECT_EQ("nan", value);
+      continue;
+    }
+    EXPECT_EQ(x[n], std::strtod(value.c_str(), 0)) << value;
+    if (std::isfinite(x[n]) && x[n] != 0) {
+      // one digit fewer does not read back
+      std::string mantissa = value.substr(0, value.find('e'));
+      size_t first = mantissa.find_first_of("123456789");
+      size_t last = mantissa.find_last_of("123456789");
+      int digits = last - first + 1;
+      if (mantissa.find('.') > first && mantissa.find('.') < last)
+        --digits;
+      if (digits > 1) {
+        std::stringstream shorter;
+        shorter << std::setprecision(digits - 1) << x[n];
+        EXPECT_NE(x[n], std::strtod(shorter.str().c_str(), 0)) << value;
+      }
+    }
+  }
+  EXPECT_EQ(x.size(), n);
+
+  std::stringstream ss_short;
+  formatter.write(ss_short, std::vector<double>{0.1, 100000, 1e-5, 0.3});
+  EXPECT_EQ("0.1,1e+05,1e-05,0.3\n", ss_short.str());
+}
+
+TEST(StanCallbacksCsvFormatter, strings) {
+  std::stringstream ss;
+  stan::callbacks::csv_formatter formatter;
+  formatter.write(ss, std::vector<std::string>{"lp__", "accept_stat__"});
+  formatter.write(ss, std::vector<std::string>{});
+  EXPECT_EQ("lp__,accept_stat__\n", ss.str());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <boost/lexical_cast.hpp>
+#include <iomanip>
 #include <stan/callbacks/stream_writer.hpp>
 
 class StanInterfaceCallbacksStreamWriter : public ::testing::Test {
@@ -47,3 +48,20 @@ TEST_F(StanInterfaceCallbacksStreamWriter, string) {
   EXPECT_NO_THROW(writer("message"));
   EXPECT_EQ("message\n", ss.str());
 }
+
+TEST_F(StanInterfaceCallbacksStreamWriter, double_vector_stream_precision) {
+  std::vector<double> x{1.0 / 3.0, -2.5e-7, 1e20};
+  ss << std::setprecision(4);
+  EXPECT_NO_THROW(writer(x));
+  EXPECT_EQ("0.3333,-2.5e-07,1e+20\n", ss.str());
+}
+
+TEST_F(StanInterfaceCallbacksStreamWriter, double_vector_precision) {
+  std::vector<double> x{1.0 / 3.0, 0.1, 100};
+  stan::callbacks::stream_writer writer_digits(ss, "", 3);
+  EXPECT_NO_THROW(writer_digits(x));
+  stan::callbacks::stream_writer writer_shortest(
+      ss, "", stan::callbacks::csv_formatter::shortest_round_trip);
+  EXPECT_NO_THROW(writer_shortest(x));
+  EXPECT_EQ("0.333,0.1,100\n0.3333333333333333,0.1,1e+02\n", ss.str());
+}
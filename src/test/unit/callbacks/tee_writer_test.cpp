@@ -1,5 +1,8 @@
 #include <stan/callbacks/tee_writer.hpp>
+#include <stan/callbacks/stream_writer.hpp>
 #include <gtest/gtest.h>
+#include <iomanip>
+#include <sstream>
 
 namespace test {
 class mock_writer : public stan::callbacks::writer {
@@ -48,3 +51,17 @@ TEST_F(StanCallbacksTeeWriter, message) {
   EXPECT_EQ(1, writer1.N);
   EXPECT_EQ(1, writer2.N);
 }
+
+TEST(StanCallbacksTeeWriterStream, state) {
+  std::vector<double> state{1.0 / 3.0, -2.0, 1e-9};
+  std::stringstream ss1, ss2;
+  ss1 << std::setprecision(12);
+  stan::callbacks::stream_writer writer1(ss1);
+  stan::callbacks::stream_writer writer2(ss2, "", 12);
+  stan::callbacks::tee_writer tee_writer(writer1, writer2);
+
+  tee_writer(state);
+  tee_writer(state);
+  EXPECT_EQ("0.333333333333,-2,1e-09\n0.333333333333,-2,1e-09\n", ss1.str());
+  EXPECT_EQ(ss1.str(), ss2.str());
+}
@@ -0,0 +1,145 @@
+#include <stan/io/stan_csv_tail_reader.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+class StanIoStanCsvTailReader : public testing::Test {
+ public:
+  void SetUp() {
+    file_name = "src/test/unit/io/test_csv_files/tail_reader.csv";
+    std::remove(file_name.c_str());
+    std::ifstream blocker0_stream(
+        "src/test/unit/io/test_csv_files/blocker.0.csv");
+    std::stringstream ss;
+    ss << blocker0_stream.rdbuf();
+    blocker0 = ss.str();
+  }
+
+  void TearDown() { std::remove(file_name.c_str()); }
+
+  void append(const std::string& s) {
+    std::ofstream out(file_name.c_str(), std::ios::app | std::ios::binary);
+    out << s;
+  }
+
+  std::string file_name;
+  std::string blocker0;
+};
+
+TEST_F(StanIoStanCsvTailReader, missing_file) {
+  stan::io::stan_csv_tail_reader reader(file_name);
+  EXPECT_EQ(0, reader.read());
+  EXPECT_EQ(0, reader.offset());
+  EXPECT_TRUE(reader.header().empty());
+}
+
+TEST_F(StanIoStanCsvTailReader, partial_line) {
+  stan::io::stan_csv_tail_reader reader(file_name);
+  size_t header_end = blocker0.find("\nlp__") + 1;
+  header_end = blocker0.find('\n', header_end) + 1;
+
+  append(blocker0.substr(0, header_end - 5));
+  EXPECT_EQ(0, reader.read());
+  EXPECT_TRUE(reader.header().empty());
+
+  append(blocker0.substr(header_end - 5, 5));
+  EXPECT_EQ(0, reader.read());
+  EXPECT_EQ(header_end, reader.offset());
+  ASSERT_EQ(55U, reader.header().size());
+  EXPECT_EQ("lp__", reader.header()[0]);
+  EXPECT_EQ("blocker_model", reader.csv().metadata.model);
+  EXPECT_EQ(2U, reader.csv().metadata.thin);
+}
+
+TEST_F(StanIoStanCsvTailReader, incremental_read) {
+  std::stringstream blocker0_stream(blocker0);
+  stan::io::stan_csv blocker = stan::io::stan_csv_reader::parse(
+      blocker0_stream, 0);
+
+  stan::io::stan_csv_tail_reader reader(file_name);
+  stan::mcmc::chains<> chains(blocker.header);
+  const size_t chunk = 997;
+  int n_read = 0;
+  for (size_t pos = 0; pos < blocker0.size(); pos += chunk) {
+    append(blocker0.substr(pos, chunk));
+    int n = reader.read(chains, 0);
+    EXPECT_EQ(n, reader.csv().samples.rows());
+    n_read += n;
+    EXPECT_EQ(n_read, reader.num_rows());
+    if (n_read > 0) {
+      EXPECT_TRUE(reader.adaptation_read());
+      EXPECT_EQ(n_read, chains.num_samples(0));
+    }
+  }
+  EXPECT_EQ(static_cast<std::streamoff>(blocker0.size()), reader.offset());
+  EXPECT_EQ(0, reader.read(chains, 0));
+
+  ASSERT_EQ(1, chains.num_chains());
+  ASSERT_EQ(blocker.samples.rows(), chains.num_samples(0));
+  EXPECT_EQ(0, chains.warmup(0));
+  for (int i = 0; i < chains.num_params(); ++i) {
+    Eigen::VectorXd expected = blocker.samples.col(i);
+    Eigen::VectorXd found = chains.samples(0, i);
+    for (int j = 0; j < expected.size(); ++j) {
+      EXPECT_FLOAT_EQ(expected(j), found(j));
+    }
+  }
+
+  const stan::io::stan_csv& csv = reader.csv();
+  EXPECT_FLOAT_EQ(blocker.adaptation.step_size, csv.adaptation.step_size);
+  ASSERT_EQ(blocker.adaptation.metric.size(), csv.adaptation.metric.size());
+  for (int i = 0; i < blocker.adaptation.metric.size(); ++i) {
+    EXPECT_FLOAT_EQ(blocker.adaptation.metric(i), csv.adaptation.metric(i));
+  }
+  EXPECT_FLOAT_EQ(blocker.timing.warmup, csv.timing.warmup);
+  EXPECT_FLOAT_EQ(blocker.timing.sampling, csv.timing.sampling);
+}
+
+TEST_F(StanIoStanCsvTailReader, saved_warmup) {
+  std::string csv = blocker0;
+  size_t pos = csv.find("save_warmup = 0 (Default)");
+  csv.replace(pos, 25, "save_warmup = 1");
+  size_t first_row = csv.find('\n', csv.find("\nlp__") + 1) + 1;
+  // repeat the first three draws as warmup draws
+  size_t draws_begin = csv.find("# Adaptation terminated");
+  while (csv[draws_begin] == '#') {
+    draws_begin = csv.find('\n', draws_begin) + 1;
+  }
+  std::string warmup_rows;
+  size_t row = draws_begin;
+  for (int i = 0; i < 3; ++i) {
+    size_t next = csv.find('\n', row) + 1;
+    warmup_rows += csv.substr(row, next - row);
+    row = next;
+  }
+  csv.insert(first_row, warmup_rows);
+
+  stan::io::stan_csv_tail_reader reader(file_name);
+  append(csv.substr(0, first_row + warmup_rows.size()));
+  EXPECT_EQ(3, reader.read());
+  stan::mcmc::chains<> chains(reader.header());
+  chains.add(0, reader.csv().samples);
+  EXPECT_EQ(3, reader.num_warmup_rows());
+  EXPECT_FALSE(reader.adaptation_read());
+
+  append(csv.substr(first_row + warmup_rows.size()));
+  EXPECT_EQ(1000, reader.read(chains, 0));
+  EXPECT_TRUE(reader.adaptation_read());
+  EXPECT_EQ(3, reader.num_warmup_rows());
+  EXPECT_EQ(3, chains.warmup(0));
+  EXPECT_EQ(1000, chains.num_kept_samples(0));
+}
+
+TEST_F(StanIoStanCsvTailReader, rewritten_file) {
+  stan::io::stan_csv_tail_reader reader(file_name);
+  append(blocker0);
+  EXPECT_EQ(1000, reader.read());
+  std::remove(file_name.c_str());
+  append(blocker0.substr(0, blocker0.find("# Adaptation terminated")));
+  EXPECT_EQ(0, reader.read());
+  EXPECT_EQ(0, reader.num_rows());
+  EXPECT_EQ(55U, reader.header().size());
+}
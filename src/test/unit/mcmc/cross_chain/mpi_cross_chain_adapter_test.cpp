@@ -383,4 +383,228 @@ TEST_F(CrossChainAdapterTest, positive_adapted_window) {
   }    
 }
 
+TEST_F(CrossChainAdapterTest, window_arrival_times) {
+  const int n_par = 4;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n_par);
+
+  stan::mcmc::mpi_cross_chain_adapter adapter;
+  adapter.set_cross_chain_adaptation_params(75, 50, num_warmup,
+                                            cross_chain_window_size, num_chains,
+                                            cross_chain_rhat, cross_chain_ess);
+  stan::mcmc::mpi_var_adaptation var_adapt(n_par, num_warmup, cross_chain_window_size);
+  adapter.set_cross_chain_metric_adaptation(&var_adapt);
+
+  Eigen::MatrixXd all_lp_draws;
+  std::vector<double> all_chain_gather;
+  for (int i = 0; i < cross_chain_window_size; ++i) {
+    adapter.add_cross_chain_sample(1.1 + i + comm.rank(), q);
+  }
+  adapter.cross_chain_gather(all_chain_gather, all_lp_draws);
+
+  const Eigen::MatrixXd& arrival = adapter.cross_chain_window_arrival_times();
+  EXPECT_EQ(arrival.rows(), num_warmup / cross_chain_window_size);
+  EXPECT_EQ(arrival.cols(), num_chains);
+  if (comm.rank() == 0) {
+    for (int chain = 0; chain < num_chains; ++chain) {
+      EXPECT_GE(arrival(0, chain), 0.0);
+      EXPECT_TRUE(std::isnan(arrival(1, chain)));
+    }
+  }
+}
+
+TEST_F(CrossChainAdapterTest, quorum) {
+  const int n_par = 4;
+  const int n_win = 2;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n_par);
+  if (comm.rank() >= 0 && comm.rank() < n_par) {       // only inter-chains
+    q(comm.rank()) = comm.rank();
+  }
+
+  stan::mcmc::mpi_cross_chain_adapter adapter;
+  adapter.set_cross_chain_adaptation_params(0, 50, n_win * cross_chain_window_size,
+                                            cross_chain_window_size, num_chains,
+                                            cross_chain_rhat, cross_chain_ess);
+  adapter.set_cross_chain_quorum(num_chains - 1);
+  EXPECT_TRUE(adapter.use_cross_chain_quorum());
+  stan::mcmc::mpi_var_adaptation var_adapt(n_par, n_win * cross_chain_window_size,
+                                           cross_chain_window_size);
+  adapter.set_cross_chain_metric_adaptation(&var_adapt);
+
+  stan::callbacks::logger logger;
+  Eigen::VectorXd inv_metric = Eigen::VectorXd::Ones(n_par);
+
+  // window 1: no synchronization before the last window
+  for (int i = 0; i < cross_chain_window_size; ++i) {
+    adapter.add_cross_chain_sample(1.1 + i + comm.rank(), q);
+    EXPECT_FALSE(adapter.cross_chain_adaptation(inv_metric, logger));
+  }
+
+  // window 2: chains synchronize at the last window
+  for (int i = 0; i < cross_chain_window_size - 1; ++i) {
+    adapter.add_cross_chain_sample(2.1 + i + comm.rank(), q);
+    EXPECT_FALSE(adapter.cross_chain_adaptation(inv_metric, logger));
+  }
+  adapter.add_cross_chain_sample(0.5 + comm.rank(), q);
+  EXPECT_TRUE(adapter.cross_chain_adaptation(inv_metric, logger));
+  EXPECT_FALSE(adapter.cross_chain_adaptation(inv_metric, logger));
+
+  // laggards are folded in when chains synchronize
+  if (comm.rank() == 0) {
+    const Eigen::MatrixXd& arrival = adapter.cross_chain_window_arrival_times();
+    for (int win = 0; win < n_win; ++win) {
+      for (int chain = 0; chain < num_chains; ++chain) {
+        EXPECT_GE(arrival(win, chain), 0.0);
+      }
+    }
+  }
+
+  adapter.set_cross_chain_quorum(num_chains);
+  EXPECT_FALSE(adapter.use_cross_chain_quorum());
+}
+
+TEST_F(CrossChainAdapterTest, quorum_dense) {
+  const int n_par = 4;
+  const int n_win = 2;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n_par);
+  if (comm.rank() >= 0 && comm.rank() < n_par) {       // only inter-chains
+    q(comm.rank()) = comm.rank();
+  }
+
+  stan::mcmc::mpi_cross_chain_adapter adapter;
+  adapter.set_cross_chain_adaptation_params(0, 50, n_win * cross_chain_window_size,
+                                            cross_chain_window_size, num_chains,
+                                            cross_chain_rhat, cross_chain_ess);
+  adapter.set_cross_chain_quorum(num_chains - 1);
+  stan::mcmc::mpi_covar_adaptation covar_adapt(n_par, num_chains,
+                                               n_win * cross_chain_window_size,
+                                               cross_chain_window_size);
+  adapter.set_cross_chain_metric_adaptation(&covar_adapt);
+
+  // dense metric exchanges every draw, so windows are evaluated by all chains
+  EXPECT_EQ(adapter.cross_chain_quorum(), num_chains - 1);
+  EXPECT_FALSE(adapter.use_cross_chain_quorum());
+
+  stan::callbacks::logger logger;
+  Eigen::MatrixXd inv_metric = Eigen::MatrixXd::Identity(n_par, n_par);
+
+  // the metric is learned at the end of each window, so that
+  // pending draws never exceed the window size
+  for (int win = 0; win < n_win; ++win) {
+    for (int i = 0; i < cross_chain_window_size - 1; ++i) {
+      adapter.add_cross_chain_sample(1.1 + win + i + comm.rank(), q);
+      EXPECT_FALSE(adapter.cross_chain_adaptation(inv_metric, logger));
+    }
+    adapter.add_cross_chain_sample(0.5 + win + comm.rank(), q);
+    EXPECT_TRUE(adapter.cross_chain_adaptation(inv_metric, logger));
+    EXPECT_EQ(inv_metric.rows(), n_par);
+    EXPECT_EQ(inv_metric.cols(), n_par);
+  }
+}
+
+TEST_F(CrossChainAdapterTest, quorum_window_clamp) {
+  using stan::mcmc::mpi_cross_chain_adapter;
+
+  // adapted windows
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(1, 3), 1);
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(2, 2), 1);
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(4, 2), 1);
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(0, 1), 0);
+
+  // windows with max ESS when warmup is not converged
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(-2, 3), -2);
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(-3, 2), -2);
+  EXPECT_EQ(mpi_cross_chain_adapter::clamp_quorum_window(-5, 2), -2);
+}
+
+TEST_F(CrossChainAdapterTest, cull_donors) {
+  using stan::mcmc::mpi_cross_chain_adapter;
+
+  // lp__ mean, lp__ sd and mean acceptance of each chain
+  std::vector<double> stats{-10.0, 1.0, 0.8,
+                            -50.0, 1.0, 0.8,
+                            -9.0, 1.0, 0.8,
+                            -11.0, 1.0, 0.1};
+  std::vector<int> donor = mpi_cross_chain_adapter::find_cull_donors(stats, 4.0, 0.5);
+  EXPECT_EQ(donor, (std::vector<int>{-1, 2, -1, 0}));
+
+  std::vector<double> healthy{-10.0, 1.0, 0.8,
+                              -12.0, 1.0, 0.8,
+                              -9.0, 1.0, 0.7};
+  donor = mpi_cross_chain_adapter::find_cull_donors(healthy, 4.0, 0.5);
+  EXPECT_EQ(donor, (std::vector<int>{-1, -1, -1}));
+
+  // no culling without a healthy majority
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  std::vector<double> no_majority{-10.0, 1.0, 0.8,
+                                  nan, nan, 0.8,
+                                  nan, nan, 0.8};
+  donor = mpi_cross_chain_adapter::find_cull_donors(no_majority, 4.0, 0.5);
+  EXPECT_EQ(donor, (std::vector<int>{-1, -1, -1}));
+}
+
+TEST_F(CrossChainAdapterTest, cull) {
+  const int n_par = 4;
+  const int interval = 5;
+
+  stan::mcmc::mpi_cross_chain_adapter adapter;
+  adapter.set_cross_chain_adaptation_params(2 * interval, 50, num_warmup,
+                                            cross_chain_window_size, num_chains,
+                                            cross_chain_rhat, cross_chain_ess);
+  adapter.set_cross_chain_culling(interval);
+  EXPECT_TRUE(adapter.use_cross_chain_culling());
+  stan::mcmc::mpi_var_adaptation var_adapt(n_par, num_warmup, cross_chain_window_size);
+  adapter.set_cross_chain_metric_adaptation(&var_adapt);
+
+  boost::ecuyer1988 rng(comm.rank());
+  stan::mcmc::stepsize_adaptation stepsize_adapt;
+  stepsize_adapt.set_mu(comm.rank());
+  Eigen::VectorXd q = Eigen::VectorXd::Constant(n_par, comm.rank());
+  Eigen::VectorXd inv_metric = Eigen::VectorXd::Ones(n_par);
+  double stepsize = 0.1 * (comm.rank() + 1);
+
+  // chain 1 is stuck far below the others
+  for (int i = 0; i < interval; ++i) {
+    double lp = (comm.rank() == 1 ? -1000.0 : -10.0) + 0.1 * i + 0.01 * comm.rank();
+    adapter.add_cross_chain_sample(lp, q);
+    bool culled = adapter.cross_chain_cull(lp, 0.8, q, stepsize, stepsize_adapt,
+                                           inv_metric, rng, logger);
+    EXPECT_EQ(culled, comm.rank() == 1 && i == interval - 1);
+  }
+  EXPECT_EQ(adapter.num_cross_chain_culled(), 1);
+
+  // chain 1 is a perturbed copy of chain 2, the healthy chain of highest lp__
+  if (comm.rank() == 1) {
+    EXPECT_FLOAT_EQ(stepsize, 0.3);
+    EXPECT_FLOAT_EQ(stepsize_adapt.get_mu(), 2.0);
+    for (int i = 0; i < n_par; ++i) {
+      EXPECT_NEAR(q(i), 2.0, 2.0);
+      EXPECT_NE(q(i), 2.0);
+    }
+  }
+
+  // chain 1 drops its lp__ draws from before the cull
+  adapter.add_cross_chain_sample(-5.0, q);
+  std::vector<double> window_data = adapter.cross_chain_window_data(2);
+  if (comm.rank() == 1) {
+    EXPECT_FLOAT_EQ(window_data[0], -5.0);
+    EXPECT_FLOAT_EQ(window_data[2], -5.0);
+    EXPECT_TRUE(std::isnan(window_data[4]));
+    EXPECT_TRUE(std::isnan(window_data[5]));
+  } else {
+    EXPECT_LT(window_data[0], -5.0);
+    EXPECT_FALSE(std::isnan(window_data[4]));
+    EXPECT_FALSE(std::isnan(window_data[5]));
+  }
+  EXPECT_FLOAT_EQ(window_data[6], -5.0);
+
+  // no culling after the initial buffer
+  for (int i = 0; i < 2 * interval; ++i) {
+    double lp = (comm.rank() == 0 && i >= interval ? -1000.0 : -10.0) + 0.1 * i;
+    adapter.add_cross_chain_sample(lp, q);
+    adapter.cross_chain_cull(lp, 0.8, q, stepsize, stepsize_adapt,
+                             inv_metric, rng, logger);
+  }
+  EXPECT_EQ(adapter.num_cross_chain_culled(), 1);
+}
+
 #endif
@@ -0,0 +1,75 @@
+#ifdef MPI_ADAPTED_WARMUP
+
+#include <gtest/gtest.h>
+#include <stan/mcmc/cross_chain/mpi_cross_chain_monitor.hpp>
+#include <stan/math/torsten/mpi.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+
+TORSTEN_MPI_SESSION_INIT;
+
+using stan::math::mpi::Session;
+using stan::math::mpi::Communicator;
+
+class CrossChainMonitorTest : public testing::Test {
+ public:
+  CrossChainMonitorTest() :
+    num_chains(3),
+    comm(Session::inter_chain_comm(num_chains)),
+    rng(comm.rank() + 1),
+    rand_norm(rng, boost::normal_distribution<>())
+  {}
+
+  stan::callbacks::logger logger;
+  int num_chains;     // must run with mpiexec -n with n>=4
+  const Communicator& comm;
+  boost::ecuyer1988 rng;
+  boost::variate_generator<boost::ecuyer1988&, boost::normal_distribution<> > rand_norm;
+};
+
+TEST_F(CrossChainMonitorTest, stop_at_target) {
+  const int n_par = 2;
+  const int num_samples = 1000;
+  stan::mcmc::mpi_cross_chain_monitor monitor;
+  monitor.set_target(num_chains, 50, 200.0, 1.1, {1});
+  EXPECT_TRUE(monitor.is_active());
+
+  Eigen::VectorXd q(n_par);
+  int n = 0;
+  for (; n < num_samples; ++n) {
+    q << rand_norm(), rand_norm();
+    monitor.add_sample(rand_norm(), q);
+    if (monitor.end_sampling(logger)) {
+      break;
+    }
+  }
+
+  // all the chains stop at the same check point well before the end
+  EXPECT_LT(n, num_samples);
+  EXPECT_EQ(monitor.num_draws() % 50, 0);
+  int n_min, n_max;
+  MPI_Allreduce(&n, &n_min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&n, &n_max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  EXPECT_EQ(n_min, n_max);
+
+  if (Session::is_in_inter_chain_comm(num_chains) && comm.rank() == 0) {
+    EXPECT_EQ(monitor.ess().size(), 2);
+    EXPECT_GT(monitor.ess().minCoeff(), 200.0);
+    EXPECT_LT(monitor.rhat().maxCoeff(), 1.1);
+  }
+}
+
+TEST_F(CrossChainMonitorTest, inactive) {
+  stan::mcmc::mpi_cross_chain_monitor monitor;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(2);
+  for (int n = 0; n < 100; ++n) {
+    monitor.add_sample(0.0, q);
+    EXPECT_FALSE(monitor.end_sampling(logger));
+  }
+  EXPECT_FALSE(monitor.is_active());
+  EXPECT_EQ(monitor.num_draws(), 100);
+}
+
+#endif
@@ -101,6 +101,59 @@ TEST_F(ServicesSampleHmcNutsDiagEMassMatrix, mpi_return_checks) {
   EXPECT_EQ(0, return_code);
 }
 
+TEST_F(ServicesSampleHmcNutsDiagEMassMatrix, mpi_cross_chain_options) {
+  unsigned int random_seed = 12345;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_warmup = 30;
+  int num_samples = 40;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 1;
+  double stepsize_jitter = 0;
+  int max_depth = 10;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 10;
+  unsigned int term_buffer = 5;
+  unsigned int window = 5;
+
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::io::dump dmp
+      = stan::services::util::create_unit_e_diag_inv_metric(3);
+  stan::io::var_context& inv_metric = dmp;
+
+  const int num_chains = 3;     // must run with mpiexec -n with n>=4
+  const int cross_chain_window_size = 5;
+  const double cross_chain_rhat = 1.1;
+  const double cross_chain_ess = 100;
+
+  if (stan::math::mpi::Session::is_in_inter_chain_comm(num_chains)) {
+    const Communicator& comm = Session::inter_chain_comm(num_chains);
+    random_seed += comm.rank();
+  }
+
+  stan::services::util::cross_chain_options options;
+  options.quorum = num_chains - 1;
+  options.cull_interval = 5;
+  options.sampling_check_interval = 10;
+  options.sampling_target_ess = 1e6;
+  options.sampling_target_rhat = 1.1;
+
+  int return_code = stan::services::sample::hmc_nuts_diag_e_adapt(
+      model, context, inv_metric, random_seed, chain, init_radius,
+      num_chains, cross_chain_window_size, cross_chain_rhat, cross_chain_ess,
+      num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init, parameter, diagnostic, options);
+
+  EXPECT_EQ(0, return_code);
+}
+
 class ServicesSampleHmcNutsDenseEMassMatrix : public testing::Test {
  public:
   ServicesSampleHmcNutsDenseEMassMatrix() : model(context, &model_log) {}
@@ -168,4 +221,46 @@ TEST_F(ServicesSampleHmcNutsDenseEMassMatrix, mpi_return_checks) {
   EXPECT_EQ(0, return_code);
 }
 
+
+TEST_F(ServicesSampleHmcNutsDenseEMassMatrix, mpi_quorum_rejected) {
+  unsigned int random_seed = 12345;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_warmup = 21;
+  int num_samples = 0;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 1;
+  double stepsize_jitter = 0;
+  int max_depth = 10;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 75;
+  unsigned int term_buffer = 50;
+  unsigned int window = 25;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  const int num_chains = 3;     // must run with mpiexec -n with n>=4
+  const int cross_chain_window_size = 5;
+  const double cross_chain_rhat = 1.1;
+  const double cross_chain_ess = 100;
+
+  stan::services::util::cross_chain_options options;
+  options.quorum = num_chains - 1;
+
+  int return_code = stan::services::sample::hmc_nuts_dense_e_adapt(
+      model, context, random_seed, chain, init_radius,
+      num_chains, cross_chain_window_size, cross_chain_rhat, cross_chain_ess,
+      num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init, parameter, diagnostic, options);
+  EXPECT_EQ(stan::services::error_codes::CONFIG, return_code);
+  EXPECT_EQ(1, logger.find_error("quorum"));
+  EXPECT_EQ(0, interrupt.call_count());
+}
+
 #endif
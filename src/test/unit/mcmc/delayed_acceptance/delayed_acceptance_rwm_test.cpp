@@ -0,0 +1,158 @@
+#include <stan/mcmc/delayed_acceptance/delayed_acceptance_rwm.hpp>
+#include <stan/mcmc/delayed_acceptance/adapt_delayed_acceptance_rwm.hpp>
+#include <stan/mcmc/delayed_acceptance/gaussian_surrogate.hpp>
+#include <stan/mcmc/delayed_acceptance/model_surrogate.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+
+#include <test/test-models/good/mcmc/hmc/common/gauss.hpp>
+
+#include <boost/random/additive_combine.hpp>
+
+#include <gtest/gtest.h>
+
+typedef boost::ecuyer1988 rng_t;
+
+class McmcDelayedAcceptance : public testing::Test {
+ public:
+  McmcDelayedAcceptance()
+      : logger(debug, info, warn, error, fatal),
+        empty_stream("", std::fstream::in),
+        data_var_context(empty_stream),
+        model(data_var_context) {}
+
+  template <class Sampler>
+  void run(Sampler& sampler, int num_draws, double& mean, double& var) {
+    stan::mcmc::sample s(Eigen::VectorXd::Ones(1), 0, 0);
+    mean = 0;
+    var = 0;
+    for (int i = 0; i < num_draws; ++i) {
+      s = sampler.transition(s, logger);
+      mean += s.cont_params(0) / num_draws;
+      var += s.cont_params(0) * s.cont_params(0) / num_draws;
+    }
+    var -= mean * mean;
+  }
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger;
+  std::fstream empty_stream;
+  stan::io::dump data_var_context;
+  gauss_model_namespace::gauss_model model;
+};
+
+TEST_F(McmcDelayedAcceptance, flat_surrogate) {
+  rng_t base_rng(4839294);
+  stan::mcmc::gaussian_surrogate surrogate;
+  stan::mcmc::delayed_acceptance_rwm<gauss_model_namespace::gauss_model,
+                                     stan::mcmc::gaussian_surrogate, rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize(2.4);
+
+  double mean, var;
+  run(sampler, 20000, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.1);
+  EXPECT_NEAR(1.0, var, 0.1);
+  // an unfit surrogate passes every proposal
+  EXPECT_EQ(20000, sampler.num_proposals());
+  EXPECT_EQ(20000, sampler.num_expensive_evaluations());
+}
+
+TEST_F(McmcDelayedAcceptance, gaussian_surrogate) {
+  rng_t base_rng(4839294);
+  stan::mcmc::gaussian_surrogate surrogate;
+  surrogate.fit(Eigen::VectorXd::Constant(1, 0.3),
+                Eigen::MatrixXd::Constant(1, 1, 1.5));
+  stan::mcmc::delayed_acceptance_rwm<gauss_model_namespace::gauss_model,
+                                     stan::mcmc::gaussian_surrogate, rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize(2.4);
+
+  double mean, var;
+  run(sampler, 50000, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.1);
+  EXPECT_NEAR(1.0, var, 0.1);
+  EXPECT_EQ(50000, sampler.num_proposals());
+  EXPECT_LT(sampler.num_expensive_evaluations(), 0.8 * 50000);
+
+  sampler.write_evaluation_summary(logger);
+  EXPECT_NE(std::string::npos, info.str().find("model evaluations saved"));
+
+  std::vector<std::string> names;
+  sampler.get_sampler_param_names(names);
+  ASSERT_EQ(2U, names.size());
+  EXPECT_EQ("stepsize__", names[0]);
+  EXPECT_EQ("expensive__", names[1]);
+}
+
+TEST_F(McmcDelayedAcceptance, exact_surrogate) {
+  rng_t base_rng(4839294);
+  stan::mcmc::model_surrogate<gauss_model_namespace::gauss_model> surrogate(
+      model);
+  stan::mcmc::delayed_acceptance_rwm<
+      gauss_model_namespace::gauss_model,
+      stan::mcmc::model_surrogate<gauss_model_namespace::gauss_model>, rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize(2.4);
+
+  // with the exact density as surrogate, the second stage always
+  // accepts
+  stan::mcmc::sample s(Eigen::VectorXd::Ones(1), 0, 0);
+  for (int i = 0; i < 100; ++i) {
+    s = sampler.transition(s, logger);
+    std::vector<double> values;
+    sampler.get_sampler_params(values);
+    if (values[1])
+      EXPECT_FLOAT_EQ(1.0, s.accept_stat());
+  }
+  EXPECT_EQ("", error.str());
+}
+
+TEST_F(McmcDelayedAcceptance, adaptation) {
+  rng_t base_rng(4839294);
+  stan::mcmc::gaussian_surrogate surrogate;
+  stan::mcmc::adapt_delayed_acceptance_rwm<gauss_model_namespace::gauss_model,
+                                           stan::mcmc::gaussian_surrogate,
+                                           rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize(0.1);
+  sampler.get_stepsize_adaptation().set_mu(log(0.1));
+  sampler.get_stepsize_adaptation().set_delta(0.25);
+  sampler.set_window_params(1000, 75, 50, 25, logger);
+  sampler.engage_adaptation();
+
+  double mean, var;
+  run(sampler, 1000, mean, var);
+  sampler.disengage_adaptation();
+
+  EXPECT_TRUE(surrogate.is_fit());
+  EXPECT_NEAR(0.0, surrogate.mean()(0), 0.5);
+  EXPECT_NEAR(1.0, sampler.get_proposal_cholesky()(0, 0), 0.5);
+  EXPECT_GT(sampler.get_nominal_stepsize(), 0.5);
+  EXPECT_EQ(0, sampler.num_proposals());
+}
+
+TEST_F(McmcDelayedAcceptance, sampler_state) {
+  rng_t base_rng(4839294);
+  stan::mcmc::gaussian_surrogate surrogate;
+  stan::mcmc::adapt_delayed_acceptance_rwm<gauss_model_namespace::gauss_model,
+                                           stan::mcmc::gaussian_surrogate,
+                                           rng_t>
+      sampler(model, surrogate, base_rng);
+  // random walk target, not the NUTS one
+  EXPECT_FLOAT_EQ(0.234, sampler.get_stepsize_adaptation().get_delta());
+  sampler.get_stepsize_adaptation().set_delta(0.0);
+  EXPECT_FLOAT_EQ(0.234, sampler.get_stepsize_adaptation().get_delta());
+
+  sampler.set_nominal_stepsize(0.5);
+  sampler.set_proposal_covariance(4.0 * Eigen::MatrixXd::Identity(1, 1));
+
+  std::stringstream out;
+  stan::callbacks::stream_writer writer(out);
+  sampler.write_sampler_state(writer);
+  EXPECT_EQ(
+      "Step size = 0.5\n"
+      "Diagonal elements of proposal covariance:\n"
+      "4\n",
+      out.str());
+}
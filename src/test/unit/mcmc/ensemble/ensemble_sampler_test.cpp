@@ -0,0 +1,110 @@
+#include <stan/mcmc/ensemble/ensemble_sampler.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/dump.hpp>
+#include <stan/services/util/thread_pool.hpp>
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+typedef boost::ecuyer1988 rng_t;
+typedef gauss3D_model_namespace::gauss3D_model model_t;
+
+class McmcEnsemble : public testing::Test {
+ public:
+  McmcEnsemble()
+      : logger(debug, info, warn, error, fatal),
+        empty_stream("", std::fstream::in),
+        data_var_context(empty_stream),
+        model(data_var_context) {
+    for (int k = 0; k < 16; ++k)
+      walkers.push_back(Eigen::VectorXd::Constant(3, 0.1 * k - 0.8));
+    for (int k = 0; k < 16; ++k)
+      walkers[k](k % 3) += 0.5;
+  }
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger;
+  std::fstream empty_stream;
+  stan::io::dump data_var_context;
+  model_t model;
+  std::vector<Eigen::VectorXd> walkers;
+};
+
+TEST_F(McmcEnsemble, transition_cycles_walkers) {
+  rng_t rng(0);
+  stan::mcmc::ensemble_sampler<model_t, rng_t> sampler(model, rng);
+  sampler.set_walkers(walkers, logger);
+  EXPECT_EQ(16, sampler.num_walkers());
+
+  std::vector<std::string> names;
+  sampler.get_sampler_param_names(names);
+  ASSERT_EQ(1, names.size());
+  EXPECT_EQ("walker__", names[0]);
+
+  stan::mcmc::sample s(walkers[0], 0, 0);
+  for (int k = 0; k < 32; ++k) {
+    s = sampler.transition(s, logger);
+    std::vector<double> values;
+    sampler.get_sampler_params(values);
+    EXPECT_EQ(k % 16, values[0]);
+    Eigen::VectorXd q = s.cont_params();
+    EXPECT_FLOAT_EQ((model.log_prob<false, true>(q, 0)), s.log_prob());
+    EXPECT_TRUE(s.cont_params() == sampler.walkers()[k % 16]);
+  }
+  EXPECT_EQ(32, sampler.num_proposals());
+  EXPECT_GT(sampler.acceptance_rate(), 0);
+  EXPECT_LT(sampler.acceptance_rate(), 1);
+}
+
+TEST_F(McmcEnsemble, independent_of_threads) {
+  rng_t rng1(3), rng2(3);
+  stan::mcmc::ensemble_sampler<model_t, rng_t> serial(model, rng1);
+  stan::mcmc::ensemble_sampler<model_t, rng_t> parallel(model, rng2);
+  stan::services::util::thread_pool pool(4);
+  parallel.set_parallel_for([&pool](int n, const std::function<void(int)>& f) {
+    pool.parallel_for(n, f);
+  });
+  serial.set_walkers(walkers, logger);
+  parallel.set_walkers(walkers, logger);
+  for (int m = 0; m < 20; ++m) {
+    serial.sweep(logger);
+    parallel.sweep(logger);
+  }
+  for (int k = 0; k < 16; ++k)
+    EXPECT_TRUE(serial.walkers()[k] == parallel.walkers()[k]);
+}
+
+TEST_F(McmcEnsemble, moments) {
+  rng_t rng(1);
+  stan::mcmc::ensemble_sampler<model_t, rng_t> sampler(model, rng);
+  sampler.set_de_probability(0.2);
+  sampler.set_walkers(walkers, logger);
+  for (int m = 0; m < 200; ++m)
+    sampler.sweep(logger);
+
+  int num_sweeps = 2000;
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(3);
+  Eigen::VectorXd var = Eigen::VectorXd::Zero(3);
+  int n = num_sweeps * sampler.num_walkers();
+  for (int m = 0; m < num_sweeps; ++m) {
+    sampler.sweep(logger);
+    for (const Eigen::VectorXd& q : sampler.walkers()) {
+      mean += q / n;
+      var += q.array().square().matrix() / n;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(0, mean(i), 0.1);
+    EXPECT_NEAR(1, var(i), 0.15);
+  }
+}
+
+TEST_F(McmcEnsemble, too_few_walkers) {
+  rng_t rng(0);
+  stan::mcmc::ensemble_sampler<model_t, rng_t> sampler(model, rng);
+  walkers.resize(3);
+  EXPECT_THROW(sampler.set_walkers(walkers, logger), std::invalid_argument);
+}
@@ -0,0 +1,142 @@
+#include <stan/mcmc/hmc/ghmc/unit_e_ghmc.hpp>
+#include <stan/mcmc/hmc/ghmc/diag_e_ghmc.hpp>
+#include <stan/mcmc/hmc/ghmc/dense_e_ghmc.hpp>
+#include <stan/mcmc/hmc/ghmc/adapt_unit_e_ghmc.hpp>
+#include <stan/mcmc/hmc/ghmc/adapt_diag_e_ghmc.hpp>
+#include <stan/mcmc/hmc/ghmc/adapt_dense_e_ghmc.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+
+#include <test/test-models/good/mcmc/hmc/common/gauss.hpp>
+
+#include <boost/random/additive_combine.hpp>
+
+#include <gtest/gtest.h>
+
+typedef boost::ecuyer1988 rng_t;
+
+class McmcGhmc : public testing::Test {
+ public:
+  McmcGhmc()
+      : logger(debug, info, warn, error, fatal),
+        empty_stream("", std::fstream::in),
+        data_var_context(empty_stream),
+        model(data_var_context) {}
+
+  template <class Sampler>
+  void run(Sampler& sampler, int num_draws, double& mean, double& var) {
+    stan::mcmc::sample s(Eigen::VectorXd::Ones(1), 0, 0);
+    mean = 0;
+    var = 0;
+    for (int i = 0; i < num_draws; ++i) {
+      s = sampler.transition(s, logger);
+      mean += s.cont_params(0) / num_draws;
+      var += s.cont_params(0) * s.cont_params(0) / num_draws;
+    }
+    var -= mean * mean;
+  }
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger;
+  std::fstream empty_stream;
+  stan::io::dump data_var_context;
+  gauss_model_namespace::gauss_model model;
+};
+
+TEST_F(McmcGhmc, set_params) {
+  rng_t base_rng(0);
+  stan::mcmc::diag_e_ghmc<gauss_model_namespace::gauss_model, rng_t> sampler(
+      model, base_rng);
+
+  EXPECT_EQ(1, sampler.get_L());
+  EXPECT_FLOAT_EQ(0.9, sampler.get_momentum_persistence());
+  EXPECT_FLOAT_EQ(0.0, sampler.get_acceptance_drift());
+
+  sampler.set_nominal_stepsize_and_L(0.5, 3);
+  EXPECT_FLOAT_EQ(0.5, sampler.get_nominal_stepsize());
+  EXPECT_EQ(3, sampler.get_L());
+  sampler.set_nominal_stepsize_and_L(-0.5, 4);
+  EXPECT_FLOAT_EQ(0.5, sampler.get_nominal_stepsize());
+  EXPECT_EQ(3, sampler.get_L());
+  sampler.set_L(0);
+  EXPECT_EQ(3, sampler.get_L());
+
+  sampler.set_momentum_persistence(0.5);
+  EXPECT_FLOAT_EQ(0.5, sampler.get_momentum_persistence());
+  sampler.set_momentum_persistence(1.0);
+  EXPECT_FLOAT_EQ(0.5, sampler.get_momentum_persistence());
+
+  sampler.set_acceptance_drift(0.2);
+  EXPECT_FLOAT_EQ(0.2, sampler.get_acceptance_drift());
+  sampler.set_acceptance_drift(1.5);
+  EXPECT_FLOAT_EQ(0.2, sampler.get_acceptance_drift());
+
+  std::vector<std::string> names;
+  sampler.get_sampler_param_names(names);
+  ASSERT_EQ(3U, names.size());
+  EXPECT_EQ("stepsize__", names[0]);
+  EXPECT_EQ("int_time__", names[1]);
+  EXPECT_EQ("energy__", names[2]);
+}
+
+TEST_F(McmcGhmc, persistent_momentum) {
+  rng_t base_rng(4839294);
+  stan::mcmc::unit_e_ghmc<gauss_model_namespace::gauss_model, rng_t> sampler(
+      model, base_rng);
+  sampler.set_nominal_stepsize_and_L(0.1, 1);
+  sampler.set_momentum_persistence(0.99);
+
+  stan::mcmc::sample s(Eigen::VectorXd::Ones(1), 0, 0);
+  s = sampler.transition(s, logger);
+  double p0 = sampler.z().p(0);
+  s = sampler.transition(s, logger);
+  // with a small step size every proposal is accepted, and the
+  // momentum barely changes
+  EXPECT_GT(s.accept_stat(), 0.99);
+  EXPECT_NEAR(p0, sampler.z().p(0), 0.2);
+  EXPECT_EQ("", error.str());
+}
+
+TEST_F(McmcGhmc, unit_e_moments) {
+  rng_t base_rng(4839294);
+  stan::mcmc::unit_e_ghmc<gauss_model_namespace::gauss_model, rng_t> sampler(
+      model, base_rng);
+  sampler.set_nominal_stepsize_and_L(0.5, 1);
+  sampler.set_momentum_persistence(0.8);
+  sampler.set_acceptance_drift(0.05);
+
+  double mean, var;
+  run(sampler, 20000, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.1);
+  EXPECT_NEAR(1.0, var, 0.1);
+}
+
+TEST_F(McmcGhmc, diag_e_moments) {
+  rng_t base_rng(4839294);
+  stan::mcmc::diag_e_ghmc<gauss_model_namespace::gauss_model, rng_t> sampler(
+      model, base_rng);
+  sampler.set_metric(Eigen::VectorXd::Constant(1, 2.0));
+  sampler.set_nominal_stepsize_and_L(0.3, 2);
+  sampler.set_momentum_persistence(0.5);
+
+  double mean, var;
+  run(sampler, 20000, mean, var);
+  EXPECT_NEAR(0.0, mean, 0.1);
+  EXPECT_NEAR(1.0, var, 0.1);
+}
+
+TEST_F(McmcGhmc, adapt_dense_e_stepsize) {
+  rng_t base_rng(4839294);
+  stan::mcmc::adapt_dense_e_ghmc<gauss_model_namespace::gauss_model, rng_t>
+      sampler(model, base_rng);
+  sampler.set_nominal_stepsize(5.0);
+  sampler.get_stepsize_adaptation().set_mu(log(10 * 5.0));
+  sampler.get_stepsize_adaptation().set_delta(0.95);
+  sampler.set_window_params(1000, 75, 50, 25, logger);
+  sampler.engage_adaptation();
+
+  double mean, var;
+  run(sampler, 1000, mean, var);
+  sampler.disengage_adaptation();
+  EXPECT_LT(sampler.get_nominal_stepsize(), 5.0);
+  EXPECT_GT(sampler.get_nominal_stepsize(), 0.0);
+}
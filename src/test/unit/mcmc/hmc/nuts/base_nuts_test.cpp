@@ -373,6 +373,40 @@ TEST(McmcNutsBaseNuts, transition) {
   EXPECT_EQ("", fatal.str());
 }
 
+TEST(McmcNutsBaseNuts, transition_in_place) {
+  rng_t base_rng(0);
+
+  int model_size = 1;
+  double init_momentum = 1.5;
+
+  stan::mcmc::ps_point z_init(model_size);
+  z_init.q(0) = 0;
+  z_init.p(0) = init_momentum;
+
+  stan::mcmc::mock_model model(model_size);
+  stan::mcmc::mock_nuts sampler(model, base_rng);
+
+  sampler.set_nominal_stepsize(1);
+  sampler.set_stepsize_jitter(0);
+  sampler.sample_stepsize();
+  sampler.z() = z_init;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::mcmc::sample s(z_init.q, 0, 0);
+  sampler.transition_in_place(s, logger);
+
+  // Same result as transition, with the sampler's state left at the
+  // new point
+  EXPECT_EQ(sampler.get_max_depth(), sampler.depth_);
+  EXPECT_EQ(21 * init_momentum, s.cont_params()(0));
+  EXPECT_EQ(21 * init_momentum, sampler.z().q(0));
+  EXPECT_EQ(0, s.log_prob());
+  EXPECT_EQ(1, s.accept_stat());
+  EXPECT_EQ("", error.str());
+}
+
 TEST(McmcNutsBaseNuts, transition_egde_momenta) {
   rng_t base_rng(0);
 
@@ -0,0 +1,73 @@
+#include <stan/mcmc/smc/adaptive_tempering.hpp>
+#include <stan/mcmc/smc/systematic_resample.hpp>
+#include <stan/mcmc/smc/tempered_model.hpp>
+#include <stan/io/dump.hpp>
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+TEST(McmcSmc, tempering_ess) {
+  Eigen::VectorXd log_ratio(4);
+  log_ratio << 0, -1, -2, -3;
+  EXPECT_FLOAT_EQ(4, stan::mcmc::tempering_ess(log_ratio, 0));
+
+  Eigen::VectorXd w = (0.5 * log_ratio).array().exp().matrix();
+  double expected = w.sum() * w.sum() / w.squaredNorm();
+  EXPECT_FLOAT_EQ(expected, stan::mcmc::tempering_ess(log_ratio, 0.5));
+}
+
+TEST(McmcSmc, next_temperature) {
+  Eigen::VectorXd log_ratio(100);
+  for (int k = 0; k < 100; ++k)
+    log_ratio(k) = -0.5 * k;
+
+  double beta = stan::mcmc::next_temperature(log_ratio, 0.2, 0.5);
+  EXPECT_GT(beta, 0.2);
+  EXPECT_LT(beta, 1);
+  EXPECT_NEAR(50, stan::mcmc::tempering_ess(log_ratio, beta - 0.2), 1e-6);
+
+  Eigen::VectorXd flat = Eigen::VectorXd::Constant(100, -3);
+  EXPECT_EQ(1, stan::mcmc::next_temperature(flat, 0.2, 0.5));
+}
+
+TEST(McmcSmc, systematic_resample) {
+  Eigen::VectorXd weights(4);
+  weights << 0.5, 0, 0.25, 0.25;
+  std::vector<int> ancestors = stan::mcmc::systematic_resample(weights, 0.5);
+  std::vector<int> expected = {0, 0, 2, 3};
+  EXPECT_EQ(expected, ancestors);
+
+  std::vector<int> counts(4, 0);
+  for (int k : stan::mcmc::systematic_resample(weights, 0.999))
+    ++counts[k];
+  EXPECT_EQ(2, counts[0]);
+  EXPECT_EQ(0, counts[1]);
+  EXPECT_EQ(1, counts[2]);
+  EXPECT_EQ(1, counts[3]);
+}
+
+TEST(McmcSmc, tempered_model) {
+  std::fstream empty_stream("", std::fstream::in);
+  stan::io::dump data_var_context(empty_stream);
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+  stan::mcmc::tempered_model<gauss3D_model_namespace::gauss3D_model> tempered(
+      model, 2);
+  EXPECT_EQ(3, tempered.num_params_r());
+
+  Eigen::VectorXd q(3);
+  q << 1, -2, 0.5;
+  double lp = model.log_prob<true, true>(q, 0);
+  double lp_ref
+      = -0.5 * q.squaredNorm() / 4 - 3 * std::log(2 * std::sqrt(2 * M_PI));
+  EXPECT_FLOAT_EQ(lp_ref, tempered.log_reference(q));
+  EXPECT_FLOAT_EQ(lp_ref, (tempered.log_prob<true, true, double>(q, 0)));
+
+  tempered.set_beta(0.25);
+  EXPECT_FLOAT_EQ(0.25 * lp + 0.75 * lp_ref,
+                  (tempered.log_prob<true, true, double>(q, 0)));
+
+  tempered.set_beta(1);
+  EXPECT_FLOAT_EQ(lp, (tempered.log_prob<true, true, double>(q, 0)));
+}
@@ -141,3 +141,22 @@ TEST(McmcStepsizeAdaptation, learn_stepsize_3) {
   EXPECT_NEAR(0.75, adaptation.kappa(), 1e-14);
   EXPECT_NEAR(10, adaptation.t0(), 1e-14);
 }
+
+TEST(McmcStepsizeAdaptation, transfer_state) {
+  exposed_adaptation from(79, 0.0206811620891896, 0.825842987938587,
+                          4.13018305456267, 0.5, 0.05, 0.75, 10);
+  double state[stan::mcmc::stepsize_adaptation::state_size];
+  from.get_state(state);
+
+  exposed_adaptation to(0, 0, 0, 1, 0.5, 0.05, 0.75, 10);
+  to.set_state(state);
+  EXPECT_EQ(from.counter(), to.counter());
+  EXPECT_EQ(from.s_bar(), to.s_bar());
+  EXPECT_EQ(from.x_bar(), to.x_bar());
+  EXPECT_EQ(from.mu(), to.mu());
+
+  double eps_from = 1.5, eps_to = 1.5;
+  from.learn_stepsize(eps_from, 0.7);
+  to.learn_stepsize(eps_to, 0.7);
+  EXPECT_EQ(eps_from, eps_to);
+}
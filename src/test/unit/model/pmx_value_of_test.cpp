@@ -0,0 +1,56 @@
+#include <stan/model/pmx_value_of.hpp>
+#include <gtest/gtest.h>
+#include <type_traits>
+#include <vector>
+
+namespace {
+// signature of a solver overload that expects data-only arguments
+double sum_data(const std::vector<std::vector<double> >& x) {
+  double s = 0;
+  for (const std::vector<double>& row : x)
+    for (double v : row)
+      s += v;
+  return s;
+}
+}  // namespace
+
+TEST(ModelUtil, pmx_value_of_nested_var_array) {
+  using stan::math::var;
+  std::vector<std::vector<var> > x{{1.0, 2.0}, {3.0, 4.0}};
+
+  auto y = stan::model::pmx_value_of(x);
+  EXPECT_TRUE((std::is_same<std::vector<std::vector<double> >,
+                            decltype(y)>::value));
+  ASSERT_EQ(2, y.size());
+  EXPECT_FLOAT_EQ(2.0, y[0][1]);
+  EXPECT_FLOAT_EQ(3.0, y[1][0]);
+  EXPECT_FLOAT_EQ(10.0, sum_data(stan::model::pmx_value_of(x)));
+}
+
+TEST(ModelUtil, pmx_value_of_double_is_not_copied) {
+  std::vector<double> x{1.0, 2.0};
+  std::vector<std::vector<double> > xx{x, x};
+  Eigen::VectorXd v(2);
+  v << 1.0, 2.0;
+
+  EXPECT_EQ(&x, &stan::model::pmx_value_of(x));
+  EXPECT_EQ(&xx, &stan::model::pmx_value_of(xx));
+  EXPECT_EQ(&v, &stan::model::pmx_value_of(v));
+  EXPECT_FLOAT_EQ(6.0, sum_data(stan::model::pmx_value_of(xx)));
+}
+
+TEST(ModelUtil, pmx_value_of_scalar_and_matrix) {
+  using stan::math::var;
+  var a = 1.5;
+  EXPECT_FLOAT_EQ(1.5, stan::model::pmx_value_of(a));
+
+  Eigen::Matrix<var, -1, 1> v(2);
+  v << 1.0, 2.0;
+  Eigen::VectorXd w = stan::model::pmx_value_of(v);
+  EXPECT_FLOAT_EQ(2.0, w(1));
+
+  std::vector<std::vector<std::vector<var> > > x3{{{1.0}, {2.0}}};
+  std::vector<std::vector<std::vector<double> > > y3
+      = stan::model::pmx_value_of(x3);
+  EXPECT_FLOAT_EQ(2.0, y3[0][1][0]);
+}
@@ -0,0 +1,161 @@
+#define TORSTEN_SOLUTION_CACHE
+#include <stan/model/solution_cache.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+struct counting_solver {
+  int& calls;
+  explicit counting_solver(int& n) : calls(n) {}
+
+  template <typename T>
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> operator()(
+      const std::vector<T>& theta, const int& nCmt) const {
+    ++calls;
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> x(nCmt, theta.size());
+    for (int j = 0; j < x.cols(); ++j) {
+      for (int i = 0; i < nCmt; ++i) {
+        x(i, j) = theta[j] * (i + 1);
+      }
+    }
+    return x;
+  }
+};
+
+// ODE system functors of two models that both name their system "ode"
+struct ode_functor__ {};
+struct other_model_ode_functor__ {};
+}  // namespace
+
+TEST(ModelUtil, solution_cache_reuses_var_solution) {
+  using stan::math::var;
+  stan::model::solution_cache::instance().clear();
+  stan::model::solution_cache::instance().enable_site("ode");
+  int calls = 0;
+  counting_solver solve(calls);
+
+  std::vector<var> theta_v{1.5, 2.5};
+  Eigen::Matrix<var, -1, -1> x_v
+      = stan::model::cached_solve<ode_functor__>("site(ode)", false, solve,
+                                                 theta_v, 2);
+  EXPECT_EQ(1, calls);
+
+  std::vector<double> theta{1.5, 2.5};
+  Eigen::MatrixXd x
+      = stan::model::cached_solve<ode_functor__>("site(ode)", false, solve,
+                                                 theta, 2);
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(1U, stan::model::solution_cache::instance().hits());
+  for (int i = 0; i < x.size(); ++i) {
+    EXPECT_FLOAT_EQ(x_v(i).val(), x(i));
+  }
+  stan::math::recover_memory();
+}
+
+TEST(ModelUtil, solution_cache_misses_on_different_inputs) {
+  stan::model::solution_cache::instance().clear();
+  stan::model::solution_cache::instance().enable_site("ode");
+  int calls = 0;
+  counting_solver solve(calls);
+
+  std::vector<double> theta{1.5, 2.5};
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  stan::model::cached_solve<ode_functor__>("other(ode)", false, solve, theta,
+                                           2);
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           3);
+  theta[1] = 2.500001;
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  EXPECT_EQ(4, calls);
+  EXPECT_EQ(0U, stan::model::solution_cache::instance().hits());
+
+  theta[1] = 2.5;
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  EXPECT_EQ(4, calls);
+}
+
+TEST(ModelUtil, solution_cache_evicts_oldest) {
+  stan::model::solution_cache cache(10 * sizeof(double) + 4,
+                                    10 * sizeof(double) + 4);
+  std::vector<double> key{1.0, 2.0};
+  Eigen::MatrixXd sol = Eigen::MatrixXd::Ones(2, 2);
+  cache.insert("site", std::vector<double>(key), sol);
+  EXPECT_EQ(1U, cache.size());
+
+  key[0] = 3.0;
+  cache.insert("site", std::vector<double>(key), sol);
+  EXPECT_EQ(1U, cache.size());
+
+  Eigen::MatrixXd found;
+  EXPECT_TRUE(cache.find("site", key, found));
+  key[0] = 1.0;
+  EXPECT_FALSE(cache.find("site", key, found));
+}
+
+TEST(ModelUtil, solution_cache_is_opt_in_per_site) {
+  stan::model::solution_cache& cache = stan::model::solution_cache::instance();
+  cache.clear();
+  cache.disable_site("ode");
+  int calls = 0;
+  counting_solver solve(calls);
+
+  std::vector<double> theta{1.5, 2.5};
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  EXPECT_EQ(2, calls);
+  EXPECT_EQ(0U, cache.size());
+
+  cache.enable_site("site(ode)");
+  EXPECT_TRUE(cache.enabled("site(ode)"));
+  EXPECT_FALSE(cache.enabled("other(ode)"));
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  EXPECT_EQ(3, calls);
+  cache.disable_site("site(ode)");
+}
+
+TEST(ModelUtil, solution_cache_separates_models) {
+  stan::model::solution_cache& cache = stan::model::solution_cache::instance();
+  cache.clear();
+  cache.enable_site("ode");
+  int calls = 0;
+  counting_solver solve(calls);
+
+  std::vector<double> theta{1.5, 2.5};
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve, theta,
+                                           2);
+  stan::model::cached_solve<other_model_ode_functor__>("site(ode)", false,
+                                                       solve, theta, 2);
+  EXPECT_EQ(2, calls);
+  EXPECT_EQ(0U, cache.hits());
+  cache.disable_site("ode");
+}
+
+TEST(ModelUtil, solution_cache_skips_large_var_solution) {
+  using stan::math::var;
+  stan::model::solution_cache& cache = stan::model::solution_cache::instance();
+  cache.clear();
+  cache.enable_site("ode");
+  cache.set_max_bytes(16 * 4 * sizeof(double));
+  int calls = 0;
+  counting_solver solve(calls);
+
+  // 2 x 2 solution fits the per-entry limit of 4 values, 3 x 2 does not
+  std::vector<var> theta_v{1.5, 2.5};
+  EXPECT_TRUE(cache.fits(4));
+  EXPECT_FALSE(cache.fits(6));
+  stan::model::cached_solve<ode_functor__>("site(ode)", false, solve,
+                                           theta_v, 3);
+  EXPECT_EQ(0U, cache.size());
+
+  cache.set_max_bytes(64 * 1024 * 1024);
+  cache.disable_site("ode");
+  stan::math::recover_memory();
+}
@@ -0,0 +1,121 @@
+#include <stan/model/sparse_hessian.hpp>
+#include <stan/model/hessian.hpp>
+#include <test/test-models/good/model/block_sparse.hpp>
+#include <gtest/gtest.h>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// dense symmetric matrix with random entries on the pattern
+Eigen::MatrixXd random_hessian(const stan::model::hessian_sparsity& sparsity,
+                               boost::ecuyer1988& rng) {
+  boost::random::uniform_real_distribution<double> unif(-1, 1);
+  int d = sparsity.dimension();
+  Eigen::MatrixXd H = Eigen::MatrixXd::Zero(d, d);
+  for (int i = 0; i < d; ++i) {
+    H(i, i) = unif(rng);
+    for (int j : sparsity.neighbors(i))
+      if (j < i)
+        H(i, j) = H(j, i) = unif(rng);
+  }
+  return H;
+}
+
+void expect_recovery(const stan::model::hessian_sparsity& sparsity,
+                     boost::ecuyer1988& rng) {
+  Eigen::MatrixXd H = random_hessian(sparsity, rng);
+  Eigen::MatrixXd compressed(sparsity.dimension(), sparsity.num_colors());
+  for (int c = 0; c < sparsity.num_colors(); ++c)
+    compressed.col(c) = H * sparsity.seed(c);
+  Eigen::SparseMatrix<double> H_sparse;
+  sparsity.recover(compressed, H_sparse);
+  EXPECT_EQ(sparsity.num_nonzeros(), H_sparse.nonZeros());
+  EXPECT_TRUE(H.isApprox(Eigen::MatrixXd(H_sparse)));
+}
+
+}  // namespace
+
+TEST(ModelUtil, hessian_sparsity_arrowhead) {
+  // 2 population parameters, 50 subjects with 3 parameters each
+  int p = 2;
+  int K = 50;
+  int s = 3;
+  int d = p + K * s;
+  std::vector<std::pair<int, int> > nonzeros;
+  nonzeros.emplace_back(0, 1);
+  for (int k = 0; k < K; ++k) {
+    for (int i = 0; i < s; ++i) {
+      int n = p + k * s + i;
+      for (int j = 0; j < p; ++j)
+        nonzeros.emplace_back(n, j);
+      for (int j = 0; j < i; ++j)
+        nonzeros.emplace_back(n, p + k * s + j);
+    }
+  }
+  stan::model::hessian_sparsity sparsity(d, nonzeros);
+  EXPECT_EQ(d, sparsity.dimension());
+  EXPECT_EQ(p + s, sparsity.num_colors());
+
+  boost::ecuyer1988 rng(1234);
+  expect_recovery(sparsity, rng);
+}
+
+TEST(ModelUtil, hessian_sparsity_random) {
+  boost::ecuyer1988 rng(1234);
+  boost::random::uniform_real_distribution<double> unif(0, 1);
+  for (double density : {0.0, 0.05, 0.2, 1.0}) {
+    int d = 40;
+    std::vector<std::pair<int, int> > nonzeros;
+    for (int i = 0; i < d; ++i)
+      for (int j = 0; j < i; ++j)
+        if (unif(rng) < density)
+          nonzeros.emplace_back(i, j);
+    stan::model::hessian_sparsity sparsity(d, nonzeros);
+    EXPECT_LE(sparsity.num_colors(), d);
+    expect_recovery(sparsity, rng);
+  }
+
+  std::vector<std::pair<int, int> > bad(1, std::make_pair(0, 3));
+  EXPECT_THROW(stan::model::hessian_sparsity(3, bad), std::invalid_argument);
+}
+
+TEST(ModelUtil, sparse_grad_hess_log_prob) {
+  std::fstream data_stream(std::string("").c_str(), std::fstream::in);
+  stan::io::dump data_var_context(data_stream);
+  data_stream.close();
+  block_sparse_model_namespace::block_sparse_model model(data_var_context);
+
+  int d = model.num_params_r();
+  Eigen::VectorXd x(d);
+  for (int i = 0; i < d; ++i)
+    x(i) = 0.1 * (i + 1);
+
+  stan::model::hessian_sparsity sparsity
+      = stan::model::detect_hessian_sparsity<true, true>(model, x);
+  EXPECT_EQ(4, sparsity.num_colors());
+  // diagonal, mu-tau, and a_k with mu, tau, b_k, b_k with tau
+  EXPECT_EQ(d + 2 * (1 + 5 * 4), sparsity.num_nonzeros());
+
+  Eigen::VectorXd y = x.array() - 0.3;
+  double f;
+  Eigen::VectorXd grad;
+  Eigen::MatrixXd H;
+  stan::model::hessian(model, y, f, grad, H);
+
+  double f_sparse;
+  Eigen::VectorXd grad_sparse;
+  Eigen::SparseMatrix<double> H_sparse;
+  f_sparse = stan::model::sparse_grad_hess_log_prob<true, true>(
+      model, sparsity, y, grad_sparse, H_sparse);
+
+  EXPECT_FLOAT_EQ(f, f_sparse);
+  for (int i = 0; i < d; ++i) {
+    EXPECT_FLOAT_EQ(grad(i), grad_sparse(i));
+    for (int j = 0; j < d; ++j)
+      EXPECT_NEAR(H(i, j), H_sparse.coeff(i, j), 1e-8);
+  }
+}
@@ -0,0 +1,194 @@
+#include <stan/model/transformed_data_cache.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class ModelTransformedDataCache : public testing::Test {
+ public:
+  ModelTransformedDataCache()
+      : names_r({"y"}),
+        vals_r({1.5, 2.5, 3.5}),
+        dims_r({{3}}),
+        names_i({"N"}),
+        vals_i({3}),
+        dims_i({{}}),
+        program_hash("0123456789abcdef"),
+        compile_info({"stanc_version = test"}) {}
+
+  void TearDown() {
+    for (const std::string& f : files)
+      std::remove(f.c_str());
+  }
+
+  stan::model::transformed_data_cache make_cache(unsigned int seed = 0) {
+    stan::io::array_var_context context(names_r, vals_r, dims_r, names_i,
+                                        vals_i, dims_i);
+    stan::model::transformed_data_cache cache("test_model", program_hash,
+                                              compile_info, context, seed,
+                                              ".");
+    files.push_back(cache.file_name());
+    return cache;
+  }
+
+  std::vector<std::string> names_r;
+  std::vector<double> vals_r;
+  std::vector<std::vector<size_t>> dims_r;
+  std::vector<std::string> names_i;
+  std::vector<int> vals_i;
+  std::vector<std::vector<size_t>> dims_i;
+  std::string program_hash;
+  std::vector<std::string> compile_info;
+  std::vector<std::string> files;
+};
+
+TEST_F(ModelTransformedDataCache, disabled) {
+  stan::io::array_var_context context(names_r, vals_r, dims_r, names_i,
+                                      vals_i, dims_i);
+  stan::model::transformed_data_cache cache("test_model", program_hash,
+                                            compile_info, context, 0, "");
+  EXPECT_FALSE(cache.enabled());
+  cache.store(1.0);
+  double x;
+  EXPECT_FALSE(cache.load(x));
+}
+
+TEST_F(ModelTransformedDataCache, round_trip) {
+  Eigen::MatrixXd m(2, 3);
+  m << 1, 2, 3, 4, 5, 6;
+  std::vector<int> idx{4, 5, 6};
+  double s = 0.25;
+
+  stan::model::transformed_data_cache cache = make_cache();
+  ASSERT_TRUE(cache.enabled());
+  Eigen::MatrixXd m_in;
+  std::vector<int> idx_in;
+  double s_in;
+  EXPECT_FALSE(cache.load(m_in, idx_in, s_in));
+  cache.store(m, idx, s);
+
+  stan::model::transformed_data_cache cache2 = make_cache();
+  EXPECT_EQ(cache.file_name(), cache2.file_name());
+  ASSERT_TRUE(cache2.load(m_in, idx_in, s_in));
+  EXPECT_EQ(2, m_in.rows());
+  EXPECT_EQ(3, m_in.cols());
+  for (int i = 0; i < m.size(); ++i)
+    EXPECT_EQ(m(i), m_in(i));
+  EXPECT_EQ(idx, idx_in);
+  EXPECT_EQ(s, s_in);
+
+  // a different number of members does not match
+  EXPECT_FALSE(cache2.load(m_in, idx_in));
+}
+
+TEST_F(ModelTransformedDataCache, round_trip_nested) {
+  std::vector<Eigen::VectorXd> v(2, Eigen::VectorXd(1000));
+  for (int i = 0; i < 1000; ++i) {
+    v[0](i) = i;
+    v[1](i) = -0.5 * i;
+  }
+  std::vector<std::vector<Eigen::MatrixXd>> w(
+      2, std::vector<Eigen::MatrixXd>(3, Eigen::MatrixXd(2, 4)));
+  for (size_t i = 0; i < w.size(); ++i)
+    for (size_t j = 0; j < w[i].size(); ++j)
+      for (int k = 0; k < w[i][j].size(); ++k)
+        w[i][j](k) = 100 * i + 10 * j + k;
+
+  stan::model::transformed_data_cache cache = make_cache();
+  cache.store(v, w);
+
+  // the values are written, not the Eigen storage
+  std::ifstream in(cache.file_name().c_str(),
+                   std::ios::binary | std::ios::ate);
+  EXPECT_GT(static_cast<int>(in.tellg()), 2000 * 8);
+  in.close();
+
+  std::vector<Eigen::VectorXd> v_in;
+  std::vector<std::vector<Eigen::MatrixXd>> w_in;
+  ASSERT_TRUE(make_cache().load(v_in, w_in));
+  ASSERT_EQ(v.size(), v_in.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    ASSERT_EQ(v[i].size(), v_in[i].size());
+    for (int k = 0; k < v[i].size(); ++k)
+      EXPECT_EQ(v[i](k), v_in[i](k));
+  }
+  ASSERT_EQ(w.size(), w_in.size());
+  for (size_t i = 0; i < w.size(); ++i) {
+    ASSERT_EQ(w[i].size(), w_in[i].size());
+    for (size_t j = 0; j < w[i].size(); ++j) {
+      ASSERT_EQ(2, w_in[i][j].rows());
+      ASSERT_EQ(4, w_in[i][j].cols());
+      for (int k = 0; k < w[i][j].size(); ++k)
+        EXPECT_EQ(w[i][j](k), w_in[i][j](k));
+    }
+  }
+}
+
+TEST_F(ModelTransformedDataCache, invalidation) {
+  stan::model::transformed_data_cache cache = make_cache();
+  cache.store(1.0);
+
+  EXPECT_NE(cache.hash(), make_cache(1).hash());
+
+  vals_r[1] = 2.75;
+  EXPECT_NE(cache.hash(), make_cache().hash());
+  vals_r[1] = 2.5;
+
+  program_hash = "fedcba9876543210";
+  stan::model::transformed_data_cache edited = make_cache();
+  EXPECT_NE(cache.hash(), edited.hash());
+  double y;
+  EXPECT_FALSE(edited.load(y));
+  program_hash = "0123456789abcdef";
+
+  compile_info.push_back("stanc_flags = --O");
+  stan::model::transformed_data_cache cache2 = make_cache();
+  EXPECT_NE(cache.hash(), cache2.hash());
+  double x;
+  EXPECT_FALSE(cache2.load(x));
+}
+
+TEST_F(ModelTransformedDataCache, corrupted_file) {
+  stan::model::transformed_data_cache cache = make_cache();
+  std::vector<double> v(10, 1.0);
+  cache.store(v);
+
+  std::ifstream in(cache.file_name().c_str(), std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  in.close();
+  std::ofstream out(cache.file_name().c_str(),
+                    std::ios::binary | std::ios::trunc);
+  out << contents.substr(0, contents.size() - 4);
+  out.close();
+
+  std::vector<double> v_in;
+  EXPECT_FALSE(cache.load(v_in));
+  cache.store(v);
+  EXPECT_TRUE(cache.load(v_in));
+  EXPECT_EQ(v, v_in);
+}
+
+TEST_F(ModelTransformedDataCache, no_temporary_files_left) {
+  stan::model::transformed_data_cache cache = make_cache();
+  cache.store(1.0);
+  cache.store(2.0);
+  double x;
+  EXPECT_TRUE(cache.load(x));
+  EXPECT_EQ(2.0, x);
+
+  std::string tmp_prefix = cache.file_name().substr(2) + ".tmp";
+  DIR* dir = opendir(".");
+  ASSERT_TRUE(dir != nullptr);
+  int num_tmp = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    if (std::string(entry->d_name).compare(0, tmp_prefix.size(), tmp_prefix)
+        == 0)
+      ++num_tmp;
+  }
+  closedir(dir);
+  EXPECT_EQ(0, num_tmp);
+}
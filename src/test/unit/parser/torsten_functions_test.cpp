@@ -154,6 +154,21 @@ TEST(lang_parser, pmx_solve_group) {
   test_throws("torsten/pmx_solve_group/rk45_var_rtol"   , "15th argument to pmx_solve_group_rk45 for relative tolerance must be data only");
 }
 
+/*****************************************************************
+ event solvers with mixed data/parameter arguments
+ ****************************************************************/
+TEST(lang_parser, pmx_solve_data_args) {
+  test_parsable("torsten/pmx_solve_data_args");
+}
+
+TEST(lang_parser, pmx_solve_nested_data_args) {
+  test_parsable("torsten/pmx_solve_nested_data_args");
+  expect_match("torsten/pmx_solve_nested_data_args",
+               "stan::model::pmx_value_of(biovar_data)");
+  expect_match("torsten/pmx_solve_nested_data_args",
+               "stan::model::pmx_value_of(tlag_group)");
+}
+
 /*****************************************************************
  pmx_solve_onecpt
  ****************************************************************/
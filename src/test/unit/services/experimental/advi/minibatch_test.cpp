@@ -0,0 +1,102 @@
+#include <stan/services/experimental/advi/meanfield.hpp>
+#include <stan/services/experimental/advi/fullrank.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/unit/variational/minibatch_normal_model.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <vector>
+
+class ServicesExperimentalAdviMinibatch : public testing::Test {
+ public:
+  ServicesExperimentalAdviMinibatch()
+      : N(1000),
+        batch_size(50),
+        model(N),
+        seed(0),
+        chain(1),
+        init_radius(0),
+        grad_samples(1),
+        elbo_samples(100),
+        max_iterations(10000),
+        tol_rel_obj(0.001),
+        eta(0.1),
+        adapt_engaged(false),
+        adapt_iterations(50),
+        eval_elbo(100),
+        output_samples(1000) {}
+
+  // the approximate posterior mean is written in the first row of
+  // draws, after lp__, log_p__ and log_g__
+  void check_output() {
+    std::vector<std::vector<std::string> > names
+        = parameter.vector_string_values();
+    ASSERT_EQ(1, names.size());
+    ASSERT_EQ(5, names[0].size());
+    EXPECT_EQ("mu", names[0][3]);
+    EXPECT_EQ("sigma", names[0][4]);
+
+    std::vector<std::vector<double> > values
+        = parameter.vector_double_values();
+    ASSERT_EQ(output_samples + 1, values.size());
+    // y[n] = n % 10: mean 4.5 and sd 2.87
+    EXPECT_NEAR(4.5, values[0][3], 0.2);
+    EXPECT_NEAR(2.87, values[0][4], 0.2);
+
+    EXPECT_EQ(batch_size, model.max_batch_size());
+    // full data are restored before the approximation is written
+    EXPECT_FLOAT_EQ(1.0, model.weight());
+    EXPECT_GE(logger.find_info("CONVERGED"), 1);
+    EXPECT_EQ(0, logger.call_count_error());
+  }
+
+  int N;
+  int batch_size;
+  stan::test::unit::minibatch_normal_model model;
+  stan::test::unit::instrumented_writer init, parameter, diagnostic;
+  stan::test::unit::instrumented_logger logger;
+  stan::io::empty_var_context context;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  unsigned int seed;
+  unsigned int chain;
+  double init_radius;
+  int grad_samples;
+  int elbo_samples;
+  int max_iterations;
+  double tol_rel_obj;
+  double eta;
+  bool adapt_engaged;
+  int adapt_iterations;
+  int eval_elbo;
+  int output_samples;
+};
+
+TEST_F(ServicesExperimentalAdviMinibatch, meanfield) {
+  int return_code = stan::services::experimental::advi::meanfield(
+      model, context, seed, chain, init_radius, grad_samples, elbo_samples,
+      max_iterations, tol_rel_obj, eta, adapt_engaged, adapt_iterations,
+      eval_elbo, output_samples, N, batch_size, interrupt, logger, init,
+      parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output();
+}
+
+TEST_F(ServicesExperimentalAdviMinibatch, fullrank) {
+  int return_code = stan::services::experimental::advi::fullrank(
+      model, context, seed, chain, init_radius, grad_samples, elbo_samples,
+      max_iterations, tol_rel_obj, eta, adapt_engaged, adapt_iterations,
+      eval_elbo, output_samples, N, batch_size, interrupt, logger, init,
+      parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output();
+}
+
+TEST_F(ServicesExperimentalAdviMinibatch, misconfigured) {
+  int return_code = stan::services::experimental::advi::meanfield(
+      model, context, seed, chain, init_radius, grad_samples, elbo_samples,
+      max_iterations, tol_rel_obj, eta, adapt_engaged, adapt_iterations,
+      eval_elbo, output_samples, N, N + 1, interrupt, logger, init,
+      parameter, diagnostic);
+  EXPECT_EQ(stan::services::error_codes::CONFIG, return_code);
+  EXPECT_EQ(1, logger.call_count_error());
+}
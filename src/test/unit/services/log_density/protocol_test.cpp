@@ -0,0 +1,80 @@
+#include <stan/services/log_density/protocol.hpp>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdint>
+#include <vector>
+
+using stan::services::log_density::protocol_magic;
+using stan::services::log_density::read_request;
+using stan::services::log_density::request;
+using stan::services::log_density::request_header;
+using stan::services::log_density::request_type;
+
+class ServicesLogDensityProtocol : public testing::Test {
+ public:
+  void SetUp() { ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fd)); }
+
+  void TearDown() {
+    ::close(fd[0]);
+    ::close(fd[1]);
+  }
+
+  /*
+   * Send a request header and the doubles it announces, or none if
+   * there are too many.
+   */
+  void send_header(std::uint32_t batch_size, std::uint32_t width) {
+    request_header h = {protocol_magic, request_type::log_density, 0, 0,
+                        batch_size, width, 0};
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(h)),
+              ::send(fd[0], &h, sizeof(h), 0));
+    std::uint64_t num_values = static_cast<std::uint64_t>(batch_size) * width;
+    if (num_values <= 1024) {
+      std::vector<double> values(num_values, 1.0);
+      ASSERT_EQ(static_cast<ssize_t>(values.size() * sizeof(double)),
+                ::send(fd[0], values.data(), values.size() * sizeof(double),
+                       0));
+    }
+  }
+
+  int fd[2];
+};
+
+TEST_F(ServicesLogDensityProtocol, read_request) {
+  send_header(3, 2);
+  request r;
+  ASSERT_TRUE(read_request(fd[1], r));
+  EXPECT_EQ(request_type::log_density, r.type);
+  EXPECT_EQ(3, r.batch_size);
+  EXPECT_EQ(2, r.width);
+  EXPECT_EQ(6U, r.values.size());
+}
+
+TEST_F(ServicesLogDensityProtocol, batch_size_without_width) {
+  request r;
+  send_header(3, 0);
+  ASSERT_TRUE(read_request(fd[1], r));
+  EXPECT_EQ(3, r.batch_size);
+  EXPECT_EQ(0U, r.values.size());
+
+  // a zero width does not lift the limit on the number of items
+  send_header(0xFFFFFFFF, 0);
+  EXPECT_FALSE(read_request(fd[1], r));
+  send_header((1 << 20) + 1, 0);
+  EXPECT_FALSE(read_request(fd[1], r));
+  send_header(11, 0);
+  EXPECT_FALSE(read_request(fd[1], r, 1 << 27, 10));
+}
+
+TEST_F(ServicesLogDensityProtocol, width_without_batch_size) {
+  request r;
+  send_header(0, 0x80000000);
+  EXPECT_FALSE(read_request(fd[1], r));
+}
+
+TEST_F(ServicesLogDensityProtocol, batch_size_above_int_max) {
+  request r;
+  send_header(0x80000000, 0);
+  EXPECT_FALSE(read_request(fd[1], r, 1 << 27, 0xFFFFFFFF));
+}
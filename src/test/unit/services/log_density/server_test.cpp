@@ -0,0 +1,235 @@
+#include <stan/services/log_density/server.hpp>
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/services/test_lp.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using stan::services::log_density::request;
+using stan::services::log_density::request_flags;
+using stan::services::log_density::request_type;
+using stan::services::log_density::response;
+using stan::services::log_density::response_status;
+
+class ServicesLogDensityServer : public testing::Test {
+ public:
+  ServicesLogDensityServer()
+      : model(context, 0, &model_ss), server(model, 2) {}
+
+  request make_request(int type, int flags, int batch_size, int width) {
+    request r;
+    r.type = type;
+    r.flags = flags;
+    r.batch_size = batch_size;
+    r.width = width;
+    r.values.assign(batch_size * width, 0);
+    return r;
+  }
+
+  stan::io::empty_var_context context;
+  std::stringstream model_ss;
+  stan_model model;
+  stan::services::log_density::log_density_server<stan_model> server;
+};
+
+// test_lp: y ~ normal(0, 1) with y in (-10, 10), so at the
+// unconstrained origin y = 0, the log Jacobian is 2 * log(5), the
+// gradient is zero and the Hessian is -25.5 times the identity
+TEST_F(ServicesLogDensityServer, describe) {
+  response result = server.evaluate(
+      make_request(request_type::describe,
+                   request_flags::include_tparams | request_flags::include_gqs,
+                   0, 0));
+  EXPECT_EQ(response_status::ok, result.status);
+  EXPECT_EQ("test_lp_model\ny.1,y.2\ny.1,y.2,z.1,z.2,xgq", result.text);
+}
+
+TEST_F(ServicesLogDensityServer, log_density) {
+  request r = make_request(request_type::log_density,
+                           request_flags::propto | request_flags::jacobian, 2,
+                           2);
+  r.values[2] = 1;
+  response result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  ASSERT_EQ(2, result.batch_size);
+  ASSERT_EQ(1, result.width);
+  EXPECT_FLOAT_EQ(2 * std::log(5.0), result.values[0]);
+  EXPECT_LT(result.values[1], result.values[0]);
+
+  r.flags = request_flags::jacobian;
+  result = server.evaluate(r);
+  EXPECT_FLOAT_EQ(2 * std::log(5.0) - std::log(2 * M_PI), result.values[0]);
+
+  r.flags = request_flags::propto;
+  result = server.evaluate(r);
+  EXPECT_NEAR(0, result.values[0], 1e-8);
+}
+
+TEST_F(ServicesLogDensityServer, gradient_and_hessian_vector) {
+  request r = make_request(request_type::gradient, request_flags::jacobian,
+                           3, 2);
+  response result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  ASSERT_EQ(3, result.width);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(2 * std::log(5.0) - std::log(2 * M_PI),
+                    result.values[3 * i]);
+    EXPECT_NEAR(0, result.values[3 * i + 1], 1e-6);
+    EXPECT_NEAR(0, result.values[3 * i + 2], 1e-6);
+  }
+
+  r = make_request(request_type::hessian_vector, request_flags::jacobian, 1,
+                   4);
+  r.values[2] = 1;
+  result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  ASSERT_EQ(3, result.width);
+  EXPECT_NEAR(-25.5, result.values[1], 1e-4);
+  EXPECT_NEAR(0, result.values[2], 1e-4);
+}
+
+TEST_F(ServicesLogDensityServer, constrain_unconstrain) {
+  request r = make_request(
+      request_type::constrain,
+      request_flags::include_tparams | request_flags::include_gqs, 1, 2);
+  r.values[1] = std::log(3.0);
+  response result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  ASSERT_EQ(5, result.width);
+  EXPECT_NEAR(0, result.values[0], 1e-12);
+  EXPECT_FLOAT_EQ(5, result.values[1]);
+  EXPECT_FLOAT_EQ(1, result.values[2]);
+  EXPECT_FLOAT_EQ(std::exp(5.0), result.values[3]);
+  EXPECT_FLOAT_EQ(0.007, result.values[4]);
+
+  r = make_request(request_type::constrain, 0, 1, 2);
+  EXPECT_EQ(2, server.evaluate(r).width);
+
+  r = make_request(request_type::unconstrain, 0, 1, 2);
+  r.values[1] = 5;
+  result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  ASSERT_EQ(2, result.width);
+  EXPECT_NEAR(0, result.values[0], 1e-12);
+  EXPECT_FLOAT_EQ(std::log(3.0), result.values[1]);
+}
+
+TEST_F(ServicesLogDensityServer, errors) {
+  response result
+      = server.evaluate(make_request(request_type::gradient, 0, 1, 3));
+  EXPECT_EQ(response_status::error, result.status);
+  EXPECT_EQ("Expected items of 2 values, found 3", result.text);
+
+  request r = make_request(request_type::gradient, 0, 2, 2);
+  r.values[3] = std::numeric_limits<double>::quiet_NaN();
+  result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  EXPECT_EQ(response_status::ok, result.item_status[0]);
+  EXPECT_EQ(response_status::error, result.item_status[1]);
+  EXPECT_FALSE(std::isnan(result.values[0]));
+  EXPECT_TRUE(std::isnan(result.values[3]));
+  EXPECT_EQ(0U, result.text.find("Item 1: "));
+}
+
+TEST_F(ServicesLogDensityServer, socket) {
+  std::string path = "log_density_server_test.sock";
+  std::string error;
+  ASSERT_TRUE(server.open(path, error)) << error;
+  stan::callbacks::interrupt interrupt;
+  std::thread serving([&]() { server.serve(interrupt); });
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  ASSERT_EQ(0, ::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                         sizeof(address)));
+
+  request r = make_request(request_type::gradient, request_flags::jacobian,
+                           100, 2);
+  response result;
+  for (int n = 0; n < 10; ++n) {
+    ASSERT_TRUE(stan::services::log_density::write_request(fd, r));
+    ASSERT_TRUE(stan::services::log_density::read_response(fd, result));
+    EXPECT_EQ(100, result.batch_size);
+    EXPECT_EQ(300U, result.values.size());
+    EXPECT_FLOAT_EQ(2 * std::log(5.0) - std::log(2 * M_PI),
+                    result.values[297]);
+  }
+
+  ASSERT_TRUE(stan::services::log_density::write_request(
+      fd, make_request(request_type::stats, 0, 0, 0)));
+  ASSERT_TRUE(stan::services::log_density::read_response(fd, result));
+  EXPECT_NE(std::string::npos, result.text.find("gradient count=10 "));
+
+  ASSERT_TRUE(stan::services::log_density::write_request(
+      fd, make_request(request_type::shutdown, 0, 0, 0)));
+  ASSERT_TRUE(stan::services::log_density::read_response(fd, result));
+  EXPECT_EQ(response_status::ok, result.status);
+  serving.join();
+  ::close(fd);
+  server.close();
+
+  EXPECT_EQ(10, server.stats(request_type::gradient).count());
+  EXPECT_GT(server.stats(request_type::gradient).mean(), 0);
+  EXPECT_NE(0, ::access(path.c_str(), F_OK));
+}
+
+TEST(ServicesLogDensity, serve_bad_path) {
+  stan::io::empty_var_context context;
+  std::stringstream model_ss, log_ss;
+  stan_model model(context, 0, &model_ss);
+  stan::callbacks::stream_logger logger(log_ss, log_ss, log_ss, log_ss,
+                                        log_ss);
+  stan::callbacks::interrupt interrupt;
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::log_density::serve(model, "", 1, interrupt,
+                                               logger));
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::log_density::serve(model, "sock", 0, interrupt,
+                                               logger));
+}
+
+TEST(ServicesLogDensity, latency_stats) {
+  stan::services::log_density::latency_stats stats;
+  EXPECT_EQ(0, stats.quantile(0.5));
+  for (int n = 1; n <= 100; ++n)
+    stats.record(n * 1e-3);
+  EXPECT_EQ(100, stats.count());
+  EXPECT_FLOAT_EQ(50.5e-3, stats.mean());
+  EXPECT_FLOAT_EQ(100e-3, stats.max());
+  EXPECT_NEAR(50e-3, stats.quantile(0.5), 50e-3 * 0.1);
+  EXPECT_NEAR(99e-3, stats.quantile(0.99), 99e-3 * 0.1);
+  EXPECT_FLOAT_EQ(100e-3, stats.quantile(1));
+}
+
+TEST(ServicesLogDensity, shared_pool) {
+  stan::io::empty_var_context context;
+  std::stringstream model_ss;
+  stan_model model(context, 0, &model_ss);
+  stan::services::util::thread_pool pool(2);
+  stan::services::log_density::log_density_server<stan_model> server(model,
+                                                                     pool);
+  request r;
+  r.type = request_type::log_density;
+  r.flags = request_flags::jacobian;
+  r.batch_size = 10;
+  r.width = 2;
+  r.values.assign(20, 0);
+  response result = server.evaluate(r);
+  ASSERT_EQ(response_status::ok, result.status);
+  EXPECT_EQ(10U, result.values.size());
+  EXPECT_EQ(10, pool.stats().num_tasks);
+  EXPECT_NE(std::string::npos,
+            server.stats_summary().find("thread_pool tasks=10 "));
+}
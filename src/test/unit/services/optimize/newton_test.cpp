@@ -120,3 +120,33 @@ TEST_F(ServicesOptimizeNewton, rosenbrock_no_save_iterations) {
   EXPECT_FLOAT_EQ(return_code, 0);
   EXPECT_GT(callback.n, 0);
 }
+
+TEST_F(ServicesOptimizeNewton, rosenbrock_sparse_hessian) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+
+  int num_iterations = 1000;
+  bool save_iterations = false;
+  bool sparse_hessian = true;
+  mock_callback callback;
+
+  int return_code = stan::services::optimize::newton(
+      model, context, seed, chain, init_radius, num_iterations, save_iterations,
+      sparse_hessian, callback, logger, init, parameter);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(logger.call_count(), logger.call_count_info())
+      << "all output to info";
+  // the cross term of the Hessian vanishes at the initial point (0, 0)
+  // but is detected at the perturbed point
+  EXPECT_EQ(1, logger.find("Hessian sparsity: 4 of 4 entries nonzero, 2 "
+                           "Hessian-vector products per iteration"));
+
+  EXPECT_EQ(1, parameter.states_.size());
+  EXPECT_NEAR(1, parameter.states_.back()[1], 1e-3)
+      << "optimal value should be (1, 1)";
+  EXPECT_NEAR(1, parameter.states_.back()[2], 1e-3)
+      << "optimal value should be (1, 1)";
+  EXPECT_GT(callback.n, 0);
+}
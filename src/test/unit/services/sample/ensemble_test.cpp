@@ -0,0 +1,85 @@
+#include <stan/math/prim.hpp>
+#include <stan/services/sample/ensemble.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <iostream>
+
+class ServicesSampleEnsemble : public testing::Test {
+ public:
+  ServicesSampleEnsemble() : model(context, 0, &model_log) {}
+
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_writer init, parameter, diagnostic;
+  stan::io::empty_var_context context;
+  stan_model model;
+};
+
+TEST_F(ServicesSampleEnsemble, call_count) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_walkers = 8;
+  int num_warmup = 100;
+  int num_samples = 200;
+  int num_thin = 5;
+  bool save_warmup = true;
+  int refresh = 0;
+  stan::services::util::thread_pool pool(2);
+  stan::test::unit::instrumented_interrupt interrupt;
+  EXPECT_EQ(interrupt.call_count(), 0);
+
+  int return_code = stan::services::sample::ensemble(
+      model, context, random_seed, chain, init_radius, num_walkers,
+      num_warmup, num_samples, num_thin, save_warmup, refresh, 2.0, 0.1, pool,
+      interrupt, logger, init, parameter, diagnostic);
+
+  EXPECT_EQ(0, return_code);
+
+  int num_output_lines = num_walkers * (num_warmup + num_samples) / num_thin;
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+  EXPECT_EQ(1, init.call_count("vector_double"));
+  EXPECT_EQ(1, parameter.call_count("vector_string"));
+  EXPECT_EQ(num_output_lines, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, diagnostic.call_count("vector_string"));
+  EXPECT_EQ(num_output_lines, diagnostic.call_count("vector_double"));
+  EXPECT_EQ(1, logger.find_info("log density evaluations while sampling"));
+}
+
+TEST_F(ServicesSampleEnsemble, output_layout) {
+  int num_walkers = 6;
+  stan::services::util::thread_pool pool(3);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  stan::services::sample::ensemble(model, context, 0, 1, 2, num_walkers, 10,
+                                   20, 1, false, 0, 2.0, 0.1, pool, interrupt,
+                                   logger, init, parameter, diagnostic);
+
+  std::vector<std::vector<std::string> > parameter_names
+      = parameter.vector_string_values();
+  ASSERT_EQ(5, parameter_names[0].size());
+  EXPECT_EQ("lp__", parameter_names[0][0]);
+  EXPECT_EQ("accept_stat__", parameter_names[0][1]);
+  EXPECT_EQ("walker__", parameter_names[0][2]);
+  EXPECT_EQ("x", parameter_names[0][3]);
+  EXPECT_EQ("y", parameter_names[0][4]);
+
+  std::vector<std::vector<double> > parameter_values
+      = parameter.vector_double_values();
+  ASSERT_EQ(20 * num_walkers, parameter_values.size());
+  for (size_t i = 0; i < parameter_values.size(); ++i)
+    EXPECT_EQ(i % num_walkers, parameter_values[i][2]);
+}
+
+TEST_F(ServicesSampleEnsemble, too_few_walkers) {
+  stan::services::util::thread_pool pool(1);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::sample::ensemble(
+                model, context, 0, 1, 2, 3, 10, 20, 1, false, 0, 2.0, 0.1,
+                pool, interrupt, logger, init, parameter, diagnostic));
+  EXPECT_EQ(1, logger.call_count_error());
+}
@@ -0,0 +1,198 @@
+#include <stan/services/sample/hmc_nuts_auto_e_adapt.hpp>
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_writer.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <iostream>
+
+class ServicesSampleHmcNutsAutoEAdapt : public testing::Test {
+ public:
+  ServicesSampleHmcNutsAutoEAdapt() : model(context, 0, &model_log) {}
+
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_writer init, parameter, diagnostic;
+  stan::io::empty_var_context context;
+  stan_model model;
+};
+
+TEST_F(ServicesSampleHmcNutsAutoEAdapt, call_count) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_warmup = 200;
+  int num_samples = 400;
+  int num_thin = 5;
+  bool save_warmup = true;
+  int refresh = 0;
+  double stepsize = 0.1;
+  double stepsize_jitter = 0;
+  int max_depth = 8;
+  double delta = .1;
+  double gamma = .1;
+  double kappa = .1;
+  double t0 = .1;
+  unsigned int init_buffer = 50;
+  unsigned int term_buffer = 50;
+  unsigned int window = 100;
+  stan::test::unit::instrumented_interrupt interrupt;
+  EXPECT_EQ(interrupt.call_count(), 0);
+
+  int return_code = stan::services::sample::hmc_nuts_auto_e_adapt(
+      model, context, random_seed, chain, init_radius, num_warmup, num_samples,
+      num_thin, save_warmup, refresh, stepsize, stepsize_jitter, max_depth,
+      delta, gamma, kappa, t0, init_buffer, term_buffer, window, interrupt,
+      logger, init, parameter, diagnostic);
+
+  EXPECT_EQ(0, return_code);
+
+  int num_output_lines = (num_warmup + num_samples) / num_thin;
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+  EXPECT_EQ(1, parameter.call_count("vector_string"));
+  EXPECT_EQ(num_output_lines, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, diagnostic.call_count("vector_string"));
+  EXPECT_EQ(num_output_lines, diagnostic.call_count("vector_double"));
+}
+
+TEST_F(ServicesSampleHmcNutsAutoEAdapt, output_regression) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_warmup = 200;
+  int num_samples = 400;
+  int num_thin = 5;
+  bool save_warmup = true;
+  int refresh = 0;
+  double stepsize = 0.1;
+  double stepsize_jitter = 0;
+  int max_depth = 8;
+  double delta = .1;
+  double gamma = .1;
+  double kappa = .1;
+  double t0 = .1;
+  unsigned int init_buffer = 50;
+  unsigned int term_buffer = 50;
+  unsigned int window = 100;
+  stan::test::unit::instrumented_interrupt interrupt;
+  EXPECT_EQ(interrupt.call_count(), 0);
+
+  stan::services::sample::hmc_nuts_auto_e_adapt(
+      model, context, random_seed, chain, init_radius, num_warmup, num_samples,
+      num_thin, save_warmup, refresh, stepsize, stepsize_jitter, max_depth,
+      delta, gamma, kappa, t0, init_buffer, term_buffer, window, interrupt,
+      logger, init, parameter, diagnostic);
+
+  std::vector<std::string> init_values;
+  init_values = init.string_values();
+
+  EXPECT_EQ(0, init_values.size());
+
+  EXPECT_EQ(1, logger.find_info("Metric selection:"));
+  EXPECT_EQ(1, logger.find_info("Elapsed Time:"));
+  EXPECT_EQ(1, logger.find_info("seconds (Warm-up)"));
+  EXPECT_EQ(1, logger.find_info("seconds (Sampling)"));
+  EXPECT_EQ(1, logger.find_info("seconds (Total)"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleHmcNutsAutoEAdapt, short_warmup_keeps_diag) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_warmup = 100;
+  int num_samples = 100;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 0.1;
+  double stepsize_jitter = 0;
+  int max_depth = 8;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 50;
+  unsigned int term_buffer = 50;
+  unsigned int window = 100;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int return_code = stan::services::sample::hmc_nuts_auto_e_adapt(
+      model, context, random_seed, chain, init_radius, num_warmup, num_samples,
+      num_thin, save_warmup, refresh, stepsize, stepsize_jitter, max_depth,
+      delta, gamma, kappa, t0, init_buffer, term_buffer, window, interrupt,
+      logger, init, parameter, diagnostic);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+  EXPECT_EQ(num_samples, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, logger.find_info("Metric selection: diag_e (too few"));
+}
+
+TEST_F(ServicesSampleHmcNutsAutoEAdapt, selection_after_windows) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_warmup = 500;
+  int num_samples = 100;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 0.1;
+  double stepsize_jitter = 0;
+  int max_depth = 8;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 50;
+  unsigned int term_buffer = 50;
+  unsigned int window = 25;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int return_code = stan::services::sample::hmc_nuts_auto_e_adapt(
+      model, context, random_seed, chain, init_radius, num_warmup, num_samples,
+      num_thin, save_warmup, refresh, stepsize, stepsize_jitter, max_depth,
+      delta, gamma, kappa, t0, init_buffer, term_buffer, window, interrupt,
+      logger, init, parameter, diagnostic);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+  EXPECT_EQ(num_samples, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, logger.find_info("Metric selection:"));
+  EXPECT_EQ(1, logger.find_info("diag_e: condition number"));
+  EXPECT_EQ(1, logger.find_info("dense_e: condition number"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleHmcNutsAutoEAdapt, adaptation_block_parses) {
+  std::stringstream output;
+  stan::callbacks::stream_writer sample_writer(output, "# ");
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int num_warmup = 500;
+  int num_samples = 100;
+  int return_code = stan::services::sample::hmc_nuts_auto_e_adapt(
+      model, context, 0, 1, 0, num_warmup, num_samples, 1, false, 0, 0.1, 0,
+      8, 0.8, 0.05, 0.75, 10, 50, 50, 25, interrupt, logger, init,
+      sample_writer, diagnostic);
+  EXPECT_EQ(0, return_code);
+
+  // the selection is written after the draws, not in the adaptation
+  // block read by stan_csv_reader
+  std::string csv = output.str();
+  size_t selection = csv.find("# Metric selection:");
+  ASSERT_NE(std::string::npos, selection);
+  EXPECT_GT(selection, csv.find("# Adaptation terminated"));
+  EXPECT_LT(selection, csv.find("Elapsed Time:"));
+
+  std::stringstream out;
+  stan::io::stan_csv parsed = stan::io::stan_csv_reader::parse(output, &out);
+  EXPECT_EQ(num_samples, parsed.samples.rows());
+  ASSERT_EQ(model.num_params_r(), parsed.adaptation.metric.cols());
+  EXPECT_TRUE(parsed.adaptation.metric.rows() == 1
+              || parsed.adaptation.metric.rows() == model.num_params_r());
+  EXPECT_GT(parsed.adaptation.step_size, 0);
+  EXPECT_EQ("", out.str());
+}
@@ -3,6 +3,7 @@
 #include <stan/io/empty_var_context.hpp>
 #include <test/test-models/good/optimization/rosenbrock.hpp>
 #include <test/unit/services/instrumented_callbacks.hpp>
+#include <algorithm>
 #include <iostream>
 
 class ServicesSampleHmcNutsDenseE : public testing::Test {
@@ -163,3 +164,27 @@ TEST_F(ServicesSampleHmcNutsDenseE, output_regression) {
   EXPECT_EQ(1, logger.find_info("seconds (Total)"));
   EXPECT_EQ(0, logger.call_count_error());
 }
+
+TEST_F(ServicesSampleHmcNutsDenseE, inv_metric_spec) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  Eigen::MatrixXd inv_metric(2, 2);
+  inv_metric << 2, 0.5, 0.5, 1;
+
+  int return_code = stan::services::sample::hmc_nuts_dense_e(
+      model, context, stan::services::util::inv_metric_spec::full(inv_metric),
+      0, 1, 0, 20, 40, 1, false, 0, 0.1, 0, 8, interrupt, logger, init,
+      parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(60, interrupt.call_count());
+
+  std::vector<std::string> metric = parameter.string_values();
+  ASSERT_NE(metric.end(), std::find(metric.begin(), metric.end(),
+                                    "Elements of inverse mass matrix:"));
+  EXPECT_NE(metric.end(), std::find(metric.begin(), metric.end(), "2, 0.5"));
+
+  return_code = stan::services::sample::hmc_nuts_dense_e(
+      model, context, stan::services::util::inv_metric_spec::identity(3), 0,
+      1, 0, 20, 40, 1, false, 0, 0.1, 0, 8, interrupt, logger, init,
+      parameter, diagnostic);
+  EXPECT_EQ(stan::services::error_codes::CONFIG, return_code);
+}
@@ -165,3 +165,90 @@ TEST_F(ServicesSampleHmcStaticDenseEMassMatrix, use_metric_skip_adapt) {
   dense_vals = inv_metric.vals_r("inv_metric");
   stan::test::unit::check_adaptation(3, 3, dense_vals, parameter, 0.2);
 }
+
+TEST_F(ServicesSampleHmcStaticDenseEMassMatrix, sidecar_round_trip) {
+  unsigned int random_seed = 12345;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_warmup = 250;
+  int num_samples = 0;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 1;
+  double stepsize_jitter = 0;
+  int int_time = 8;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 75;
+  unsigned int term_buffer = 50;
+  unsigned int window = 25;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  std::stringstream sidecar(std::ios::in | std::ios::out
+                            | std::ios::binary);
+  int return_code = stan::services::sample::hmc_static_dense_e_adapt(
+      model, context, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      int_time, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init, parameter, diagnostic, &sidecar);
+  EXPECT_EQ(0, return_code);
+
+  // the sidecar holds the adapted metric printed to the adaptation block
+  std::stringstream sidecar_copy(sidecar.str());
+  stan::services::util::inv_metric_spec adapted
+      = stan::services::util::read_inv_metric_binary(sidecar_copy, 3, logger);
+  EXPECT_EQ(stan::services::util::inv_metric_spec::dense, adapted.kind());
+  Eigen::MatrixXd adapted_metric = adapted.dense_inv_metric();
+  std::vector<double> dense_vals(adapted_metric.data(),
+                                 adapted_metric.data() + 9);
+  stan::test::unit::check_adaptation(3, 3, dense_vals, parameter, 1e-4);
+
+  // and starts a later run without adaptation from the same metric
+  stan::test::unit::instrumented_writer rerun_parameter;
+  return_code = stan::services::sample::hmc_static_dense_e_adapt(
+      model, context, sidecar, random_seed, chain, init_radius, 0, 2,
+      num_thin, save_warmup, refresh, stepsize, stepsize_jitter, int_time,
+      delta, gamma, kappa, t0, init_buffer, term_buffer, window, interrupt,
+      logger, init, rerun_parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  stan::test::unit::check_adaptation(3, 3, dense_vals, rerun_parameter,
+                                     1e-4);
+}
+
+TEST_F(ServicesSampleHmcStaticDenseEMassMatrix, sidecar_wrong_size) {
+  unsigned int random_seed = 12345;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_warmup = 0;
+  int num_samples = 2;
+  int num_thin = 1;
+  bool save_warmup = false;
+  int refresh = 0;
+  double stepsize = 1;
+  double stepsize_jitter = 0;
+  int int_time = 8;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 75;
+  unsigned int term_buffer = 50;
+  unsigned int window = 25;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  std::stringstream sidecar(std::ios::in | std::ios::out
+                            | std::ios::binary);
+  stan::services::util::write_inv_metric_binary(
+      stan::services::util::inv_metric_spec::identity(2), sidecar);
+
+  int return_code = stan::services::sample::hmc_static_dense_e_adapt(
+      model, context, sidecar, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      int_time, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(stan::services::error_codes::CONFIG, return_code);
+  EXPECT_EQ(1, logger.find_error("expected 3 parameters, found 2"));
+}
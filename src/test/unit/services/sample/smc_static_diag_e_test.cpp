@@ -0,0 +1,81 @@
+#include <stan/math/prim.hpp>
+#include <stan/services/sample/smc_static_diag_e.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+class ServicesSampleSmcStaticDiagE : public testing::Test {
+ public:
+  ServicesSampleSmcStaticDiagE() : model(context, 0, &model_log) {}
+
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_writer parameter;
+  stan::io::empty_var_context context;
+  gauss3D_model_namespace::gauss3D_model model;
+};
+
+TEST_F(ServicesSampleSmcStaticDiagE, marginal_likelihood) {
+  int num_particles = 400;
+  stan::services::util::thread_pool pool(4);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int return_code = stan::services::sample::smc_static_diag_e(
+      model, 0, 1, num_particles, 3, 0.5, 10, 0.5, 1.5, 0.8, pool, interrupt,
+      logger, parameter);
+  EXPECT_EQ(0, return_code);
+
+  std::vector<std::vector<std::string>> names
+      = parameter.vector_string_values();
+  ASSERT_EQ(1, names.size());
+  ASSERT_EQ(8, names[0].size());
+  EXPECT_EQ("lp__", names[0][0]);
+  EXPECT_EQ("stepsize__", names[0][2]);
+  EXPECT_EQ("x.1", names[0][5]);
+
+  std::vector<std::vector<double>> draws = parameter.vector_double_values();
+  ASSERT_EQ(num_particles, draws.size());
+  Eigen::VectorXd mean = Eigen::VectorXd::Zero(3);
+  Eigen::VectorXd var = Eigen::VectorXd::Zero(3);
+  for (const std::vector<double>& draw : draws) {
+    for (int i = 0; i < 3; ++i) {
+      mean(i) += draw[5 + i] / num_particles;
+      var(i) += draw[5 + i] * draw[5 + i] / num_particles;
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(0, mean(i), 0.2);
+    EXPECT_NEAR(1, var(i), 0.25);
+  }
+
+  // The model density drops the constant of the standard normal, so
+  // its normalizing constant is (2 pi)^(3/2)
+  std::vector<std::string> comments = parameter.string_values();
+  ASSERT_EQ(2, comments.size());
+  std::string prefix = "Log marginal likelihood = ";
+  ASSERT_EQ(0, comments[0].find(prefix));
+  double log_z = std::stod(comments[0].substr(prefix.size()));
+  EXPECT_NEAR(1.5 * std::log(2 * M_PI), log_z, 0.2);
+  EXPECT_EQ(0, comments[1].find("Number of tempering stages = "));
+  EXPECT_EQ(interrupt.call_count(), logger.find_info("Stage "));
+}
+
+TEST_F(ServicesSampleSmcStaticDiagE, bad_arguments) {
+  stan::services::util::thread_pool pool(1);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::sample::smc_static_diag_e(
+                model, 0, 1, 1, 3, 0.5, 5, 0.5, 1.5, 0.8, pool, interrupt,
+                logger, parameter));
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::sample::smc_static_diag_e(
+                model, 0, 1, 100, 3, 1, 5, 0.5, 1.5, 0.8, pool, interrupt,
+                logger, parameter));
+  EXPECT_EQ(2, logger.call_count_error());
+  EXPECT_EQ(0, parameter.call_count());
+}
@@ -0,0 +1,71 @@
+#include <stan/services/util/cross_chain_options.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+struct mock_cross_chain_sampler {
+  int quorum = -1;
+  int cull_interval = -1;
+  double cull_lp_threshold = 0.0;
+  double cull_accept_ratio = 0.0;
+  int check_interval = -1;
+  double target_ess = -1.0;
+  double target_rhat = -1.0;
+  std::vector<int> index{-1};
+
+  void set_cross_chain_quorum(int q) { quorum = q; }
+
+  void set_cross_chain_culling(int interval, double lp_threshold,
+                               double accept_ratio) {
+    cull_interval = interval;
+    cull_lp_threshold = lp_threshold;
+    cull_accept_ratio = accept_ratio;
+  }
+
+  void set_cross_chain_sampling_target(int interval, double ess, double rhat,
+                                       const std::vector<int>& idx) {
+    check_interval = interval;
+    target_ess = ess;
+    target_rhat = rhat;
+    index = idx;
+  }
+};
+}  // namespace
+
+TEST(cross_chain_options, default_is_off) {
+  stan::services::util::cross_chain_options options;
+  mock_cross_chain_sampler sampler;
+  stan::services::util::set_cross_chain_options(sampler, options);
+
+  EXPECT_FALSE(options.use_quorum(4));
+  EXPECT_EQ(0, sampler.quorum);
+  EXPECT_EQ(0, sampler.cull_interval);
+  EXPECT_EQ(0, sampler.check_interval);
+  EXPECT_TRUE(sampler.index.empty());
+}
+
+TEST(cross_chain_options, passed_to_sampler) {
+  stan::services::util::cross_chain_options options;
+  options.quorum = 3;
+  options.cull_interval = 10;
+  options.cull_lp_threshold = 3.0;
+  options.cull_accept_ratio = 0.25;
+  options.sampling_check_interval = 50;
+  options.sampling_target_ess = 400.0;
+  options.sampling_target_rhat = 1.01;
+  options.sampling_index = {0, 2};
+
+  mock_cross_chain_sampler sampler;
+  stan::services::util::set_cross_chain_options(sampler, options);
+
+  EXPECT_TRUE(options.use_quorum(4));
+  EXPECT_FALSE(options.use_quorum(3));
+  EXPECT_EQ(3, sampler.quorum);
+  EXPECT_EQ(10, sampler.cull_interval);
+  EXPECT_FLOAT_EQ(3.0, sampler.cull_lp_threshold);
+  EXPECT_FLOAT_EQ(0.25, sampler.cull_accept_ratio);
+  EXPECT_EQ(50, sampler.check_interval);
+  EXPECT_FLOAT_EQ(400.0, sampler.target_ess);
+  EXPECT_FLOAT_EQ(1.01, sampler.target_rhat);
+  EXPECT_EQ((std::vector<int>{0, 2}), sampler.index);
+}
@@ -300,6 +300,45 @@ TEST_F(ServicesUtilInitialize, model_throws__full_init) {
   EXPECT_EQ(100, logger.find_info("throwing within log_prob"));
 }
 
+namespace test {
+// Mock model whose log density is finite in double but whose
+// gradient throws, as with a failing ODE sensitivity solve
+class mock_gradient_throwing_model : public mock_throwing_model {
+ public:
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    ++templated_log_prob_calls;
+    if (!std::is_same<T__, double>::value)
+      throw std::runtime_error("sensitivity solve failed");
+    return log_prob_return_value;
+  }
+};
+}  // namespace test
+
+TEST_F(ServicesUtilInitialize, gradient_throws__check_gradient_false) {
+  test::mock_gradient_throwing_model model;
+
+  double init_radius = 2;
+  bool print_timing = false;
+  EXPECT_THROW(
+      stan::services::util::initialize(model, empty_context, rng,
+                                       init_radius, print_timing, logger, init),
+      std::runtime_error);
+
+  stan::test::unit::instrumented_logger double_logger;
+  model.reset();
+  std::vector<double> params = stan::services::util::initialize(
+      model, empty_context, rng, init_radius, print_timing, double_logger,
+      init, false);
+  ASSERT_EQ(1, params.size());
+  EXPECT_GT(params[0], -init_radius);
+  EXPECT_LT(params[0], init_radius);
+  EXPECT_EQ(1, model.templated_log_prob_calls);
+  EXPECT_EQ(0, double_logger.call_count());
+  ASSERT_EQ(1, init.vector_double_values().size());
+}
+
 namespace test {
 // Mock Throwing Model throws exception
 class mock_error_model : public stan::model::prob_grad {
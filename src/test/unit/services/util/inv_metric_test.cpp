@@ -192,3 +192,90 @@ TEST(inv_metric, validate_dense_imm) {
   EXPECT_THROW(stan::services::util::validate_dense_inv_metric(m2, logger),
                std::domain_error);
 }
+
+TEST(inv_metric, spec_identity) {
+  stan::services::util::inv_metric_spec spec
+      = stan::services::util::inv_metric_spec::identity(3);
+  EXPECT_EQ(stan::services::util::inv_metric_spec::unit, spec.kind());
+  EXPECT_EQ(3U, spec.num_params());
+  EXPECT_EQ(0U, spec.size());
+  EXPECT_TRUE(spec.diag_inv_metric().isOnes());
+  EXPECT_TRUE(spec.dense_inv_metric().isIdentity());
+}
+
+TEST(inv_metric, spec_diag_dense) {
+  Eigen::VectorXd diag(2);
+  diag << 2, 3;
+  stan::services::util::inv_metric_spec spec
+      = stan::services::util::inv_metric_spec::diagonal(diag);
+  EXPECT_EQ(2U, spec.size());
+  EXPECT_FLOAT_EQ(3, spec.dense_inv_metric()(1, 1));
+  EXPECT_FLOAT_EQ(0, spec.dense_inv_metric()(0, 1));
+
+  Eigen::MatrixXd dense(2, 2);
+  dense << 2, 1, 1, 3;
+  spec = stan::services::util::inv_metric_spec::full(dense);
+  EXPECT_EQ(stan::services::util::inv_metric_spec::dense, spec.kind());
+  EXPECT_EQ(4U, spec.size());
+  EXPECT_FLOAT_EQ(3, spec.diag_inv_metric()(1));
+  EXPECT_TRUE(spec.dense_inv_metric().isApprox(dense));
+}
+
+TEST(inv_metric, spec_validate) {
+  stan::callbacks::logger logger;
+  Eigen::MatrixXd dense(2, 2);
+  dense << 1, 2, 2, 1;
+  stan::services::util::inv_metric_spec spec
+      = stan::services::util::inv_metric_spec::full(dense);
+  EXPECT_THROW(spec.validate(2, logger), std::domain_error);
+  spec = stan::services::util::inv_metric_spec::identity(2);
+  EXPECT_NO_THROW(spec.validate(2, logger));
+  EXPECT_THROW(spec.validate(3, logger), std::domain_error);
+  spec = stan::services::util::inv_metric_spec::diagonal(
+      Eigen::VectorXd::Constant(2, -1));
+  EXPECT_THROW(spec.validate(2, logger), std::domain_error);
+}
+
+TEST(inv_metric, binary_round_trip) {
+  stan::callbacks::logger logger;
+  Eigen::MatrixXd dense(3, 3);
+  dense << 2, 0.5, 0.1, 0.5, 3, 0.2, 0.1, 0.2, 1.0 / 3;
+  std::stringstream out;
+  stan::services::util::write_inv_metric_binary(
+      stan::services::util::inv_metric_spec::full(dense), out);
+  EXPECT_EQ(24U + 9 * sizeof(double), out.str().size());
+
+  std::stringstream in(out.str());
+  stan::services::util::inv_metric_spec spec
+      = stan::services::util::read_inv_metric_binary(in, 3, logger);
+  EXPECT_EQ(stan::services::util::inv_metric_spec::dense, spec.kind());
+  EXPECT_TRUE(spec.dense_inv_metric() == dense);
+
+  std::stringstream unit_out;
+  stan::services::util::write_inv_metric_binary(
+      stan::services::util::inv_metric_spec::identity(3), unit_out);
+  std::stringstream unit_in(unit_out.str());
+  spec = stan::services::util::read_inv_metric_binary(unit_in, 3, logger);
+  EXPECT_EQ(stan::services::util::inv_metric_spec::unit, spec.kind());
+}
+
+TEST(inv_metric, binary_bad) {
+  stan::callbacks::logger logger;
+  std::stringstream out;
+  stan::services::util::write_inv_metric_binary(
+      stan::services::util::inv_metric_spec::diagonal(
+          Eigen::VectorXd::Ones(4)),
+      out);
+
+  std::stringstream wrong_size(out.str());
+  EXPECT_THROW(
+      stan::services::util::read_inv_metric_binary(wrong_size, 3, logger),
+      std::domain_error);
+  std::stringstream truncated(out.str().substr(0, 40));
+  EXPECT_THROW(
+      stan::services::util::read_inv_metric_binary(truncated, 4, logger),
+      std::domain_error);
+  std::stringstream text("inv_metric <- c(1, 1, 1, 1)");
+  EXPECT_THROW(stan::services::util::read_inv_metric_binary(text, 4, logger),
+               std::domain_error);
+}
@@ -0,0 +1,139 @@
+#include <stan/services/util/metric_selection.hpp>
+#include <gtest/gtest.h>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+
+namespace {
+
+/*
+ * Add n draws from a standard normal in d dimensions whose first two
+ * coordinates have correlation rho.
+ */
+void add_normal_draws(stan::services::util::metric_selector& selector,
+                      int n, int d, double rho) {
+  boost::ecuyer1988 rng(1234);
+  boost::variate_generator<boost::ecuyer1988&, boost::normal_distribution<> >
+      std_normal(rng, boost::normal_distribution<>());
+  for (int i = 0; i < n; ++i) {
+    Eigen::VectorXd q(d);
+    for (int k = 0; k < d; ++k)
+      q(k) = std_normal();
+    if (d > 1)
+      q(1) = rho * q(0) + std::sqrt(1 - rho * rho) * q(1);
+    selector.add_draw(q);
+  }
+}
+
+/*
+ * Add n draws from a normal in d dimensions with unit variances and
+ * all correlations equal to rho.
+ */
+void add_equicorrelated_draws(stan::services::util::metric_selector& selector,
+                              int n, int d, double rho) {
+  boost::ecuyer1988 rng(4321);
+  boost::variate_generator<boost::ecuyer1988&, boost::normal_distribution<> >
+      std_normal(rng, boost::normal_distribution<>());
+  for (int i = 0; i < n; ++i) {
+    double common = std_normal();
+    Eigen::VectorXd q(d);
+    for (int k = 0; k < d; ++k)
+      q(k) = std::sqrt(rho) * common + std::sqrt(1 - rho) * std_normal();
+    selector.add_draw(q);
+  }
+}
+
+}  // namespace
+
+TEST(metric_selection, correlated_chooses_dense) {
+  stan::services::util::metric_selector selector(2);
+  add_normal_draws(selector, 150, 2, 0.99);
+  EXPECT_EQ(150, selector.num_draws());
+
+  stan::services::util::metric_choice choice = selector.select(1e-6);
+  EXPECT_TRUE(choice.dense);
+  EXPECT_EQ("dense_e", choice.name());
+  EXPECT_GT(choice.diag_condition, 100);
+  EXPECT_LT(choice.dense_condition, 2);
+  EXPECT_LT(choice.dense_cost, choice.diag_cost);
+  EXPECT_TRUE(choice.reason.empty());
+
+  ASSERT_EQ(2, choice.covariance.rows());
+  ASSERT_EQ(2, choice.covariance.cols());
+  double correlation
+      = choice.covariance(0, 1)
+        / std::sqrt(choice.covariance(0, 0) * choice.covariance(1, 1));
+  EXPECT_NEAR(0.99, correlation, 0.01);
+}
+
+TEST(metric_selection, independent_chooses_diag) {
+  stan::services::util::metric_selector selector(40);
+  add_normal_draws(selector, 150, 40, 0);
+
+  stan::services::util::metric_choice choice = selector.select(1e-6);
+  EXPECT_FALSE(choice.dense);
+  EXPECT_EQ("diag_e", choice.name());
+  EXPECT_GT(choice.dense_cost, choice.diag_cost);
+  EXPECT_EQ(0, choice.covariance.size());
+}
+
+TEST(metric_selection, too_few_draws) {
+  stan::services::util::metric_selector selector(10);
+  add_normal_draws(selector, 8, 10, 0.99);
+
+  stan::services::util::metric_choice choice = selector.select(1e-6);
+  EXPECT_FALSE(choice.dense);
+  EXPECT_FALSE(choice.reason.empty());
+  EXPECT_NE(std::string::npos, choice.summary().find("diag_e"));
+}
+
+TEST(metric_selection, constant_parameter) {
+  stan::services::util::metric_selector selector(2);
+  for (int i = 0; i < 50; ++i)
+    selector.add_draw(Eigen::Vector2d(i, 1));
+
+  stan::services::util::metric_choice choice = selector.select(1e-6);
+  EXPECT_FALSE(choice.dense);
+  EXPECT_FALSE(choice.reason.empty());
+}
+
+// 75 selection draws, as with the default adaptation windows, and a
+// sampling metric estimated from a last window of 500 draws
+TEST(metric_selection, correlated_moderate_dimension_chooses_dense) {
+  for (int d : {50, 74, 100}) {
+    stan::services::util::metric_selector selector(d);
+    add_equicorrelated_draws(selector, 75, d, 0.9);
+
+    stan::services::util::metric_choice choice = selector.select(1e-5, 500);
+    EXPECT_TRUE(choice.dense) << "d = " << d << "\n" << choice.summary();
+    EXPECT_GT(choice.diag_condition, 100) << "d = " << d;
+    EXPECT_LT(choice.dense_cost, choice.diag_cost) << "d = " << d;
+
+    ASSERT_EQ(d, choice.covariance.rows());
+    Eigen::LLT<Eigen::MatrixXd> llt(choice.covariance);
+    EXPECT_EQ(Eigen::Success, llt.info()) << "d = " << d;
+    double correlation
+        = choice.covariance(0, 1)
+          / std::sqrt(choice.covariance(0, 0) * choice.covariance(1, 1));
+    EXPECT_NEAR(0.9, correlation, 0.15) << "d = " << d;
+  }
+}
+
+TEST(metric_selection, independent_high_dimension_chooses_diag) {
+  stan::services::util::metric_selector selector(100);
+  add_normal_draws(selector, 75, 100, 0);
+
+  stan::services::util::metric_choice choice = selector.select(1e-5, 500);
+  EXPECT_FALSE(choice.dense) << choice.summary();
+  EXPECT_LT(choice.diag_condition, 10);
+}
+
+TEST(metric_selection, metric_window_too_short) {
+  stan::services::util::metric_selector selector(50);
+  add_equicorrelated_draws(selector, 75, 50, 0.9);
+
+  stan::services::util::metric_choice choice = selector.select(1e-5, 50);
+  EXPECT_FALSE(choice.dense);
+  EXPECT_FALSE(choice.reason.empty());
+}
@@ -0,0 +1,72 @@
+#include <stan/services/util/shared_thread_pool.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+TEST(ServicesUtilSharedThreadPool, configure_before_use) {
+  EXPECT_GE(stan::services::util::default_num_threads(), 1);
+  EXPECT_THROW(stan::services::util::configure_shared_thread_pool(
+                   stan::services::util::thread_pool_options(0)),
+               std::invalid_argument);
+  stan::services::util::configure_shared_thread_pool(
+      stan::services::util::thread_pool_options(2));
+
+  stan::services::util::thread_pool& pool
+      = stan::services::util::shared_thread_pool();
+  EXPECT_EQ(2, pool.num_threads());
+  EXPECT_EQ(&pool, &stan::services::util::shared_thread_pool());
+  std::atomic<int> count(0);
+  pool.parallel_for(20, [&](int i) { ++count; });
+  EXPECT_EQ(20, count);
+
+  EXPECT_THROW(stan::services::util::configure_shared_thread_pool(
+                   stan::services::util::thread_pool_options(4)),
+               std::logic_error);
+}
+
+#ifdef STAN_THREADS
+// runs after configure_before_use, on the shared pool of two workers
+TEST(ServicesUtilSharedThreadPool, reverse_mode_on_workers) {
+  using stan::math::var;
+  stan::services::util::thread_pool& pool
+      = stan::services::util::shared_thread_pool();
+
+  // long expressions, so that the gradients of the two workers
+  // overlap and would corrupt a shared autodiff stack
+  const int n = 200;
+  const int num_terms = 1000;
+  std::vector<double> lp(n), grad(n);
+  pool.parallel_for(n, [&](int i) {
+    var x = 0.01 * i;
+    var y = 0;
+    for (int k = 0; k < num_terms; ++k)
+      y += stan::math::exp(x) * x;
+    y.grad();
+    lp[i] = y.val();
+    grad[i] = x.adj();
+    stan::math::recover_memory();
+  });
+
+  for (int i = 0; i < n; ++i) {
+    double x = 0.01 * i;
+    EXPECT_FLOAT_EQ(num_terms * std::exp(x) * x, lp[i]);
+    EXPECT_FLOAT_EQ(num_terms * std::exp(x) * (1 + x), grad[i]);
+  }
+
+  // nested loops on the same workers use the same stacks
+  std::vector<double> nested_grad(n);
+  pool.parallel_for(2, [&](int j) {
+    pool.parallel_for(n / 2, [&](int i) {
+      var x = 0.01 * (j * n / 2 + i);
+      var y = x * x;
+      y.grad();
+      nested_grad[j * n / 2 + i] = x.adj();
+      stan::math::recover_memory();
+    });
+  });
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(2 * 0.01 * i, nested_grad[i]);
+}
+#endif
@@ -0,0 +1,175 @@
+#include <stan/services/util/thread_pool.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(ServicesUtilThreadPool, parallel_for) {
+  stan::services::util::thread_pool pool(4);
+  EXPECT_EQ(4, pool.num_threads());
+  std::vector<int> visits(1000, 0);
+  pool.parallel_for(visits.size(), [&](int i) { visits[i] += i; });
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i, visits[i]);
+  pool.parallel_for(0, [&](int i) { visits[i] = -1; });
+}
+
+TEST(ServicesUtilThreadPool, concurrent_loops) {
+  stan::services::util::thread_pool pool(3);
+  std::atomic<long> sum(0);
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < 4; ++t)
+    submitters.emplace_back([&]() {
+      for (int n = 0; n < 50; ++n)
+        pool.parallel_for(100, [&](int i) { sum += i; });
+    });
+  for (std::thread& submitter : submitters)
+    submitter.join();
+  EXPECT_EQ(4 * 50 * 4950, sum);
+}
+
+TEST(ServicesUtilThreadPool, exception) {
+  stan::services::util::thread_pool pool(2);
+  std::atomic<int> count(0);
+  EXPECT_THROW(pool.parallel_for(100,
+                                 [&](int i) {
+                                   ++count;
+                                   if (i == 10)
+                                     throw std::domain_error("bad");
+                                 }),
+               std::domain_error);
+  EXPECT_LE(count, 100);
+  pool.parallel_for(10, [&](int i) { ++count; });
+  EXPECT_THROW(stan::services::util::thread_pool(0), std::invalid_argument);
+}
+
+TEST(ServicesUtilThreadPool, nested_parallel_for) {
+  stan::services::util::thread_pool pool(2);
+  std::atomic<long> sum(0);
+  pool.parallel_for(8, [&](int i) {
+    pool.parallel_for(100, [&](int j) { sum += j; });
+  });
+  EXPECT_EQ(8 * 4950, sum);
+}
+
+// a worker waiting for a nested loop runs only iterations of that
+// loop and of loops nested in it, never unrelated queued work
+TEST(ServicesUtilThreadPool, nested_wait_runs_only_nested_work) {
+  stan::services::util::thread_pool pool(2);
+  std::atomic<bool> waiting(false);
+  std::atomic<int> nested_count(0);
+  std::atomic<int> unrelated_on_outer(0);
+  thread_local bool in_outer = false;
+
+  std::thread outer([&]() {
+    pool.parallel_for(1, [&](int) {
+      in_outer = true;
+      waiting = true;
+      pool.parallel_for(4, [&](int) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        // iterations nested in the outer task may run on its thread
+        pool.parallel_for(2, [&](int) { ++nested_count; });
+      });
+      in_outer = false;
+    });
+  });
+  while (!waiting)
+    std::this_thread::yield();
+  pool.parallel_for(40, [&](int) {
+    if (in_outer)
+      ++unrelated_on_outer;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  });
+  outer.join();
+
+  EXPECT_EQ(8, nested_count);
+  EXPECT_EQ(0, unrelated_on_outer);
+  EXPECT_EQ(0, pool.queue_depth());
+}
+
+#ifdef STAN_THREADS
+// an outer task keeps live autodiff variables across a nested loop
+// while unrelated reverse mode tasks, which end by recovering the
+// memory of their stack, are queued
+TEST(ServicesUtilThreadPool, nested_wait_keeps_autodiff_stack) {
+  using stan::math::var;
+  stan::services::util::thread_pool pool(2);
+  std::atomic<bool> waiting(false);
+  double outer_value = 0;
+  double outer_grad = 0;
+
+  std::thread outer([&]() {
+    pool.parallel_for(1, [&](int) {
+      var x = 1.5;
+      var y = x;
+      for (int k = 0; k < 100; ++k)
+        y = y * 1.0 + x;
+      waiting = true;
+      pool.parallel_for(4, [&](int) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      });
+      y.grad();
+      outer_value = y.val();
+      outer_grad = x.adj();
+      stan::math::recover_memory();
+    });
+  });
+  while (!waiting)
+    std::this_thread::yield();
+  std::vector<double> grad(40);
+  pool.parallel_for(40, [&](int i) {
+    var a = 0.1 * i;
+    var b = a * a;
+    for (int k = 0; k < 100; ++k)
+      b = b + a;
+    b.grad();
+    grad[i] = a.adj();
+    stan::math::recover_memory();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  });
+  outer.join();
+
+  EXPECT_FLOAT_EQ(101 * 1.5, outer_value);
+  EXPECT_FLOAT_EQ(101, outer_grad);
+  for (int i = 0; i < 40; ++i)
+    EXPECT_FLOAT_EQ(2 * 0.1 * i + 100, grad[i]);
+}
+#endif
+
+TEST(ServicesUtilThreadPool, stats) {
+  stan::services::util::thread_pool pool(3);
+  pool.parallel_for(60, [](int i) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  });
+  stan::services::util::thread_pool_stats stats = pool.stats();
+  EXPECT_EQ(60, stats.num_tasks);
+  EXPECT_GE(stats.mean_task_seconds(), 1e-4);
+  EXPECT_GE(stats.max_task_seconds, stats.mean_task_seconds());
+  EXPECT_EQ(3, stats.num_submits);
+  EXPECT_GE(stats.max_queue_depth, 1);
+  EXPECT_LE(stats.max_queue_depth, 3);
+  EXPECT_NE(std::string::npos, stats.summary().find("tasks=60"));
+  EXPECT_EQ(0, pool.queue_depth());
+
+  pool.reset_stats();
+  EXPECT_EQ(0, pool.stats().num_tasks);
+  EXPECT_EQ(0, pool.stats().max_queue_depth);
+}
+
+TEST(ServicesUtilThreadPool, options) {
+  stan::services::util::thread_pool_options options(2);
+  options.cpus.push_back(0);
+  options.autodiff = false;
+  stan::services::util::thread_pool pool(options);
+  EXPECT_EQ(2, pool.num_threads());
+  EXPECT_EQ(1U, pool.options().cpus.size());
+  std::atomic<int> count(0);
+  pool.parallel_for(50, [&](int i) { ++count; });
+  EXPECT_EQ(50, count);
+  EXPECT_THROW(stan::services::util::thread_pool(
+                   stan::services::util::thread_pool_options(0)),
+               std::invalid_argument);
+}
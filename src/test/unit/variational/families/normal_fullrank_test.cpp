@@ -1,3 +1,4 @@
+#define EIGEN_RUNTIME_NO_MALLOC
 #include <stan/variational/families/normal_fullrank.hpp>
 #include <vector>
 #include <gtest/gtest.h>
@@ -157,3 +158,48 @@ TEST(normal_fullrank_test, calc_log_g) {
 
   EXPECT_FLOAT_EQ(log_g_out, log_g_true);
 }
+
+TEST(normal_fullrank_test, adagrad_update) {
+  Eigen::Vector3d mu;
+  mu << 5.7, -3.2, 0.1332;
+  Eigen::Matrix3d L;
+  L << 1.3, 0, 0, 2.3, 41, 0, 3.3, 42, 92;
+  Eigen::Vector3d mu_grad;
+  mu_grad << 0.3, -1.2, 2.5;
+  Eigen::Matrix3d L_grad;
+  L_grad << -0.7, 0, 0, 0.05, 1.1, 0, 2.2, -0.4, 0.9;
+
+  stan::variational::normal_fullrank q(mu, L);
+  stan::variational::normal_fullrank q_ref(mu, L);
+  stan::variational::normal_fullrank grad(mu_grad, L_grad);
+  stan::variational::normal_fullrank history(3);
+  stan::variational::normal_fullrank history_ref(3);
+
+  for (int iter = 1; iter <= 3; ++iter) {
+    double eta = 0.1 / std::sqrt(static_cast<double>(iter));
+    if (iter == 1)
+      history_ref += grad.square();
+    else
+      history_ref = 0.9 * history_ref + 0.1 * grad.square();
+    q_ref += eta * grad / (1.0 + history_ref.sqrt());
+
+    Eigen::internal::set_is_malloc_allowed(false);
+    if (iter == 1)
+      q.adagrad_update(grad, history, eta, 1.0, 1.0, 1.0);
+    else
+      q.adagrad_update(grad, history, eta, 1.0, 0.9, 0.1);
+    Eigen::internal::set_is_malloc_allowed(true);
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(q_ref.mu()(i), q.mu()(i));
+    EXPECT_FLOAT_EQ(history_ref.mu()(i), history.mu()(i));
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_FLOAT_EQ(q_ref.L_chol()(i, j), q.L_chol()(i, j));
+      EXPECT_FLOAT_EQ(history_ref.L_chol()(i, j), history.L_chol()(i, j));
+    }
+  }
+
+  stan::variational::normal_fullrank wrong_dim(4);
+  EXPECT_THROW(q.adagrad_update(wrong_dim, history, 0.1, 1.0, 0.9, 0.1),
+               std::domain_error);
+}
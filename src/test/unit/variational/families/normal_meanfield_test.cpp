@@ -1,3 +1,4 @@
+#define EIGEN_RUNTIME_NO_MALLOC
 #include <stan/variational/families/normal_meanfield.hpp>
 #include <vector>
 #include <gtest/gtest.h>
@@ -153,3 +154,46 @@ TEST(normal_meanfield_test, calc_log_g) {
 
   EXPECT_FLOAT_EQ(log_g_out, log_g_true);
 }
+
+TEST(normal_meanfield_test, adagrad_update) {
+  Eigen::Vector3d mu;
+  mu << 5.7, -3.2, 0.1332;
+  Eigen::Vector3d omega;
+  omega << -0.42, 0.8922, 13.4;
+  Eigen::Vector3d mu_grad;
+  mu_grad << 0.3, -1.2, 2.5;
+  Eigen::Vector3d omega_grad;
+  omega_grad << -0.7, 0.05, 1.1;
+
+  stan::variational::normal_meanfield q(mu, omega);
+  stan::variational::normal_meanfield q_ref(mu, omega);
+  stan::variational::normal_meanfield grad(mu_grad, omega_grad);
+  stan::variational::normal_meanfield history(3);
+  stan::variational::normal_meanfield history_ref(3);
+
+  for (int iter = 1; iter <= 3; ++iter) {
+    double eta = 0.1 / std::sqrt(static_cast<double>(iter));
+    if (iter == 1)
+      history_ref += grad.square();
+    else
+      history_ref = 0.9 * history_ref + 0.1 * grad.square();
+    q_ref += eta * grad / (1.0 + history_ref.sqrt());
+
+    Eigen::internal::set_is_malloc_allowed(false);
+    if (iter == 1)
+      q.adagrad_update(grad, history, eta, 1.0, 1.0, 1.0);
+    else
+      q.adagrad_update(grad, history, eta, 1.0, 0.9, 0.1);
+    Eigen::internal::set_is_malloc_allowed(true);
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(q_ref.mu()(i), q.mu()(i));
+    EXPECT_FLOAT_EQ(q_ref.omega()(i), q.omega()(i));
+    EXPECT_FLOAT_EQ(history_ref.mu()(i), history.mu()(i));
+    EXPECT_FLOAT_EQ(history_ref.omega()(i), history.omega()(i));
+  }
+
+  stan::variational::normal_meanfield wrong_dim(4);
+  EXPECT_THROW(q.adagrad_update(wrong_dim, history, 0.1, 1.0, 0.9, 0.1),
+               std::domain_error);
+}
@@ -0,0 +1,141 @@
+#ifndef TEST_UNIT_VARIATIONAL_MINIBATCH_NORMAL_MODEL_HPP
+#define TEST_UNIT_VARIATIONAL_MINIBATCH_NORMAL_MODEL_HPP
+
+#include <stan/io/var_context.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <stan/math/rev.hpp>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace test {
+namespace unit {
+
+/**
+ * Hand-written model with the minibatch hook of
+ * <code>stan::variational::has_minibatch</code>, as stanc would
+ * generate it for
+ * <pre>
+ * data {
+ *   int N;
+ *   vector[N] y;
+ * }
+ * parameters {
+ *   real mu;
+ *   real<lower=0> sigma;
+ * }
+ * model {
+ *   mu ~ normal(0, 10);
+ *   sigma ~ lognormal(0, 1);
+ *   y[batch] ~ normal(mu, sigma);  // scaled by the minibatch weight
+ * }
+ * </pre>
+ * with <code>y[n] = n % 10</code> for <code>n = 0, ..., N - 1</code>.
+ */
+class minibatch_normal_model : public stan::model::prob_grad {
+ public:
+  explicit minibatch_normal_model(int N)
+      : stan::model::prob_grad(2), y_(N), weight_(1.0), max_batch_size_(0) {
+    for (int n = 0; n < N; ++n) {
+      y_[n] = n % 10;
+      batch_.push_back(n + 1);
+    }
+  }
+
+  void set_minibatch(const std::vector<int>& indices, double weight) {
+    batch_ = indices;
+    weight_ = weight;
+    max_batch_size_
+        = std::max(max_batch_size_, static_cast<int>(indices.size()));
+  }
+
+  int max_batch_size() const { return max_batch_size_; }
+
+  double weight() const { return weight_; }
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    return log_density<jacobian__>(params_r__[0], params_r__[1]);
+  }
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(Eigen::Matrix<T__, Eigen::Dynamic, 1>& params_r__,
+               std::ostream* pstream__ = 0) const {
+    return log_density<jacobian__>(params_r__(0), params_r__(1));
+  }
+
+  void transform_inits(const stan::io::var_context& context__,
+                       std::vector<int>& params_i__,
+                       std::vector<double>& params_r__,
+                       std::ostream* pstream__) const {
+    params_r__.resize(2);
+    params_r__[0] = context__.vals_r("mu")[0];
+    params_r__[1] = std::log(context__.vals_r("sigma")[0]);
+  }
+
+  void get_param_names(std::vector<std::string>& names__) const {
+    names__.clear();
+    names__.push_back("mu");
+    names__.push_back("sigma");
+  }
+
+  void get_dims(std::vector<std::vector<size_t> >& dimss__) const {
+    dimss__.clear();
+    dimss__.push_back(std::vector<size_t>());
+    dimss__.push_back(std::vector<size_t>());
+  }
+
+  void constrained_param_names(std::vector<std::string>& param_names__,
+                               bool include_tparams__ = true,
+                               bool include_gqs__ = true) const {
+    param_names__.push_back("mu");
+    param_names__.push_back("sigma");
+  }
+
+  void unconstrained_param_names(std::vector<std::string>& param_names__,
+                                 bool include_tparams__ = true,
+                                 bool include_gqs__ = true) const {
+    constrained_param_names(param_names__, include_tparams__, include_gqs__);
+  }
+
+  template <typename RNG>
+  void write_array(RNG& base_rng__, std::vector<double>& params_r__,
+                   std::vector<int>& params_i__, std::vector<double>& vars__,
+                   bool include_tparams__ = true, bool include_gqs__ = true,
+                   std::ostream* pstream__ = 0) const {
+    vars__.resize(2);
+    vars__[0] = params_r__[0];
+    vars__[1] = std::exp(params_r__[1]);
+  }
+
+ private:
+  template <bool jacobian__, typename T__>
+  T__ log_density(const T__& mu, const T__& log_sigma) const {
+    using std::exp;
+    using stan::math::exp;
+    T__ sigma = exp(log_sigma);
+    T__ lp = -0.5 * mu * mu / 100 - log_sigma - 0.5 * log_sigma * log_sigma;
+    if (jacobian__)
+      lp += log_sigma;
+    T__ log_lik = 0;
+    for (int n : batch_) {
+      T__ z = (y_[n - 1] - mu) / sigma;
+      log_lik += -0.5 * z * z - log_sigma;
+    }
+    return lp + weight_ * log_lik;
+  }
+
+  std::vector<double> y_;
+  std::vector<int> batch_;
+  double weight_;
+  int max_batch_size_;
+};
+
+}  // namespace unit
+}  // namespace test
+}  // namespace stan
+#endif